@@ -13,6 +13,15 @@ const uint8_t HEAD_CMD_L = 0x3B;       // 帧头低位
 const uint16_t BUFFER_SIZE = 4096;     // 缓冲区大小
 const uint16_t MIN_FRAME_LEN = 8;      // 最小帧长度
 
+// 日志文件
+const char* const LOG_FILE_PATH = "/var/log/test_app.log";
+const uint32_t LOG_FILE_MAX_SIZE = 8 * 1024 * 1024;    // 单个日志文件上限，超过后轮转
+const int LOG_FILE_COUNT = 4;                          // 保留 test_app.log.1 ~ test_app.log.4
+const int LOG_FILE_SYNC_MS = 5000;                     // INFO / DEBUG 日志的定时落盘间隔
+const char* const LOG_RING_FILE_PATH = "/var/log/test_app.ring";   // 持久化日志环形缓冲区，用 log_recover 导出
+const uint32_t LOG_RING_FILE_SIZE = 4 * 1024 * 1024;
+const char* const LOG_JSON_FILE_PATH = "/var/log/test_app.jsonl";  // 结构化日志，用 log_index 按 cmdIndex / LN 检索
+
 // 命令类型
 enum CmdType {
     CMD_REQUEST = 1,
@@ -36,6 +45,8 @@ enum SubCommand {
     CMD_SIGNAL_EXEC_RES = 0x0E,
     CMD_SIGNAL_TOBEMEASURED_COMBINE = 0x0F,
     CMD_SIGNAL_TOBEMEASURED_COMBINE_RES = 0x10,
+    CMD_CANCEL_TEST = 0x11,                 // 按 cmdIndex 取消测试任务
+    CMD_QUERY_TEST_STATUS = 0x12,           // 查询测试任务状态
 
     CMD_SIGNAL_TEST_ITEM_RES = 6,
     CMD_OVER_TEST_ACK = 8,
@@ -66,6 +77,8 @@ enum TestItem {
     STORAGE,
     USB,
     DDR,
+    DDR_BANDWIDTH,
+    DDR_MEMTEST,
     EMMC,
     TF,
     FACILITYUSB3_0,
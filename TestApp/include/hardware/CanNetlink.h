@@ -0,0 +1,93 @@
+#ifndef __CAN_NETLINK_H__
+#define __CAN_NETLINK_H__
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/Log.h"
+
+struct CanLinkConfig {
+    std::string ifname;                     // 如 "can0"
+    uint32_t bitrate = 250000;              // 0: 不改位定时，只重新 down / up
+    uint32_t samplePoint = 0;               // 采样点，千分之一 (875 即 87.5%)，0 由驱动按 CiA 推荐值计算
+    uint32_t restartMs = 0;                 // bus-off 后自动重启的延时，0 不自动重启
+    bool up = true;                         // 配置完成后是否 up
+};
+
+struct CanLinkStatus {
+    std::string ifname;
+    int ifindex = 0;
+    bool ok = false;                        // configure: 所有步骤成功；query: 取到了链路信息
+    std::string error;
+
+    bool up = false;
+    std::string kind;                       // "can"、"vcan" 等
+    uint32_t bitrate = 0;
+    uint32_t samplePoint = 0;
+    uint32_t restartMs = 0;
+    int state = -1;                         // enum can_state，-1 未知 (vcan 没有)
+    uint16_t txErrors = 0;                  // 控制器的错误计数 (TEC / REC)
+    uint16_t rxErrors = 0;
+
+    bool statsValid = false;                // IFLA_INFO_XSTATS (struct can_device_stats)
+    uint32_t busErrors = 0;
+    uint32_t errorWarning = 0;
+    uint32_t errorPassive = 0;
+    uint32_t busOff = 0;
+    uint32_t arbitrationLost = 0;
+    uint32_t restarts = 0;
+};
+
+const char* can_state_name(int state);
+
+/*
+ * 用 rtnetlink 配置 CAN 接口，代替 system("ip link set ...")
+ * 所有接口的 down、位定时 / restart-ms 请求拼在一个缓冲区里一次 sendmsg 发出，内核按顺序处理，
+ * 之后按序号收齐每条请求的 ack；前面的步骤都成功的接口再用第二批请求 up。
+ * 查询同样一次发出所有 RTM_GETLINK。
+ * 常驻一个 netlink socket，第一次使用时打开，调用之间用锁串行化。
+ */
+class CanNetlink {
+public:
+    CanNetlink();
+    ~CanNetlink();
+
+    CanNetlink(const CanNetlink&) = delete;
+    CanNetlink& operator=(const CanNetlink&) = delete;
+
+    /*
+     * @brief 按 links 配置各接口 (先 down，再设置参数，最后按 up 决定是否 up)
+     * down 或设置参数失败的接口不会 up
+     * @param results 与 links 一一对应，某一步失败时 error 为该步和内核返回的错误
+     * @return 所有接口都配置成功返回 true
+     */
+    bool configure(const std::vector<CanLinkConfig>& links, std::vector<CanLinkStatus>& results);
+
+    /*
+     * @brief 读取各接口的状态、位定时、错误计数和 IFLA_INFO_XSTATS 统计
+     * @return 所有接口都取到返回 true
+     */
+    bool query(const std::vector<std::string>& ifnames, std::vector<CanLinkStatus>& results);
+
+private:
+    bool ensureOpen();
+    bool transact(std::vector<char>& batch, uint32_t firstSeq, uint32_t count, std::vector<int>& errors,
+                  std::vector<std::vector<char>>* replies);
+
+    int fd_;
+    uint32_t seq_;
+    std::mutex mutex_;
+
+    const char* CAN_NETLINK_TAG = "CanNetlink";
+};
+
+#endif
+
+/*
+ * @description: v1 rtnetlink 批量配置 CAN 接口 (位速率、采样点、restart-ms、up/down)，读取错误统计
+ * @Date: 2026-10-19 *
+ * @description: v2 up 放到第二批，只 up 前面步骤都成功的接口
+ * @Date: 2026-10-19
+ */
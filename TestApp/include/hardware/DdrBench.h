@@ -0,0 +1,59 @@
+#ifndef __DDR_BENCH_H__
+#define __DDR_BENCH_H__
+
+#include <string>
+#include <stdint.h>
+
+#include "util/Log.h"
+#include "util/theradpoolv1/thread_pool.h"
+
+struct DdrBenchConfig {
+    uint64_t arrayBytes = 64ULL << 20;      // 每个数组的大小，共三个；要远大于末级缓存 (STREAM 要求至少 4 倍)
+    unsigned threads = 0;                   // 0 为所有可用 CPU，每个线程绑一个核
+    int iterations = 5;                     // 每个 kernel 跑的轮数，取最快的一轮
+};
+
+struct DdrBenchResult {
+    std::string isa;                        // 实际使用的 kernel: neon / avx / sse2 / scalar
+    unsigned threads = 0;
+    uint64_t arrayBytes = 0;
+    double copyGBps = 0;                    // c = a            GB/s (10^9 字节)，按 STREAM 的方式只计读写的数组字节；取消时为 0
+    double scaleGBps = 0;                   // b = s * c
+    double addGBps = 0;                     // c = a + b
+    double triadGBps = 0;                   // a = b + s * c
+    bool valid = false;                     // 结果数组校验通过
+    std::string error;
+};
+
+/*
+ * DDR 带宽测试 (STREAM 的 copy / scale / add / triad 四个 kernel)
+ * 所有核同时跑，每个线程只访问自己的一段 (也由它首次写入分配物理页)，每轮前后用屏障同步，
+ * 以最慢的线程结束为一轮的时间。sysinfo 只能看出容量，训练失败只跑半带宽的 DDR 通道要靠这个发现。
+ */
+class DdrBench {
+public:
+    explicit DdrBench(const DdrBenchConfig& config);
+
+    /*
+     * @param interrupt 不为空时每轮之前检查，置位后所有线程在同一轮退出，result.error 为 "cancelled"
+     * @return 内存分配失败、结果校验不通过或被取消返回 false
+     */
+    bool run(DdrBenchResult& result, const interrupt_flag* interrupt = nullptr);
+
+    // 编译进来的 kernel 指令集
+    static const char* isa();
+
+private:
+    DdrBenchConfig config_;
+    const char* DDR_BENCH_TAG = "DdrBench";
+};
+
+#endif
+
+/*
+ * @description: v1 STREAM 方式的多核 DDR 带宽测试，NEON / SSE2 / AVX kernel
+ * @Date: 2026-10-19
+ *
+ * @description: v2 run 接受中断标志，每轮之间检查
+ * @Date: 2026-10-19
+ */
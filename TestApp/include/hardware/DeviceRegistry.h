@@ -0,0 +1,208 @@
+#ifndef __DEVICE_REGISTRY_H__
+#define __DEVICE_REGISTRY_H__
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "hardware/UsbSysfs.h"
+#include "util/AsyncWait.h"
+#include "util/Reactor.h"
+
+struct udev;
+struct udev_device;
+struct udev_monitor;
+
+/*
+ * 块设备在板上的角色，按所在总线和控制器分类，不依赖 mmcblk0 / mmcblk1 的编号顺序
+ */
+enum BlockRole {
+    BLOCK_ROLE_OTHER,
+    BLOCK_ROLE_EMMC,            // mmc 总线上的 MMC 卡 (boot0 / boot1 / rpmb 硬件分区不算)
+    BLOCK_ROLE_TF,              // mmc 总线上的 SD 卡
+    BLOCK_ROLE_NVME,
+    BLOCK_ROLE_USB,             // usb 大容量存储，包括 usb 读卡器
+};
+
+const char* block_role_name(BlockRole role);
+
+/*
+ * 一个块设备 (/sys/class/block/<name>)，包括分区
+ */
+struct BlockDeviceInfo {
+    std::string name;           // sysfs 名，如 "sda"、"sda1"、"mmcblk1"
+    std::string devnode;        // 设备节点，如 "/dev/sda1"
+    std::string devtype;        // "disk" 或 "partition"
+    std::string parent;         // 分区所在的磁盘名，磁盘为空
+    uint64_t sizeBytes = 0;     // 容量，BLKGETSIZE64 取得，打不开设备节点时用 sysfs size * 512
+    bool removable = false;     // 磁盘的 removable 属性，分区继承所在磁盘
+    BlockRole role = BLOCK_ROLE_OTHER;      // 分区继承所在磁盘
+    std::string usbPort;        // 所在 usb 设备的端口路径 (UsbDeviceInfo::name，如 "1-1.2")，不在 usb 上为空
+    std::string mountPoint;     // 第一个挂载点，未挂载为空
+};
+
+/*
+ * 某一时刻的设备快照，发布后不再修改，多个线程可以同时读
+ */
+struct DeviceSnapshot {
+    uint64_t generation = 0;                // 每次发布加 1
+    std::vector<UsbDeviceInfo> usb;         // 按 busnum、devnum 排序，和 lsusb 相同
+    std::vector<BlockDeviceInfo> block;     // 按 name 排序
+
+    const UsbDeviceInfo* findUsb(const std::string& port) const;
+    const BlockDeviceInfo* findBlock(const std::string& name) const;
+
+    // usb 上的磁盘 (不含分区)，按端口路径排序
+    std::vector<const BlockDeviceInfo*> usbDisks() const;
+
+    // 按角色取磁盘 (不含分区)，没有时返回 nullptr；同一角色有多个时取名字最小的
+    const BlockDeviceInfo* disk(BlockRole role) const;
+    const BlockDeviceInfo* emmc() const { return disk(BLOCK_ROLE_EMMC); }
+    const BlockDeviceInfo* tf() const { return disk(BLOCK_ROLE_TF); }
+    const BlockDeviceInfo* nvme() const { return disk(BLOCK_ROLE_NVME); }
+
+    // 指定 usb 端口 (或其下级 hub) 上的第一个磁盘，端口路径同 UsbDeviceInfo::name
+    const BlockDeviceInfo* usbDisk(const std::string& port) const;
+};
+
+struct DeviceEvent {
+    enum Type {
+        USB_ADDED,
+        USB_REMOVED,
+        BLOCK_ADDED,
+        BLOCK_CHANGED,          // 容量或角色变化，如读卡器换卡
+        BLOCK_REMOVED,
+        MOUNT_CHANGED,          // 挂载点变化
+    };
+    Type type;
+    std::string name;           // usb 设备或块设备的 sysfs 名
+    std::string port;           // usb 端口路径，usb 设备为自身，块设备为所在 usb 设备，不在 usb 上为空
+    std::shared_ptr<const DeviceSnapshot> snapshot;     // 包含本次变化的快照
+};
+
+/*
+ * 常驻的 usb / 块设备登记表
+ * 启动时枚举一次，之后由 udev 热插拔事件和 /proc/self/mounts 的变化通知增量更新，
+ * 测试时直接读快照，不再每次 libusb_init / 枚举 / 打开设备，也不再每次遍历 udev。
+ * 更新只在 reactor 线程中进行，每次变化发布一个新的不可变快照；
+ * snapshot() 用 std::atomic_load 取出当前快照的 shared_ptr，libstdc++ 中这是按地址选的一把全局互斥锁，
+ * 锁内只有一次引用计数加减，不是无锁的，但读者不会等待枚举和 udev 事件处理。
+ * 需要等设备出现的测试 (type-c 翻转后等枚举) 按端口订阅变化，或者在协程中 co_await wait_until。
+ */
+class DeviceRegistry {
+public:
+    using event_callback = std::function<void(const DeviceEvent& event)>;
+
+    explicit DeviceRegistry(Reactor& reactor);
+    ~DeviceRegistry();
+
+    DeviceRegistry(const DeviceRegistry&) = delete;
+    DeviceRegistry& operator=(const DeviceRegistry&) = delete;
+
+    /*
+     * @brief 开始监听并做首次枚举，需要在 reactor 启动之后调用
+     * @return udev 不可用时返回 false，此时 snapshot() 一直为空，调用者回退到原来的探测方式
+     */
+    bool start();
+
+    // 停止监听，在 reactor 停止之后调用
+    void stop();
+
+    /*
+     * @brief 指定某个控制器下的块设备的角色，优先于按总线的自动分类，需要在 start 之前调用
+     * @param devpath 控制器在 sysfs 设备路径中的一段，如 "fe2e0000.mmc"
+     * 用于 mmc 卡类型读不出来，或者 eMMC 控制器上接的是 SD 卡座这类板子
+     */
+    void setControllerRole(const std::string& devpath, BlockRole role);
+
+    // 当前快照，未启动或启动失败返回 nullptr
+    std::shared_ptr<const DeviceSnapshot> snapshot() const;
+
+    /*
+     * @brief 订阅设备变化
+     * @param port usb 端口路径，如 "1-1"，该端口及其下级 hub 上的设备 ("1-1.x") 的事件都会通知；为空则订阅全部
+     * @param callback 在 reactor 线程中调用，不要阻塞
+     * @return 订阅 id，用于 unsubscribe
+     * 订阅不改变登记表的内容，和 snapshot() 一样可以通过 const 指针调用
+     */
+    int subscribe(const std::string& port, event_callback callback) const;
+    void unsubscribe(int id) const;
+
+    /*
+     * @brief 等到快照满足 ready：先检查当前快照，之后 port 上每次有变化再检查
+     * @param port 同 subscribe
+     * @param ready 在 reactor 线程中调用
+     * @return 协程中 co_await 得到 ASYNC_WAIT_READY / TIMEOUT / CANCELLED，未启动 (没有快照) 时为 ASYNC_WAIT_ERROR
+     */
+    void wait_until(AsyncWaiter& waiter, const std::string& port, std::function<bool(const DeviceSnapshot&)> ready,
+                    int timeout_ms, std::shared_ptr<interrupt_flag> flag,
+                    std::function<void(AsyncWaitResult result)> callback) const;
+    AsyncAwaitable<AsyncWaitResult> wait_until(AsyncWaiter& waiter, const std::string& port,
+                                               std::function<bool(const DeviceSnapshot&)> ready,
+                                               int timeout_ms, std::shared_ptr<interrupt_flag> flag) const;
+
+private:
+    struct Subscriber {
+        std::string port;
+        event_callback callback;
+    };
+
+    void enumerate();
+    void onMonitorReadable();
+    void onMountsChanged();
+
+    bool updateUsb(struct udev_device* dev, const char* action, std::vector<DeviceEvent>& events);
+    bool updateBlock(struct udev_device* dev, const char* action, std::vector<DeviceEvent>& events);
+    bool refreshMounts(std::vector<DeviceEvent>& events);
+    BlockRole classifyDisk(struct udev_device* disk, const std::string& name, const std::string& usbPort) const;
+
+    std::shared_ptr<const DeviceSnapshot> publish();
+    void dispatch(std::vector<DeviceEvent>& events, const std::shared_ptr<const DeviceSnapshot>& snapshot);
+
+    Reactor& reactor_;
+    struct udev* udev_;
+    struct udev_monitor* monitor_;
+    int monitor_fd_;
+    int mounts_fd_;
+
+    // 以下只在 reactor 线程 (start 中首次枚举时在调用线程) 访问
+    std::map<std::string, UsbDeviceInfo> usb_;          // key 为 syspath
+    std::map<std::string, BlockDeviceInfo> block_;      // key 为 syspath
+    std::map<std::string, std::string> mounts_;         // 设备节点 -> 第一个挂载点
+    std::vector<std::pair<std::string, BlockRole>> controller_roles_;   // start 之前设置，之后只读
+    uint64_t generation_;
+
+    std::shared_ptr<const DeviceSnapshot> current_;     // 只通过 std::atomic_load / atomic_store 访问
+
+    mutable std::mutex subscribers_mutex_;
+    mutable std::map<int, Subscriber> subscribers_;
+    mutable int next_subscriber_id_;
+
+    const char* DEVICE_REGISTRY_TAG = "DeviceRegistry";
+};
+
+#endif
+
+/*
+ * @description: v1 udev 热插拔驱动的 usb / 块设备登记表，测试读快照，可按端口订阅插拔事件
+ * @Date: 2026-10-19
+ */
+
+/*
+ * @description: v2 块设备按总线 / mmc 卡类型 / 控制器分类为 emmc / tf / nvme / usb，容量改用 BLKGETSIZE64
+ * @Date: 2026-10-19
+ */
+
+/*
+ * @description: v3 去掉没有使用者的 subscribe / 设备事件，测试只读快照
+ * @Date: 2026-10-19
+ */
+
+/*
+ * @description: v4 恢复按端口订阅，增加协程中等待设备出现的 wait_until，type-c 测试用它代替固定的 2 秒等待
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,71 @@
+#ifndef __DRAM_TEST_H__
+#define __DRAM_TEST_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/Log.h"
+#include "util/theradpoolv1/thread_pool.h"
+
+struct DramTestConfig {
+    uint64_t sizeBytes = 256ULL << 20;      // 测试的内存大小，不超过空闲内存的一半
+    unsigned threads = 0;                   // 0 为所有可用 CPU，每个线程绑一个核、测自己的一段
+    uint32_t durationMs = 0;                // 0: 只跑一遍；否则重复到时间用完，时间到了当前一遍也中止
+};
+
+// 一段出错的地址，相距不到一页的错误地址合并成一段
+struct DramFaultRange {
+    uint64_t start = 0;                     // 物理地址 (没有权限读 pagemap 时为缓冲区内的偏移)
+    uint64_t end = 0;                       // 不含
+    uint64_t bits = 0;                      // 出错的数据位 (期望值 ^ 实际值 的或)
+    uint64_t count = 0;                     // 记录到的出错字数
+};
+
+struct DramTestResult {
+    std::string backing;                    // 缓冲区来源: hugetlb / thp / normal
+    bool physical = false;                  // ranges 是否为物理地址
+    unsigned threads = 0;
+    uint64_t testedBytes = 0;
+    int passes = 0;                         // 完整跑完的遍数
+    uint64_t verifiedBytes = 0;             // 读出比较过的字节数 (每遍读多次，累加所有遍和中止的那一遍)
+    bool timedOut = false;                  // 最后一遍因为时间用完而中止 (取消不算)
+    uint64_t elapsedMs = 0;
+    uint64_t errors = 0;                    // 出错的字数 (64 位)，同一个字在不同步骤出错重复计数
+    std::vector<DramFaultRange> ranges;     // 只根据每个线程记录的前 64 个错误地址
+    std::string error;
+};
+
+/*
+ * DDR 颗粒测试: address-in-address、moving inversions (全 0 和棋盘格)、march C-
+ * 一大块内存 (优先 hugetlb 大页，其次透明大页) 按核平分，每个线程绑核测自己的一段，
+ * 每步之间用屏障同步，地址线错误把数据写到别的线程那段时也能查出来。
+ * 纯填充的步骤用 non-temporal store (x86 movntdq，aarch64 stnp) 绕开 cache。
+ * 出错地址通过 /proc/self/pagemap 换算成物理地址 (需要 root)，合并成区间报告。
+ */
+class DramTest {
+public:
+    explicit DramTest(const DramTestConfig& config);
+
+    /*
+     * @param interrupt 不为空时每个 march 元素之后检查，置位后所有线程在下一个屏障停下，result.error 为 "cancelled"
+     * @return 读出比较过的数据都没有出错返回 true，时间不够跑完一遍时只校验了部分也算通过 (见 verifiedBytes)；
+     *         分配内存失败、被取消、或时间短到一个字都没校验时 result.error 不为空，已经查到的错误照常填入
+     */
+    bool run(DramTestResult& result, const interrupt_flag* interrupt = nullptr);
+
+private:
+    DramTestConfig config_;
+    const char* DRAM_TEST_TAG = "DramTest";
+};
+
+#endif
+
+/*
+ * @description: v1 多核 march / moving inversions 内存测试，出错地址换算为物理地址
+ * @Date: 2026-10-19 *
+ * @description: v2 时间不够跑完一遍时按已校验的部分判定，结果中增加 verifiedBytes
+ * @Date: 2026-10-19 *
+ * @description: v3 run 接受中断标志，每个 march 元素之后检查
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,91 @@
+#ifndef __IO_ENGINE_H__
+#define __IO_ENGINE_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/Log.h"
+
+enum IoEngineType {
+    IO_ENGINE_AUTO = 0,         // 依次尝试 io_uring、内核 aio、同步读写
+    IO_ENGINE_URING = 1,
+    IO_ENGINE_AIO = 2,
+    IO_ENGINE_SYNC = 3,
+};
+
+struct IoCompletion {
+    uint32_t tag;               // queue 时传入的 tag
+    int64_t result;             // 读写的字节数，失败为 -errno
+};
+
+/*
+ * 异步块 I/O 引擎，存储测速、多盘并发测试和数据校验共用
+ * 直接用系统调用实现 io_uring 和内核 aio (libaio 的接口)，不依赖 liburing / libaio 库；
+ * 内核不支持或被禁用 (容器的 seccomp、io_uring_disabled) 时 AUTO 自动回退。
+ * 一个引擎只在一个线程中使用。
+ */
+class IoEngine {
+public:
+    virtual ~IoEngine() {}
+
+    /*
+     * @param depth 最多同时在途的请求数，tag 取值 [0, depth)
+     * @return 指定类型不可用时返回 nullptr，AUTO 至少返回同步引擎
+     */
+    static std::unique_ptr<IoEngine> create(IoEngineType type, unsigned depth);
+
+    static const char* typeName(IoEngineType type);
+
+    virtual const char* name() const = 0;
+
+    // 排队一个请求，submitAndWait 时才真正提交；buf / len / offset 在 O_DIRECT 时需要按扇区对齐
+    virtual bool queue(bool write, int fd, void* buf, uint32_t len, uint64_t offset, uint32_t tag) = 0;
+
+    /*
+     * @brief 提交所有排队的请求，并等待至少 min 个完成
+     * @param done 完成的请求追加到末尾
+     * @return 本次取到的完成数，系统调用失败返回 -errno；
+     *         单个请求被拒绝或读写失败 (如 EBADF) 都作为完成返回，result 为 -errno
+     */
+    virtual int submitAndWait(unsigned min, std::vector<IoCompletion>& done) = 0;
+
+protected:
+    const char* IO_ENGINE_TAG = "IoEngine";
+};
+
+// 存储测速和数据校验的测试对象
+struct IoTarget {
+    int fd = -1;
+    bool direct = false;                // 已加上 O_DIRECT，文件系统不支持 (tmpfs 等) 时为 false，走 page cache
+    bool temporary = false;             // 在目录下新建的临时文件，打开后已 unlink
+    bool blockDevice = false;
+    uint64_t size = 0;                  // 块设备容量或已有文件的长度，临时文件为 0
+};
+
+/*
+ * @brief 打开测试对象
+ *   目录     - 在其中创建 "<tempName>.<pid>" 临时文件读写，打开后立即 unlink，测试结束或进程退出时自动释放空间
+ *   块设备   - writeDevice 为 true 时读写打开，否则只读；容量由 BLKGETSIZE64 取得
+ *   普通文件 - writeFile 为 true 时读写打开，否则只读
+ * 打开后再用 fcntl 加 O_DIRECT，不支持时退回 page cache:
+ * 不支持 O_DIRECT 的文件系统 (6.6 之前的 tmpfs、ramfs 等) 上 open 会先创建文件再返回 EINVAL，
+ * 带 O_EXCL 重试只会得到 EEXIST，临时文件也留在了目录里
+ * @return 失败时 error 为原因，target.fd 为 -1
+ */
+bool io_target_open(const std::string& path, const char* tempName, bool writeFile, bool writeDevice,
+                    IoTarget& target, std::string& error);
+
+#endif
+
+/*
+ * @description: v1 io_uring / 内核 aio / 同步读写三种 I/O 引擎
+ * @Date: 2026-10-19 *
+ * @description: v2 io_uring 引擎析构时先收完在途请求的完成
+ * @Date: 2026-10-19 *
+ * @description: v3 内核 aio 引擎提交时被拒绝的请求也作为失败的完成返回，和 io_uring 一致
+ * @Date: 2026-10-19 *
+ * @description: v4 io_target_open，存储测速和数据校验共用的打开测试对象 (临时文件、O_DIRECT)
+ * @Date: 2026-10-19
+ */
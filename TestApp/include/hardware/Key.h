@@ -10,6 +10,8 @@
 #include <sys/time.h>
 #include <errno.h>
 #include <map>
+#include <vector>
+#include <string>
 
 #include "util/Log.h"
 
@@ -41,6 +43,20 @@ public:
     std::map<std::string, std::string> keyEventNamesToPath;
     virtual int waitForKeyPress(int timeOut = 60);
 
+    /*
+     * @brief 按 keyEventNamesToPath 查找并打开按键事件设备
+     * @param deviceFds 打开的设备 fd
+     * @param nonBlock 是否以非阻塞方式打开，交给 reactor 等待时使用
+     */
+    virtual bool openKeyEventDevices(std::vector<int>& deviceFds, bool nonBlock);
+    virtual void closeKeyEventDevices(std::vector<int>& deviceFds);
+
+    /*
+     * @brief 从可读的事件设备读取按键
+     * @return 按键码，没有按键事件返回 -1
+     */
+    virtual int readKeyCode(int fd);
+
     // wait for key press v3.0, not yet in use
     virtual void set_event_info_map(const std::map<std::string, event_info> info_map);           // set event_info_map
     virtual bool get_event_info();                                                               // open event devices based on event_info_map
@@ -0,0 +1,74 @@
+#ifndef __MULTI_DISK_BENCH_H__
+#define __MULTI_DISK_BENCH_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "hardware/StorageBench.h"
+#include "util/Log.h"
+
+struct MultiDiskTarget {
+    std::string name;                       // 测试项名称，如 "usb0"、"usb_pcie"
+    std::string path;                       // 测速对象，规则同 StorageBenchConfig::path
+};
+
+struct MultiDiskConfig {
+    uint64_t sizeBytes = 256ULL << 20;      // 每个盘的测试区域
+    uint32_t blockSize = 4 << 20;           // 大块顺序读写
+    uint32_t queueDepth = 4;
+    uint32_t soloMs = 1500;                 // 单独测量的时长，作为基准
+    uint32_t concurrentMs = 3000;           // 所有盘同时测量的时长
+    bool write = false;                     // 默认测读；写只对可写对象 (目录 / 文件) 生效
+    double collapseRatio = 0.5;             // 并发带宽低于期望份额的这个比例判为塌陷
+    IoEngineType engine = IO_ENGINE_AUTO;
+};
+
+struct MultiDiskDeviceResult {
+    std::string name;
+    std::string path;
+    std::string engine;
+    int cpu = -1;                           // I/O 线程绑定的 CPU
+    double soloMBps = -1;
+    double concurrentMBps = -1;
+    double expectedMBps = 0;                // 按单独带宽的比例分配并发总带宽得到的期望份额
+    bool collapsed = false;
+    std::string error;
+};
+
+struct MultiDiskResult {
+    std::vector<MultiDiskDeviceResult> devices;
+    double soloSumMBps = 0;                 // 各盘单独带宽之和
+    double aggregateMBps = 0;               // 并发时的总带宽
+};
+
+/*
+ * 多盘并发带宽测试
+ * 先逐个单独测出基准带宽，再让所有盘同时跑 (每个盘一个绑核的 I/O 线程，同一时刻开始、同一时刻结束)。
+ * 共享同一条总线 (hub、PCIe 交换) 时总带宽会下降，但每个盘大致按单独带宽的比例分到份额；
+ * 某个盘的并发带宽低于 期望份额 * collapseRatio 时判为塌陷，常见于 hub 故障或 3.0 口降到 2.0。
+ */
+class MultiDiskBench {
+public:
+    explicit MultiDiskBench(const MultiDiskConfig& config);
+
+    /*
+     * @param interrupt 不为空时传给每个盘的 StorageBench，置位后还没开始的阶段跳过，对应盘的 error 为 "cancelled"
+     * @return 有盘打开或读写失败返回 false (对应 error 不为空)，其它盘的结果仍然有效
+     */
+    bool run(const std::vector<MultiDiskTarget>& targets, MultiDiskResult& result, const interrupt_flag* interrupt = nullptr);
+
+private:
+    MultiDiskConfig config_;
+    const char* MULTI_DISK_TAG = "MultiDiskBench";
+};
+
+#endif
+
+/*
+ * @description: v1 多盘同时顺序读写，按单独带宽的比例检查并发份额
+ * @Date: 2026-10-19
+ *
+ * @description: v2 run 接受中断标志，取消时跳过剩下的单独 / 并发测量
+ * @Date: 2026-10-19
+ */
@@ -43,6 +43,9 @@ public:
 
     std::string board_name = "RkGenericBoard";
     virtual std::string get_board_name();
+
+    // 同时交给 Storage 和 Tf
+    void setDeviceRegistry(const DeviceRegistry* registry);
     static BOARD_NAME string_to_enum(const std::string board_name_str);
 };
 
@@ -47,7 +47,24 @@ public:
      */
     virtual bool setAndWait(struct rtc_time& tm, int waitSeconds);
 
+    /*
+     * @ brief First half of setAndWait, so the wait can run on the timer wheel instead of sleeping.
+     *        Opens the device and sets the time; the device stays open until checkTimeAdvanced.
+     * @ param tm: The time to set. It is not modified.
+     * @ return true if successful, false otherwise (the device is closed again).
+     */
+    virtual bool setTimeBegin(const struct rtc_time& tm);
+
+    /*
+     * @ brief Second half of setAndWait: reads the time back, checks it advanced by waitSeconds and closes the device.
+     * @ param tm: The time passed to setTimeBegin. On success it is updated with the time read back.
+     * @ param waitSeconds: The number of seconds waited since setTimeBegin.
+     * @ return true if successful, false otherwise.
+     */
+    virtual bool checkTimeAdvanced(struct rtc_time& tm, int waitSeconds);
+
 private:
+    void closeRtc();
 
 };
 
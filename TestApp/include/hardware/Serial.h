@@ -15,6 +15,8 @@
 #include <pthread.h>
 #include <poll.h>
 
+#include "hardware/CanNetlink.h"
+#include "hardware/SerialLoopback.h"
 #include "util/Log.h"
 
 class Serial {
@@ -31,7 +33,7 @@ public:
     virtual int openSerial(const char *device, int baudRate);
 
     /*
-     * @brief 串口通信测试
+     * @brief 串口通信测试 (TX 接 RX 回环)，多个端口一起测请直接用 SerialLoopback
      * @param device 串口设备路径，如 "/dev/ttyUSB0"
      * @param testCount 测试次数
      * @param reCount 重试次数
@@ -53,6 +55,12 @@ public:
 
     // CAN 相关方法
     virtual int open_can_device(const char* ifname);
+
+    /*
+     * @brief 读取 CAN 接口的状态、位速率、错误计数和 bus-off / 仲裁丢失等统计 (IFLA_INFO_XSTATS)
+     * @return 所有接口都取到返回 true
+     */
+    virtual bool can_link_status(const std::vector<std::string>& ifnames, std::vector<CanLinkStatus>& status);
     virtual bool can_send(int fd, uint32_t can_id, const uint8_t* data);
     virtual int can_recv(int fd, unsigned char* buf, int& len, int timeout_ms);
     virtual bool can_test(int fd, int test_count);
@@ -65,6 +73,7 @@ public:
 
 
 private:
+    CanNetlink canNetlink;                  // CAN 接口的 down / 位速率 / up 和状态查询
 
 };
 
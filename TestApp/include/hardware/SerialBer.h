@@ -0,0 +1,82 @@
+#ifndef __SERIAL_BER_H__
+#define __SERIAL_BER_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/Log.h"
+#include "util/theradpoolv1/thread_pool.h"
+
+struct SerialBerConfig {
+    uint32_t baudRate = 115200;             // 任意波特率 (termios2 BOTHER)，能否达到 4M 取决于串口驱动和时钟
+    int prbs = 15;                          // 15: x^15 + x^14 + 1，23: x^23 + x^18 + 1
+    uint32_t durationMs = 0;                // 发送时长，和 byteCount 先到为止；都为 0 时按 2 秒
+    uint64_t byteCount = 0;                 // 发送字节数
+    uint32_t drainMs = 200;                 // 发送结束后继续收的时间 (最后一次收到数据起算)
+};
+
+struct SerialBerResult {
+    std::string device;
+    uint32_t baudRate = 0;
+    int prbs = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t elapsedUs = 0;                 // 开始发送到最后一次收到数据
+    double throughputBps = 0;               // 收到的字节数 / elapsed，字节每秒
+    double efficiency = 0;                  // throughput 占线路速率 (8N1 为 baud / 10) 的比例
+
+    bool locked = false;                    // 是否同步过
+    uint64_t checkedBytes = 0;              // 同步状态下比较过的字节
+    uint64_t byteErrors = 0;                // 其中有错误位的字节
+    uint64_t bitErrors = 0;
+    double byteErrorRate = 0;               // byteErrors / checkedBytes
+    uint64_t slipBytes = 0;                 // 失步窗口和重新搜索期间收到、没有参与比较的字节
+    int resyncs = 0;                        // 失步 (丢字节、插入字节或连续错误) 的次数
+    uint64_t firstLockUs = 0;               // 开始发送到第一次同步
+    uint64_t maxResyncUs = 0;               // 失步到重新同步最长的一次，按期间收到的字节数换算成线路时间
+
+    bool icountValid = false;               // 驱动是否支持 TIOCGICOUNT (pty、部分 usb 串口不支持)
+    uint32_t frameErrors = 0;               // 测试期间 TIOCGICOUNT 计数的增量
+    uint32_t overruns = 0;                  // 硬件 FIFO 溢出
+    uint32_t bufOverruns = 0;               // tty 缓冲区溢出
+    uint32_t parityErrors = 0;
+    uint32_t breaks = 0;
+
+    std::string error;
+};
+
+/*
+ * 串口误码率测试，端口需要 TX 接 RX 回环
+ * 所有端口同时以指定波特率持续发送 PRBS 序列 (一个 epoll 线程，发送端写满 tty 缓冲区)，
+ * 接收端按位比较: 先用收到的位作为移位寄存器搜索同步，连续 64 位符合后锁定，之后由本地发生器预测，
+ * 单个错误位不会扩散。256 位内错误超过 1/8 判为失步 (通常是丢了字节)，这个窗口内的错误不计入误码，
+ * 重新搜索同步并记录用时。帧错误和溢出从 TIOCGICOUNT 前后相减得到。
+ */
+class SerialBer {
+public:
+    explicit SerialBer(const SerialBerConfig& config);
+
+    /*
+     * @param results 与 devices 一一对应
+     * @param interrupt 不为空时每轮 epoll 都检查 (最多等 100ms)，置位后所有端口立即结束，
+     *                  还没结束的端口 error 为 "cancelled"，已收到的数据照常统计
+     * @return 所有端口都完成测试 (能打开、能配置、同步过) 返回 true，误码率由调用者判断
+     */
+    bool run(const std::vector<std::string>& devices, std::vector<SerialBerResult>& results,
+             const interrupt_flag* interrupt = nullptr);
+
+private:
+    SerialBerConfig config_;
+    const char* SERIAL_BER_TAG = "SerialBer";
+};
+
+#endif
+
+/*
+ * @description: v1 PRBS-15 / 23 串口误码率、吞吐率测试，termios2 任意波特率，TIOCGICOUNT 统计线路错误
+ * @Date: 2026-10-19
+ *
+ * @description: v2 run 接受中断标志，在 epoll 循环中检查，取消时结束所有端口
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,61 @@
+#ifndef __SERIAL_LOOPBACK_H__
+#define __SERIAL_LOOPBACK_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/Log.h"
+
+struct SerialLoopbackConfig {
+    int baudRate = 115200;
+    int rounds = 10;                        // 每个端口往返的次数，全部成功才算通过
+    uint32_t timeoutMs = 1000;              // 一次往返等待回环数据的最长时间
+    int retries = 3;                        // 失败后重新打开端口重测的次数
+    uint32_t retryDelayMs = 1000;           // 重测前的等待，期间其它端口照常进行
+};
+
+struct SerialLoopbackResult {
+    std::string device;
+    bool ok = false;
+    int attempts = 0;                       // 实际进行的次数 (含第一次)
+    int rounds = 0;                         // 最后一次完成的往返数
+    uint64_t maxRoundTripUs = 0;            // 最后一次中最慢的一个往返
+    uint64_t elapsedUs = 0;                 // 从开始到该端口结束 (通过或用完重试)
+    std::string error;                      // 最后一次失败的原因
+};
+
+/*
+ * RS-232 回环测试 (TX 接 RX)，所有端口同时进行
+ * 每个端口写一个带端口序号和轮次的唯一标记，用一个 epoll 等所有端口的回传数据，各端口有自己的截止时间；
+ * 收齐一个标记立刻发下一个，不再固定等 100ms。两个端口的线接反了会收到对方的标记，同样判为失败。
+ * 总耗时是最慢那个端口的往返时间之和，而不是所有端口所有轮次的等待时间之和。
+ */
+class SerialLoopback {
+public:
+    explicit SerialLoopback(const SerialLoopbackConfig& config);
+
+    /*
+     * @param devices 串口设备路径，如 "/dev/ttyS3"
+     * @param results 与 devices 一一对应
+     * @return 所有端口都通过返回 true
+     */
+    bool run(const std::vector<std::string>& devices, std::vector<SerialLoopbackResult>& results);
+
+    /*
+     * @brief 打开串口并配置为原始模式、非阻塞，8N1，无流控
+     * @return 成功返回文件描述符，失败返回 -1
+     */
+    static int openRaw(const char* device, int baudRate);
+
+private:
+    SerialLoopbackConfig config_;
+    const char* SERIAL_LOOPBACK_TAG = "SerialLoopback";
+};
+
+#endif
+
+/*
+ * @description: v1 多个 232 端口同时回环测试，epoll 等待回传数据，按端口截止时间判超时
+ * @Date: 2026-10-19
+ */
@@ -1,7 +1,6 @@
 #ifndef __STORAGE_H__
 #define __STORAGE_H__
 
-#include <regex>
 #include <memory>
 #include <string>
 #include <fstream>
@@ -36,6 +35,9 @@
 #include <sstream> 
 
 #include "util/Log.h"
+#include "hardware/UsbSysfs.h"
+#include "hardware/DeviceRegistry.h"
+#include "hardware/UsbDescriptorCache.h"
 
 class Storage {
 private:
@@ -46,7 +48,8 @@ public:
     const char* PCIE_DEVICE_SIZE_PATH;
     
     Storage(const char* mmcDeviceSizePath = "/sys/block/mmcblk0/size",
-            const char* pcieDeviceSizePath = "/sys/block/nvme0n1/size");  
+            const char* pcieDeviceSizePath = "/sys/block/nvme0n1/size",
+            const char* usbSysfsRoot = "/sys/bus/usb/devices");  
     /* 
      * @brief 获取ddr大小
      */
@@ -73,6 +76,13 @@ public:
      */
     virtual float getUdiskSize();
 
+    /*
+     * @brief 使用常驻的设备登记表，之后 getUdiskSize / scanUsbDisks / lsusbGetVidPidInfo 直接读快照，
+     *        getEmmcSize / getPcieSize 取登记表按总线识别出的 emmc / nvme 磁盘
+     *        登记表没有启动 (snapshot 为空) 时仍然走原来的 udev / libusb / sysfs 探测
+     */
+    void setDeviceRegistry(const DeviceRegistry* registry);
+
     // TODO: 暂未做成接口，需要优化。
     // 获取u盘容量大小
 
@@ -103,6 +113,12 @@ public:
     void search_directory(const char *path);
     void scan_usb_with_libusb();
 
+    /*
+     * @brief 统计 u 盘容量，结果放在 usbDiskSizeList[1..usbDiskCount] (GB)
+     * 有设备登记表时按 usb 端口顺序取快照中的 usb 磁盘，否则 scan_usb_with_libusb
+     */
+    void scanUsbDisks();
+
 
 
     struct lsusbFacilityusbInfo {
@@ -111,8 +127,20 @@ public:
     };
     int lsusbFacilityUsbCount = 0;
     std::vector<lsusbFacilityusbInfo> lsusbFacilityUsbInfoList;    // 后来测试过程中发现usb小板3.0  2.0  pid vid 不同，且不同小板之间也不同。不需要区分   
+
+    /*
+     * @brief 枚举 usb 设备的 vid / pid，结果放在 lsusbFacilityUsbInfoList (只包含找到的设备)
+     * 原来 popen("lsusb") + 正则，现在直接读 sysfs，见 UsbSysfs
+     */
     virtual bool lsusbGetVidPidInfo();   
 
+    UsbSysfs usbSysfs;
+    std::vector<UsbDeviceInfo> usbDevices;                          // 最近一次 lsusbGetVidPidInfo 的完整结果
+
+    const DeviceRegistry* deviceRegistry = nullptr;
+    UsbDescriptorCache usbDescriptorCache;                          // scan_usb_with_libusb 使用，第一次扫描时启动；
+                                                                    // 设备登记表没有快照 (udev 启动失败) 时才会走到
+
 
 private:
 
@@ -0,0 +1,108 @@
+#ifndef __STORAGE_BENCH_H__
+#define __STORAGE_BENCH_H__
+
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+#include "hardware/IoEngine.h"
+#include "util/Log.h"
+#include "util/theradpoolv1/thread_pool.h"
+
+struct StorageBenchConfig {
+    /*
+     * 测试对象:
+     *   目录   - 在其中创建临时文件 (打开后立即 unlink)，做写、读、随机读
+     *   块设备 - 只读测试，从不写裸设备
+     *   普通文件 - 已有文件只读测试，write 为 true 时覆盖写
+     */
+    std::string path;
+    uint64_t offset = 0;                    // 块设备 / 文件内的起始偏移，按 4K 对齐
+    uint64_t sizeBytes = 64ULL << 20;       // 顺序读写的区域大小，块设备不超过设备容量
+    uint32_t seqBlockSize = 1 << 20;
+    uint32_t seqQueueDepth = 4;
+    uint32_t randBlockSize = 4096;
+    uint32_t randQueueDepth = 32;
+    uint32_t randDurationMs = 2000;
+    bool write = true;
+    IoEngineType engine = IO_ENGINE_AUTO;
+};
+
+struct StorageBenchResult {
+    std::string engine;                     // 实际使用的 I/O 引擎
+    bool direct = false;                    // 是否 O_DIRECT (tmpfs 等不支持时退回 page cache + fadvise)
+    uint64_t regionBytes = 0;
+    double seqWriteMBps = -1;               // MB/s (10^6 字节)，未测试为 -1
+    double seqReadMBps = -1;
+    double randReadIops = -1;
+    double latP50Us = 0;                    // 随机读延迟分位数
+    double latP99Us = 0;
+    double latP999Us = 0;
+    double latMaxUs = 0;
+    std::string error;
+};
+
+/*
+ * 存储测速: 顺序写、顺序读 (大块，浅队列) 和 4K 随机读 (可配置队列深度，统计延迟分位数)
+ * 默认 O_DIRECT，绕开 page cache，测的是设备本身
+ */
+class StorageBench {
+public:
+    explicit StorageBench(const StorageBenchConfig& config);
+    ~StorageBench();
+
+    StorageBench(const StorageBench&) = delete;
+    StorageBench& operator=(const StorageBench&) = delete;
+
+    /*
+     * @brief 按配置依次跑完所有项目，耗时大约 2 * sizeBytes / 带宽 + randDurationMs
+     * @param interrupt 不为空时每批完成后检查，置位后等在途的请求结束就返回，result.error 为 "cancelled"
+     * @return 打开失败或 I/O 出错返回 false，result.error 为原因，已测完的项目保留结果
+     */
+    bool run(StorageBenchResult& result, const interrupt_flag* interrupt = nullptr);
+
+    /*
+     * 分步接口，多盘并发测试用: prepare -> sequentialPass / sequentialUntil ... -> release
+     * prepare 打开测试对象、创建引擎和缓冲区，result 中填入 engine / direct / regionBytes 或 error；
+     * interrupt 对之后的每一步都有效，取消时返回 false，error 为 "cancelled"
+     */
+    bool prepare(StorageBenchResult& result, const interrupt_flag* interrupt = nullptr);
+    void release();
+
+    // 顺序读或写整个区域一遍 (写包括 fdatasync)
+    bool sequentialPass(bool write, double& mbps, std::string& error);
+
+    // 顺序读或写到 deadlineNs (monotonic_ns() 的时间基准) 为止，到区域末尾时从头开始
+    bool sequentialUntil(bool write, uint64_t deadlineNs, double& mbps, std::string& error);
+
+    bool canWrite() const { return canWrite_; }
+
+private:
+    bool openTarget(StorageBenchResult& result);
+    void dropCache();
+
+    StorageBenchConfig config_;
+    int fd_;
+    bool canWrite_;
+    bool direct_;
+    uint64_t region_;
+    std::unique_ptr<IoEngine> engine_;
+    char* buffers_;
+    uint32_t slotSize_;
+    uint64_t seed_;
+    const interrupt_flag* interrupt_;
+    const char* STORAGE_BENCH_TAG = "StorageBench";
+};
+
+#endif
+
+/*
+ * @description: v1 存储顺序读写 / 4K 随机读测速，io_uring 优先，回退内核 aio 和同步读写
+ * @Date: 2026-10-19
+ *
+ * @description: v2 run / prepare 接受中断标志，每批完成后检查，取消时等在途的请求结束再返回
+ * @Date: 2026-10-19
+ *
+ * @description: v3 去掉 nowNs，时间基准统一用 util/Clock.h 的 monotonic_ns；打开测试对象改用 io_target_open
+ * @Date: 2026-10-19
+ */
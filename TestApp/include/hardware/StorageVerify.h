@@ -0,0 +1,76 @@
+#ifndef __STORAGE_VERIFY_H__
+#define __STORAGE_VERIFY_H__
+
+#include <string>
+#include <stdint.h>
+
+#include "hardware/IoEngine.h"
+#include "util/Log.h"
+#include "util/theradpoolv1/thread_pool.h"
+
+struct StorageVerifyConfig {
+    /*
+     * 测试对象:
+     *   目录   - 在其中创建临时文件 (打开后立即 unlink)
+     *   普通文件 - 覆盖写
+     *   块设备 - 会破坏设备上的数据，必须设置 allowDevice
+     */
+    std::string path;
+    uint64_t offset = 0;                    // 起始偏移，按 blockSize 对齐
+    uint64_t sizeBytes = 256ULL << 20;      // 测试区域；0 表示到设备末尾 / 目录所在文件系统可用空间的 90%
+    uint32_t blockSize = 1 << 20;           // 校验块大小，每块保存一个 64 位哈希
+    unsigned threads = 0;                   // 生成 / 校验线程数，0 为在线 CPU 数
+    uint64_t seed = 0;                      // 0 为随机
+    bool allowDevice = false;
+    IoEngineType engine = IO_ENGINE_AUTO;
+};
+
+struct StorageVerifyResult {
+    std::string engine;
+    bool direct = false;
+    uint64_t regionBytes = 0;
+    double writeMBps = 0;
+    double verifyMBps = 0;
+    uint64_t ioErrors = 0;                  // 读写请求失败的次数
+    uint64_t errorBlocks = 0;               // 校验失败的块数
+    uint64_t errorSectors = 0;              // 其中内容不符的 4K 扇区数 (读失败的块整块计入)
+    int64_t firstBadOffset = -1;            // 第一个出错字节在测试对象中的偏移，-1 表示没有错误
+    int64_t aliasOffset = -1;               // 第一个坏扇区读到的其实是写到哪个偏移的数据 (假容量盘的地址回绕)，-1 表示无法识别
+    std::string error;                      // 打开 / 分配失败等无法进行测试的原因
+};
+
+/*
+ * 存储数据完整性测试: 写入由种子和偏移决定的伪随机数据，落盘后读回校验
+ * 每个 4K 扇区带有自己的偏移，假容量 u 盘把高地址回绕到低地址时能识别出来。
+ * 生成和校验由多个线程并行 (校验用 NEON / SSE2 的 64 位哈希)，和读写交替使用两组缓冲区:
+ * 一组在做 I/O 时另一组在生成 / 校验，内存占用固定为 2 * max(threads, 4) * blockSize，与测试区域大小无关。
+ */
+class StorageVerify {
+public:
+    explicit StorageVerify(const StorageVerifyConfig& config);
+
+    /*
+     * @param interrupt 不为空时每批读写之前检查，置位后停止测试，result.error 为 "cancelled"，已经校验过的部分照常统计
+     * @return 没有任何错误返回 true；无法进行测试或被取消时 result.error 不为空
+     */
+    bool run(StorageVerifyResult& result, const interrupt_flag* interrupt = nullptr);
+
+    // 校验使用的哈希，公开出来便于对比不同实现
+    static uint64_t hash64(const void* data, size_t len, uint64_t seed);
+
+private:
+    int openTarget(StorageVerifyResult& result);
+
+    StorageVerifyConfig config_;
+    const char* STORAGE_VERIFY_TAG = "StorageVerify";
+};
+
+#endif
+
+/*
+ * @description: v1 写入后读回校验，检测假容量 u 盘和接触不良的 tf 卡座
+ * @Date: 2026-10-19
+ *
+ * @description: v2 run 接受中断标志，每批之间检查
+ * @Date: 2026-10-19
+ */
@@ -17,6 +17,9 @@
 #include <fcntl.h>
 
 #include "util/Log.h"
+
+class DeviceRegistry;
+
 class Tf {
 public:
     const char* TF_CARD_DEVICE_SIZE_PATH;
@@ -25,7 +28,13 @@ public:
     Tf(const char* tfCardDeviceSizePath = "/sys/block/mmcblk1/size");
     float getTfCardSize();
 
+    /*
+     * @brief 使用常驻的设备登记表，getTfCardSize 取按 mmc 卡类型识别出的 SD 卡，不再依赖 mmcblk 编号
+     */
+    void setTfDeviceRegistry(const DeviceRegistry* registry);
+
 private:
+    const DeviceRegistry* tfDeviceRegistry = nullptr;
 
 };
 
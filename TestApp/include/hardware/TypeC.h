@@ -16,6 +16,9 @@ class TypeC {
 public:
     const char* TYPEC_TAG = "TYPEC";
 
+    // type-c 口在 usb 上的端口路径 (如 "1-1")，type-c 测试只等这个端口上的设备变化；为空时等所有端口
+    std::string typecUsbPort;
+
     /*正插返回 1：   反差返回：0      未插入或异常返回：-1 */
     virtual int typeCTest(std::string typeCPath);
 
@@ -0,0 +1,111 @@
+#ifndef __USB_DESCRIPTOR_CACHE_H__
+#define __USB_DESCRIPTOR_CACHE_H__
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <libusb-1.0/libusb.h>
+
+#include "util/Log.h"
+
+/*
+ * 一个 usb 设备的缓存描述符
+ * 设备描述符和配置描述符在 linux 上由 libusb 从 sysfs 读出，不产生控制传输；
+ * 只有字符串描述符需要打开设备发控制传输，所以第一次用到时才取，之后一直缓存到设备拔出。
+ */
+struct UsbDescriptorEntry {
+    std::string path;                       // 总线 - 端口路径，如 "1-1.2"，root hub 为 "usb1"，和 sysfs 目录名一致
+    uint8_t bus = 0;
+    uint8_t address = 0;
+    struct libusb_device_descriptor desc;
+    libusb_device* device = nullptr;        // 持有一个引用，拔出后释放并置空 (在缓存的锁下)
+    bool massStorage = false;               // 有 mass storage (0x08) 接口，加入缓存时从配置描述符得到
+
+    // 字符串描述符，由 UsbDescriptorCache::fetchStrings 填入
+    bool stringsFetched = false;            // 所有字符串都读到后才置位
+    bool stringsValid = false;
+    uint8_t stringsRead = 0;                // 已经读到的字符串 (厂商、产品、序列号各一位)，没读到的下次重试时再读
+    unsigned stringsFailures = 0;           // 连续打开或读取失败的次数，决定下次重试的间隔
+    std::chrono::steady_clock::time_point stringsRetryAt;
+    std::string manufacturer;
+    std::string product;
+    std::string serial;
+};
+
+/*
+ * 常驻的 libusb 上下文和描述符缓存
+ * 启动时注册热插拔回调 (带 ENUMERATE，已有设备也会回调一次)，之后由独立的事件线程处理插拔，
+ * 按端口路径增删缓存项。重复的 storage / typec 测试对没有变化的设备不再产生任何 usb 控制传输。
+ * libusb 不支持热插拔时 (没有 udev / netlink) 每次 devices() 重新枚举，按端口路径和设备地址复用缓存项。
+ */
+class UsbDescriptorCache {
+public:
+    UsbDescriptorCache();
+    ~UsbDescriptorCache();
+
+    UsbDescriptorCache(const UsbDescriptorCache&) = delete;
+    UsbDescriptorCache& operator=(const UsbDescriptorCache&) = delete;
+
+    /*
+     * @brief 初始化 libusb 并开始监听，重复调用直接返回上次的结果
+     * @return libusb 初始化失败返回 false
+     */
+    bool start();
+    void stop();
+
+    // 当前所有设备，按端口路径排序
+    std::vector<std::shared_ptr<UsbDescriptorEntry>> devices();
+
+    /*
+     * @brief 取字符串描述符 (厂商、产品、序列号)，每个设备读取成功一次之后只返回缓存
+     * 设备打不开时 (刚插入还在枚举、被其他进程占用) 不缓存失败，按 1s 起倍增、最长 64s 的间隔重试，
+     * 间隔内的调用直接返回 false，不会每次扫描都去打开；
+     * 单个字符串读取失败时已读到的保留，没读到的按同样的间隔重试
+     * @return 所有字符串都读到或设备没有字符串描述符返回 true
+     */
+    bool fetchStrings(UsbDescriptorEntry& entry);
+
+    // 累计打开设备读取字符串描述符的次数，用于确认缓存生效
+    uint64_t stringFetches() const { return string_fetches_.load(); }
+
+private:
+    static int LIBUSB_CALL onHotplug(libusb_context* ctx, libusb_device* device, libusb_hotplug_event event, void* user);
+    void add(libusb_device* device);
+    void remove(libusb_device* device);
+    void rescan();
+    void eventLoop();
+
+    static std::string portPath(libusb_device* device);
+
+    libusb_context* ctx_;
+    bool started_;
+    bool hotplug_;
+    libusb_hotplug_callback_handle hotplug_handle_;
+    std::atomic<bool> stop_;
+    std::thread event_thread_;
+
+    std::mutex start_mutex_;                            // 串行化 start / stop
+    std::mutex mutex_;                                  // 保护 entries_，热插拔回调中也会加锁
+    std::map<std::string, std::shared_ptr<UsbDescriptorEntry>> entries_;
+    std::mutex strings_mutex_;                          // 串行化字符串描述符的读取
+    std::atomic<uint64_t> string_fetches_;
+
+    const char* USB_CACHE_TAG = "UsbDescriptorCache";
+};
+
+#endif
+
+/*
+ * @description: v1 常驻 libusb 上下文，热插拔维护描述符缓存，字符串描述符按需读取
+ * @Date: 2026-10-19 *
+ * @description: v2 字符串描述符读取失败不再永久缓存，按退避间隔重试
+ * @Date: 2026-10-19 *
+ * @description: v3 单个字符串读取失败时只缓存读到的，其余按同样的退避间隔重试
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,54 @@
+#ifndef __USB_SYSFS_H__
+#define __USB_SYSFS_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "util/Log.h"
+
+/*
+ * sysfs 中的一个 usb 设备 (/sys/bus/usb/devices/<name>)，包括 root hub，和 lsusb 列出的设备一致
+ */
+struct UsbDeviceInfo {
+    std::string name;           // sysfs 目录名，如 "1-1.2"、"usb1"
+    uint16_t vid = 0;           // idVendor
+    uint16_t pid = 0;           // idProduct
+    int busnum = 0;
+    int devnum = 0;
+    std::string devpath;        // 端口路径，如 "1.2"，root hub 为 "0"
+    uint32_t speedMbps = 0;     // 1 (1.5M 低速取整)、12、480、5000、10000 ...
+    uint8_t deviceClass = 0;    // bDeviceClass
+};
+
+/*
+ * 直接读 sysfs 枚举 usb 设备，代替 popen("lsusb") + 正则
+ * 每个设备只读几个属性文件，不打开设备、不 fork
+ */
+class UsbSysfs {
+public:
+    /*
+     * @param root usb 设备目录，默认 /sys/bus/usb/devices；可以指向按相同结构搭建的假目录做测试
+     */
+    explicit UsbSysfs(const char* root = "/sys/bus/usb/devices");
+
+    /*
+     * @brief 枚举当前所有 usb 设备，按 busnum、devnum 排序 (和 lsusb 相同)
+     * @param devices 输出，先清空
+     * @return 目录无法打开返回 false
+     */
+    bool scan(std::vector<UsbDeviceInfo>& devices) const;
+
+    const std::string& root() const { return root_; }
+
+private:
+    const char* USB_SYSFS_TAG = "USB_SYSFS";
+    std::string root_;
+};
+
+#endif
+
+/*
+ * @description: v1 sysfs usb 设备枚举，代替 lsusb
+ * @Date: 2026-10-19
+ */
@@ -5,7 +5,7 @@
 #include "protocol/Crc16.h"
 #include "common/Constants.h"
 #include "common/Types.h"
-#include "util/JsonHelper.h"
+#include "util/JsonDom.h"
 #include <vector>
 #include <string>
 #include <cstdint>
@@ -60,7 +60,7 @@ private:
     Uart* uart_;                    // 串口引用
     BufferManager buffer_;          // 缓冲区管理
     Task currentTask_;              // 当前任务
-    Json::Value jsonRoot_;          // 解析后的JSON数据
+    JsonDocument request_;          // 解析后的JSON数据，arena 每帧复用
     uint16_t lastCmdIndex_;         // 上一次命令索引（去重）
     Crc16::Calculator crcCalculator_;  // CRC计算器
     ParseState state_;              // 当前解析状态
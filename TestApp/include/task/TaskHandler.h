@@ -7,13 +7,25 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <functional>
 
 #include "common/Types.h"
 #include "task/TaskQueue.h"
+#include "task/TaskRegistry.h"
+#include "task/TestCase.h"
 #include "protocol/ProtocolParser.h"
 #include "hardware/TestInterface.h"
 #include "hardware/RkGenericBoard.h"
+#include "hardware/StorageBench.h"
+#include "hardware/MultiDiskBench.h"
+#include "hardware/StorageVerify.h"
+#include "hardware/DdrBench.h"
+#include "hardware/DramTest.h"
+#include "hardware/SerialBer.h"
 #include "util/Log.h"
+#include "util/AsyncWait.h"
+#include "util/JsonPatch.h"
 
 /**
  * 任务处理器，负责执行测试任务并处理结果
@@ -50,6 +62,12 @@ public:
     // 回复单个测试组合命令
     void handleSignalToBeMeasuredCombine(const Task& task);   // 0x0F
 
+    // 按 cmdIndex 取消测试任务
+    void handleCancelTest(const Task& task);     // 0x11
+
+    // 查询测试任务状态列表
+    void handleQueryTestStatus(const Task& task);     // 0x12
+
 
     // 字符串转换为测试项目枚举
     TestItem stringToTestItem(const std::string& str);
@@ -83,6 +101,132 @@ private:
     std::shared_ptr<std::thread> keyThread_;   // 按键检测线程
     std::mutex keyThreadMutex_;                // 线程互斥锁
 
+    AsyncWaiter waiter_;                       // 交互式测试的异步等待，回调在 reactor 线程中执行
+
+    /**
+     * 提交异步测试任务到任务线程池，并以 cmdIndex 登记到 task_registry
+     * @param task 测试任务
+     * @param name 测试项名称，用于状态查询
+     * @param fn 测试函数，需定期检查 flag 是否请求停止
+     */
+    void submit_test(const Task& task, const std::string& name, std::function<void(interrupt_flag&)> fn);
+
+    /**
+     * 登记一个不占用线程的异步测试 (基于 waiter_ 的协程)，直接标记为 RUNNING
+     * 测试结束时调用者需要 task_registry.markDone(cmdIndex, *flag)
+     * @return 该任务的中断标志
+     */
+    std::shared_ptr<interrupt_flag> start_async_test(const Task& task, const std::string& name);
+
+    /**
+     * type-c 测试：检查某一面 (positive / negative) 需要枚举到的 usb 设备
+     * @param groups 解码后的 groupList，结果按相同下标写入 responseData
+     * @return 该面所有设备都找到返回 true
+     */
+    bool typec_check_group(const TypecGroupCase& groups, Json::Value& responseData, const char* side, std::shared_ptr<RkGenericBoard> Board);
+
+    /**
+     * 存储测速：config 配置了测速门限时在 target 上跑 StorageBench，结果写入 item["bench"]
+     * @param target 为空表示找不到测速对象，按失败处理
+     * @param flag 测试任务的中断标志，每批 I/O 之后检查，取消时按失败处理
+     * @return 没有配置门限或全部达标返回 true
+     */
+    bool storage_bench(const StorageItem& config, const std::string& target, Json::Value& item, const interrupt_flag& flag);
+
+    /**
+     * DDR 带宽测试：所有核同时跑 STREAM 的四个 kernel，每个数组 bandwidthSizeMB，结果写入 item["bandwidth"]，testValue 为 triad 带宽
+     * @param flag 测试任务的中断标志，每轮之间检查，取消时按失败处理
+     * @return 结果校验通过且达到配置的门限返回 true
+     */
+    bool ddr_bandwidth(const StorageItem& config, Json::Value& item, const interrupt_flag& flag);
+
+    /**
+     * DDR 颗粒测试：march / moving inversions 跑 memtestSizeMB 内存，最长 memtestDurationMs，
+     * 结果写入 item["memtest"]，出错时附上出错的物理地址区间，testValue 为出错字数
+     * @param flag 测试任务的中断标志，每个 march 元素之后检查，取消时按失败处理，已经查到的错误照常写入
+     * @return 没有错误且至少校验过一部分内存返回 true
+     */
+    bool ddr_memtest(const StorageItem& config, Json::Value& item, const interrupt_flag& flag);
+
+    /**
+     * 存储完整性校验：在 target 上写入 verifySizeMB 的伪随机数据后读回比较，结果写入 item["verify"]
+     * @param flag 测试任务的中断标志，每批读写之前检查，取消时按失败处理
+     * @return 没有坏扇区和读写错误返回 true
+     */
+    bool storage_verify(const StorageItem& config, const std::string& target, Json::Value& item, const interrupt_flag& flag);
+
+    /**
+     * 串口误码率测试：devices 按 config 的波特率和 PRBS 同时发送 berDurationMs / berBytes，
+     * 结果写入对应 items 的 "ber"，未通过时 testResult 置为 NG
+     * @param flag 测试任务的中断标志，测试过程中检查，取消时所有端口按失败处理
+     * @return 所有端口都同步上、没有丢字节且误字节率不超过 berMaxErrorRate 返回 true
+     */
+    bool serial_ber(const SerialItem& config, const std::vector<std::string>& devices, const std::vector<Json::Value*>& items,
+                    const interrupt_flag& flag);
+
+    /**
+     * 多盘并发带宽测试：启用的 u 盘、pcie、tf 同时顺序读写，结果写入各项的 "concurrent"
+     * 和 testCase.concurrentBench 中
+     * @param flag 测试任务的中断标志，取消时还没开始的阶段跳过，对应的盘判为 NG
+     * @return 没有盘塌陷、都达到门限返回 true
+     */
+    bool storage_concurrent_bench(const StorageTestCase& testCase, Json::Value& store, Json::Value& summary, std::shared_ptr<RkGenericBoard> Board,
+                                  const interrupt_flag& flag);
+
+    /**
+     * 选择测速对象：协议给了 benchPath 就用它；emmc 在 /var/tmp 所在的文件系统在 emmc 上时用 /var/tmp，
+     * 否则用 emmc 上挂载了的分区，都不是返回空；
+     * tf / pcie / u 盘 (第 usbIndex 个) 挂载了用挂载点上的临时文件，没挂载只读测裸设备
+     */
+    std::string storage_bench_target(const StorageItem& config, TestItem type, size_t usbIndex, std::shared_ptr<RkGenericBoard> Board);
+
+    /**
+     * 补丁应答模式：请求 data 中带 "responseMode": "patch" 时，测试结果只回传相对请求的差异
+     * 应答 data 为 {"responseMode":"patch", "cmdIndex":请求索引, "type", "testFuncCode",
+     *             "patch":[操作...]}，补丁是 RFC 6902 操作数组，格式见 util/JsonPatch.h
+     */
+    struct PatchRequest {
+        uint16_t cmdIndex;
+        Json::Value data;                       // 原始请求 data
+    };
+
+    /* @return 请求开启了补丁模式时返回请求的副本，否则返回 nullptr (完整回传) */
+    std::shared_ptr<const PatchRequest> patchRequest(const Task& task);
+
+    /**
+     * 发送测试结果
+     * @param response 完整应答，patch 不为空时把 response["data"] 换成补丁
+     * @param patch patchRequest() 的返回值
+     */
+    void sendTestResult(Json::Value& response, const std::shared_ptr<const PatchRequest>& patch);
+
+    /**
+     * 存储测试的主体，在 submit_test 的任务线程中执行：容量探测、测速、校验、多盘并发，最后回传结果
+     * @param flag submit_test 登记的中断标志，取消时跳过剩下的测速 / 校验项，已经得到的结果照常回传
+     */
+    void storage_run(const StorageTestCase& testCase, Json::Value responseData,
+                     std::shared_ptr<const PatchRequest> patch, std::shared_ptr<RkGenericBoard> Board,
+                     interrupt_flag& flag);
+
+    /*
+     * 按键测试协程：等待按键事件直到 keyMap 中的按键全部按下或任务被取消
+     * @param itemCodes itemList 中每项的键值，下标与 itemList 相同
+     */
+    AsyncTask switchs_wait_keys(std::shared_ptr<RkGenericBoard> Board, std::shared_ptr<interrupt_flag> flag,
+                                uint16_t cmdIndex, std::map<int, std::string> keyMap, std::vector<int> itemCodes,
+                                Json::Value responseData, std::shared_ptr<const PatchRequest> patch);
+
+    // type-c 测试协程：等待 typec 插拔事件，先后检查正反两面枚举到的设备，60 秒超时
+    AsyncTask typec_wait_flip(std::shared_ptr<RkGenericBoard> Board, std::shared_ptr<interrupt_flag> flag,
+                              uint16_t cmdIndex, TypecGroupCase groups, Json::Value responseData,
+                              std::shared_ptr<const PatchRequest> patch);
+
+    /**
+     * testCase 解码失败：回复 ERROR_INVALID_PARAM，errorMsg 为出错字段的路径和原因
+     * @param error JsonDecodeContext::error()
+     */
+    void respondInvalidParam(const Task& task, const std::string& error);
+
     // 执行测试并发送结果
     void executeTestAndRespond(const Task& task, std::shared_ptr<RkGenericBoard> Board);
 
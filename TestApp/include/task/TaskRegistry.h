@@ -0,0 +1,115 @@
+#ifndef TASK_REGISTRY_H
+#define TASK_REGISTRY_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+
+#include "json/json.h"
+#include "util/Mutex.h"
+#include "util/theradpoolv1/thread_pool.h"
+
+// 任务状态
+enum TaskState {
+    TASK_STATE_QUEUED = 0,
+    TASK_STATE_RUNNING = 1,
+    TASK_STATE_DONE = 2,
+    TASK_STATE_CANCELLED = 3
+};
+
+/**
+ * 测试任务登记表，以 cmdIndex 为键
+ * 记录每个异步测试任务的状态、开始时间、进度和中断标志，
+ * 用于按 cmdIndex 取消任务以及上位机查询任务状态
+ */
+class TaskRegistry {
+public:
+    struct TaskRecord {
+        uint16_t cmdIndex;
+        std::string name;
+        TaskState state;
+        std::chrono::steady_clock::time_point startTime;    // 用于计算耗时
+        time_t startWallTime;                               // 上报给上位机
+        int progress;                                       // 0 - 100
+        std::shared_ptr<interrupt_flag> flag;
+    };
+
+    TaskRegistry() = default;
+    ~TaskRegistry() = default;
+
+    // 禁止拷贝
+    TaskRegistry(const TaskRegistry&) = delete;
+    TaskRegistry& operator=(const TaskRegistry&) = delete;
+
+    /**
+     * 登记一个新任务，状态为 QUEUED
+     * 若同一 cmdIndex 还有未结束的任务，先取消旧任务
+     * @param cmdIndex 命令索引
+     * @param name 测试项名称
+     * @return 该任务的中断标志，提交到线程池时使用
+     */
+    std::shared_ptr<interrupt_flag> add(uint16_t cmdIndex, const std::string& name);
+
+    /*
+     * 以下更新接口都带上 add() 返回的中断标志：cmdIndex 被新任务复用后，
+     * 被取消的旧任务仍会调用这些接口，标志不是当前记录的就忽略，不会改写新任务的状态
+     */
+    void markRunning(uint16_t cmdIndex, const interrupt_flag& flag);
+
+    /**
+     * 设置任务进度
+     * @param progress 0 - 100，超出范围会被截断
+     */
+    void setProgress(uint16_t cmdIndex, const interrupt_flag& flag, int progress);
+
+    // 任务结束，若已请求停止则记为 CANCELLED
+    void markDone(uint16_t cmdIndex, const interrupt_flag& flag);
+
+    /**
+     * 按 cmdIndex 取消任务
+     * @return 任务存在且未结束时返回 true
+     */
+    bool cancel(uint16_t cmdIndex);
+
+    // 取消所有未结束的任务
+    void cancelAll();
+
+    /**
+     * 登记常驻任务 (串口接收、任务处理线程、LED 闪烁等) 的中断标志
+     * 这些任务没有 cmdIndex，不出现在任务列表中，只在程序退出时由 shutdown() 停止
+     */
+    void addResident(const std::shared_ptr<interrupt_flag>& flag);
+
+    // 停止所有常驻任务并取消所有测试任务，程序退出时调用
+    void shutdown();
+
+    // 查询单个任务，不存在返回 false
+    bool get(uint16_t cmdIndex, TaskRecord& record);
+
+    /**
+     * 列出所有任务
+     * @return Json 数组，每项包含 cmdIndex/name/state/startTime/elapsedMs/progress
+     */
+    Json::Value list();
+
+    static const char* stateToString(TaskState state);
+
+private:
+    // 清理过多的已结束任务记录，调用者需持有锁
+    void prune();
+
+    // 查找 flag 对应的当前记录，cmdIndex 已被其他任务占用时返回 nullptr，调用者需持有锁
+    TaskRecord* find(uint16_t cmdIndex, const interrupt_flag& flag);
+
+    Mutex mutex_;
+    std::map<uint16_t, TaskRecord> tasks_;
+    std::vector<std::shared_ptr<interrupt_flag>> residents_;
+
+    static const size_t MAX_FINISHED_RECORDS = 32;
+    const char* TASK_REGISTRY_TAG = "TaskRegistry";
+};
+
+#endif // TASK_REGISTRY_H
@@ -0,0 +1,278 @@
+#ifndef TEST_CASE_H
+#define TEST_CASE_H
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "common/Constants.h"
+#include "util/JsonSchema.h"
+
+/**
+ * 各测试项 data.testCase 的类型化描述
+ * 处理函数开始时用 json_decode_member(task.data, "testCase", ...) 一次解码，出错回复 ERROR_INVALID_PARAM；
+ * 应答仍然是原请求加上 testResult / testValue，数组元素的下标和请求中的 itemList 等一一对应。
+ * 只描述处理函数用到的字段，其它字段原样回传。
+ */
+
+/* ---------------- storage ---------------- */
+
+struct StorageItem {
+    std::string name;                       // ddr / emmc / usb0 / usb_tf / facilityusb2(3.0) ...
+    bool enable = false;
+    double min = 0;
+    double max = 0;
+    int isVid = 0;                          // 工装 USB 设备的 VID / PID，协议中是字符串
+    int isPid = 0;
+
+    // 测速门限 (可选)，任一大于 0 时在容量检查之后跑 StorageBench
+    double minReadMBps = 0;                 // 顺序读
+    double minWriteMBps = 0;                // 顺序写，只读测试 (裸设备) 时不检查
+    double minRandIops = 0;                 // 4K 随机读
+    double maxLatencyUs = 0;                // 4K 随机读 p99 延迟
+    std::string benchPath;                  // 测速对象 (目录 / 块设备 / 文件)，为空时按存储类型选择
+    int benchSizeMB = 64;
+    int queueDepth = 32;                    // 4K 随机读的队列深度
+    double minConcurrentMBps = 0;           // 多盘并发测试时该盘的最低带宽
+    // ddr_bandwidth 项: 每个数组的大小 (共三个，远大于末级缓存)，门限 (GB/s) 为 0 不检查
+    int bandwidthSizeMB = 64;
+    double minCopyGBps = 0;
+    double minScaleGBps = 0;
+    double minAddGBps = 0;
+    double minTriadGBps = 0;
+    // ddr_memtest 项: 测试的内存大小和时间上限 (0 为只跑一遍，不限时)
+    int memtestSizeMB = 256;
+    int memtestDurationMs = 0;
+    int verifySizeMB = 0;                   // 写入后读回校验的区域大小，0 不做；在测速对象上进行
+    bool verifyRawDevice = false;           // 测速对象是裸设备时允许覆盖写 (破坏盘上数据)
+
+    bool benchEnabled() const {
+        return minReadMBps > 0 || minWriteMBps > 0 || minRandIops > 0 || maxLatencyUs > 0;
+    }
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_required("name", &StorageItem::name),
+                               json_optional("enable", &StorageItem::enable),
+                               json_optional("min", &StorageItem::min),
+                               json_optional("max", &StorageItem::max),
+                               json_optional("isVid", &StorageItem::isVid),
+                               json_optional("isPid", &StorageItem::isPid),
+                               json_optional("minReadMBps", &StorageItem::minReadMBps),
+                               json_optional("minWriteMBps", &StorageItem::minWriteMBps),
+                               json_optional("minRandIops", &StorageItem::minRandIops),
+                               json_optional("maxLatencyUs", &StorageItem::maxLatencyUs),
+                               json_optional("benchPath", &StorageItem::benchPath),
+                               json_optional("benchSizeMB", &StorageItem::benchSizeMB),
+                               json_optional("queueDepth", &StorageItem::queueDepth),
+                               json_optional("minConcurrentMBps", &StorageItem::minConcurrentMBps),
+                               json_optional("bandwidthSizeMB", &StorageItem::bandwidthSizeMB),
+                               json_optional("minCopyGBps", &StorageItem::minCopyGBps),
+                               json_optional("minScaleGBps", &StorageItem::minScaleGBps),
+                               json_optional("minAddGBps", &StorageItem::minAddGBps),
+                               json_optional("minTriadGBps", &StorageItem::minTriadGBps),
+                               json_optional("memtestSizeMB", &StorageItem::memtestSizeMB),
+                               json_optional("memtestDurationMs", &StorageItem::memtestDurationMs),
+                               json_optional("verifySizeMB", &StorageItem::verifySizeMB),
+                               json_optional("verifyRawDevice", &StorageItem::verifyRawDevice));
+    }
+};
+
+// 多盘并发带宽测试 (可选)：u 盘、pcie、tf 同时顺序读，检查每个盘分到的带宽
+struct StorageConcurrentCase {
+    bool enable = false;
+    bool write = false;                     // 只对挂载了的盘 (临时文件) 生效，裸设备总是只读
+    int durationMs = 3000;
+    int sizeMB = 256;
+    double collapseRatio = 0.5;             // 低于期望份额的比例判为塌陷，见 MultiDiskBench
+    double minAggregateMBps = 0;            // 并发总带宽下限，0 不检查
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_optional("enable", &StorageConcurrentCase::enable),
+                               json_optional("write", &StorageConcurrentCase::write),
+                               json_optional("durationMs", &StorageConcurrentCase::durationMs),
+                               json_optional("sizeMB", &StorageConcurrentCase::sizeMB),
+                               json_optional("collapseRatio", &StorageConcurrentCase::collapseRatio),
+                               json_optional("minAggregateMBps", &StorageConcurrentCase::minAggregateMBps));
+    }
+};
+
+struct StorageTestCase {
+    std::vector<StorageItem> store;
+    StorageConcurrentCase concurrentBench;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_required("store", &StorageTestCase::store),
+                               json_optional("concurrentBench", &StorageTestCase::concurrentBench));
+    }
+};
+
+/* ---------------- serial (232 / 485 / CAN) ---------------- */
+
+struct SerialItem {
+    bool enable = false;
+    std::string serialPath;                 // 为空时跳过该项
+    std::string serialName;                 // 包含 232 / 485 / CAN
+    int mode = 0;                           // 0 收集后一起测试，2 单独测试；协议中可能是字符串
+
+    // 误码率测试 (端口需要 TX 接 RX 回环)，berDurationMs 和 berBytes 都为 0 时不测
+    int berBaudRate = 115200;               // 最高 4000000，取决于串口驱动
+    int berPrbs = 15;                       // 15 或 23
+    int berDurationMs = 0;
+    int berBytes = 0;
+    double berMaxErrorRate = 0;             // 误字节率上限，另外丢字节 (失步) 一律判 NG
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_optional("enable", &SerialItem::enable),
+                               json_optional("serialPath", &SerialItem::serialPath),
+                               json_optional("serialName", &SerialItem::serialName),
+                               json_optional("mode", &SerialItem::mode),
+                               json_optional("berBaudRate", &SerialItem::berBaudRate),
+                               json_optional("berPrbs", &SerialItem::berPrbs),
+                               json_optional("berDurationMs", &SerialItem::berDurationMs),
+                               json_optional("berBytes", &SerialItem::berBytes),
+                               json_optional("berMaxErrorRate", &SerialItem::berMaxErrorRate));
+    }
+};
+
+struct SerialGroup {
+    std::vector<SerialItem> itemList;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_optional("itemList", &SerialGroup::itemList));
+    }
+};
+
+struct SerialTestCase {
+    bool enable = false;
+    std::vector<SerialGroup> groupList;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_optional("enable", &SerialTestCase::enable),
+                               json_optional("groupList", &SerialTestCase::groupList));
+    }
+};
+
+/* ---------------- switchs ---------------- */
+
+// 按键类型 "VOL-_114": 按键名 + '_' + 键值
+struct SwitchKey {
+    std::string name;
+    int code = -1;
+};
+
+bool json_decode_value(const Json::Value& value, SwitchKey& out, JsonDecodeContext& ctx);
+
+struct SwitchItem {
+    bool enable = false;
+    SwitchKey type;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_optional("enable", &SwitchItem::enable),
+                               json_required("type", &SwitchItem::type));
+    }
+};
+
+struct SwitchTestCase {
+    std::vector<SwitchItem> itemList;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_required("itemList", &SwitchTestCase::itemList));
+    }
+};
+
+/* ---------------- typec ---------------- */
+
+struct TypecItem {
+    std::string name;                       // 包含 2.0 / 3.0，其它的不检查
+    int vid = -1;                           // 协议中是字符串，缺少时不会匹配任何设备
+    int pid = -1;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_required("name", &TypecItem::name),
+                               json_optional("vid", &TypecItem::vid),
+                               json_optional("pid", &TypecItem::pid));
+    }
+};
+
+struct TypecGroup {
+    std::string type;                       // positive / negative
+    std::vector<TypecItem> itemList;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_required("type", &TypecGroup::type),
+                               json_optional("itemList", &TypecGroup::itemList));
+    }
+};
+
+struct TypecGroupCase {
+    std::vector<TypecGroup> groupList;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_required("groupList", &TypecGroupCase::groupList));
+    }
+};
+
+struct TypecGroupData {
+    TypecGroupCase testCase;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_required("testCase", &TypecGroupData::testCase));
+    }
+};
+
+// data.testCase.groupData.testCase.groupList
+struct TypecTestCase {
+    TypecGroupData groupData;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_required("groupData", &TypecTestCase::groupData));
+    }
+};
+
+/* ---------------- camera ---------------- */
+
+struct CameraTestCase {
+    bool enable = true;                     // 没有 enable 字段时测试
+    std::string cameraId;                   // 协议中是数字，对应 cameraidToInfo 中的 "cam" + cameraId
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_optional("enable", &CameraTestCase::enable),
+                               json_required("cameraId", &CameraTestCase::cameraId));
+    }
+};
+
+/* ---------------- common (adc 等范围测试) ---------------- */
+
+struct CommonRangeCase {
+    std::string name;
+    bool enable = false;
+    double min = 0;
+    double max = 0;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_required("name", &CommonRangeCase::name),
+                               json_optional("enable", &CommonRangeCase::enable),
+                               json_optional("min", &CommonRangeCase::min),
+                               json_optional("max", &CommonRangeCase::max));
+    }
+};
+
+struct CommonTestCase {
+    bool enable = true;
+    std::vector<CommonRangeCase> rangeCaseList;
+
+    static constexpr auto json_fields() {
+        return std::make_tuple(json_optional("enable", &CommonTestCase::enable),
+                               json_optional("rangeCaseList", &CommonTestCase::rangeCaseList));
+    }
+};
+
+#endif // TEST_CASE_H
+
+/*
+ * @description: v1 storage / serial / switchs / typec / camera / common 测试参数的字段描述
+ * @Date: 2026-10-19
+ *
+ * @description: v2 ddr_bandwidth 的数组大小改用单独的 bandwidthSizeMB，不再和存储测速共用 benchSizeMB
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,203 @@
+#ifndef __ASYNC_WAIT_H__
+#define __ASYNC_WAIT_H__
+
+#include <chrono>
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/Reactor.h"
+#include "util/TimerWheel.h"
+#include "util/theradpoolv1/thread_pool.h"
+
+// 异步等待结果
+enum AsyncWaitResult {
+    ASYNC_WAIT_READY = 0,          // fd 可读写 / 收到 udev 事件
+    ASYNC_WAIT_TIMEOUT = 1,        // 超时，sleep_for 正常结束也返回该值
+    ASYNC_WAIT_CANCELLED = 2,      // 中断标志被置位
+    ASYNC_WAIT_ERROR = 3
+};
+
+struct udev;
+struct udev_monitor;
+
+/*
+ * 不关心结果的协程 (fire-and-forget)，交互式测试写成协程，等待处用 co_await
+ * 调用后立即执行到第一个 co_await，之后在 reactor 线程中恢复，协程结束时自动释放协程帧
+ * 协程的参数会拷贝到协程帧中，不要传引用
+ */
+struct AsyncTask {
+    struct promise_type {
+        AsyncTask get_return_object() noexcept { return AsyncTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept;
+    };
+};
+
+/*
+ * 把 AsyncWaiter 的回调接口包装成 awaitable，co_await 的结果为回调的参数
+ * 回调在 reactor 线程中恢复协程，可能早于 await_suspend 返回，发起等待之后不能再访问成员
+ */
+template <typename T>
+class AsyncAwaitable {
+public:
+    using starter = std::function<void(std::function<void(T)>)>;
+
+    explicit AsyncAwaitable(starter start) : start_(std::move(start)), value_() {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        starter start = std::move(start_);
+        start([this, handle](T value) {
+            value_ = std::move(value);
+            handle.resume();
+        });
+    }
+
+    T await_resume() { return std::move(value_); }
+
+private:
+    starter start_;
+    T value_;
+};
+
+/*
+ * udev 事件监听，构造时开始接收，析构时关闭
+ * 先创建监听再检查设备状态，检查和等待之间发生的事件会留在 socket 中，不会漏掉
+ */
+class UdevMonitor {
+public:
+    /**
+     * @param subsystem 子系统，如 "usb" "block" "typec"
+     * @param devtype 设备类型，可为 nullptr
+     */
+    UdevMonitor(const char* subsystem, const char* devtype);
+    ~UdevMonitor();
+
+    UdevMonitor(const UdevMonitor&) = delete;
+    UdevMonitor& operator=(const UdevMonitor&) = delete;
+
+    bool is_open() const { return monitor_ != nullptr; }
+    int fd() const;
+
+    // 读取一个事件，没有待读的事件返回 false
+    bool receive(std::string& action, std::string& devnode);
+
+private:
+    struct udev* udev_;
+    struct udev_monitor* monitor_;
+};
+
+/**
+ * 基于 Reactor 和 TimerWheel 的异步等待
+ * 交互式测试 (按键、type-c 插拔等) 等待期间不占用线程，等待完成后在 reactor 线程中回调，
+ * 每种等待都有回调和协程 (不带回调，返回 awaitable) 两个版本，测试逻辑写成 AsyncTask 协程。
+ * 回调里不要做阻塞操作，阻塞的探测 (lsusb 等) 通过 run_blocking 放到线程池执行。
+ * 中断标志每 CANCEL_CHECK_MS 检查一次，任务被取消后尽快回调 ASYNC_WAIT_CANCELLED。
+ * 发起等待时线程的日志 cmdIndex 会带到回调中，续体链中的日志仍然关联到同一个测试。
+ */
+class AsyncWaiter {
+public:
+    using wait_callback = std::function<void(AsyncWaitResult result, int fd)>;
+    using udev_callback = std::function<void(AsyncWaitResult result, const std::string& action, const std::string& devnode)>;
+
+    struct fd_event {
+        AsyncWaitResult result;
+        int fd;                                 // 就绪的文件描述符，非 READY 时为 -1
+    };
+
+    struct udev_event {
+        AsyncWaitResult result;
+        std::string action;                     // "add" / "remove" / "change" ...
+        std::string devnode;                    // 设备节点，可能为空
+    };
+
+    AsyncWaiter(Reactor& reactor, TimerWheel& wheel);
+
+    /**
+     * 等待一组 fd 中任意一个就绪
+     * @param fds 文件描述符，生命周期由调用者管理，等待期间不能注册到其它地方
+     * @param events EPOLLIN / EPOLLOUT 等
+     * @param timeout_ms 超时时间，小于 0 表示一直等待
+     * @param flag 中断标志，可为空
+     * @param callback 回调，fd 为就绪的文件描述符，非 READY 时为 -1
+     */
+    void wait_fds(const std::vector<int>& fds, uint32_t events, int timeout_ms,
+                  std::shared_ptr<interrupt_flag> flag, wait_callback callback);
+
+    void wait_fd(int fd, uint32_t events, int timeout_ms,
+                 std::shared_ptr<interrupt_flag> flag, wait_callback callback);
+
+    // 定时等待，到时回调 ASYNC_WAIT_TIMEOUT，被取消回调 ASYNC_WAIT_CANCELLED
+    void sleep_for(int timeout_ms, std::shared_ptr<interrupt_flag> flag,
+                   std::function<void(AsyncWaitResult result)> callback);
+
+    /**
+     * 等待 monitor 上的一个 udev 事件，monitor 在等待期间必须有效
+     * @param callback 回调 action ("add" / "remove" ...) 和设备节点 (可能为空)
+     */
+    void wait_udev(UdevMonitor& monitor, int timeout_ms, std::shared_ptr<interrupt_flag> flag,
+                   udev_callback callback);
+
+    /**
+     * 等待外部通知，把订阅类接口 (DeviceRegistry::subscribe 等) 接到超时和取消上
+     * @return notify，在 reactor 线程中调用时以 ASYNC_WAIT_READY 结束等待，等待结束后再调用无效
+     */
+    std::function<void()> wait_notify(int timeout_ms, std::shared_ptr<interrupt_flag> flag,
+                                      std::function<void(AsyncWaitResult result)> callback);
+
+    // 投递到 reactor 线程执行
+    void post(std::function<void()> fn);
+
+    // 在线程池中执行阻塞操作，完成后在 reactor 线程中回调 done
+    void run_blocking(thread_pool& pool, std::function<void()> work, std::function<void()> done);
+
+    // 协程版本，co_await 之后在 reactor 线程中继续执行
+    AsyncAwaitable<fd_event> wait_fds(const std::vector<int>& fds, uint32_t events, int timeout_ms,
+                                      std::shared_ptr<interrupt_flag> flag);
+    AsyncAwaitable<AsyncWaitResult> sleep_for(int timeout_ms, std::shared_ptr<interrupt_flag> flag);
+    AsyncAwaitable<udev_event> wait_udev(UdevMonitor& monitor, int timeout_ms, std::shared_ptr<interrupt_flag> flag);
+    AsyncAwaitable<AsyncWaitResult> run_blocking(thread_pool& pool, std::function<void()> work);         // 结果总是 READY
+
+private:
+    struct wait_op {
+        std::vector<int> fds;
+        int timeout_ms;
+        TimerWheel::timer_id deadline_timer;    // 超时定时器
+        TimerWheel::timer_id cancel_timer;      // 周期检查中断标志
+        std::shared_ptr<interrupt_flag> flag;
+        wait_callback callback;
+        bool done;
+        int log_cmd_index;                      // 发起等待时的日志 cmdIndex
+    };
+
+    void arm(std::shared_ptr<wait_op> op, uint32_t events);
+    void finish(std::shared_ptr<wait_op> op, AsyncWaitResult result, int fd);
+
+    Reactor& reactor_;
+    TimerWheel& wheel_;
+
+    static const int CANCEL_CHECK_MS = 200;
+    const char* ASYNC_WAIT_TAG = "AsyncWait";
+};
+
+#endif // __ASYNC_WAIT_H__
+
+/*
+ * @description: v1 基于 reactor 的异步等待，交互式测试等待期间不占用线程
+ * @Date: 2026-10-19 *
+ * @description: v2 超时和取消检查改用共享的 TimerWheel，不再每次等待创建 timerfd
+ * @Date: 2026-10-19 *
+ * @description: v3 回调中恢复发起等待时的日志 cmdIndex
+ * @Date: 2026-10-19 *
+ * @description: v4 增加 AsyncTask 协程和各等待的 awaitable 版本，udev 等待改用常驻的 UdevMonitor
+ * @Date: 2026-10-19 *
+ * @description: v5 增加 wait_notify，等待由外部回调结束
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,22 @@
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * CLOCK_MONOTONIC 的纳秒数，日志、时间轮、测速和内存测试共用的时间基准
+ * 和 std::chrono::steady_clock 是同一个时钟，两边得到的时间可以直接比较
+ */
+inline uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif // __CLOCK_H__
+
+/*
+ * @description: v1 单调时钟纳秒数，替换各文件里各自的 now_ns / monotonic_ns
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,211 @@
+#ifndef JSON_DOM_H
+#define JSON_DOM_H
+
+#include "json/json.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * 请求 / 应答热路径用的紧凑 JSON DOM
+ * jsoncpp 每个值一次堆分配、对象成员是 std::map；这里所有节点和字符串都从 JsonArena 分配，
+ * 一帧处理完 clear() 后内存留给下一帧复用，稳定运行时不再 malloc。
+ *   - 节点固定 16 字节，不超过 14 字节的字符串 (绝大多数 key 和值) 直接存在节点内
+ *   - 对象成员是按 key 排序的连续数组，二分查找；排序规则和 jsoncpp 相同，输出的 key 顺序一致
+ * 边界上用 from_value / to_value 和 Json::Value 互相转换，处理函数可以逐步迁移
+ */
+
+class JsonArena {
+public:
+    explicit JsonArena(size_t block_size = 4096);
+    ~JsonArena();
+
+    JsonArena(const JsonArena&) = delete;
+    JsonArena& operator=(const JsonArena&) = delete;
+
+    void* allocate(size_t size, size_t align = 8);
+
+    // 释放所有分配，内存块保留下次复用
+    void reset();
+
+    size_t used() const;                    // 已分配的字节数
+    size_t reserved() const;                // 向系统申请的字节数
+
+private:
+    struct block {
+        block* next;
+        size_t size;
+    };
+
+    size_t block_size_;
+    block* head_;                           // 所有内存块
+    block* current_;                        // 正在分配的内存块
+    size_t offset_;                         // current_ 中的分配位置
+    size_t used_;                           // current_ 之前的块已分配的字节数
+};
+
+struct JsonMember;
+
+class JsonNode {
+public:
+    enum Type : uint8_t {
+        NULL_VALUE = 0,
+        BOOL_VALUE,
+        INT_VALUE,                          // int64，负数或不超过 INT64_MAX 的整数
+        UINT_VALUE,                         // 超过 INT64_MAX 的整数
+        REAL_VALUE,
+        STRING_VALUE,
+        ARRAY_VALUE,
+        OBJECT_VALUE
+    };
+
+    static const size_t SHORT_STRING_MAX = 14;
+
+    JsonNode() { set_null(); }
+
+    Type type() const { return (Type)small_.type; }
+    bool is_null() const { return type() == NULL_VALUE; }
+    bool is_bool() const { return type() == BOOL_VALUE; }
+    bool is_number() const { return type() == INT_VALUE || type() == UINT_VALUE || type() == REAL_VALUE; }
+    bool is_string() const { return type() == STRING_VALUE; }
+    bool is_array() const { return type() == ARRAY_VALUE; }
+    bool is_object() const { return type() == OBJECT_VALUE; }
+
+    // 和 Json::Value::asXxx 一样做宽松转换，类型不匹配时返回 0 / false / 空串
+    bool as_bool() const;
+    int as_int() const { return (int)as_int64(); }
+    int64_t as_int64() const;
+    uint64_t as_uint64() const;
+    double as_double() const;
+    std::string as_string() const;
+
+    // 字符串内容，不以 '\0' 结尾
+    const char* str() const;
+    size_t str_size() const;
+    bool equals(const char* str, size_t size) const;
+
+    // 数组元素个数 / 对象成员个数
+    size_t size() const;
+
+    // 数组元素，越界返回 null 节点
+    const JsonNode& operator[](size_t index) const;
+    const JsonNode& operator[](int index) const { return (*this)[(size_t)index]; }
+
+    // 对象成员，不存在返回 null 节点 / nullptr
+    const JsonNode& operator[](const char* key) const;
+    const JsonNode* find(const char* key, size_t size) const;
+    const JsonNode* find(const char* key) const;
+
+    // 按 key 顺序访问对象成员
+    const JsonMember& member(size_t index) const;
+
+    static const JsonNode& null_node();
+
+private:
+    friend class JsonDocument;
+
+    static const uint8_t LONG_STRING = 0xff;
+
+    void set_null() {
+        large_.type = NULL_VALUE;
+        large_.string_kind = 0;
+        large_.reserved = 0;
+        large_.size = 0;
+        large_.u = 0;
+    }
+
+    // 两种布局的第一个字节都是类型
+    struct short_layout {
+        uint8_t type;
+        uint8_t size;                       // 短字符串长度，LONG_STRING 表示长字符串
+        char chars[SHORT_STRING_MAX];
+    };
+    struct long_layout {
+        uint8_t type;
+        uint8_t string_kind;                // 和 short_layout::size 重叠
+        uint16_t reserved;
+        uint32_t size;                      // 长字符串长度 / 数组元素个数 / 对象成员个数
+        union {
+            bool b;
+            int64_t i;
+            uint64_t u;
+            double d;
+            const char* str;
+            JsonNode* items;
+            JsonMember* members;
+        };
+    };
+
+    union {
+        short_layout small_;
+        long_layout large_;
+    };
+};
+
+struct JsonMember {
+    JsonNode key;                           // 总是字符串
+    JsonNode value;
+};
+
+class JsonDocument {
+public:
+    explicit JsonDocument(size_t arena_block = 4096);
+
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    /**
+     * 解析 JSON 文本，之前的内容全部释放
+     * @param data JSON 文本，不需要以 '\0' 结尾，末尾的空白和 '\0' 会被忽略
+     * @param size 长度
+     * @return 是否解析成功，失败时 error() 返回原因
+     */
+    bool parse(const char* data, size_t size);
+    bool parse(const std::string& text) { return parse(text.data(), text.size()); }
+
+    /* @brief 从 Json::Value 转换，之前的内容全部释放 */
+    void from_value(const Json::Value& value);
+
+    /* @brief 转换为 Json::Value */
+    static void to_value(const JsonNode& node, Json::Value& value);
+
+    /**
+     * 紧凑格式输出，追加到 out
+     * 转义规则、浮点数格式和 jsoncpp 默认的 StreamWriterBuilder 相同 (非 ASCII 字符输出为 \uXXXX)
+     */
+    static void write(const JsonNode& node, std::string& out);
+    void write(std::string& out) const { write(root_, out); }
+
+    const JsonNode& root() const { return root_; }
+    const JsonNode& operator[](const char* key) const { return root_[key]; }
+
+    const std::string& error() const { return error_; }
+
+    // 释放所有节点，内存留给下一次复用
+    void clear();
+
+    const JsonArena& arena() const { return arena_; }
+
+private:
+    class parser;
+
+    JsonNode* copy_nodes(const JsonNode* nodes, size_t count);
+    JsonMember* copy_members(JsonMember* members, size_t& count);     // 排序去重，count 返回去重后的个数
+    void set_string(JsonNode& node, const char* str, size_t size);
+    void convert(const Json::Value& value, JsonNode& node);
+
+    JsonArena arena_;
+    JsonNode root_;
+    std::string error_;
+    std::vector<JsonNode> node_stack_;      // 解析 / 转换时暂存数组元素和对象成员，复用避免分配
+    std::vector<JsonMember> member_stack_;
+    std::string scratch_;                   // 解析带转义的字符串
+};
+
+#endif // JSON_DOM_H
+
+/*
+ * @description: v1 arena 分配的紧凑 JSON DOM，可以和 Json::Value 互相转换
+ * @Date: 2026-10-19
+ */
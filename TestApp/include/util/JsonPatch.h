@@ -0,0 +1,51 @@
+#ifndef JSON_PATCH_H
+#define JSON_PATCH_H
+
+#include "json/json.h"
+
+/**
+ * 两个 Json::Value 之间的差异补丁，用于只回传测试结果
+ * 格式是 JSON Patch (RFC 6902) 的操作数组，每个操作显式标明类型，null 值和类型变化都能准确还原:
+ *   - 对象: 新增的成员 add，删除的成员 remove，修改的成员递归 (对象 / 等长数组) 或 replace
+ *   - 数组: 长度不变时只对变化的元素递归，长度变化时整个数组 replace
+ *   - 其它: replace (path 为 "" 时替换整个文档)
+ * 例: 请求 {"store":[{"name":"ddr"},{"name":"emmc"}]}
+ *     应答 {"store":[{"name":"ddr","testResult":"OK"},{"name":"emmc"}]}
+ *     补丁 [{"op":"add","path":"/store/0/testResult","value":"OK"}]
+ */
+
+/**
+ * 计算 base -> target 的补丁
+ * @param patch 输出，操作追加到数组末尾 (非数组时先置为空数组)，没有差异时不修改
+ * @return 有差异返回 true
+ */
+bool json_diff(const Json::Value& base, const Json::Value& target, Json::Value& patch);
+
+/**
+ * 按顺序把补丁中的操作应用到 doc (上位机还原完整应答的参考实现)
+ * 支持 add / remove / replace / move，不支持 copy / test
+ * @return 操作格式错误或路径不存在时返回 false，此前的操作已经生效
+ */
+bool json_patch_apply(Json::Value& doc, const Json::Value& patch);
+
+/**
+ * 按 JSON Pointer (RFC 6901) 查找，如 "/testCase/groupData/testCase"、"/store/0"
+ * @return 不存在返回 nullptr
+ */
+const Json::Value* json_pointer_find(const Json::Value& doc, const char* pointer);
+
+/**
+ * 把 from 处的值移动到 to (RFC 6902 move)，from 处删除 (to 的父节点必须存在)，from 可以是 to 的子节点
+ * to 为数组下标时插入到该位置，"-" 追加到末尾
+ * @return from 或 to 的父节点不存在返回 false (to 的父节点不存在时 from 已经删除)
+ */
+bool json_pointer_move(Json::Value& doc, const char* from, const char* to);
+
+#endif // JSON_PATCH_H
+
+/*
+ * @description: v1 merge patch 风格的差异补丁，带数组下标和 JSON Pointer 移动
+ * @Date: 2026-10-19 *
+ * @description: v2 补丁改为 RFC 6902 操作数组，显式的 null 和数组变对象不再被误读
+ * @Date: 2026-10-19
+ */
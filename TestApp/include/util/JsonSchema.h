@@ -0,0 +1,160 @@
+#ifndef JSON_SCHEMA_H
+#define JSON_SCHEMA_H
+
+#include "json/json.h"
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/**
+ * 按编译期字段描述把 Json::Value 解码为普通结构体
+ * 结构体提供 static constexpr auto json_fields()，返回 json_required / json_optional 组成的 tuple:
+ *
+ *     struct RangeCase {
+ *         std::string name;
+ *         double min = 0;
+ *         static constexpr auto json_fields() {
+ *             return std::make_tuple(json_required("name", &RangeCase::name),
+ *                                    json_optional("min", &RangeCase::min));
+ *         }
+ *     };
+ *
+ * 每个字段只查找一次，数字 / 布尔值直接写入成员；缺少可选字段时保留成员的默认值。
+ * 出错时停止解码，error() 给出出错字段的完整路径，如 "data.testCase.store[3].max: expected number"。
+ * 其它类型 (如 "VOL-_114" 这样的组合字段) 提供 json_decode_value 重载即可。
+ */
+
+class JsonDecodeContext {
+public:
+    /* @param root 错误信息中根节点的名字 */
+    explicit JsonDecodeContext(const char* root = "data");
+
+    bool failed() const { return failed_; }
+    const std::string& error() const { return error_; }
+
+    // 记录错误 (只保留第一个)，总是返回 false
+    bool fail(const char* message);
+
+    // 进入 / 离开对象成员或数组元素，只保存指针和下标，出错时才拼接路径
+    void push(const char* key) { path_.push_back({key, 0}); }
+    void push(size_t index) { path_.push_back({nullptr, index}); }
+    void pop() { path_.pop_back(); }
+
+private:
+    struct path_item {
+        const char* key;                    // nullptr 表示数组下标
+        size_t index;
+    };
+
+    const char* root_;
+    std::vector<path_item> path_;
+    bool failed_;
+    std::string error_;
+};
+
+template <class T, class M>
+struct JsonField {
+    const char* name;
+    M T::*member;
+    bool required;
+};
+
+template <class T, class M>
+constexpr JsonField<T, M> json_required(const char* name, M T::*member) {
+    return JsonField<T, M>{name, member, true};
+}
+
+template <class T, class M>
+constexpr JsonField<T, M> json_optional(const char* name, M T::*member) {
+    return JsonField<T, M>{name, member, false};
+}
+
+/*
+ * 基本类型，和协议里的实际数据一致做少量兼容:
+ *   int / double 也接受数字字符串 ("mode": "0"、"isVid": "2")，int 接受整数值的浮点数
+ *   bool 也接受 0 / 1
+ *   string 也接受整数 ("cameraId": 1)
+ */
+bool json_decode_value(const Json::Value& value, bool& out, JsonDecodeContext& ctx);
+bool json_decode_value(const Json::Value& value, int& out, JsonDecodeContext& ctx);
+bool json_decode_value(const Json::Value& value, double& out, JsonDecodeContext& ctx);
+bool json_decode_value(const Json::Value& value, std::string& out, JsonDecodeContext& ctx);
+
+template <class T>
+auto json_decode_value(const Json::Value& value, T& out, JsonDecodeContext& ctx)
+    -> decltype(T::json_fields(), bool());
+
+template <class T>
+bool json_decode_value(const Json::Value& value, std::vector<T>& out, JsonDecodeContext& ctx) {
+    if (!value.isArray()) {
+        return ctx.fail("expected array");
+    }
+    out.clear();
+    out.resize(value.size());
+    for (Json::ArrayIndex i = 0; i < value.size(); ++i) {
+        ctx.push((size_t)i);
+        if (!json_decode_value(value[i], out[i], ctx)) {
+            return false;
+        }
+        ctx.pop();
+    }
+    return true;
+}
+
+// 查找并解码一个成员，出错时保留路径
+template <class M>
+bool json_decode_key(const Json::Value& object, const char* key, bool required, M& out, JsonDecodeContext& ctx) {
+    const Json::Value* member = object.find(key, key + strlen(key));
+    ctx.push(key);
+    if (member == nullptr || member->isNull()) {
+        if (required) {
+            return ctx.fail("missing");
+        }
+        ctx.pop();
+        return true;
+    }
+    if (!json_decode_value(*member, out, ctx)) {
+        return false;
+    }
+    ctx.pop();
+    return true;
+}
+
+template <class T, class M>
+bool json_decode_field(const Json::Value& object, T& out, const JsonField<T, M>& field, JsonDecodeContext& ctx) {
+    return json_decode_key(object, field.name, field.required, out.*field.member, ctx);
+}
+
+template <class T>
+auto json_decode_value(const Json::Value& value, T& out, JsonDecodeContext& ctx)
+    -> decltype(T::json_fields(), bool()) {
+    if (!value.isObject()) {
+        return ctx.fail("expected object");
+    }
+    bool ok = true;
+    std::apply([&](const auto&... field) {
+        ((ok = ok && json_decode_field(value, out, field, ctx)), ...);
+    }, T::json_fields());
+    return ok;
+}
+
+/**
+ * 解码 object 的 key 成员
+ * @return 成功返回 true，失败时 ctx.error() 给出原因
+ */
+template <class T>
+bool json_decode_member(const Json::Value& object, const char* key, T& out, JsonDecodeContext& ctx) {
+    if (!object.isObject()) {
+        return ctx.fail("expected object");
+    }
+    return json_decode_key(object, key, true, out, ctx);
+}
+
+#endif // JSON_SCHEMA_H
+
+/*
+ * @description: v1 编译期字段描述的 JSON 解码
+ * @Date: 2026-10-19
+ */
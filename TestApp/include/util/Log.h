@@ -3,7 +3,9 @@
 
 #include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <stdint.h>
 
 enum LogLevel {
     LOG_LEVEL_DEBUG = 0,
@@ -14,14 +16,89 @@ enum LogLevel {
 
 const LogLevel defaultLogLevel = LOG_LEVEL_DEBUG;
 
-std::string get_current_time();
+/*
+ * 编译期日志级别 (0 DEBUG ~ 3 ERROR)，低于该级别的日志调用连同参数求值在编译时去掉
+ * 发布版本: make LOG_LEVEL=1 去掉所有 DEBUG 日志
+ * 运行时级别 (SetLogLevel) 只能在编译期级别之上再过滤
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+// printf 格式检查，参数类型和格式串不一致时编译告警
+#define LOG_FORMAT_CHECK(format_index, args_index) __attribute__((format(printf, format_index, args_index)))
 
-void LogDebug(const char* TAG, const char* format, ...);
-void LogInfo(const char* TAG, const char* format, ...);
-void LogWarn(const char* TAG, const char* format, ...);
-void LogError(const char* TAG, const char* format, ...);
+std::string get_current_time();
 
 void log_output_str(LogLevel level, const char* TAG, const std::string& msg);
-void log_thread_safe(LogLevel level, const char* TAG, const char* format, ...);
+
+/*
+ * 日志只记录到当前线程的环形缓冲区，由后台日志线程格式化输出
+ * format 和 TAG 只保存指针，必须是字符串常量 (或整个程序运行期间都有效)，%s 参数会被拷贝
+ * 不要直接调用，使用下面的 log_thread_safe / LogDebug ... 宏
+ */
+void log_printf(LogLevel level, const char* TAG, const char* format, ...) LOG_FORMAT_CHECK(3, 4);
+
+/*
+ * 日志入口
+ * level 是常量时条件在编译期确定，低于 LOG_COMPILE_LEVEL 的调用和参数求值都不会生成代码
+ */
+#define log_thread_safe(level, TAG, ...)                                    \
+    do {                                                                    \
+        if ((int)(level) >= LOG_COMPILE_LEVEL) {                            \
+            log_printf((level), (TAG), __VA_ARGS__);                        \
+        }                                                                   \
+    } while (0)
+
+#define LogDebug(TAG, ...) log_thread_safe(LOG_LEVEL_DEBUG, TAG, __VA_ARGS__)
+#define LogInfo(TAG, ...)  log_thread_safe(LOG_LEVEL_INFO, TAG, __VA_ARGS__)
+#define LogWarn(TAG, ...)  log_thread_safe(LOG_LEVEL_WARN, TAG, __VA_ARGS__)
+#define LogError(TAG, ...) log_thread_safe(LOG_LEVEL_ERROR, TAG, __VA_ARGS__)
+
+// TAG 的 id (FNV-1a)，TAG 是常量时在编译期计算，如 constexpr uint32_t id = log_tag_id("STORAGE");
+constexpr uint32_t log_tag_id(const char* tag, uint32_t hash = 2166136261u) {
+    return *tag ? log_tag_id(tag + 1, (hash ^ (uint8_t)*tag) * 16777619u) : hash;
+}
+
+/*
+ * 按 TAG 设置运行时日志级别，比如只打开 STORAGE 的 DEBUG 日志
+ * 没有设置过时写日志不计算 TAG id，不增加开销
+ */
+void log_set_tag_level(const char* TAG, LogLevel level);
+void log_set_tag_level(uint32_t tag_id, LogLevel level);
+
+// 等待已写入的日志全部输出，程序退出时会自动调用
+void log_flush();
+
+class LogSink;
+
+// 增加日志输出端 (见 util/LogSink.h)，默认只有控制台
+void log_add_sink(std::shared_ptr<LogSink> sink);
+
+// 打开 / 关闭控制台输出
+void log_enable_console(bool enable);
+
+/*
+ * 日志关联的 cmdIndex (线程局部)，结构化日志据此把同一个测试的日志串起来
+ * 由 TaskHandler 处理命令、任务线程池执行测试、AsyncWaiter 回调时设置，-1 表示没有关联
+ */
+int log_cmd_index();
+void log_set_cmd_index(int cmdIndex);
+
+// 作用域内设置当前线程的 cmdIndex，退出时恢复
+class LogCmdScope {
+public:
+    explicit LogCmdScope(int cmdIndex) : previous_(log_cmd_index()) { log_set_cmd_index(cmdIndex); }
+    ~LogCmdScope() { log_set_cmd_index(previous_); }
+
+    LogCmdScope(const LogCmdScope&) = delete;
+    LogCmdScope& operator=(const LogCmdScope&) = delete;
+
+private:
+    int previous_;
+};
+
+// 设置板卡 LN (写入 vendor storage 的序列号)，之后的结构化日志都带上该字段
+void log_set_ln(const std::string& ln);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,115 @@
+#ifndef __LOG_PERSIST_H__
+#define __LOG_PERSIST_H__
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/LogSink.h"
+
+/**
+ * 掉电 / 崩溃后仍能找回最后日志的持久化环形缓冲区
+ * 固定大小的文件 mmap(MAP_SHARED) 到内存，后台日志线程用普通内存拷贝写入，不调用 write / fsync：
+ *   进程崩溃、被 kill 时数据已经在页缓存里，不会丢；
+ *   掉电时只丢最近还没回写的部分，每隔 writeback_ms (或出现 WARN / ERROR) 用 sync_file_range
+ *   发起异步回写，不等待完成，写日志的线程完全不受影响。
+ * 每条记录带 magic、序号和 CRC，恢复时扫描整个文件找出有效记录按序号排序，
+ * 头部的写位置丢失或记录写了一半都不影响其它记录。
+ * 程序重新启动后接着上次的序号写，旧记录被覆盖前都可以用 log_recover 工具导出。
+ */
+class PersistentLogSink : public LogSink {
+public:
+    /**
+     * @param path 环形缓冲区文件，大小不一致时重新创建
+     * @param size 文件大小 (字节)
+     * @param writeback_ms 发起异步回写的间隔
+     */
+    PersistentLogSink(const std::string& path, size_t size = 4 * 1024 * 1024, int writeback_ms = 1000);
+    ~PersistentLogSink();
+
+    PersistentLogSink(const PersistentLogSink&) = delete;
+    PersistentLogSink& operator=(const PersistentLogSink&) = delete;
+
+    bool is_open() const { return data_ != nullptr; }
+    const std::string& path() const { return path_; }
+
+    void write(const LogEntry& entry) override;
+    void flush() override;
+    void poll() override;
+
+    struct record {
+        uint64_t seq;                   // 全局递增序号
+        uint32_t run;                   // 第几次运行，同一次运行的日志 run 相同
+        std::string line;               // 日志行，含结尾的 '\n'
+    };
+
+    /**
+     * 从环形缓冲区文件中恢复日志
+     * @param path 文件路径
+     * @param records 按序号排列的有效记录
+     * @return 文件格式正确返回 true
+     */
+    static bool recover(const std::string& path, std::vector<record>& records);
+
+private:
+    static const uint32_t FILE_MAGIC = 0x474c505a;          // "ZPLG"
+    static const uint32_t FILE_VERSION = 1;
+    static const uint32_t RECORD_MAGIC = 0xa55a5aa5;
+    static const size_t HEADER_SIZE = 4096;
+
+    struct file_header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t size;                  // 文件大小
+        uint32_t run;                   // 最近一次运行的编号
+        uint32_t reserved;
+        uint64_t write_offset;          // 只作提示，恢复时不依赖
+    };
+
+    struct record_header {
+        uint32_t magic;
+        uint16_t length;                // 日志行长度
+        uint16_t crc;                   // seq / run / 日志行 的 CRC16
+        uint64_t seq;
+        uint32_t run;
+        uint32_t reserved;
+    };
+
+    struct found_record {
+        uint64_t seq;
+        uint32_t run;
+        size_t offset;                  // 在记录区中的偏移
+        size_t size;                    // 记录占用的大小
+    };
+
+    static uint16_t record_crc(const record_header* header);
+    static size_t record_size(size_t length);
+    static void scan(const uint8_t* area, size_t capacity, std::vector<found_record>& found);
+    bool open_file();
+    void writeback();
+
+    std::string path_;
+    size_t size_;
+    uint64_t writeback_ns_;
+
+    int fd_;
+    uint8_t* data_;                     // 整个文件的映射
+    size_t capacity_;                   // 记录区大小
+    size_t offset_;                     // 记录区中的写位置
+    uint64_t seq_;
+    uint32_t run_;
+
+    std::string line_;
+    bool urgent_;
+    size_t dirty_begin_;                // 还没有发起回写的范围 (文件偏移)
+    size_t dirty_end_;
+    uint64_t last_writeback_;
+};
+
+#endif // __LOG_PERSIST_H__
+
+/*
+ * @description: v1 mmap 持久化日志环形缓冲区，断电 / 崩溃后用 log_recover 导出最后的日志
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,78 @@
+#ifndef __LOG_RING_H__
+#define __LOG_RING_H__
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * 单生产者单消费者的字节环形缓冲区
+ * 每个写日志的线程一个，后台日志线程是唯一的消费者，读写两端都不加锁。
+ * 写入: reserve -> 填充 -> commit；读取: peek -> 使用 -> release
+ * 记录不跨越缓冲区末尾，尾部放不下时写入 wrap 标记 (长度为 0) 后回到开头，
+ * 因此每条记录的第一个 uint32_t 必须是记录长度且不为 0。
+ */
+class LogRing {
+public:
+    static const size_t ALIGN = 8;
+
+    // capacity 向上取 2 的幂
+    explicit LogRing(size_t capacity);
+    ~LogRing();
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    /**
+     * 申请一段连续空间 (生产者)
+     * @param size 最大长度，实际长度在 commit 时给出
+     * @return 写入地址，空间不足返回 nullptr
+     */
+    void* reserve(size_t size);
+
+    /**
+     * 提交 reserve 得到的记录
+     * @param size 实际长度，不能超过 reserve 的长度
+     * @return 已使用超过一半容量时返回 true，生产者据此唤醒消费者
+     */
+    bool commit(size_t size);
+
+    /**
+     * 读取下一条记录 (消费者)，多次 peek 之间不 release 时依次返回后续记录
+     * @param size 记录长度 (已按 ALIGN 对齐)
+     * @return 记录地址，没有数据返回 nullptr
+     */
+    const void* peek(size_t& size);
+
+    // 释放 peek 过的所有记录，生产者可以复用这部分空间
+    void release();
+
+    bool empty() const;
+
+    // 已使用的字节数，只是一个近似值
+    size_t used() const;
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    static const uint32_t WRAP_MARK = 0;
+
+    uint8_t* buffer_;
+    size_t capacity_;
+    size_t mask_;
+
+    // 读写位置单调递增，取模得到下标；分开放在不同的 cache line 上避免伪共享
+    alignas(64) std::atomic<uint64_t> tail_;       // 生产者写
+    uint64_t reserve_pos_;                         // reserve 后实际的写入位置 (可能跳过了尾部)
+    uint64_t cached_head_;                         // 生产者缓存的读位置，空间不足时才重新读取 head_
+
+    alignas(64) std::atomic<uint64_t> head_;       // 消费者写
+    uint64_t read_pos_;                            // 消费者已 peek 到的位置
+};
+
+#endif // __LOG_RING_H__
+
+/*
+ * @description: v1 日志用的 SPSC 环形缓冲区，每个线程一个，写日志时不再加锁
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,135 @@
+#ifndef __LOG_SINK_H__
+#define __LOG_SINK_H__
+
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/Log.h"
+
+// 后台日志线程格式化好的一条日志，字段只在 write 调用期间有效
+struct LogEntry {
+    LogLevel level;
+    const char* tag;
+    uint32_t tid;                   // 写日志的线程 id
+    uint64_t timestamp;             // CLOCK_REALTIME 纳秒
+    const char* time_str;           // "%Y-%m-%d %H:%M:%S"
+    const char* msg;
+    size_t msg_len;
+    int cmd_index;                  // 关联的 cmdIndex，-1 表示没有
+    const char* ln;                 // 板卡 LN，未知时为空字符串
+};
+
+/**
+ * 日志输出端
+ * write / flush / poll 只在后台日志线程中调用，不需要自己加锁，也不能在里面写日志。
+ * 一批日志依次 write 之后调用一次 flush，write 里只做缓存，真正的输出放到 flush。
+ */
+class LogSink {
+public:
+    virtual ~LogSink() {}
+    virtual void write(const LogEntry& entry) = 0;
+    virtual void flush() {}
+
+    // 后台线程没有日志时周期调用 (最长间隔约 50ms)，用于定时落盘等
+    virtual void poll() {}
+};
+
+// 输出到 stdout，格式: [time] [LEVEL] [TAG] msg
+class ConsoleLogSink : public LogSink {
+public:
+    void write(const LogEntry& entry) override;
+    void flush() override;
+
+private:
+    std::string buffer_;
+};
+
+/**
+ * 输出到文件，替代原来 stdout 重定向到 /var/log/test_app.log 的方式
+ * 一批日志合并成一次 write(2) (O_APPEND)；文件超过 max_size 时轮转为 path.1 ... path.max_files，
+ * 最旧的删除；只在出现 WARN / ERROR 或距上次落盘超过 sync_interval_ms 时 fdatasync，
+ * 避免和 eMMC 读写测试争抢带宽。
+ */
+class FileLogSink : public LogSink {
+public:
+    /**
+     * @param path 日志文件路径
+     * @param max_size 单个文件的大小上限 (字节)
+     * @param max_files 保留的历史文件个数，0 表示超过上限时直接清空 (清空失败时丢弃日志，直到能清空为止)
+     * @param sync_interval_ms 定时落盘间隔
+     */
+    FileLogSink(const std::string& path, size_t max_size = 8 * 1024 * 1024, int max_files = 4,
+                int sync_interval_ms = 5000);
+    ~FileLogSink();
+
+    FileLogSink(const FileLogSink&) = delete;
+    FileLogSink& operator=(const FileLogSink&) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+    const std::string& path() const { return path_; }
+
+    void write(const LogEntry& entry) override;
+    void flush() override;
+    void poll() override;
+
+protected:
+    // 一条日志格式化成一行追加到 out，默认与控制台相同
+    virtual void format(std::string& out, const LogEntry& entry);
+
+private:
+    static const size_t BUFFER_LIMIT = 256 * 1024;     // 缓存超过该值时不等 flush 直接写出
+
+    bool open_file();
+    void write_buffer();
+    void rotate();
+    void sync();
+
+    std::string path_;
+    size_t max_size_;
+    int max_files_;
+    uint64_t sync_interval_ns_;
+
+    int fd_;
+    size_t file_size_;
+    std::string buffer_;
+    bool urgent_;                                       // 本批次有 WARN / ERROR，flush 后立即落盘
+    bool dirty_;                                        // 有写出但还没有落盘的数据
+    bool rotate_failed_;                                // 上次清空文件失败，同样的错误只向 stderr 报一次
+    uint64_t last_sync_;
+};
+
+/**
+ * 结构化日志，每行一个 JSON 对象 (JSON Lines)，写入、轮转、落盘规则与 FileLogSink 相同
+ * {"ts":毫秒时间戳,"time":"...","level":"INFO","tag":"...","tid":线程,"cmd":cmdIndex,"ln":"...","msg":"..."}
+ * 字段顺序固定，没有关联 cmdIndex 时 cmd 为 -1；log_index 工具依赖这个顺序建立索引，改动时要同步修改
+ */
+class JsonLogSink : public FileLogSink {
+public:
+    using FileLogSink::FileLogSink;
+
+protected:
+    void format(std::string& out, const LogEntry& entry) override;
+};
+
+// 按 [time] [LEVEL] [TAG] msg\n 格式追加一行
+void log_format_line(std::string& out, const LogEntry& entry);
+
+// 按 JSON Lines 格式追加一行
+void log_format_json(std::string& out, const LogEntry& entry);
+
+// 日志级别字符串，DEBUG / INFO  / WARN  / ERROR，等宽
+const char* log_level_name(LogLevel level);
+
+#endif // __LOG_SINK_H__
+
+/*
+ * @description: v1 日志输出端接口，由后台日志线程批量写出
+ * @Date: 2026-10-19 *
+ * @description: v2 增加 FileLogSink，批量写入、按大小轮转、按级别或定时落盘
+ * @Date: 2026-10-19 *
+ * @description: v3 增加 JsonLogSink 结构化日志，带 cmdIndex 和 LN
+ * @Date: 2026-10-19 *
+ * @description: v4 max_files 为 0 时检查清空文件的结果，失败时不再追加写
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,76 @@
+#ifndef __REACTOR_H__
+#define __REACTOR_H__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+/**
+ * epoll 事件循环，单独一个线程运行
+ * 所有回调都在 reactor 线程中执行，回调里不要做阻塞操作
+ */
+class Reactor {
+public:
+    using fd_callback = std::function<void(uint32_t events)>;
+
+    Reactor();
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    // 启动 reactor 线程，重复调用直接返回 true
+    bool start();
+
+    // 停止 reactor 线程并等待其退出
+    void stop();
+
+    /**
+     * 注册文件描述符
+     * @param fd 文件描述符，生命周期由调用者管理
+     * @param events EPOLLIN / EPOLLOUT 等
+     * @param callback 事件回调，参数为 epoll 返回的事件
+     * @return 是否成功
+     */
+    bool add_fd(int fd, uint32_t events, fd_callback callback);
+    bool modify_fd(int fd, uint32_t events);
+    bool remove_fd(int fd);
+
+    // 投递一个函数到 reactor 线程执行
+    void post(std::function<void()> fn);
+
+    bool is_loop_thread() const;
+    bool is_running() const;
+
+private:
+    void loop();
+    void wakeup();
+    void run_pending();
+
+    int epoll_fd_;
+    int wakeup_fd_;
+    std::atomic_bool running_;
+    std::thread thread_;
+    std::atomic<std::thread::id> loop_thread_id_;   // 其它线程调用 is_loop_thread 时 reactor 线程可能正在写入
+
+    std::mutex mutex_;
+    std::unordered_map<int, std::shared_ptr<fd_callback>> handlers_;
+    std::vector<std::function<void()>> pending_;
+
+    const char* REACTOR_TAG = "Reactor";
+};
+
+#endif // __REACTOR_H__
+
+/*
+ * @description: v1 epoll reactor, 承载 signalfd 等事件源
+ * @Date: 2026-10-19 *
+ * @description: v2 loop_thread_id_ 改为 atomic，is_loop_thread 可以在任意线程调用
+ * @Date: 2026-10-19
+ */
@@ -2,13 +2,19 @@
 #define TIMER_H
 
 #include <functional>
-#include <thread>
 #include <chrono>
 #include <atomic>
 #include <mutex>
 
+#include "util/TimerWheel.h"
+
 /**
  * 定时器类，用于周期性执行任务
+ * 挂在共享的 main_timer_wheel 上，不再每个定时器一个线程，回调在 reactor 线程中执行。
+ * 和原来每个定时器一个线程的实现相比有两点不同:
+ *   - 第一次回调在 start 之后一个周期才执行，不再 start 时立即执行一次
+ *   - stop 只从时间轮上取消，不等正在 reactor 线程中执行的回调结束，stop 返回后回调可能还会执行完这一次；
+ *     回调是拷贝挂到时间轮上的，Timer 析构不影响它，但回调里用到的其它对象要比这一次回调活得久
  */
 class Timer {
 public:
@@ -22,10 +28,10 @@ public:
     // 析构函数
     ~Timer();
     
-    // 启动定时器
+    // 启动定时器，第一次回调在 interval 毫秒后
     void start();
     
-    // 停止定时器
+    // 停止定时器，不等正在执行的回调 (可以在回调中调用)
     void stop();
     
     // 设置定时周期
@@ -35,10 +41,8 @@ public:
     bool isRunning() const;
 
 private:
-    // 定时器线程函数
-    void timerThread();
-    
-    std::thread thread_;               // 定时器线程
+    TimerWheel& wheel_;                // 共享时间轮
+    TimerWheel::timer_id timerId_;     // 时间轮中的定时器 id
     std::atomic<bool> running_;        // 运行状态
     std::atomic<uint32_t> interval_;   // 定时周期（毫秒）
     std::function<void()> callback_;   // 回调函数
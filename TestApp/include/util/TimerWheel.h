@@ -0,0 +1,116 @@
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#include "util/Reactor.h"
+#include "util/theradpoolv1/thread_pool.h"
+
+/**
+ * 分层时间轮，整个程序共用一个 (main_timer_wheel)
+ * 由一个 timerfd 驱动，挂在 Reactor 上，回调在 reactor 线程中执行，回调里不要做阻塞操作。
+ * 4 层，每层 64 个槽，tick 默认 10ms，最长定时约 46 小时，超出按最长处理。
+ * 添加 / 取消定时器都是 O(1)。tick 按 CLOCK_MONOTONIC 计算，timerfd 按最近一次到期 (或上层槽下放) 的时间单次设定，
+ * 不按 tick 周期唤醒，醒来后补齐经过的 tick；没有定时器时 timerfd 停止。
+ * 定时器可以绑定 interrupt_flag，到期时标志已置位则直接丢弃不再回调 (周期定时器随之停止)。
+ */
+class TimerWheel {
+public:
+    using timer_id = uint64_t;                  // 0 为无效 id
+
+    /**
+     * @param reactor 驱动时间轮的 reactor
+     * @param tick_ms 时间轮精度 (毫秒)
+     */
+    explicit TimerWheel(Reactor& reactor, uint32_t tick_ms = 10);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * 单次定时器
+     * @param delay_ms 延时 (毫秒)，按 tick 向上取整
+     * @param callback 到期回调
+     * @param flag 中断标志，可为空
+     * @return 定时器 id，失败返回 0
+     */
+    timer_id schedule_once(uint32_t delay_ms, std::function<void()> callback,
+                           std::shared_ptr<interrupt_flag> flag = nullptr);
+
+    // 周期定时器，第一次在 interval_ms 后触发
+    timer_id schedule_periodic(uint32_t interval_ms, std::function<void()> callback,
+                               std::shared_ptr<interrupt_flag> flag = nullptr);
+
+    /**
+     * 取消定时器，可以在回调中取消自己
+     * @return 定时器存在返回 true
+     */
+    bool cancel(timer_id id);
+
+    size_t size();
+
+private:
+    static const int WHEEL_LEVELS = 4;
+    static const int WHEEL_BITS = 6;
+    static const int WHEEL_SIZE = 1 << WHEEL_BITS;
+    static const uint64_t WHEEL_MASK = WHEEL_SIZE - 1;
+
+    struct timer_node {
+        timer_id id;
+        uint64_t expires;                       // 到期 tick
+        uint64_t interval;                      // 周期 tick，0 为单次
+        std::function<void()> callback;
+        std::shared_ptr<interrupt_flag> flag;
+        bool cancelled;
+        timer_node* prev;                       // 槽内双向链表，用于 O(1) 取消
+        timer_node* next;
+    };
+
+    struct slot {
+        timer_node head;                        // 哨兵
+    };
+
+    timer_id schedule(uint32_t delay_ms, uint32_t interval_ms, std::function<void()> callback,
+                      std::shared_ptr<interrupt_flag> flag);
+    uint64_t ms_to_ticks(uint32_t ms) const;
+    void add_node(timer_node* node);
+    void unlink_node(timer_node* node);
+    int cascade(int level, int index);
+    void on_tick();
+    void advance(std::vector<std::shared_ptr<timer_node>>& expired);
+    uint64_t now_ns() const;
+    uint64_t current_tick() const;
+    uint64_t next_wakeup_tick();
+    void arm_timerfd(uint64_t tick);
+    void update_timerfd();
+
+    Reactor& reactor_;
+    uint32_t tick_ms_;
+    uint64_t tick_ns_;
+    uint64_t start_ns_;                         // tick 0 对应的 CLOCK_MONOTONIC 时间
+    int timer_fd_;
+    uint64_t armed_tick_;                       // timerfd 设定的唤醒 tick，UINT64_MAX 为未设定
+
+    std::mutex mutex_;
+    uint64_t next_tick_;                        // 下一个要处理的 tick
+    timer_id next_id_;
+    slot wheel_[WHEEL_LEVELS][WHEEL_SIZE];
+    std::unordered_map<timer_id, std::shared_ptr<timer_node>> timers_;
+
+    const char* TIMER_WHEEL_TAG = "TimerWheel";
+};
+
+#endif // __TIMER_WHEEL_H__
+
+/*
+ * @description: v1 timerfd 驱动的分层时间轮，替代每个定时器一个线程
+ * @Date: 2026-10-19 *
+ * @description: v2 timerfd 改为按下一次到期时间单次设定，不再每个 tick 唤醒
+ * @Date: 2026-10-19
+ */
@@ -0,0 +1,73 @@
+#ifndef __FUTURE_UTILS_H__
+#define __FUTURE_UTILS_H__
+
+#include <future>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <type_traits>
+
+/*
+ * thread_pool::submit 返回的 future 组合工具
+ * when_all / then 返回的都是 deferred future，组合本身不占用线程池线程，
+ * 在调用 get() / wait() 的线程中等待各个子 future 并执行后续函数，
+ * 避免线程池线程互相等待造成死锁
+ */
+
+/*
+ * @brief 等待一组同类型 future 全部完成
+ * @param futures 子任务 future，按顺序返回结果
+ * @return future，get() 得到与输入顺序一致的结果数组
+ */
+template<typename T>
+std::future<std::vector<T>> when_all(std::vector<std::future<T>> futures) {
+    auto shared_futures = std::make_shared<std::vector<std::future<T>>>(std::move(futures));
+    return std::async(std::launch::deferred, [shared_futures]() {
+        std::vector<T> results;
+        results.reserve(shared_futures->size());
+        for (auto& f : *shared_futures) {
+            results.push_back(f.get());
+        }
+        return results;
+    });
+}
+
+// void 版本，只等待全部完成；子任务抛出的异常在 get() 时重新抛出
+inline std::future<void> when_all(std::vector<std::future<void>> futures) {
+    auto shared_futures = std::make_shared<std::vector<std::future<void>>>(std::move(futures));
+    return std::async(std::launch::deferred, [shared_futures]() {
+        for (auto& f : *shared_futures) {
+            f.get();
+        }
+    });
+}
+
+/*
+ * @brief 在 future 完成后对结果执行 f
+ * @param future 前置任务
+ * @param f 后续函数，参数为前置任务结果 (前置为 void 时无参数)
+ * @return future，get() 得到 f 的返回值
+ */
+template<typename T, typename FunctionType>
+auto then(std::future<T> future, FunctionType f) -> std::future<typename std::invoke_result<FunctionType, T>::type> {
+    auto shared_future = std::make_shared<std::future<T>>(std::move(future));
+    return std::async(std::launch::deferred, [shared_future, f]() mutable {
+        return f(shared_future->get());
+    });
+}
+
+template<typename FunctionType>
+auto then(std::future<void> future, FunctionType f) -> std::future<typename std::invoke_result<FunctionType>::type> {
+    auto shared_future = std::make_shared<std::future<void>>(std::move(future));
+    return std::async(std::launch::deferred, [shared_future, f]() mutable {
+        shared_future->get();
+        return f();
+    });
+}
+
+#endif // __FUTURE_UTILS_H__
+
+/*
+ * @description: v1 future 组合工具 when_all / then
+ * @Date: 2026-10-19
+ */
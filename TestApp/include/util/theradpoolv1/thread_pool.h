@@ -7,6 +7,10 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <future>
+#include <type_traits>
+#include <signal.h>
+#include <pthread.h>
 
 #include "thread_safe_queue.h"
 #include "join_thread.h"
@@ -70,9 +74,16 @@ public:
         done = true;
     }
     
+    // 提交任务，返回 future 获取结果，任务抛出的异常在 get() 时重新抛出
     template<typename FunctionType>
-    void submit(FunctionType f) {
-        work_queue.push(std::function<void()>(f));
+    std::future<typename std::invoke_result<FunctionType>::type> submit(FunctionType f) {
+        using result_type = typename std::invoke_result<FunctionType>::type;
+        auto task = std::make_shared<std::packaged_task<result_type()>>(std::move(f));   // packaged_task 不可拷贝，用 shared_ptr 包一层放进 std::function
+        std::future<result_type> res(task->get_future());
+        work_queue.push(std::function<void()>([task]() {
+            (*task)();
+        }));
+        return res;
     }
 
     // template<typename FunctionType>
@@ -103,6 +114,18 @@ public:
     return flag;
 }
 
+    // 使用外部创建的中断标志提交任务，标志由调用者登记管理 (如 TaskRegistry)
+    template<typename FunctionType>
+    void submit_interruptible(std::shared_ptr<interrupt_flag> flag, FunctionType f) {
+        std::function<void(interrupt_flag&)> func = f;
+
+        work_queue.push(std::function<void()>(
+            [flag, func]() {
+                func(*flag);
+            }
+        ));
+    }
+
 
     int get_queue_size() {
         return work_queue.size();
@@ -116,6 +139,12 @@ private:
     join_threads joiner;
 
     void worker_thread() {
+        // 工作线程屏蔽 SIGINT，由主线程通过 signalfd 统一处理
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGINT);
+        pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
         while (!done) {
             std::function<void()> task;
             if (work_queue.try_pop(task)) {
@@ -140,4 +169,10 @@ private:
  *
  * @description: v2 添加可提交可中断任务的任务包装器
  * @Date: 2025-12-12
- */
\ No newline at end of file
+ *
+ * @description: v3 工作线程屏蔽 SIGINT，支持使用外部中断标志提交任务
+ * @Date: 2026-10-19
+ *
+ * @description: v4 submit 返回 future，配合 future_utils.h 中的 when_all / then 组合任务
+ * @Date: 2026-10-19
+ */
\ No newline at end of file
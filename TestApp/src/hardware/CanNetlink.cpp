@@ -0,0 +1,404 @@
+#include "hardware/CanNetlink.h"
+
+#include <errno.h>
+#include <net/if.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <linux/can/netlink.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+const char* can_state_name(int state) {
+    switch (state) {
+    case CAN_STATE_ERROR_ACTIVE:  return "error-active";
+    case CAN_STATE_ERROR_WARNING: return "error-warning";
+    case CAN_STATE_ERROR_PASSIVE: return "error-passive";
+    case CAN_STATE_BUS_OFF:       return "bus-off";
+    case CAN_STATE_STOPPED:       return "stopped";
+    case CAN_STATE_SLEEPING:      return "sleeping";
+    default:                      return "unknown";
+    }
+}
+
+namespace {
+
+// 在一个缓冲区里依次拼 netlink 消息，属性按 4 字节对齐
+class NlBatch {
+public:
+    explicit NlBatch(std::vector<char>& data) : data_(data) {
+
+    }
+
+    void begin(uint16_t type, uint16_t flags, uint32_t seq, int ifindex, unsigned change, unsigned ifflags) {
+        msg_ = data_.size();
+        struct nlmsghdr header;
+        memset(&header, 0, sizeof(header));
+        header.nlmsg_type = type;
+        header.nlmsg_flags = flags;
+        header.nlmsg_seq = seq;
+        append(&header, sizeof(header));
+
+        struct ifinfomsg info;
+        memset(&info, 0, sizeof(info));
+        info.ifi_family = AF_UNSPEC;
+        info.ifi_index = ifindex;
+        info.ifi_change = change;
+        info.ifi_flags = ifflags;
+        append(&info, sizeof(info));
+    }
+
+    void end() {
+        header()->nlmsg_len = (uint32_t)(data_.size() - msg_);
+    }
+
+    void attr(uint16_t type, const void* payload, size_t len) {
+        struct rtattr rta;
+        rta.rta_type = type;
+        rta.rta_len = (unsigned short)RTA_LENGTH(len);
+        append(&rta, sizeof(rta));
+        append(payload, len);
+    }
+
+    void attrU32(uint16_t type, uint32_t value) {
+        attr(type, &value, sizeof(value));
+    }
+
+    size_t nestBegin(uint16_t type) {
+        size_t offset = data_.size();
+        attr(type, nullptr, 0);
+        return offset;
+    }
+
+    void nestEnd(size_t offset) {
+        reinterpret_cast<struct rtattr*>(&data_[offset])->rta_len = (unsigned short)(data_.size() - offset);
+    }
+
+private:
+    struct nlmsghdr* header() {
+        return reinterpret_cast<struct nlmsghdr*>(&data_[msg_]);
+    }
+
+    void append(const void* payload, size_t len) {
+        size_t offset = data_.size();
+        data_.resize(offset + RTA_ALIGN(len), 0);
+        if (len) {
+            memcpy(&data_[offset], payload, len);
+        }
+    }
+
+    std::vector<char>& data_;
+    size_t msg_ = 0;
+};
+
+// 把一段属性按类型放进表里，同一类型取最后一个
+void parse_attrs(const struct rtattr* rta, int len, const struct rtattr* table[], int max) {
+    memset(table, 0, sizeof(struct rtattr*) * (max + 1));
+    for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        if (rta->rta_type <= max) {
+            table[rta->rta_type] = rta;
+        }
+    }
+}
+
+}
+
+CanNetlink::CanNetlink() : fd_(-1), seq_(1) {
+
+}
+
+CanNetlink::~CanNetlink() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool CanNetlink::ensureOpen() {
+    if (fd_ >= 0) {
+        return true;
+    }
+    fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd_ < 0) {
+        LogError(CAN_NETLINK_TAG, "create netlink socket failed: %s", strerror(errno));
+        return false;
+    }
+    struct sockaddr_nl local;
+    memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    if (bind(fd_, (struct sockaddr*)&local, sizeof(local)) < 0) {
+        LogError(CAN_NETLINK_TAG, "bind netlink socket failed: %s", strerror(errno));
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    struct timeval timeout = {2, 0};                        // 内核不回应时不要一直等
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    int rcvbuf = 256 * 1024;
+    setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    return true;
+}
+
+/*
+ * 一次发出 batch 中序号为 [firstSeq, firstSeq + count) 的请求，收齐每条请求的应答
+ * errors[k] 为 0 或 -errno；replies 不为空时保存非 NLMSG_ERROR 的应答 (RTM_GETLINK 的结果)
+ */
+bool CanNetlink::transact(std::vector<char>& batch, uint32_t firstSeq, uint32_t count, std::vector<int>& errors,
+                          std::vector<std::vector<char>>* replies) {
+    errors.assign(count, -ETIMEDOUT);
+    if (replies) {
+        replies->assign(count, std::vector<char>());
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    struct sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    struct iovec iov = {batch.data(), batch.size()};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &kernel;
+    msg.msg_namelen = sizeof(kernel);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (sendmsg(fd_, &msg, 0) < 0) {
+        LogError(CAN_NETLINK_TAG, "sendmsg failed: %s", strerror(errno));
+        errors.assign(count, -errno);
+        return false;
+    }
+
+    std::vector<char> buffer(64 * 1024);
+    uint32_t answered = 0;
+    while (answered < count) {
+        ssize_t len = recv(fd_, buffer.data(), buffer.size(), 0);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LogError(CAN_NETLINK_TAG, "recv failed: %s, %u of %u requests answered", strerror(errno), answered, count);
+            return false;
+        }
+        int remaining = (int)len;
+        for (struct nlmsghdr* header = (struct nlmsghdr*)buffer.data(); NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_seq < firstSeq || header->nlmsg_seq >= firstSeq + count) {
+                continue;                                   // 上一次超时留下的应答
+            }
+            uint32_t k = header->nlmsg_seq - firstSeq;
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                const struct nlmsgerr* err = (const struct nlmsgerr*)NLMSG_DATA(header);
+                errors[k] = err->error;
+            } else if (replies) {
+                errors[k] = 0;
+                (*replies)[k].assign((const char*)header, (const char*)header + header->nlmsg_len);
+            } else {
+                continue;
+            }
+            answered++;
+        }
+    }
+    return true;
+}
+
+bool CanNetlink::configure(const std::vector<CanLinkConfig>& links, std::vector<CanLinkStatus>& results) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results.assign(links.size(), CanLinkStatus());
+    if (!ensureOpen()) {
+        for (CanLinkStatus& result : results) {
+            result.error = "netlink unavailable";
+        }
+        return false;
+    }
+
+    // 每个接口最多 3 条请求: down、参数、up；stepOf / linkOf 记录每条请求属于哪个接口的哪一步
+    enum { STEP_DOWN, STEP_CONFIG, STEP_UP, STEP_COUNT };
+    static const char* STEP_NAMES[STEP_COUNT] = {"set down", "set bittiming", "set up"};
+    std::vector<int> stepOf;
+    std::vector<size_t> linkOf;
+    std::vector<char> batch;
+    const uint16_t flags = NLM_F_REQUEST | NLM_F_ACK;
+
+    // 发出 batch 并收 ack，只记每个接口第一个失败的步骤；返回 transact 的结果 (是否收齐了应答)
+    auto send_batch = [&](uint32_t firstSeq) {
+        std::vector<int> errors;
+        bool complete = transact(batch, firstSeq, (uint32_t)stepOf.size(), errors, nullptr);
+        for (size_t k = 0; k < stepOf.size(); ++k) {
+            CanLinkStatus& result = results[linkOf[k]];
+            if (errors[k] != 0 && result.ok) {
+                result.ok = false;
+                result.error = std::string(STEP_NAMES[stepOf[k]]) +
+                    (complete || errors[k] != -ETIMEDOUT ? std::string(" failed: ") + strerror(-errors[k]) : " not acknowledged");
+            }
+        }
+        stepOf.clear();
+        linkOf.clear();
+        batch.clear();
+        return complete;
+    };
+
+    // 第一批: 所有接口的 down 和参数
+    NlBatch nl(batch);
+    uint32_t firstSeq = seq_;
+    for (size_t i = 0; i < links.size(); ++i) {
+        const CanLinkConfig& link = links[i];
+        results[i].ifname = link.ifname;
+        results[i].ifindex = (int)if_nametoindex(link.ifname.c_str());
+        if (results[i].ifindex == 0) {
+            results[i].error = "no such interface";
+            continue;
+        }
+
+        nl.begin(RTM_NEWLINK, flags, seq_++, results[i].ifindex, IFF_UP, 0);        // 位定时只能在 down 时修改
+        nl.end();
+        stepOf.push_back(STEP_DOWN);
+        linkOf.push_back(i);
+
+        if (link.bitrate) {
+            nl.begin(RTM_NEWLINK, flags, seq_++, results[i].ifindex, 0, 0);
+            size_t linkinfo = nl.nestBegin(IFLA_LINKINFO);
+            nl.attr(IFLA_INFO_KIND, "can", 3);
+            size_t data = nl.nestBegin(IFLA_INFO_DATA);
+            struct can_bittiming bittiming;
+            memset(&bittiming, 0, sizeof(bittiming));
+            bittiming.bitrate = link.bitrate;               // 其余为 0，由内核按位速率和采样点计算
+            bittiming.sample_point = link.samplePoint;
+            nl.attr(IFLA_CAN_BITTIMING, &bittiming, sizeof(bittiming));
+            nl.attrU32(IFLA_CAN_RESTART_MS, link.restartMs);
+            nl.nestEnd(data);
+            nl.nestEnd(linkinfo);
+            nl.end();
+            stepOf.push_back(STEP_CONFIG);
+            linkOf.push_back(i);
+        }
+        results[i].ok = true;
+    }
+
+    // 第二批: 只 up 前面的步骤都 ack 成功的接口，位定时设置失败的接口保持 down，不会用旧的位速率上总线；
+    // 第一批没收齐应答 (socket 出错或内核不回应) 时不再发 up，要 up 的接口都判失败
+    bool complete = send_batch(firstSeq);
+    firstSeq = seq_;
+    for (size_t i = 0; i < links.size(); ++i) {
+        if (!results[i].ok || !links[i].up) {
+            continue;
+        }
+        if (!complete) {
+            results[i].ok = false;
+            results[i].error = "set up skipped: netlink not answering";
+            continue;
+        }
+        nl.begin(RTM_NEWLINK, flags, seq_++, results[i].ifindex, IFF_UP, IFF_UP);
+        nl.end();
+        stepOf.push_back(STEP_UP);
+        linkOf.push_back(i);
+    }
+    send_batch(firstSeq);
+
+    bool allOk = true;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (!results[i].ok) {
+            LogError(CAN_NETLINK_TAG, "configure %s failed: %s", results[i].ifname.c_str(), results[i].error.c_str());
+            allOk = false;
+        } else {
+            LogDebug(CAN_NETLINK_TAG, "configure %s: bitrate %u, sample point %u, restart-ms %u, %s", results[i].ifname.c_str(),
+                links[i].bitrate, links[i].samplePoint, links[i].restartMs, links[i].up ? "up" : "down");
+        }
+    }
+    return allOk;
+}
+
+bool CanNetlink::query(const std::vector<std::string>& ifnames, std::vector<CanLinkStatus>& results) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results.assign(ifnames.size(), CanLinkStatus());
+    if (!ensureOpen()) {
+        for (CanLinkStatus& result : results) {
+            result.error = "netlink unavailable";
+        }
+        return false;
+    }
+
+    std::vector<size_t> linkOf;
+    std::vector<char> batch;
+    NlBatch nl(batch);
+    const uint32_t firstSeq = seq_;
+    for (size_t i = 0; i < ifnames.size(); ++i) {
+        results[i].ifname = ifnames[i];
+        results[i].ifindex = (int)if_nametoindex(ifnames[i].c_str());
+        if (results[i].ifindex == 0) {
+            results[i].error = "no such interface";
+            continue;
+        }
+        nl.begin(RTM_GETLINK, NLM_F_REQUEST, seq_++, results[i].ifindex, 0, 0);
+        nl.end();
+        linkOf.push_back(i);
+    }
+
+    std::vector<int> errors;
+    std::vector<std::vector<char>> replies;
+    transact(batch, firstSeq, (uint32_t)linkOf.size(), errors, &replies);
+
+    bool allOk = true;
+    for (size_t k = 0; k < linkOf.size(); ++k) {
+        CanLinkStatus& result = results[linkOf[k]];
+        if (errors[k] != 0 || replies[k].empty()) {
+            result.error = std::string("get link failed: ") + strerror(errors[k] ? -errors[k] : EIO);
+            continue;
+        }
+        const struct nlmsghdr* header = (const struct nlmsghdr*)replies[k].data();
+        const struct ifinfomsg* info = (const struct ifinfomsg*)NLMSG_DATA(header);
+        result.up = (info->ifi_flags & IFF_UP) != 0;
+        result.ok = true;
+
+        const struct rtattr* link[IFLA_MAX + 1];
+        parse_attrs(IFLA_RTA(info), (int)IFLA_PAYLOAD(header), link, IFLA_MAX);
+        if (!link[IFLA_LINKINFO]) {
+            continue;
+        }
+        const struct rtattr* linkinfo[IFLA_INFO_MAX + 1];
+        parse_attrs((const struct rtattr*)RTA_DATA(link[IFLA_LINKINFO]), (int)RTA_PAYLOAD(link[IFLA_LINKINFO]), linkinfo, IFLA_INFO_MAX);
+        if (linkinfo[IFLA_INFO_KIND]) {
+            result.kind = std::string((const char*)RTA_DATA(linkinfo[IFLA_INFO_KIND]),
+                                      strnlen((const char*)RTA_DATA(linkinfo[IFLA_INFO_KIND]), RTA_PAYLOAD(linkinfo[IFLA_INFO_KIND])));
+        }
+        if (linkinfo[IFLA_INFO_XSTATS] && RTA_PAYLOAD(linkinfo[IFLA_INFO_XSTATS]) >= sizeof(struct can_device_stats)) {
+            struct can_device_stats stats;
+            memcpy(&stats, RTA_DATA(linkinfo[IFLA_INFO_XSTATS]), sizeof(stats));
+            result.statsValid = true;
+            result.busErrors = stats.bus_error;
+            result.errorWarning = stats.error_warning;
+            result.errorPassive = stats.error_passive;
+            result.busOff = stats.bus_off;
+            result.arbitrationLost = stats.arbitration_lost;
+            result.restarts = stats.restarts;
+        }
+        if (!linkinfo[IFLA_INFO_DATA]) {
+            continue;
+        }
+        const struct rtattr* can[IFLA_CAN_MAX + 1];
+        parse_attrs((const struct rtattr*)RTA_DATA(linkinfo[IFLA_INFO_DATA]), (int)RTA_PAYLOAD(linkinfo[IFLA_INFO_DATA]), can, IFLA_CAN_MAX);
+        if (can[IFLA_CAN_BITTIMING] && RTA_PAYLOAD(can[IFLA_CAN_BITTIMING]) >= sizeof(struct can_bittiming)) {
+            struct can_bittiming bittiming;
+            memcpy(&bittiming, RTA_DATA(can[IFLA_CAN_BITTIMING]), sizeof(bittiming));
+            result.bitrate = bittiming.bitrate;
+            result.samplePoint = bittiming.sample_point;
+        }
+        if (can[IFLA_CAN_STATE] && RTA_PAYLOAD(can[IFLA_CAN_STATE]) >= sizeof(uint32_t)) {
+            result.state = (int)*(const uint32_t*)RTA_DATA(can[IFLA_CAN_STATE]);
+        }
+        if (can[IFLA_CAN_RESTART_MS] && RTA_PAYLOAD(can[IFLA_CAN_RESTART_MS]) >= sizeof(uint32_t)) {
+            result.restartMs = *(const uint32_t*)RTA_DATA(can[IFLA_CAN_RESTART_MS]);
+        }
+        if (can[IFLA_CAN_BERR_COUNTER] && RTA_PAYLOAD(can[IFLA_CAN_BERR_COUNTER]) >= sizeof(struct can_berr_counter)) {
+            struct can_berr_counter counter;
+            memcpy(&counter, RTA_DATA(can[IFLA_CAN_BERR_COUNTER]), sizeof(counter));
+            result.txErrors = counter.txerr;
+            result.rxErrors = counter.rxerr;
+        }
+    }
+    for (const CanLinkStatus& result : results) {
+        allOk = allOk && result.ok;
+    }
+    return allOk;
+}
@@ -0,0 +1,318 @@
+#include "hardware/DdrBench.h"
+#include "util/Clock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/sysinfo.h>
+#include <thread>
+#include <vector>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define DDR_BENCH_NEON 1
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define DDR_BENCH_AVX 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DDR_BENCH_SSE2 1
+#endif
+
+static const double SCALAR = 3.0;
+static const size_t ARRAY_ALIGN = 2 << 20;                  // 按大页对齐，配合 MADV_HUGEPAGE 减少 TLB miss
+
+enum DdrKernel {
+    KERNEL_COPY,
+    KERNEL_SCALE,
+    KERNEL_ADD,
+    KERNEL_TRIAD,
+    KERNEL_COUNT,
+};
+
+/* ---------------- kernel: 每次处理 8 个 double (64 字节，一条 cache line)，n 是 8 的倍数 ---------------- */
+
+static void kernel_copy(double* c, const double* a, size_t n) {
+#if defined(DDR_BENCH_NEON)
+    for (size_t i = 0; i < n; i += 8) {
+        for (size_t j = 0; j < 8; j += 2) {
+            vst1q_f64(c + i + j, vld1q_f64(a + i + j));
+        }
+    }
+#elif defined(DDR_BENCH_AVX)
+    for (size_t i = 0; i < n; i += 8) {
+        _mm256_store_pd(c + i, _mm256_load_pd(a + i));
+        _mm256_store_pd(c + i + 4, _mm256_load_pd(a + i + 4));
+    }
+#elif defined(DDR_BENCH_SSE2)
+    for (size_t i = 0; i < n; i += 8) {
+        _mm_store_pd(c + i, _mm_load_pd(a + i));
+        _mm_store_pd(c + i + 2, _mm_load_pd(a + i + 2));
+        _mm_store_pd(c + i + 4, _mm_load_pd(a + i + 4));
+        _mm_store_pd(c + i + 6, _mm_load_pd(a + i + 6));
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        c[i] = a[i];
+    }
+#endif
+}
+
+static void kernel_scale(double* b, const double* c, double s, size_t n) {
+#if defined(DDR_BENCH_NEON)
+    for (size_t i = 0; i < n; i += 8) {
+        for (size_t j = 0; j < 8; j += 2) {
+            vst1q_f64(b + i + j, vmulq_n_f64(vld1q_f64(c + i + j), s));
+        }
+    }
+#elif defined(DDR_BENCH_AVX)
+    const __m256d vs = _mm256_set1_pd(s);
+    for (size_t i = 0; i < n; i += 8) {
+        _mm256_store_pd(b + i, _mm256_mul_pd(vs, _mm256_load_pd(c + i)));
+        _mm256_store_pd(b + i + 4, _mm256_mul_pd(vs, _mm256_load_pd(c + i + 4)));
+    }
+#elif defined(DDR_BENCH_SSE2)
+    const __m128d vs = _mm_set1_pd(s);
+    for (size_t i = 0; i < n; i += 8) {
+        for (size_t j = 0; j < 8; j += 2) {
+            _mm_store_pd(b + i + j, _mm_mul_pd(vs, _mm_load_pd(c + i + j)));
+        }
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        b[i] = s * c[i];
+    }
+#endif
+}
+
+static void kernel_add(double* c, const double* a, const double* b, size_t n) {
+#if defined(DDR_BENCH_NEON)
+    for (size_t i = 0; i < n; i += 8) {
+        for (size_t j = 0; j < 8; j += 2) {
+            vst1q_f64(c + i + j, vaddq_f64(vld1q_f64(a + i + j), vld1q_f64(b + i + j)));
+        }
+    }
+#elif defined(DDR_BENCH_AVX)
+    for (size_t i = 0; i < n; i += 8) {
+        _mm256_store_pd(c + i, _mm256_add_pd(_mm256_load_pd(a + i), _mm256_load_pd(b + i)));
+        _mm256_store_pd(c + i + 4, _mm256_add_pd(_mm256_load_pd(a + i + 4), _mm256_load_pd(b + i + 4)));
+    }
+#elif defined(DDR_BENCH_SSE2)
+    for (size_t i = 0; i < n; i += 8) {
+        for (size_t j = 0; j < 8; j += 2) {
+            _mm_store_pd(c + i + j, _mm_add_pd(_mm_load_pd(a + i + j), _mm_load_pd(b + i + j)));
+        }
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        c[i] = a[i] + b[i];
+    }
+#endif
+}
+
+static void kernel_triad(double* a, const double* b, const double* c, double s, size_t n) {
+#if defined(DDR_BENCH_NEON)
+    for (size_t i = 0; i < n; i += 8) {
+        for (size_t j = 0; j < 8; j += 2) {
+            vst1q_f64(a + i + j, vfmaq_n_f64(vld1q_f64(b + i + j), vld1q_f64(c + i + j), s));
+        }
+    }
+#elif defined(DDR_BENCH_AVX)
+    const __m256d vs = _mm256_set1_pd(s);
+    for (size_t i = 0; i < n; i += 8) {
+        _mm256_store_pd(a + i, _mm256_add_pd(_mm256_load_pd(b + i), _mm256_mul_pd(vs, _mm256_load_pd(c + i))));
+        _mm256_store_pd(a + i + 4, _mm256_add_pd(_mm256_load_pd(b + i + 4), _mm256_mul_pd(vs, _mm256_load_pd(c + i + 4))));
+    }
+#elif defined(DDR_BENCH_SSE2)
+    const __m128d vs = _mm_set1_pd(s);
+    for (size_t i = 0; i < n; i += 8) {
+        for (size_t j = 0; j < 8; j += 2) {
+            _mm_store_pd(a + i + j, _mm_add_pd(_mm_load_pd(b + i + j), _mm_mul_pd(vs, _mm_load_pd(c + i + j))));
+        }
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = b[i] + s * c[i];
+    }
+#endif
+}
+
+const char* DdrBench::isa() {
+#if defined(DDR_BENCH_NEON)
+    return "neon";
+#elif defined(DDR_BENCH_AVX)
+    return "avx";
+#elif defined(DDR_BENCH_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+static double* alloc_array(size_t bytes) {
+    void* p = nullptr;
+    if (posix_memalign(&p, ARRAY_ALIGN, bytes) != 0) {
+        return nullptr;
+    }
+    madvise(p, bytes, MADV_HUGEPAGE);
+    return (double*)p;
+}
+
+static std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+DdrBench::DdrBench(const DdrBenchConfig& config) : config_(config) {
+
+}
+
+bool DdrBench::run(DdrBenchResult& result, const interrupt_flag* interrupt) {
+    result = DdrBenchResult();
+    result.isa = isa();
+
+    std::vector<int> cpus = allowed_cpus();
+    unsigned threads = config_.threads ? config_.threads : (unsigned)std::max<size_t>(cpus.size(), 1);
+    int iterations = std::max(config_.iterations, 2);
+
+    // 三个数组不超过空闲内存的一半，每个线程分到整数个 cache line
+    uint64_t arrayBytes = config_.arrayBytes;
+    struct sysinfo info;
+    if (sysinfo(&info) == 0) {
+        uint64_t freeBytes = (uint64_t)info.freeram * info.mem_unit;
+        arrayBytes = std::min<uint64_t>(arrayBytes, freeBytes / 6);
+    }
+    size_t chunk = (size_t)(arrayBytes / sizeof(double) / threads) & ~(size_t)7;
+    if (chunk == 0) {
+        result.error = "not enough memory";
+        LogError(DDR_BENCH_TAG, "%s", result.error.c_str());
+        return false;
+    }
+    size_t n = chunk * threads;
+    result.threads = threads;
+    result.arrayBytes = n * sizeof(double);
+
+    double* a = alloc_array(result.arrayBytes);
+    double* b = alloc_array(result.arrayBytes);
+    double* c = alloc_array(result.arrayBytes);
+    if (!a || !b || !c) {
+        free(a);
+        free(b);
+        free(c);
+        result.error = "out of memory";
+        LogError(DDR_BENCH_TAG, "%s", result.error.c_str());
+        return false;
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, nullptr, threads);
+    std::vector<uint64_t> best(KERNEL_COUNT, UINT64_MAX);
+    std::atomic<bool> cancelled(false);                                     // 0 号线程在屏障之前写，其它线程在屏障之后读
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            if (!cpus.empty()) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[t % cpus.size()], &set);
+                pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            }
+            double* pa = a + t * chunk;
+            double* pb = b + t * chunk;
+            double* pc = c + t * chunk;
+            for (size_t i = 0; i < chunk; ++i) {                            // 首次写入，物理页落在本线程
+                pa[i] = 1.0;
+                pb[i] = 2.0;
+                pc[i] = 0.0;
+            }
+
+            for (int iter = 0; iter < iterations; ++iter) {
+                if (t == 0 && interrupt && interrupt->is_stop_requested()) {
+                    cancelled.store(true, std::memory_order_relaxed);
+                }
+                pthread_barrier_wait(&barrier);
+                if (cancelled.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                for (int kernel = 0; kernel < KERNEL_COUNT; ++kernel) {
+                    uint64_t start = 0;
+                    pthread_barrier_wait(&barrier);
+                    if (t == 0) {
+                        start = monotonic_ns();
+                    }
+                    switch (kernel) {
+                        case KERNEL_COPY:  kernel_copy(pc, pa, chunk);              break;
+                        case KERNEL_SCALE: kernel_scale(pb, pc, SCALAR, chunk);     break;
+                        case KERNEL_ADD:   kernel_add(pc, pa, pb, chunk);           break;
+                        case KERNEL_TRIAD: kernel_triad(pa, pb, pc, SCALAR, chunk); break;
+                    }
+                    pthread_barrier_wait(&barrier);
+                    if (t == 0 && iter > 0) {                               // 第一轮含缺页和预热，不计
+                        best[kernel] = std::min(best[kernel], monotonic_ns() - start);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    pthread_barrier_destroy(&barrier);
+    if (cancelled) {
+        free(a);
+        free(b);
+        free(c);
+        result.error = "cancelled";
+        LogError(DDR_BENCH_TAG, "%s", result.error.c_str());
+        return false;
+    }
+
+    // 和 STREAM 一样用标量推算期望值校验结果，kernel 写错或内存出错都能发现
+    double ea = 1.0, eb = 2.0, ec = 0.0;
+    for (int iter = 0; iter < iterations; ++iter) {
+        ec = ea;
+        eb = SCALAR * ec;
+        ec = ea + eb;
+        ea = eb + SCALAR * ec;
+    }
+    result.valid = true;
+    for (size_t i = 0; i < n; i += 4099) {
+        if (fabs(a[i] - ea) > ea * 1e-13 || fabs(b[i] - eb) > eb * 1e-13 || fabs(c[i] - ec) > ec * 1e-13) {
+            result.valid = false;
+            result.error = "result mismatch at element " + std::to_string(i);
+            break;
+        }
+    }
+    free(a);
+    free(b);
+    free(c);
+
+    double bytes = (double)result.arrayBytes;
+    result.copyGBps = 2 * bytes / best[KERNEL_COPY];
+    result.scaleGBps = 2 * bytes / best[KERNEL_SCALE];
+    result.addGBps = 3 * bytes / best[KERNEL_ADD];
+    result.triadGBps = 3 * bytes / best[KERNEL_TRIAD];
+
+    if (!result.valid) {
+        LogError(DDR_BENCH_TAG, "%s", result.error.c_str());
+        return false;
+    }
+    LogInfo(DDR_BENCH_TAG, "%u threads [%s] %llu MB x 3: copy %.2f GB/s, scale %.2f GB/s, add %.2f GB/s, triad %.2f GB/s",
+        threads, result.isa.c_str(), (unsigned long long)(result.arrayBytes >> 20),
+        result.copyGBps, result.scaleGBps, result.addGBps, result.triadGBps);
+    return true;
+}
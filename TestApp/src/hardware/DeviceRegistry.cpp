@@ -0,0 +1,569 @@
+#include "hardware/DeviceRegistry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <libudev.h>
+#include <linux/fs.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+const char* block_role_name(BlockRole role) {
+    switch (role) {
+    case BLOCK_ROLE_EMMC: return "emmc";
+    case BLOCK_ROLE_TF:   return "tf";
+    case BLOCK_ROLE_NVME: return "nvme";
+    case BLOCK_ROLE_USB:  return "usb";
+    default:              return "other";
+    }
+}
+
+const UsbDeviceInfo* DeviceSnapshot::findUsb(const std::string& port) const {
+    for (const UsbDeviceInfo& device : usb) {
+        if (device.name == port) {
+            return &device;
+        }
+    }
+    return nullptr;
+}
+
+const BlockDeviceInfo* DeviceSnapshot::findBlock(const std::string& name) const {
+    for (const BlockDeviceInfo& device : block) {
+        if (device.name == name) {
+            return &device;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<const BlockDeviceInfo*> DeviceSnapshot::usbDisks() const {
+    std::vector<const BlockDeviceInfo*> disks;
+    for (const BlockDeviceInfo& device : block) {
+        if (device.devtype == "disk" && !device.usbPort.empty()) {
+            disks.push_back(&device);
+        }
+    }
+    std::sort(disks.begin(), disks.end(), [](const BlockDeviceInfo* a, const BlockDeviceInfo* b) {
+        return a->usbPort < b->usbPort;
+    });
+    return disks;
+}
+
+// filter 为空、等于 port 或是 port 的上级端口 ("1-1" 匹配 "1-1.2")
+static bool port_matches(const std::string& filter, const std::string& port) {
+    if (filter.empty()) {
+        return true;
+    }
+    if (port.compare(0, filter.size(), filter) != 0) {
+        return false;
+    }
+    return port.size() == filter.size() || port[filter.size()] == '.';
+}
+
+const BlockDeviceInfo* DeviceSnapshot::disk(BlockRole role) const {
+    for (const BlockDeviceInfo& device : block) {                           // block 按 name 排序
+        if (device.devtype == "disk" && device.role == role) {
+            return &device;
+        }
+    }
+    return nullptr;
+}
+
+const BlockDeviceInfo* DeviceSnapshot::usbDisk(const std::string& port) const {
+    const BlockDeviceInfo* found = nullptr;
+    for (const BlockDeviceInfo& device : block) {
+        if (device.devtype == "disk" && !device.usbPort.empty() && port_matches(port, device.usbPort) &&
+            (found == nullptr || device.usbPort < found->usbPort)) {
+            found = &device;
+        }
+    }
+    return found;
+}
+
+static bool sysattr_ulong(struct udev_device* dev, const char* attr, int base, unsigned long long& value) {
+    const char* text = udev_device_get_sysattr_value(dev, attr);
+    if (text == nullptr) {
+        return false;
+    }
+    char* end = nullptr;
+    value = strtoull(text, &end, base);
+    return end != text;
+}
+
+static std::string str_or_empty(const char* text) {
+    return text ? text : "";
+}
+
+// 块设备容量: 优先 BLKGETSIZE64 (驱动实际报告的字节数)，没有设备节点或打不开 (如读卡器无卡) 时退回 sysfs
+static uint64_t block_size_bytes(struct udev_device* dev, const std::string& devnode) {
+    if (!devnode.empty()) {
+        int fd = open(devnode.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd >= 0) {
+            uint64_t bytes = 0;
+            int ret = ioctl(fd, BLKGETSIZE64, &bytes);
+            close(fd);
+            if (ret == 0) {
+                return bytes;
+            }
+        }
+    }
+    unsigned long long sectors;
+    if (sysattr_ulong(dev, "size", 10, sectors)) {
+        return sectors * 512;                                               // sysfs 的 size 固定以 512 字节为单位
+    }
+    return 0;
+}
+
+DeviceRegistry::DeviceRegistry(Reactor& reactor)
+    : reactor_(reactor), udev_(nullptr), monitor_(nullptr), monitor_fd_(-1), mounts_fd_(-1),
+      generation_(0), next_subscriber_id_(1) {
+
+}
+
+DeviceRegistry::~DeviceRegistry() {
+    stop();
+}
+
+bool DeviceRegistry::start() {
+    if (udev_ != nullptr) {
+        return true;
+    }
+
+    udev_ = udev_new();
+    if (udev_ == nullptr) {
+        LogError(DEVICE_REGISTRY_TAG, "udev_new failed");
+        return false;
+    }
+    monitor_ = udev_monitor_new_from_netlink(udev_, "udev");
+    if (monitor_ == nullptr) {
+        LogError(DEVICE_REGISTRY_TAG, "udev_monitor_new_from_netlink failed");
+        udev_ = udev_unref(udev_);
+        return false;
+    }
+    udev_monitor_filter_add_match_subsystem_devtype(monitor_, "usb", "usb_device");
+    udev_monitor_filter_add_match_subsystem_devtype(monitor_, "block", nullptr);
+    udev_monitor_set_receive_buffer_size(monitor_, 1024 * 1024);           // 一次插入 hub 会有几十个事件
+    udev_monitor_enable_receiving(monitor_);
+    monitor_fd_ = udev_monitor_get_fd(monitor_);
+
+    // 先开始接收再枚举，枚举期间的事件留在 socket 中，之后在 reactor 线程中重放，不会丢
+    mounts_fd_ = open("/proc/self/mounts", O_RDONLY | O_CLOEXEC);
+    std::vector<DeviceEvent> ignored;
+    refreshMounts(ignored);
+    enumerate();
+    publish();
+
+    if (!reactor_.add_fd(monitor_fd_, EPOLLIN, [this](uint32_t) { onMonitorReadable(); })) {
+        LogError(DEVICE_REGISTRY_TAG, "register udev monitor to reactor failed");
+    }
+    // 挂载表变化时 /proc/self/mounts 报告 EPOLLPRI | EPOLLERR
+    if (mounts_fd_ >= 0 && !reactor_.add_fd(mounts_fd_, EPOLLPRI | EPOLLERR, [this](uint32_t) { onMountsChanged(); })) {
+        LogError(DEVICE_REGISTRY_TAG, "register /proc/self/mounts to reactor failed");
+    }
+
+    std::shared_ptr<const DeviceSnapshot> current = snapshot();
+    LogInfo(DEVICE_REGISTRY_TAG, "device registry started: %zu usb devices, %zu block devices",
+        current->usb.size(), current->block.size());
+    return true;
+}
+
+void DeviceRegistry::setControllerRole(const std::string& devpath, BlockRole role) {
+    controller_roles_.push_back(std::make_pair(devpath, role));
+}
+
+void DeviceRegistry::stop() {
+    if (udev_ == nullptr) {
+        return;
+    }
+    reactor_.remove_fd(monitor_fd_);
+    if (mounts_fd_ >= 0) {
+        reactor_.remove_fd(mounts_fd_);
+        close(mounts_fd_);
+        mounts_fd_ = -1;
+    }
+    monitor_ = udev_monitor_unref(monitor_);
+    monitor_fd_ = -1;
+    udev_ = udev_unref(udev_);
+}
+
+std::shared_ptr<const DeviceSnapshot> DeviceRegistry::snapshot() const {
+    return std::atomic_load(&current_);
+}
+
+int DeviceRegistry::subscribe(const std::string& port, event_callback callback) const {
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
+    int id = next_subscriber_id_++;
+    subscribers_[id] = Subscriber{port, std::move(callback)};
+    return id;
+}
+
+void DeviceRegistry::unsubscribe(int id) const {
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
+    subscribers_.erase(id);
+}
+
+void DeviceRegistry::wait_until(AsyncWaiter& waiter, const std::string& port, std::function<bool(const DeviceSnapshot&)> ready,
+                                int timeout_ms, std::shared_ptr<interrupt_flag> flag,
+                                std::function<void(AsyncWaitResult result)> callback) const {
+    // 订阅和首次检查都在 reactor 线程中进行，和事件分发串行，订阅之前的变化已经在快照里，之后的会通知
+    waiter.post([this, &waiter, port, ready, timeout_ms, flag, callback]() {
+        std::shared_ptr<const DeviceSnapshot> current = snapshot();
+        if (!current) {
+            callback(ASYNC_WAIT_ERROR);
+            return;
+        }
+        std::shared_ptr<int> id = std::make_shared<int>(0);
+        std::function<void()> notify = waiter.wait_notify(timeout_ms, flag, [this, id, callback](AsyncWaitResult result) {
+            unsubscribe(*id);
+            callback(result);
+        });
+        *id = subscribe(port, [ready, notify](const DeviceEvent& event) {
+            if (ready(*event.snapshot)) {
+                notify();
+            }
+        });
+        if (ready(*current)) {
+            notify();
+        }
+    });
+}
+
+AsyncAwaitable<AsyncWaitResult> DeviceRegistry::wait_until(AsyncWaiter& waiter, const std::string& port,
+                                                           std::function<bool(const DeviceSnapshot&)> ready,
+                                                           int timeout_ms, std::shared_ptr<interrupt_flag> flag) const {
+    return AsyncAwaitable<AsyncWaitResult>([this, &waiter, port, ready, timeout_ms, flag](std::function<void(AsyncWaitResult)> resume) {
+        wait_until(waiter, port, ready, timeout_ms, flag, resume);
+    });
+}
+
+void DeviceRegistry::enumerate() {
+    struct udev_enumerate* enumerate = udev_enumerate_new(udev_);
+    udev_enumerate_add_match_subsystem(enumerate, "usb");
+    udev_enumerate_add_match_subsystem(enumerate, "block");
+    udev_enumerate_scan_devices(enumerate);
+
+    std::vector<DeviceEvent> ignored;                                       // 首次枚举不通知
+    struct udev_list_entry* entry;
+    udev_list_entry_foreach(entry, udev_enumerate_get_list_entry(enumerate)) {
+        struct udev_device* dev = udev_device_new_from_syspath(udev_, udev_list_entry_get_name(entry));
+        if (dev == nullptr) {
+            continue;
+        }
+        const char* subsystem = udev_device_get_subsystem(dev);
+        if (subsystem && strcmp(subsystem, "usb") == 0) {
+            updateUsb(dev, "add", ignored);
+        } else if (subsystem && strcmp(subsystem, "block") == 0) {
+            updateBlock(dev, "add", ignored);
+        }
+        udev_device_unref(dev);
+    }
+    udev_enumerate_unref(enumerate);
+}
+
+void DeviceRegistry::onMonitorReadable() {
+    std::vector<DeviceEvent> events;
+    bool changed = false;
+    struct udev_device* dev;
+    while ((dev = udev_monitor_receive_device(monitor_)) != nullptr) {      // monitor 的 socket 是非阻塞的，取完为止
+        const char* subsystem = udev_device_get_subsystem(dev);
+        const char* action = udev_device_get_action(dev);
+        if (action != nullptr && subsystem != nullptr) {
+            if (strcmp(subsystem, "usb") == 0) {
+                changed |= updateUsb(dev, action, events);
+            } else if (strcmp(subsystem, "block") == 0) {
+                changed |= updateBlock(dev, action, events);
+            }
+        }
+        udev_device_unref(dev);
+    }
+    if (changed) {
+        std::shared_ptr<const DeviceSnapshot> current = publish();
+        dispatch(events, current);
+    }
+}
+
+void DeviceRegistry::onMountsChanged() {
+    std::vector<DeviceEvent> events;
+    if (refreshMounts(events)) {
+        std::shared_ptr<const DeviceSnapshot> current = publish();
+        dispatch(events, current);
+    }
+}
+
+bool DeviceRegistry::updateUsb(struct udev_device* dev, const char* action, std::vector<DeviceEvent>& events) {
+    const char* devtype = udev_device_get_devtype(dev);
+    if (devtype == nullptr || strcmp(devtype, "usb_device") != 0) {         // 接口 "1-1:1.0" 不登记
+        return false;
+    }
+    std::string syspath = str_or_empty(udev_device_get_syspath(dev));
+    std::string name = str_or_empty(udev_device_get_sysname(dev));
+
+    if (strcmp(action, "remove") == 0) {
+        if (usb_.erase(syspath) == 0) {
+            return false;
+        }
+        LogInfo(DEVICE_REGISTRY_TAG, "usb device removed: %s", name.c_str());
+        events.push_back(DeviceEvent{DeviceEvent::USB_REMOVED, name, name, nullptr});
+        return true;
+    }
+    if (strcmp(action, "add") != 0 && strcmp(action, "change") != 0 && strcmp(action, "bind") != 0) {
+        return false;
+    }
+
+    unsigned long long vid, pid, value;
+    if (!sysattr_ulong(dev, "idVendor", 16, vid) || !sysattr_ulong(dev, "idProduct", 16, pid)) {
+        return false;
+    }
+    UsbDeviceInfo info;
+    info.name = name;
+    info.vid = (uint16_t)vid;
+    info.pid = (uint16_t)pid;
+    if (sysattr_ulong(dev, "busnum", 10, value)) {
+        info.busnum = (int)value;
+    }
+    if (sysattr_ulong(dev, "devnum", 10, value)) {
+        info.devnum = (int)value;
+    }
+    if (sysattr_ulong(dev, "speed", 10, value)) {
+        info.speedMbps = (uint32_t)value;
+    }
+    if (sysattr_ulong(dev, "bDeviceClass", 16, value)) {
+        info.deviceClass = (uint8_t)value;
+    }
+    info.devpath = str_or_empty(udev_device_get_sysattr_value(dev, "devpath"));
+
+    bool added = usb_.find(syspath) == usb_.end();
+    usb_[syspath] = info;
+    if (added) {
+        LogInfo(DEVICE_REGISTRY_TAG, "usb device added: %s %04x:%04x %u Mbps", name.c_str(), info.vid, info.pid, info.speedMbps);
+        events.push_back(DeviceEvent{DeviceEvent::USB_ADDED, name, name, nullptr});
+    }
+    return true;
+}
+
+bool DeviceRegistry::updateBlock(struct udev_device* dev, const char* action, std::vector<DeviceEvent>& events) {
+    std::string syspath = str_or_empty(udev_device_get_syspath(dev));
+    std::string name = str_or_empty(udev_device_get_sysname(dev));
+    if (name.compare(0, 4, "loop") == 0 || name.compare(0, 3, "ram") == 0 || name.compare(0, 4, "zram") == 0) {
+        return false;
+    }
+
+    if (strcmp(action, "remove") == 0) {
+        std::map<std::string, BlockDeviceInfo>::iterator it = block_.find(syspath);
+        if (it == block_.end()) {
+            return false;
+        }
+        LogInfo(DEVICE_REGISTRY_TAG, "block device removed: %s", name.c_str());
+        events.push_back(DeviceEvent{DeviceEvent::BLOCK_REMOVED, name, it->second.usbPort, nullptr});
+        block_.erase(it);
+        return true;
+    }
+    if (strcmp(action, "add") != 0 && strcmp(action, "change") != 0) {
+        return false;
+    }
+
+    BlockDeviceInfo info;
+    info.name = name;
+    info.devnode = str_or_empty(udev_device_get_devnode(dev));
+    info.devtype = str_or_empty(udev_device_get_devtype(dev));
+
+    unsigned long long value;
+    info.sizeBytes = block_size_bytes(dev, info.devnode);
+    struct udev_device* disk = dev;
+    if (info.devtype == "partition") {
+        disk = udev_device_get_parent(dev);                                 // 父设备归 dev 所有，不需要 unref
+        if (disk != nullptr) {
+            info.parent = str_or_empty(udev_device_get_sysname(disk));
+        }
+    }
+    if (disk != nullptr && sysattr_ulong(disk, "removable", 10, value)) {
+        info.removable = value != 0;
+    }
+    struct udev_device* usb = udev_device_get_parent_with_subsystem_devtype(dev, "usb", "usb_device");
+    if (usb != nullptr) {
+        info.usbPort = str_or_empty(udev_device_get_sysname(usb));
+    }
+    if (disk != nullptr) {
+        info.role = classifyDisk(disk, info.parent.empty() ? name : info.parent, info.usbPort);
+    }
+    std::map<std::string, std::string>::const_iterator mount = mounts_.find(info.devnode);
+    if (mount != mounts_.end()) {
+        info.mountPoint = mount->second;
+    }
+
+    std::map<std::string, BlockDeviceInfo>::iterator it = block_.find(syspath);
+    if (it == block_.end()) {
+        LogInfo(DEVICE_REGISTRY_TAG, "block device added: %s %s %llu bytes%s%s", name.c_str(), block_role_name(info.role),
+            (unsigned long long)info.sizeBytes, info.usbPort.empty() ? "" : " on usb ", info.usbPort.c_str());
+        events.push_back(DeviceEvent{DeviceEvent::BLOCK_ADDED, name, info.usbPort, nullptr});
+        block_[syspath] = info;
+        return true;
+    }
+    if (it->second.sizeBytes != info.sizeBytes || it->second.usbPort != info.usbPort || it->second.role != info.role) {
+        LogInfo(DEVICE_REGISTRY_TAG, "block device changed: %s %s %llu bytes", name.c_str(), block_role_name(info.role),
+            (unsigned long long)info.sizeBytes);
+        events.push_back(DeviceEvent{DeviceEvent::BLOCK_CHANGED, name, info.usbPort, nullptr});
+        it->second = info;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * 按以下顺序判断磁盘的角色:
+ * 1. setControllerRole 指定的控制器 (devpath 中包含该段)
+ * 2. usb 上的设备，或 udev 属性 ID_BUS=usb
+ * 3. mmc 总线上的卡: 卡的 MMC_TYPE 属性 (没有时读 type 属性)，MMC 为 eMMC，SD 为 TF；
+ *    都读不到时按 removable 区分。eMMC 的 boot0 / boot1 / rpmb 硬件分区也挂在同一张卡上，不算
+ * 4. nvme 总线上的设备，或 udev 属性 ID_BUS=nvme
+ */
+BlockRole DeviceRegistry::classifyDisk(struct udev_device* disk, const std::string& name, const std::string& usbPort) const {
+    std::string devpath = str_or_empty(udev_device_get_devpath(disk));
+    for (const std::pair<std::string, BlockRole>& controller : controller_roles_) {
+        if (devpath.find(controller.first) != std::string::npos) {
+            return controller.second;
+        }
+    }
+
+    std::string bus = str_or_empty(udev_device_get_property_value(disk, "ID_BUS"));
+    if (!usbPort.empty() || bus == "usb") {
+        return BLOCK_ROLE_USB;
+    }
+
+    struct udev_device* card = udev_device_get_parent_with_subsystem_devtype(disk, "mmc", nullptr);
+    if (card != nullptr) {
+        if (name.find("boot") != std::string::npos || name.find("rpmb") != std::string::npos) {
+            return BLOCK_ROLE_OTHER;
+        }
+        std::string type = str_or_empty(udev_device_get_property_value(card, "MMC_TYPE"));
+        if (type.empty()) {
+            type = str_or_empty(udev_device_get_sysattr_value(card, "type"));
+        }
+        if (type == "MMC") {
+            return BLOCK_ROLE_EMMC;
+        }
+        if (type == "SD") {
+            return BLOCK_ROLE_TF;
+        }
+        unsigned long long removable;
+        if (sysattr_ulong(disk, "removable", 10, removable)) {
+            return removable ? BLOCK_ROLE_TF : BLOCK_ROLE_EMMC;
+        }
+        return BLOCK_ROLE_OTHER;
+    }
+
+    if (bus == "nvme" || udev_device_get_parent_with_subsystem_devtype(disk, "nvme", nullptr) != nullptr) {
+        return BLOCK_ROLE_NVME;
+    }
+    return BLOCK_ROLE_OTHER;
+}
+
+// 还原 /proc/self/mounts 中的转义 ("\040" -> ' ')
+static std::string unescape_mount_field(const char* begin, const char* end) {
+    std::string out;
+    out.reserve(end - begin);
+    for (const char* p = begin; p < end; ++p) {
+        if (*p == '\\' && end - p >= 4 && p[1] >= '0' && p[1] <= '7') {
+            out += (char)(((p[1] - '0') << 6) | ((p[2] - '0') << 3) | (p[3] - '0'));
+            p += 3;
+        } else {
+            out += *p;
+        }
+    }
+    return out;
+}
+
+bool DeviceRegistry::refreshMounts(std::vector<DeviceEvent>& events) {
+    if (mounts_fd_ < 0) {
+        return false;
+    }
+    std::string text;
+    char buf[4096];
+    ssize_t len;
+    off_t offset = 0;
+    while ((len = pread(mounts_fd_, buf, sizeof(buf), offset)) > 0) {
+        text.append(buf, len);
+        offset += len;
+    }
+
+    std::map<std::string, std::string> mounts;
+    const char* p = text.c_str();
+    while (*p != '\0') {
+        const char* line_end = strchr(p, '\n');
+        if (line_end == nullptr) {
+            line_end = p + strlen(p);
+        }
+        const char* dev_end = (const char*)memchr(p, ' ', line_end - p);
+        if (dev_end != nullptr && strncmp(p, "/dev/", 5) == 0) {
+            const char* dir = dev_end + 1;
+            const char* dir_end = (const char*)memchr(dir, ' ', line_end - dir);
+            std::string devnode = unescape_mount_field(p, dev_end);
+            if (dir_end != nullptr && mounts.find(devnode) == mounts.end()) {
+                mounts[devnode] = unescape_mount_field(dir, dir_end);
+            }
+        }
+        p = (*line_end == '\n') ? line_end + 1 : line_end;
+    }
+    mounts_.swap(mounts);
+
+    bool changed = false;
+    for (std::map<std::string, BlockDeviceInfo>::iterator it = block_.begin(); it != block_.end(); ++it) {
+        BlockDeviceInfo& info = it->second;
+        std::map<std::string, std::string>::const_iterator mount = mounts_.find(info.devnode);
+        std::string mountPoint = (mount != mounts_.end()) ? mount->second : "";
+        if (mountPoint != info.mountPoint) {
+            LogInfo(DEVICE_REGISTRY_TAG, "%s mount point: \"%s\" -> \"%s\"", info.name.c_str(), info.mountPoint.c_str(), mountPoint.c_str());
+            info.mountPoint = mountPoint;
+            events.push_back(DeviceEvent{DeviceEvent::MOUNT_CHANGED, info.name, info.usbPort, nullptr});
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+std::shared_ptr<const DeviceSnapshot> DeviceRegistry::publish() {
+    std::shared_ptr<DeviceSnapshot> next = std::make_shared<DeviceSnapshot>();
+    next->generation = ++generation_;
+    next->usb.reserve(usb_.size());
+    for (std::map<std::string, UsbDeviceInfo>::const_iterator it = usb_.begin(); it != usb_.end(); ++it) {
+        next->usb.push_back(it->second);
+    }
+    std::sort(next->usb.begin(), next->usb.end(), [](const UsbDeviceInfo& a, const UsbDeviceInfo& b) {
+        if (a.busnum != b.busnum) {
+            return a.busnum < b.busnum;
+        }
+        return a.devnum < b.devnum;
+    });
+    next->block.reserve(block_.size());
+    for (std::map<std::string, BlockDeviceInfo>::const_iterator it = block_.begin(); it != block_.end(); ++it) {
+        next->block.push_back(it->second);
+    }
+    std::sort(next->block.begin(), next->block.end(), [](const BlockDeviceInfo& a, const BlockDeviceInfo& b) {
+        return a.name < b.name;
+    });
+
+    std::shared_ptr<const DeviceSnapshot> published = next;
+    std::atomic_store(&current_, published);
+    return published;
+}
+
+void DeviceRegistry::dispatch(std::vector<DeviceEvent>& events, const std::shared_ptr<const DeviceSnapshot>& snapshot) {
+    std::vector<Subscriber> subscribers;
+    {
+        std::lock_guard<std::mutex> lock(subscribers_mutex_);
+        for (std::map<int, Subscriber>::const_iterator it = subscribers_.begin(); it != subscribers_.end(); ++it) {
+            subscribers.push_back(it->second);
+        }
+    }
+    for (DeviceEvent& event : events) {
+        event.snapshot = snapshot;
+        for (const Subscriber& subscriber : subscribers) {
+            if (port_matches(subscriber.port, event.port)) {
+                subscriber.callback(event);
+            }
+        }
+    }
+}
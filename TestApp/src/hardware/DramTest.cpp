@@ -0,0 +1,409 @@
+#include "hardware/DramTest.h"
+#include "util/Clock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/sysinfo.h>
+#include <thread>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const size_t HUGE_PAGE_SIZE = 2 << 20;
+static const size_t CHUNK_WORDS = 32768;                    // 每 256K 检查一次是否超时
+static const size_t MAX_RECORDED_FAULTS = 64;
+static const uint64_t CHECKERBOARD = 0x5555555555555555ULL;
+
+struct DramFault {
+    uint64_t vaddr;
+    uint64_t expected;
+    uint64_t actual;
+};
+
+/*
+ * 所有线程共享的状态，每个线程只写自己的 slice；
+ * 每一步结束都过屏障，stop 之后剩下的步骤空跑，保证所有线程走过同样多的屏障
+ */
+struct DramShared {
+    uint64_t* base = nullptr;
+    size_t sliceWords = 0;
+    uint64_t deadlineNs = 0;
+    const interrupt_flag* interrupt = nullptr;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> cancelled{false};     // stop 的原因是取消而不是超时
+    bool another = false;                   // 屏障的 serial 线程决定是否再跑一遍
+    pthread_barrier_t barrier;
+};
+
+class DramWorker {
+public:
+    DramWorker(DramShared& shared, unsigned index) : shared_(shared),
+        begin_(shared.base + index * shared.sliceWords), end_(begin_ + shared.sliceWords) {
+    }
+
+    uint64_t errors = 0;
+    uint64_t verifiedWords = 0;             // 读出比较过的字数，包括中止的那一遍
+    std::vector<DramFault> faults;
+
+    // 整遍: 每一步之后过屏障
+    void pass() {
+        fill_address(false);
+        step();
+        verify_address(false);
+        step();
+        fill_address(true);
+        step();
+        verify_address(true);
+        step();
+
+        // moving inversions: 填 p；升序 读 p 写 ~p；降序 读 ~p 写 p；最后读一遍 p
+        for (uint64_t p : {(uint64_t)0, CHECKERBOARD}) {
+            fill(p);
+            step();
+            march(true, p, true, ~p);
+            step();
+            march(false, ~p, true, p);
+            step();
+            march(true, p, false, 0);
+            step();
+        }
+
+        // march C-: ⇕(w0) ⇑(r0,w1) ⇑(r1,w0) ⇓(r0,w1) ⇓(r1,w0) ⇕(r0)
+        fill(0);
+        step();
+        march(true, 0, true, ~0ULL);
+        step();
+        march(true, ~0ULL, true, 0);
+        step();
+        march(false, 0, true, ~0ULL);
+        step();
+        march(false, ~0ULL, true, 0);
+        step();
+        march(true, 0, false, 0);
+        step();
+    }
+
+private:
+    // 每个 march 元素之后检查取消，过了屏障所有线程都看到 stop，剩下的步骤空跑
+    void step() {
+#if defined(__SSE2__)
+        _mm_sfence();                       // non-temporal store 是弱序的
+#endif
+        if (shared_.interrupt && shared_.interrupt->is_stop_requested()) {
+            shared_.cancelled.store(true, std::memory_order_relaxed);
+            shared_.stop.store(true, std::memory_order_relaxed);
+        }
+        pthread_barrier_wait(&shared_.barrier);
+    }
+
+    // 每段开始前检查是否超时，超时后剩下的步骤都不再读写，不会把没写完的数据当成错误
+    bool keep_going() {
+        if (shared_.stop.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (shared_.deadlineNs && monotonic_ns() >= shared_.deadlineNs) {
+            shared_.stop.store(true, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void record(volatile uint64_t* p, uint64_t expected, uint64_t actual) {
+        errors++;
+        if (faults.size() < MAX_RECORDED_FAULTS) {
+            faults.push_back({(uint64_t)(uintptr_t)p, expected, actual});
+        }
+    }
+
+    // 绕开 cache 写一对 64 位字，p 按 16 字节对齐
+    static inline void store_pair(uint64_t* p, uint64_t lo, uint64_t hi) {
+#if defined(__SSE2__)
+        _mm_stream_si128((__m128i*)p, _mm_set_epi64x((long long)hi, (long long)lo));
+#elif defined(__aarch64__)
+        __asm__ volatile("stnp %x0, %x1, [%2]" : : "r"(lo), "r"(hi), "r"(p) : "memory");
+#else
+        ((volatile uint64_t*)p)[0] = lo;
+        ((volatile uint64_t*)p)[1] = hi;
+#endif
+    }
+
+    void fill(uint64_t value) {
+        for (uint64_t* chunk = begin_; chunk < end_; chunk += CHUNK_WORDS) {
+            if (!keep_going()) {
+                return;
+            }
+            uint64_t* last = std::min(chunk + CHUNK_WORDS, end_);
+            for (uint64_t* p = chunk; p < last; p += 2) {
+                store_pair(p, value, value);
+            }
+        }
+    }
+
+    void fill_address(bool invert) {
+        uint64_t mask = invert ? ~0ULL : 0;
+        for (uint64_t* chunk = begin_; chunk < end_; chunk += CHUNK_WORDS) {
+            if (!keep_going()) {
+                return;
+            }
+            uint64_t* last = std::min(chunk + CHUNK_WORDS, end_);
+            for (uint64_t* p = chunk; p < last; p += 2) {
+                store_pair(p, (uint64_t)(uintptr_t)p ^ mask, (uint64_t)(uintptr_t)(p + 1) ^ mask);
+            }
+        }
+    }
+
+    void verify_address(bool invert) {
+        uint64_t mask = invert ? ~0ULL : 0;
+        for (uint64_t* chunk = begin_; chunk < end_; chunk += CHUNK_WORDS) {
+            if (!keep_going()) {
+                return;
+            }
+            volatile uint64_t* last = std::min(chunk + CHUNK_WORDS, end_);
+            for (volatile uint64_t* p = chunk; p < last; ++p) {
+                uint64_t expected = (uint64_t)(uintptr_t)p ^ mask;
+                uint64_t actual = *p;
+                if (actual != expected) {
+                    record(p, expected, actual);
+                }
+            }
+            verifiedWords += last - chunk;
+        }
+    }
+
+    // march 元素: 按 ascending 方向逐字读出比较 expect，write 时再写入 value
+    void march(bool ascending, uint64_t expect, bool write, uint64_t value) {
+        size_t chunks = ((size_t)(end_ - begin_) + CHUNK_WORDS - 1) / CHUNK_WORDS;
+        for (size_t n = 0; n < chunks; ++n) {
+            if (!keep_going()) {
+                return;
+            }
+            size_t index = ascending ? n : chunks - 1 - n;
+            volatile uint64_t* first = begin_ + index * CHUNK_WORDS;
+            volatile uint64_t* last = std::min(begin_ + (index + 1) * CHUNK_WORDS, end_);
+            if (ascending) {
+                for (volatile uint64_t* p = first; p < last; ++p) {
+                    uint64_t actual = *p;
+                    if (actual != expect) {
+                        record(p, expect, actual);
+                    }
+                    if (write) {
+                        *p = value;
+                    }
+                }
+            } else {
+                for (volatile uint64_t* p = last; p-- > first;) {
+                    uint64_t actual = *p;
+                    if (actual != expect) {
+                        record(p, expect, actual);
+                    }
+                    if (write) {
+                        *p = value;
+                    }
+                }
+            }
+            verifiedWords += last - first;
+        }
+    }
+
+    DramShared& shared_;
+    uint64_t* begin_;
+    uint64_t* end_;
+};
+
+// 大页优先: 预留的 hugetlb 页 > 透明大页 > 普通页
+static uint64_t* map_buffer(size_t bytes, std::string& backing) {
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        backing = "hugetlb";
+        return (uint64_t*)p;
+    }
+    p = mmap(nullptr, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    // 对齐到 2M，多出来的头尾还给内核
+    uintptr_t start = ((uintptr_t)p + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    if (start > (uintptr_t)p) {
+        munmap(p, start - (uintptr_t)p);
+    }
+    uintptr_t tail = (uintptr_t)p + bytes + HUGE_PAGE_SIZE;
+    if (tail > start + bytes) {
+        munmap((void*)(start + bytes), tail - (start + bytes));
+    }
+    backing = (madvise((void*)start, bytes, MADV_HUGEPAGE) == 0) ? "thp" : "normal";
+    return (uint64_t*)start;
+}
+
+// 虚拟地址换算成物理地址，没有权限时 pagemap 中的 PFN 为 0
+static bool virt_to_phys(int pagemap, uint64_t vaddr, uint64_t& paddr) {
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    uint64_t entry = 0;
+    if (pagemap < 0 || pread(pagemap, &entry, sizeof(entry), (off_t)(vaddr / pageSize * sizeof(entry))) != (ssize_t)sizeof(entry)) {
+        return false;
+    }
+    uint64_t pfn = entry & ((1ULL << 55) - 1);
+    if (!(entry & (1ULL << 63)) || pfn == 0) {
+        return false;
+    }
+    paddr = pfn * pageSize + vaddr % pageSize;
+    return true;
+}
+
+DramTest::DramTest(const DramTestConfig& config) : config_(config) {
+
+}
+
+bool DramTest::run(DramTestResult& result, const interrupt_flag* interrupt) {
+    result = DramTestResult();
+
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    unsigned threads = config_.threads ? config_.threads : (unsigned)std::max<size_t>(cpus.size(), 1);
+
+    uint64_t size = config_.sizeBytes;
+    struct sysinfo info;
+    if (sysinfo(&info) == 0) {
+        size = std::min<uint64_t>(size, (uint64_t)info.freeram * info.mem_unit / 2);
+    }
+    size_t sliceBytes = (size_t)(size / threads) & ~(size_t)(CHUNK_WORDS * sizeof(uint64_t) - 1);
+    if (sliceBytes == 0) {
+        result.error = "not enough memory";
+        LogError(DRAM_TEST_TAG, "%s", result.error.c_str());
+        return false;
+    }
+    size_t bytes = sliceBytes * threads;
+    bytes = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+    DramShared shared;
+    shared.base = map_buffer(bytes, result.backing);
+    if (!shared.base) {
+        result.error = "mmap failed";
+        LogError(DRAM_TEST_TAG, "%s: %llu bytes", result.error.c_str(), (unsigned long long)bytes);
+        return false;
+    }
+    mlock(shared.base, bytes);                                                // 测试期间物理页不能换出或迁移
+    shared.sliceWords = sliceBytes / sizeof(uint64_t);
+    result.threads = threads;
+    result.testedBytes = (uint64_t)sliceBytes * threads;
+
+    uint64_t start = monotonic_ns();
+    if (config_.durationMs) {
+        shared.deadlineNs = start + (uint64_t)config_.durationMs * 1000000ULL;
+    }
+    shared.interrupt = interrupt;
+    pthread_barrier_init(&shared.barrier, nullptr, threads);
+
+    std::vector<DramWorker> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back(shared, t);
+    }
+    std::vector<std::thread> handles;
+    for (unsigned t = 0; t < threads; ++t) {
+        handles.emplace_back([&, t]() {
+            if (!cpus.empty()) {
+                cpu_set_t cpu;
+                CPU_ZERO(&cpu);
+                CPU_SET(cpus[t % cpus.size()], &cpu);
+                pthread_setaffinity_np(pthread_self(), sizeof(cpu), &cpu);
+            }
+            for (;;) {
+                workers[t].pass();
+                if (pthread_barrier_wait(&shared.barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+                    bool complete = !shared.stop.load();
+                    if (complete) {
+                        result.passes++;
+                    }
+                    shared.another = complete && shared.deadlineNs != 0;
+                }
+                pthread_barrier_wait(&shared.barrier);
+                if (!shared.another) {
+                    break;
+                }
+            }
+        });
+    }
+    for (std::thread& handle : handles) {
+        handle.join();
+    }
+    pthread_barrier_destroy(&shared.barrier);
+    result.elapsedMs = (monotonic_ns() - start) / 1000000ULL;
+    result.timedOut = shared.stop.load() && !shared.cancelled.load();
+
+    // 出错地址 -> 物理地址 (munmap 之前)，有一个换算不了就都报缓冲区内的偏移
+    int pagemap = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    std::vector<DramFault> faults;
+    for (const DramWorker& worker : workers) {
+        result.errors += worker.errors;
+        result.verifiedBytes += worker.verifiedWords * sizeof(uint64_t);
+        faults.insert(faults.end(), worker.faults.begin(), worker.faults.end());
+    }
+    std::vector<uint64_t> addresses(faults.size());
+    result.physical = true;
+    for (size_t i = 0; i < faults.size() && result.physical; ++i) {
+        result.physical = virt_to_phys(pagemap, faults[i].vaddr, addresses[i]);
+    }
+    for (size_t i = 0; i < faults.size(); ++i) {
+        faults[i].vaddr = result.physical ? addresses[i] : faults[i].vaddr - (uint64_t)(uintptr_t)shared.base;
+    }
+    if (pagemap >= 0) {
+        close(pagemap);
+    }
+    munlock(shared.base, bytes);
+    munmap(shared.base, bytes);
+
+    std::sort(faults.begin(), faults.end(), [](const DramFault& a, const DramFault& b) { return a.vaddr < b.vaddr; });
+    for (const DramFault& fault : faults) {
+        if (result.ranges.empty() || fault.vaddr >= result.ranges.back().end + 4096) {
+            result.ranges.push_back(DramFaultRange());
+            result.ranges.back().start = fault.vaddr;
+        }
+        DramFaultRange& range = result.ranges.back();
+        range.end = std::max(range.end, fault.vaddr + sizeof(uint64_t));
+        range.bits |= fault.expected ^ fault.actual;
+        range.count++;
+    }
+
+    if (shared.cancelled.load()) {
+        result.error = "cancelled";
+        LogError(DRAM_TEST_TAG, "%s after %d passes, %llu MB verified, %llu errors", result.error.c_str(), result.passes,
+            (unsigned long long)(result.verifiedBytes >> 20), (unsigned long long)result.errors);
+        return false;
+    }
+    // 时间不够跑完一遍时，已经读出比较过的部分没有错误也算通过，日志里给出覆盖了多少
+    if (result.errors == 0 && result.verifiedBytes == 0) {
+        result.error = "duration too short, nothing verified";
+        LogError(DRAM_TEST_TAG, "%s: %u ms", result.error.c_str(), config_.durationMs);
+        return false;
+    }
+    if (result.errors == 0) {
+        LogInfo(DRAM_TEST_TAG, "%llu MB [%s] %u threads: %d passes%s in %llu ms, %llu MB verified, no errors",
+            (unsigned long long)(result.testedBytes >> 20), result.backing.c_str(), threads, result.passes,
+            result.timedOut ? " + partial" : "", (unsigned long long)result.elapsedMs,
+            (unsigned long long)(result.verifiedBytes >> 20));
+        return true;
+    }
+    LogError(DRAM_TEST_TAG, "%llu MB [%s] %u threads: %d passes in %llu ms, %llu errors in %zu ranges",
+        (unsigned long long)(result.testedBytes >> 20), result.backing.c_str(), threads, result.passes,
+        (unsigned long long)result.elapsedMs, (unsigned long long)result.errors, result.ranges.size());
+    for (const DramFaultRange& range : result.ranges) {
+        LogError(DRAM_TEST_TAG, "  %s 0x%llx-0x%llx bits 0x%016llx (%llu words)", result.physical ? "phys" : "offset",
+            (unsigned long long)range.start, (unsigned long long)range.end, (unsigned long long)range.bits,
+            (unsigned long long)range.count);
+    }
+    return false;
+}
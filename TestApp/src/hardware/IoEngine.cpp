@@ -0,0 +1,369 @@
+#include "hardware/IoEngine.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <linux/aio_abi.h>
+#include <linux/fs.h>
+#include <linux/io_uring.h>
+
+/* ---------------- io_uring ---------------- */
+
+class UringEngine : public IoEngine {
+public:
+    explicit UringEngine(unsigned depth) : depth_(depth), iovecs_(depth) {}
+
+    ~UringEngine() override {
+        // 提交出错后调用者可能不再等待，在途的请求还在读写调用者的缓冲区，收完它们的完成再释放 ring；
+        // 调用者在引擎销毁之后才释放缓冲区、关闭 fd
+        std::vector<IoCompletion> ignored;
+        while (inflight_ > 0) {
+            int ret = (int)syscall(__NR_io_uring_enter, ring_fd_, 0, inflight_, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0 && errno != EINTR) {
+                LogError(IO_ENGINE_TAG, "io_uring drain failed with %u requests in flight: %s", inflight_, strerror(errno));
+                break;
+            }
+            ignored.clear();
+            reap(ignored);
+        }
+        if (sqes_ != MAP_FAILED) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != MAP_FAILED) {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        if (ring_fd_ >= 0) {
+            close(ring_fd_);
+        }
+    }
+
+    bool init() {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd_ = (int)syscall(__NR_io_uring_setup, depth_, &params);
+        if (ring_fd_ < 0) {
+            LogDebug(IO_ENGINE_TAG, "io_uring_setup failed: %s", strerror(errno));
+            return false;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap && cq_ring_size_ > sq_ring_size_) {
+            sq_ring_size_ = cq_ring_size_;
+        }
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            return false;
+        }
+        if (single_mmap) {
+            cq_ring_ = sq_ring_;
+        } else {
+            cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+            if (cq_ring_ == MAP_FAILED) {
+                return false;
+            }
+        }
+        sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+        sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sqes_ == MAP_FAILED) {
+            return false;
+        }
+
+        char* sq = (char*)sq_ring_;
+        sq_tail_ = (unsigned*)(sq + params.sq_off.tail);
+        sq_mask_ = *(unsigned*)(sq + params.sq_off.ring_mask);
+        sq_array_ = (unsigned*)(sq + params.sq_off.array);
+        char* cq = (char*)cq_ring_;
+        cq_head_ = (unsigned*)(cq + params.cq_off.head);
+        cq_tail_ = (unsigned*)(cq + params.cq_off.tail);
+        cq_mask_ = *(unsigned*)(cq + params.cq_off.ring_mask);
+        cqes_ = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+    bool queue(bool write, int fd, void* buf, uint32_t len, uint64_t offset, uint32_t tag) override {
+        if (tag >= depth_) {
+            return false;
+        }
+        // 用 READV / WRITEV (5.1 起支持)，不需要探测 IORING_OP_READ (5.6) 是否可用
+        iovecs_[tag].iov_base = buf;
+        iovecs_[tag].iov_len = len;
+
+        unsigned tail = *sq_tail_;                                          // 只有本线程写 sq tail
+        unsigned index = tail & sq_mask_;
+        struct io_uring_sqe* sqe = (struct io_uring_sqe*)sqes_ + index;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)(uintptr_t)&iovecs_[tag];
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = tag;
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        to_submit_++;
+        return true;
+    }
+
+    int submitAndWait(unsigned min, std::vector<IoCompletion>& done) override {
+        int count = reap(done);
+        if (to_submit_ > 0 || (unsigned)count < min) {
+            unsigned wait = (unsigned)count < min ? min - count : 0;
+            int ret;
+            do {
+                ret = (int)syscall(__NR_io_uring_enter, ring_fd_, to_submit_, wait, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            } while (ret < 0 && errno == EINTR);
+            if (ret < 0) {
+                return -errno;
+            }
+            to_submit_ -= (unsigned)ret;
+            inflight_ += (unsigned)ret;
+            count += reap(done);
+        }
+        return count;
+    }
+
+private:
+    int reap(std::vector<IoCompletion>& done) {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        int count = 0;
+        while (head != tail) {
+            const struct io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+            done.push_back(IoCompletion{(uint32_t)cqe->user_data, cqe->res});
+            head++;
+            count++;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        inflight_ -= (unsigned)count;
+        return count;
+    }
+
+    unsigned depth_;
+    int ring_fd_ = -1;
+    void* sq_ring_ = MAP_FAILED;
+    void* cq_ring_ = MAP_FAILED;
+    void* sqes_ = MAP_FAILED;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    size_t sqes_size_ = 0;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    struct io_uring_cqe* cqes_ = nullptr;
+    unsigned to_submit_ = 0;
+    unsigned inflight_ = 0;                             // 已提交、还没收到完成的请求
+    std::vector<struct iovec> iovecs_;                  // 按 tag，请求完成前保持有效
+};
+
+/* ---------------- 内核 aio ---------------- */
+
+class AioEngine : public IoEngine {
+public:
+    explicit AioEngine(unsigned depth) : depth_(depth), iocbs_(depth), events_(depth) {}
+
+    ~AioEngine() override {
+        if (ctx_ != 0) {                                                    // io_destroy 会等在途的请求结束
+            syscall(__NR_io_destroy, ctx_);
+        }
+    }
+
+    bool init() {
+        if (syscall(__NR_io_setup, depth_, &ctx_) < 0) {
+            LogDebug(IO_ENGINE_TAG, "io_setup failed: %s", strerror(errno));
+            ctx_ = 0;
+            return false;
+        }
+        return true;
+    }
+
+    const char* name() const override { return "libaio"; }
+
+    bool queue(bool write, int fd, void* buf, uint32_t len, uint64_t offset, uint32_t tag) override {
+        if (tag >= depth_) {
+            return false;
+        }
+        struct iocb& cb = iocbs_[tag];
+        memset(&cb, 0, sizeof(cb));
+        cb.aio_lio_opcode = write ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+        cb.aio_fildes = (uint32_t)fd;
+        cb.aio_buf = (uint64_t)(uintptr_t)buf;
+        cb.aio_nbytes = len;
+        cb.aio_offset = (int64_t)offset;
+        cb.aio_data = tag;
+        pending_.push_back(&cb);
+        return true;
+    }
+
+    int submitAndWait(unsigned min, std::vector<IoCompletion>& done) override {
+        size_t submitted = 0;
+        unsigned rejected = 0;
+        while (submitted < pending_.size()) {
+            long ret = syscall(__NR_io_submit, ctx_, (long)(pending_.size() - submitted), pending_.data() + submitted);
+            if (ret < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                // io_submit 只在第一个请求就被拒绝 (EBADF、EINVAL 等) 时返回错误，
+                // 和 io_uring 一样把它当作一个失败的完成，后面的请求继续提交
+                done.push_back(IoCompletion{(uint32_t)pending_[submitted]->aio_data, -errno});
+                submitted++;
+                rejected++;
+                continue;
+            }
+            submitted += (size_t)ret;
+        }
+        pending_.clear();
+
+        unsigned wait = min > rejected ? min - rejected : 0;
+        long ret;
+        do {
+            ret = syscall(__NR_io_getevents, ctx_, (long)wait, (long)depth_, events_.data(), nullptr);
+        } while (ret < 0 && errno == EINTR);
+        if (ret < 0) {
+            return -errno;
+        }
+        for (long i = 0; i < ret; ++i) {
+            done.push_back(IoCompletion{(uint32_t)events_[i].data, events_[i].res});
+        }
+        return (int)(ret + rejected);
+    }
+
+private:
+    unsigned depth_;
+    aio_context_t ctx_ = 0;
+    std::vector<struct iocb> iocbs_;                    // 按 tag，请求完成前保持有效
+    std::vector<struct iocb*> pending_;
+    std::vector<struct io_event> events_;
+};
+
+/* ---------------- 同步读写 ---------------- */
+
+class SyncEngine : public IoEngine {
+public:
+    const char* name() const override { return "sync"; }
+
+    bool queue(bool write, int fd, void* buf, uint32_t len, uint64_t offset, uint32_t tag) override {
+        pending_.push_back(Request{write, fd, buf, len, offset, tag});
+        return true;
+    }
+
+    int submitAndWait(unsigned, std::vector<IoCompletion>& done) override {
+        for (const Request& request : pending_) {
+            ssize_t ret = request.write ? pwrite(request.fd, request.buf, request.len, (off_t)request.offset)
+                                        : pread(request.fd, request.buf, request.len, (off_t)request.offset);
+            done.push_back(IoCompletion{request.tag, ret < 0 ? -errno : (int64_t)ret});
+        }
+        int count = (int)pending_.size();
+        pending_.clear();
+        return count;
+    }
+
+private:
+    struct Request {
+        bool write;
+        int fd;
+        void* buf;
+        uint32_t len;
+        uint64_t offset;
+        uint32_t tag;
+    };
+    std::vector<Request> pending_;
+};
+
+std::unique_ptr<IoEngine> IoEngine::create(IoEngineType type, unsigned depth) {
+    if (depth == 0) {
+        depth = 1;
+    }
+    if (type == IO_ENGINE_AUTO || type == IO_ENGINE_URING) {
+        std::unique_ptr<UringEngine> engine(new UringEngine(depth));
+        if (engine->init()) {
+            return engine;
+        }
+        if (type == IO_ENGINE_URING) {
+            return nullptr;
+        }
+    }
+    if (type == IO_ENGINE_AUTO || type == IO_ENGINE_AIO) {
+        std::unique_ptr<AioEngine> engine(new AioEngine(depth));
+        if (engine->init()) {
+            return engine;
+        }
+        if (type == IO_ENGINE_AIO) {
+            return nullptr;
+        }
+    }
+    return std::unique_ptr<IoEngine>(new SyncEngine());
+}
+
+const char* IoEngine::typeName(IoEngineType type) {
+    switch (type) {
+        case IO_ENGINE_URING: return "io_uring";
+        case IO_ENGINE_AIO:   return "libaio";
+        case IO_ENGINE_SYNC:  return "sync";
+        default:              return "auto";
+    }
+}
+
+bool io_target_open(const std::string& path, const char* tempName, bool writeFile, bool writeDevice,
+                    IoTarget& target, std::string& error) {
+    target = IoTarget();
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        error = path + ": " + strerror(errno);
+        return false;
+    }
+
+    std::string openPath = path;
+    int flags = O_CLOEXEC;
+    if (S_ISDIR(st.st_mode)) {
+        char name[64];
+        snprintf(name, sizeof(name), "/%s.%d", tempName, (int)getpid());
+        openPath += name;
+        flags |= O_RDWR | O_CREAT | O_EXCL;
+        target.temporary = true;
+    } else if (S_ISBLK(st.st_mode)) {
+        flags |= writeDevice ? O_RDWR : O_RDONLY;
+        target.blockDevice = true;
+    } else if (S_ISREG(st.st_mode)) {
+        flags |= writeFile ? O_RDWR : O_RDONLY;
+        target.size = (uint64_t)st.st_size;
+    } else {
+        error = path + ": not a directory, block device or file";
+        return false;
+    }
+
+    int fd = open(openPath.c_str(), flags, 0600);
+    if (fd < 0) {
+        error = openPath + ": " + strerror(errno);
+        return false;
+    }
+    int status = fcntl(fd, F_GETFL);
+    target.direct = status >= 0 && fcntl(fd, F_SETFL, status | O_DIRECT) == 0;
+    if (target.temporary) {
+        unlink(openPath.c_str());
+    }
+    if (target.blockDevice && ioctl(fd, BLKGETSIZE64, &target.size) != 0) {
+        error = openPath + ": BLKGETSIZE64 failed: " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    target.fd = fd;
+    return true;
+}
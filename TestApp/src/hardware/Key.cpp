@@ -16,10 +16,10 @@ Key::Key(const char* eventPath, int timeOut) : KEY_EVENT_PATH(eventPath), timeOu
 // wait for key press from multiple input devices
 // return the key code if a key is pressed within the timeout period, otherwise return -1
 // timeOut: timeout in seconds
-int Key::waitForKeyPress(int timeOut) {
+bool Key::openKeyEventDevices(std::vector<int>& deviceFds, bool nonBlock) {
     if (keyEventNamesToPath.empty()) {
         log_thread_safe(LOG_LEVEL_ERROR, KEY_TAG, "Key event names to path map is empty.");
-        return -1;
+        return false;
     }
 
     for (const auto& pair : keyEventNamesToPath) {                                                  // print key event names to listen for
@@ -35,7 +35,7 @@ int Key::waitForKeyPress(int timeOut) {
     dir = opendir(DEV_INPUT);                                                                       // open "/dev/input"
     if (dir == NULL) {
         log_thread_safe(LOG_LEVEL_ERROR, KEY_TAG, "can not open input device directory: %s", DEV_INPUT);
-        return -1;
+        return false;
     }
 
     int keyEventCount = 0;
@@ -57,6 +57,7 @@ int Key::waitForKeyPress(int timeOut) {
                 close(temp_fd);
                 continue;
             }
+            close(temp_fd);
 
             log_thread_safe(LOG_LEVEL_INFO, KEY_TAG, "check device : %s -> %s", device_name, device_path);
             for (auto& pair : keyEventNamesToPath) {
@@ -69,52 +70,75 @@ int Key::waitForKeyPress(int timeOut) {
             }
         }
     }
+    closedir(dir);
 
     log_thread_safe(LOG_LEVEL_INFO, KEY_TAG, "needed key event device count: %d", keyEventCount);
-    if (keyEventCount != keyEventNamesToPath.size()) {
+    if (keyEventCount != (int)keyEventNamesToPath.size()) {
         log_thread_safe(LOG_LEVEL_ERROR, KEY_TAG, "already found key event device count (%d) does not match needed count (%d)", keyEventCount, (int)keyEventNamesToPath.size());
         log_thread_safe(LOG_LEVEL_ERROR, KEY_TAG, "please check if the target key event devices are present");
-        closedir(dir);
-        return -1;
+        return false;
     }
-    closedir(dir);
 
-   // TODO : The code above and the code below can be modified to two separate functions.
-
-    int device_fds[16];
-    int device_count = 0;
-    int maxFd = -1;
-    bool all_opened = true;
+    deviceFds.clear();
     for (const auto& pair : keyEventNamesToPath) {
-        if (device_count >= 16) {
-            log_thread_safe(LOG_LEVEL_WARN, KEY_TAG, "device count exceeds maximum limit of 16, ignoring extra devices");
-            break;
-        }
         const std::string& eventPath = pair.second;
-        device_fds[device_count] = open(eventPath.c_str(), O_RDONLY);                           // store device file descriptor
-        maxFd = (device_fds[device_count] > maxFd) ? device_fds[device_count] : maxFd;          // update maxFd
-        if (device_fds[device_count] < 0) {
+        int fd = open(eventPath.c_str(), nonBlock ? (O_RDONLY | O_NONBLOCK) : O_RDONLY);
+        if (fd < 0) {
             log_thread_safe(LOG_LEVEL_ERROR, KEY_TAG, "can not open target device file: %s", eventPath.c_str());
-            all_opened = false;
+            closeKeyEventDevices(deviceFds);
+            return false;
+        }
+        deviceFds.push_back(fd);
+    }
+    return true;
+}
+
+void Key::closeKeyEventDevices(std::vector<int>& deviceFds) {
+    for (int fd : deviceFds) {
+        if (fd >= 0) {
+            close(fd);
         }
-        device_count++;
     }
+    deviceFds.clear();
+}
 
-    if (!all_opened) {
-        log_thread_safe(LOG_LEVEL_ERROR, KEY_TAG, "Failed to open all target device files");
-        for (int i = 0; i < device_count; i++) {
-            if (device_fds[i] >= 0) {
-                close(device_fds[i]);
+int Key::readKeyCode(int fd) {
+    struct input_event ev;
+    int pressedKeyCode = -1;
+    while (true) {                                                                              // drain all pending events of this device
+        ssize_t n = read(fd, &ev, sizeof(ev));
+        if (n != sizeof(ev)) {
+            if (n == -1 && errno != EAGAIN) {
+                log_thread_safe(LOG_LEVEL_ERROR, KEY_TAG, "read event failed for device fd %d: %s", fd, strerror(errno));
             }
+            break;
+        }
+
+        if (ev.type == EV_KEY && (ev.value == 1 || ev.value == 0)) {                            // key press / release event
+            log_thread_safe(LOG_LEVEL_INFO, KEY_TAG, "Detected key press - Key code: %d", ev.code);
+            pressedKeyCode = ev.code;
+            break;
+        }
+
+        if (!(fcntl(fd, F_GETFL) & O_NONBLOCK)) {                                               // blocking fd: only one read, same as before
+            break;
         }
+    }
+    return pressedKeyCode;
+}
+
+int Key::waitForKeyPress(int timeOut) {
+    std::vector<int> device_fds;
+    if (!openKeyEventDevices(device_fds, false)) {
         return -1;
     }
 
-    struct input_event ev;
+    int maxFd = -1;
     fd_set readfds;
     FD_ZERO(&readfds);                                                                          // clear the set
-    for(int i = 0; i < device_count; i++) {
-        FD_SET(device_fds[i], &readfds);
+    for (int fd : device_fds) {
+        FD_SET(fd, &readfds);
+        maxFd = (fd > maxFd) ? fd : maxFd;
     }
 
     struct timeval timeout;                                                                    // set timeout
@@ -124,39 +148,24 @@ int Key::waitForKeyPress(int timeOut) {
     int ret = select(maxFd + 1, &readfds, NULL, NULL, &timeout);                               // wait for event or timeout
     if (ret == -1) {
         log_thread_safe(LOG_LEVEL_ERROR, KEY_TAG, "select error: %s", strerror(errno));
-        for (int i = 0; i < device_count; i++) {                                               // close all device fds
-            close(device_fds[i]);
-        }
+        closeKeyEventDevices(device_fds);
         return -1;
     } else if (ret == 0) {
         log_thread_safe(LOG_LEVEL_INFO, KEY_TAG, "Timeout, no key pressed within %d seconds", timeOut);
-        for (int i = 0; i < device_count; i++) {
-            close(device_fds[i]);
-        }
+        closeKeyEventDevices(device_fds);
         return 0;
     }
 
     int pressedKeyCode = -1;
-    for (int i = 0; i < device_count; i++) {                                                // check which device has event
-        if (FD_ISSET(device_fds[i], &readfds)) {                                            // device has event
-            ssize_t n = read(device_fds[i], &ev, sizeof(ev));                               // read event
-            if (n == -1) {
-                log_thread_safe(LOG_LEVEL_ERROR, KEY_TAG, "read event failed for device fd %d: %s", device_fds[i], strerror(errno));
-                continue;
+    for (int fd : device_fds) {                                                                // check which device has event
+        if (FD_ISSET(fd, &readfds)) {
+            pressedKeyCode = readKeyCode(fd);
+            if (pressedKeyCode != -1) {
+                break;                                                                        // exit loop after first key press detected
             }
-
-            if (ev.type == EV_KEY) {                                                          // is key event
-                if (ev.value == 1 || ev.value == 0) {                                                          // key press event
-                    log_thread_safe(LOG_LEVEL_INFO, KEY_TAG, "Detected key press - Key code: %d", ev.code);
-                    pressedKeyCode = ev.code;
-                    break;                                                                    // exit loop after first key press detected  ???????
-                }
-            } 
         }
     }
-    for (int i = 0; i < device_count; i++) {
-        close(device_fds[i]);
-    }
+    closeKeyEventDevices(device_fds);
     return pressedKeyCode;
 }
 
@@ -0,0 +1,169 @@
+#include "hardware/MultiDiskBench.h"
+#include "util/Clock.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+
+// 可用的 CPU，从编号大的开始 (rk3588 的 A76 大核是 4-7)
+static std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = CPU_SETSIZE - 1; cpu >= 0; --cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+static void pin_to_cpu(int cpu) {
+    if (cpu < 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+MultiDiskBench::MultiDiskBench(const MultiDiskConfig& config) : config_(config) {
+
+}
+
+bool MultiDiskBench::run(const std::vector<MultiDiskTarget>& targets, MultiDiskResult& result, const interrupt_flag* interrupt) {
+    result = MultiDiskResult();
+    std::vector<int> cpus = allowed_cpus();
+    std::vector<std::unique_ptr<StorageBench>> benches;
+    std::vector<bool> write(targets.size(), false);
+    bool ok = true;
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        MultiDiskDeviceResult device;
+        device.name = targets[i].name;
+        device.path = targets[i].path;
+        device.cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+
+        StorageBenchConfig benchConfig;
+        benchConfig.path = targets[i].path;
+        benchConfig.sizeBytes = config_.sizeBytes;
+        benchConfig.seqBlockSize = config_.blockSize;
+        benchConfig.seqQueueDepth = config_.queueDepth;
+        benchConfig.randQueueDepth = 1;
+        benchConfig.write = config_.write;
+        benchConfig.engine = config_.engine;
+        std::unique_ptr<StorageBench> bench(new StorageBench(benchConfig));
+        StorageBenchResult prepared;
+        if (bench->prepare(prepared, interrupt)) {
+            device.engine = prepared.engine;
+            write[i] = config_.write && bench->canWrite();
+            double fillMBps;
+            // 临时文件只有 fallocate 的空间，不先写一遍的话读到的是文件系统填的零，不经过设备
+            if (!write[i] && bench->canWrite() && !bench->sequentialPass(true, fillMBps, device.error)) {
+                bench.reset();
+            }
+        } else {
+            device.error = prepared.error;
+            bench.reset();
+        }
+        if (!bench) {
+            ok = false;
+            LogError(MULTI_DISK_TAG, "%s (%s): %s", device.name.c_str(), device.path.c_str(), device.error.c_str());
+        }
+        benches.push_back(std::move(bench));
+        result.devices.push_back(device);
+    }
+
+    // 单独测量：一次只跑一个盘，线程和并发阶段一样绑核
+    for (size_t i = 0; i < benches.size(); ++i) {
+        if (!benches[i]) {
+            continue;
+        }
+        MultiDiskDeviceResult& device = result.devices[i];
+        if (interrupt && interrupt->is_stop_requested()) {
+            device.error = "cancelled";                                     // soloMBps 保持 -1，不参加并发测量
+            continue;
+        }
+        std::thread worker([this, &benches, &device, &write, i]() {
+            pin_to_cpu(device.cpu);
+            uint64_t deadline = monotonic_ns() + (uint64_t)config_.soloMs * 1000000ULL;
+            if (!benches[i]->sequentialUntil(write[i], deadline, device.soloMBps, device.error)) {
+                device.soloMBps = -1;
+            }
+        });
+        worker.join();
+    }
+
+    // 并发测量：所有线程就绪后同时开始，使用同一个截止时间
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t ready = 0;
+    size_t expected = 0;
+    uint64_t deadline = 0;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < benches.size(); ++i) {
+        if (!benches[i] || result.devices[i].soloMBps < 0) {
+            continue;
+        }
+        if (interrupt && interrupt->is_stop_requested()) {
+            result.devices[i].error = "cancelled";
+            continue;
+        }
+        expected++;
+        workers.emplace_back([&, i]() {
+            MultiDiskDeviceResult& device = result.devices[i];
+            pin_to_cpu(device.cpu);
+            uint64_t until;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready++;
+                cv.notify_all();
+                cv.wait(lock, [&]() { return deadline != 0; });
+                until = deadline;
+            }
+            if (!benches[i]->sequentialUntil(write[i], until, device.concurrentMBps, device.error)) {
+                device.concurrentMBps = -1;
+            }
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return ready == expected; });
+        deadline = monotonic_ns() + (uint64_t)config_.concurrentMs * 1000000ULL;
+        cv.notify_all();
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    benches.clear();
+
+    for (const MultiDiskDeviceResult& device : result.devices) {
+        if (device.soloMBps > 0 && device.concurrentMBps >= 0) {
+            result.soloSumMBps += device.soloMBps;
+            result.aggregateMBps += device.concurrentMBps;
+        }
+    }
+    for (MultiDiskDeviceResult& device : result.devices) {
+        if (!device.error.empty()) {
+            ok = false;
+            continue;
+        }
+        if (device.soloMBps <= 0 || result.soloSumMBps <= 0) {
+            continue;
+        }
+        device.expectedMBps = result.aggregateMBps * device.soloMBps / result.soloSumMBps;
+        device.collapsed = device.concurrentMBps < device.expectedMBps * config_.collapseRatio;
+        LogInfo(MULTI_DISK_TAG, "%s (%s) cpu %d: solo %.1f MB/s, concurrent %.1f MB/s, expected %.1f MB/s%s",
+            device.name.c_str(), device.path.c_str(), device.cpu, device.soloMBps, device.concurrentMBps,
+            device.expectedMBps, device.collapsed ? ", COLLAPSED" : "");
+    }
+    LogInfo(MULTI_DISK_TAG, "%zu disks: solo sum %.1f MB/s, concurrent aggregate %.1f MB/s",
+        result.devices.size(), result.soloSumMBps, result.aggregateMBps);
+    return ok;
+}
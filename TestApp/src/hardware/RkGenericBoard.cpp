@@ -37,6 +37,11 @@ RkGenericBoard::RkGenericBoard(
     log_thread_safe(LOG_LEVEL_INFO, "RkGenericBoard", "rtcDevicePath: %s", rtcDevicePath.c_str());
 }
 
+void RkGenericBoard::setDeviceRegistry(const DeviceRegistry* registry) {
+    Storage::setDeviceRegistry(registry);
+    setTfDeviceRegistry(registry);
+}
+
 std::string RkGenericBoard::get_board_name() {
     return board_name;
 }
\ No newline at end of file
@@ -13,7 +13,6 @@ Rtc::~Rtc() {
 bool Rtc::getRtcTime(struct rtc_time& tm) {
     if (ioctl(rtcFd_, RTC_RD_TIME, &tm) == -1) {
         LogError(RTC_TAG, "Failed to read RTC time: %s", strerror(errno));
-        close(rtcFd_);
         return false;
     }
 
@@ -35,30 +34,32 @@ bool Rtc::setRtcTime(const struct rtc_time& tm) {
     return true;
 }
 
-bool Rtc::setAndWait(struct rtc_time& tm, int waitSeconds) {
+bool Rtc::setTimeBegin(const struct rtc_time& tm) {
     rtcFd_ = open(rtcDevicePath_.c_str(), O_RDWR);
     if (rtcFd_ < 0) {
         LogError(RTC_TAG, "Failed to open RTC device: %s. ret = %d", rtcDevicePath_.c_str(), rtcFd_);
         rtcFd_ = -1;
+        return false;
     }
 
     if (!setRtcTime(tm)) {
-        close(rtcFd_);
+        closeRtc();
         return false;
     }
+    return true;
+}
 
-    sleep(waitSeconds);
-
+bool Rtc::checkTimeAdvanced(struct rtc_time& tm, int waitSeconds) {
     struct rtc_time newTm;
     if (!getRtcTime(newTm)) {
-        close(rtcFd_);
+        closeRtc();
         return false;
     }
 
     if (newTm.tm_sec != (tm.tm_sec + waitSeconds) % 60) {
         LogError(RTC_TAG, "RTC time did not advance as expected. Expected seconds: %d, Actual seconds: %d",
                  (tm.tm_sec + waitSeconds) % 60, newTm.tm_sec);
-        close(rtcFd_);
+        closeRtc();
         return false;
     }
 
@@ -69,6 +70,23 @@ bool Rtc::setAndWait(struct rtc_time& tm, int waitSeconds) {
            newTm.tm_hour, newTm.tm_min, newTm.tm_sec,
            newTm.tm_year + 1900, newTm.tm_mon + 1, newTm.tm_mday);
 
-    close(rtcFd_);
+    closeRtc();
     return true;
-}
\ No newline at end of file
+}
+
+bool Rtc::setAndWait(struct rtc_time& tm, int waitSeconds) {
+    if (!setTimeBegin(tm)) {
+        return false;
+    }
+
+    sleep(waitSeconds);
+
+    return checkTimeAdvanced(tm, waitSeconds);
+}
+
+void Rtc::closeRtc() {
+    if (rtcFd_ >= 0) {
+        close(rtcFd_);
+        rtcFd_ = -1;
+    }
+}
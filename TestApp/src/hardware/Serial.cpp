@@ -53,7 +53,7 @@ int Serial::openSerial(const char *device, int baudRate) {
     options.c_cc[VMIN] = 0;    // 最小读取字符数
 
     if (tcsetattr(fd, TCSANOW, &options) < 0) {        // 应用配置
-        LogError(SERIAL_TAG, "%s set serial config failed. ", baudRate);
+        LogError(SERIAL_TAG, "%d set serial config failed. ", baudRate);
         close(fd);
         return -1;
     }
@@ -63,63 +63,15 @@ int Serial::openSerial(const char *device, int baudRate) {
     return fd;
 }
 
-// 串口自测方法
+// 串口自测方法，收齐回传数据立即进行下一次，不再固定等 100ms
 bool Serial::serialTest(const char *device, int reCount, int reCountTimeUs, int testCount) {
-    bool result = true;
-    const char *testData = "1234567890!@#$%^&*()";
-    char buffer[256];
-    ssize_t bytesWritten, bytesRead;
-
-    for (int attempt = 0; attempt <= reCount; attempt++) {   // 重试机制
-        result = true;   // 每次重试开始时假设成功
-
-        int fd = openSerial(device, 115200);
-        if (fd < 0) {
-            LogError(SERIAL_TAG, "open serial %s failed on attempt %d", device, attempt + 1);
-            result = false;
-            usleep(reCountTimeUs);   // 等待一段时间后重试
-            continue;
-        }
-
-        for (int i = 0; i < testCount; i++) {    // 跳过前10%的数据，后80%数据用于测试
-            bytesWritten = -1;
-            bytesRead = -1;
-            memset(buffer, 0, sizeof(buffer));
-            bytesWritten = write(fd, testData, strlen(testData));      // 发送数据
-            if (bytesWritten < 0) {
-                LogError(SERIAL_TAG, "write failed. ret = %d", bytesWritten);
-                result = false;        // 写入失败, 标记失败
-                break;                 // 退出当前测试循环，进行重试
-            }
-
-            usleep(100000);  // 等待数据回传100ms 
-
-            bytesRead = read(fd, buffer, sizeof(buffer) - 1);   // 读取数据
-            if (bytesRead < 0) {
-                LogError(SERIAL_TAG, "read failed. ret = %d", bytesRead);
-                result = false;       // 读取失败
-                break;                // 退出当前测试循环，进行重试
-            }
-            buffer[bytesRead] = '\0';
-            LogDebug(SERIAL_TAG, "read : %s", buffer);
-            if ((bytesRead != bytesWritten || strcmp(buffer, testData) != 0)) {      // 
-                LogError(SERIAL_TAG, "test failed. written = %d, read = %d", bytesWritten, bytesRead);
-                result = false;
-                break;                // 退出当前测试循环，进行重试
-            } 
-        }
-
-        close(fd);   // 关闭串口
-        
-        if (result == true) {
-            LogDebug(SERIAL_TAG, "serial test success on attempt %d", attempt + 1);
-            break;  // 测试成功，退出重试循环
-        } else {
-            LogDebug(SERIAL_TAG, "serial test failed on attempt %d, retrying...", attempt + 1);
-            usleep(reCountTimeUs);   // 等待一段时间后重试
-        }
-    }
+    SerialLoopbackConfig config;
+    config.rounds = testCount;
+    config.retries = reCount;
+    config.retryDelayMs = reCountTimeUs / 1000;
 
+    std::vector<SerialLoopbackResult> results;
+    bool result = SerialLoopback(config).run(std::vector<std::string>(1, device), results);
     LogDebug(SERIAL_TAG, "test ok : %d", result);
     return result;
 }
@@ -157,7 +109,7 @@ bool Serial::serial485Test(std::vector<std::string>& deviceList, std::vector<boo
                 ssize_t bytesRead = -1;
                 bytesWritten = write(fds[i], testData, strlen(testData));     // i发送数据
                 if (bytesWritten < 0) {
-                    LogError(SERIAL_TAG, "write to %s failed. ret = %d", deviceList[i].c_str(), bytesWritten);
+                    LogError(SERIAL_TAG, "write to %s failed. ret = %zd", deviceList[i].c_str(), bytesWritten);
                     sendResult[i] = false;              // 标记发送失败
                     continue;                           // 尝试下一次发送
                 }
@@ -165,9 +117,9 @@ bool Serial::serial485Test(std::vector<std::string>& deviceList, std::vector<boo
 
                 memset(buffer, 0, sizeof(buffer));
                 bytesRead = read(fds[j], buffer, sizeof(buffer) - 1);        // j接收数据
-                printf("bytesRead = %s  readCount = %d\n", buffer, bytesRead);
+                printf("bytesRead = %s  readCount = %zd\n", buffer, bytesRead);
                 if (bytesRead < 0) {
-                    LogError(SERIAL_TAG, "read from %s failed. ret = %d", deviceList[j].c_str(), bytesRead);
+                    LogError(SERIAL_TAG, "read from %s failed. ret = %zd", deviceList[j].c_str(), bytesRead);
                     recvResult[j] = false;          // 标记接收失败，只要有一次失败就标记
                     break;                          // 下一个设备
                 } else if (bytesRead > 0) {
@@ -249,7 +201,7 @@ bool Serial::serial485TestRetry(std::vector<std::string>& deviceList, std::vecto
                     ssize_t bytesRead = -1;
                     bytesWritten = write(fds[i], testData, strlen(testData));     // i发送数据
                     if (bytesWritten < 0) {
-                        LogError(SERIAL_TAG, "write to %s failed. ret = %d", deviceList[i].c_str(), bytesWritten);
+                        LogError(SERIAL_TAG, "write to %s failed. ret = %zd", deviceList[i].c_str(), bytesWritten);
                         sendResult[i] = false;              // 标记发送失败
                         continue;                           // 尝试下一次发送
                     }
@@ -257,9 +209,9 @@ bool Serial::serial485TestRetry(std::vector<std::string>& deviceList, std::vecto
 
                     memset(buffer, 0, sizeof(buffer));
                     bytesRead = read(fds[j], buffer, sizeof(buffer) - 1);        // j接收数据
-                    printf("bytesRead = %s  readCount = %d\n", buffer, bytesRead);
+                    printf("bytesRead = %s  readCount = %zd\n", buffer, bytesRead);
                     if (bytesRead < 0) {
-                        LogError(SERIAL_TAG, "read from %s failed. ret = %d", deviceList[j].c_str(), bytesRead);
+                        LogError(SERIAL_TAG, "read from %s failed. ret = %zd", deviceList[j].c_str(), bytesRead);
                         recvResult[j] = false;          // 标记接收失败，只要有一次失败就标记
                         break;                          // 下一个设备
                     } else if (bytesRead > 0) {
@@ -316,6 +268,20 @@ bool Serial::serial485TestRetry(std::vector<std::string>& deviceList, std::vecto
 
 
 
+// 每个接口按 250kbps 配置并 up
+static std::vector<CanLinkConfig> can_link_configs(const std::vector<std::string>& deviceList) {
+    std::vector<CanLinkConfig> configs(deviceList.size());
+    for (size_t i = 0; i < deviceList.size(); ++i) {
+        configs[i].ifname = deviceList[i];
+        configs[i].bitrate = 250000;
+    }
+    return configs;
+}
+
+bool Serial::can_link_status(const std::vector<std::string>& ifnames, std::vector<CanLinkStatus>& status) {
+    return canNetlink.query(ifnames, status);
+}
+
 bool Serial::serialCanTest(std::vector<std::string>& deviceList, std::vector<bool>& sendResult, std::vector<bool>& recvResult, int testCount) {
     if (deviceList.size() < 2) {                     // CAN 测试，至少需要两个设备
         LogError(SERIAL_TAG, "deviceList size < 2");
@@ -326,29 +292,16 @@ bool Serial::serialCanTest(std::vector<std::string>& deviceList, std::vector<boo
     sendResult.resize(deviceList.size(), true);      // 初始化发送结果, 默认成功
     recvResult.resize(deviceList.size(), true);      // 初始化接收结果, 默认成功
 
+    // 所有接口的 down、位速率、up 通过 rtnetlink 一次发出
+    std::vector<CanLinkStatus> links;
+    canNetlink.configure(can_link_configs(deviceList), links);
+
     // 打开所有CAN设备
     for (int i = 0; i < deviceList.size(); i++) {
-        //ip link set down can0 
-        //ip link set can0 type can bitrate 250000
-        //ip link set up can0
-        int ret = system(("ip link set down " + deviceList[i]).c_str());    // 无法使用系统命令设置时，收发结果置位false, system命令不靠谱，后期需要改为ioctl方式
-        if (ret != 0) {
-            sendResult[i] = false;
-            recvResult[i] = false;
-            LogError(SERIAL_TAG, "set down %s failed", deviceList[i].c_str());
-        }
-        ret = system(("ip link set " + deviceList[i] + " type can bitrate 250000").c_str());
-        if (ret != 0) {
+        if (!links[i].ok) {                                             // 无法配置时，收发结果置位false
             sendResult[i] = false;
             recvResult[i] = false;
-            LogError(SERIAL_TAG, "set bitrate for %s failed", deviceList[i].c_str());
-        }
-
-        system(("ip link set up " + deviceList[i]).c_str());
-        if (ret != 0) {
-            sendResult[i] = false;
-            recvResult[i] = false;
-            LogError(SERIAL_TAG, "set up %s failed", deviceList[i].c_str());
+            LogError(SERIAL_TAG, "configure %s failed: %s", deviceList[i].c_str(), links[i].error.c_str());
         }
 
         int sockfd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
@@ -432,7 +385,7 @@ bool Serial::serialCanTest(std::vector<std::string>& deviceList, std::vector<boo
                 // 发送CAN帧
                 bytesWritten = write(sockfds[i], &testFrame, sizeof(testFrame));
                 if (bytesWritten != sizeof(testFrame)) {
-                    LogError(SERIAL_TAG, "write to %s failed. ret = %d, expected = %zu",
+                    LogError(SERIAL_TAG, "write to %s failed. ret = %zd, expected = %zu",
                              deviceList[i].c_str(), bytesWritten, sizeof(testFrame));
                     sendResult[i] = false;              // 标记发送失败
                     continue;                           // 尝试下一次发送
@@ -494,7 +447,7 @@ bool Serial::serialCanTest(std::vector<std::string>& deviceList, std::vector<boo
                         }
                     } else {
                         recvResult[j] = false;          // 标记接收失败
-                        LogError(SERIAL_TAG, "incomplete CAN frame received from %s, bytes=%d",
+                        LogError(SERIAL_TAG, "incomplete CAN frame received from %s, bytes=%zd",
                                  deviceList[j].c_str(), bytesRead);
                         break;                          // 下一个设备
                     }
@@ -543,29 +496,16 @@ bool Serial::serialCanTestRetry(std::vector<std::string>& deviceList, std::vecto
                       << std::endl;
         }
 
+        // 所有接口的 down、位速率、up 通过 rtnetlink 一次发出
+        std::vector<CanLinkStatus> links;
+        canNetlink.configure(can_link_configs(deviceList), links);
+
         // 打开所有CAN设备
         for (int i = 0; i < deviceList.size(); i++) {
-            //ip link set down can0 
-            //ip link set can0 type can bitrate 250000
-            //ip link set up can0
-            int ret = system(("ip link set down " + deviceList[i]).c_str());    // 无法使用系统命令设置时，收发结果置位false, system命令不靠谱，后期需要改为ioctl方式
-            if (ret != 0) {
-                sendResult[i] = false;
-                recvResult[i] = false;
-                LogError(SERIAL_TAG, "set down %s failed", deviceList[i].c_str());
-            }
-            ret = system(("ip link set " + deviceList[i] + " type can bitrate 250000").c_str());
-            if (ret != 0) {
-                sendResult[i] = false;
-                recvResult[i] = false;
-                LogError(SERIAL_TAG, "set bitrate for %s failed", deviceList[i].c_str());
-            }
-
-            system(("ip link set up " + deviceList[i]).c_str());
-            if (ret != 0) {
+            if (!links[i].ok) {                                             // 无法配置时，收发结果置位false
                 sendResult[i] = false;
                 recvResult[i] = false;
-                LogError(SERIAL_TAG, "set up %s failed", deviceList[i].c_str());
+                LogError(SERIAL_TAG, "configure %s failed: %s", deviceList[i].c_str(), links[i].error.c_str());
             }
 
             int sockfd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
@@ -648,7 +588,7 @@ bool Serial::serialCanTestRetry(std::vector<std::string>& deviceList, std::vecto
                     // 发送CAN帧
                     bytesWritten = write(sockfds[i], &testFrame, sizeof(testFrame));
                     if (bytesWritten != sizeof(testFrame)) {
-                        LogError(SERIAL_TAG, "write to %s failed. ret = %d, expected = %zu",
+                        LogError(SERIAL_TAG, "write to %s failed. ret = %zd, expected = %zu",
                                 deviceList[i].c_str(), bytesWritten, sizeof(testFrame));
                         sendResult[i] = false;              // 标记发送失败
                         continue;                           // 尝试下一次发送
@@ -710,7 +650,7 @@ bool Serial::serialCanTestRetry(std::vector<std::string>& deviceList, std::vecto
                             }
                         } else {
                             recvResult[j] = false;          // 标记接收失败
-                            LogError(SERIAL_TAG, "incomplete CAN frame received from %s, bytes=%d",
+                            LogError(SERIAL_TAG, "incomplete CAN frame received from %s, bytes=%zd",
                                     deviceList[j].c_str(), bytesRead);
                             break;                          // 下一个设备
                         }
@@ -752,6 +692,7 @@ bool Serial::serialCanTestRetry(std::vector<std::string>& deviceList, std::vecto
 }
 
 /*
+等价于以下命令，通过 rtnetlink 一次发出:
 /# ip link set can2 down
 /# ip link set can2 type can bitrate 250000
 /# ip link set can2 up
@@ -763,23 +704,10 @@ int Serial::open_can_device(const char* can_interface_name)
         return -1;
     }
 
-    char cmd[128];
-
-    // Bring down interface
-    snprintf(cmd, sizeof(cmd), "ip link set %s down", can_interface_name);
-    system(cmd);
-
-    // Set bitrate 250kbps
-    snprintf(cmd, sizeof(cmd), "ip link set %s type can bitrate 250000", can_interface_name);
-    if (system(cmd) != 0) {
-        log_thread_safe(LOG_LEVEL_ERROR, SERIAL_TAG, "set bitrate failed");
-        return -1;
-    }
-
-    // Bring up interface
-    snprintf(cmd, sizeof(cmd), "ip link set %s up", can_interface_name);
-    if (system(cmd) != 0) {
-        log_thread_safe(LOG_LEVEL_ERROR, SERIAL_TAG, "bring up failed");
+    // Bring down, set bitrate 250kbps and bring up in one netlink batch
+    std::vector<CanLinkStatus> links;
+    if (!canNetlink.configure(can_link_configs(std::vector<std::string>(1, can_interface_name)), links)) {
+        log_thread_safe(LOG_LEVEL_ERROR, SERIAL_TAG, "configure %s failed: %s", can_interface_name, links[0].error.c_str());
         return -1;
     }
 
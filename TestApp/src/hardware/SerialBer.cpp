@@ -0,0 +1,435 @@
+#include "hardware/SerialBer.h"
+
+// termios2 (BOTHER 任意波特率) 和 glibc 的 <termios.h> 不能同时包含，这个文件只用内核的定义
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+static const int BER_INTERRUPT_POLL_MS = 100;          // 有中断标志时 epoll 最多等这么久，取消后及时退出
+
+static uint64_t now_us() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+namespace {
+
+const int BER_LOCK_BITS = 64;               // 搜索时连续这么多位符合预测才锁定
+const int BER_WINDOW_BITS = 256;            // 锁定后按窗口统计错误
+const int BER_LOSS_ERRORS = 32;             // 一个窗口内错误位超过 1/8 判为失步，失步后约一半的位出错
+
+/*
+ * Fibonacci LFSR，state 的 bit0 是最近的一位，新位 = b[n-order] ^ b[n-tap]
+ * 按 UART 的顺序 (低位先发) 把连续 8 位装成一个字节
+ */
+struct Prbs {
+    int order;
+    int tap;
+    uint32_t mask;
+    uint32_t state;
+
+    explicit Prbs(int prbs) : order(prbs == 23 ? 23 : 15), tap(prbs == 23 ? 18 : 14),
+        mask((1u << order) - 1), state(mask) {
+
+    }
+
+    uint32_t predict() const {
+        return ((state >> (order - 1)) ^ (state >> (tap - 1))) & 1;
+    }
+
+    void shift(uint32_t bit) {
+        state = ((state << 1) | bit) & mask;
+    }
+
+    uint8_t nextByte() {
+        uint8_t byte = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint32_t bit = predict();
+            shift(bit);
+            byte |= (uint8_t)(bit << i);
+        }
+        return byte;
+    }
+};
+
+/*
+ * 接收端: 未锁定时把收到的位移入寄存器 (自同步)，锁定后寄存器只由自己的预测推进，
+ * 这样一个错误位只算一次，不会在后面 order / tap 位处再引起两次错误
+ */
+struct PrbsChecker {
+    Prbs prbs;
+    bool locked = false;
+    int searchBits = 0;
+    int goodBits = 0;
+    uint64_t received = 0;                  // 收到的总字节数
+    uint64_t lossByte = 0;                  // 最近一次失步时的 received
+
+    // 错位可能在上一个窗口的末尾就开始了，所以晚一个窗口再计入结果，失步时两个窗口都丢弃
+    struct Window {
+        uint64_t bits = 0;
+        uint64_t bitErrors = 0;
+        uint64_t byteErrors = 0;
+        uint64_t bytes = 0;
+    };
+    Window current;
+    Window pending;
+
+    explicit PrbsChecker(int order) : prbs(order) {
+
+    }
+
+    static void commit(Window& window, SerialBerResult& result) {
+        result.bitErrors += window.bitErrors;
+        result.byteErrors += window.byteErrors;
+        result.checkedBytes += window.bytes;
+        window = Window();
+    }
+
+    void flush(SerialBerResult& result) {
+        commit(pending, result);
+        commit(current, result);
+    }
+
+    void feed(const uint8_t* data, size_t len, uint64_t nowUs, uint64_t startUs, SerialBerResult& result) {
+        for (size_t n = 0; n < len; ++n) {
+            uint8_t byte = data[n];
+            received++;
+            if (locked) {
+                uint8_t diff = byte ^ prbs.nextByte();
+                current.bitErrors += __builtin_popcount(diff);
+                current.byteErrors += diff != 0;
+                current.bytes++;
+                current.bits += 8;
+                if (current.bitErrors > BER_LOSS_ERRORS) {
+                    result.slipBytes += pending.bytes + current.bytes;     // 错位引起的错误不算误码
+                    pending = current = Window();
+                    locked = false;
+                    searchBits = goodBits = 0;
+                    lossByte = received;
+                    result.resyncs++;
+                } else if (current.bits >= BER_WINDOW_BITS) {
+                    commit(pending, result);
+                    pending = current;
+                    current = Window();
+                }
+                continue;
+            }
+
+            for (int i = 0; i < 8; ++i) {
+                uint32_t bit = (byte >> i) & 1;
+                if (searchBits >= prbs.order) {
+                    goodBits = (prbs.predict() == bit) ? goodBits + 1 : 0;
+                }
+                prbs.shift(bit);
+                searchBits++;
+            }
+            result.slipBytes++;
+            if (goodBits >= BER_LOCK_BITS && prbs.state != 0) {      // 全 0 (如线路一直是低电平) 也符合预测，不能锁定
+                locked = true;
+                if (!result.locked) {
+                    result.locked = true;
+                    result.firstLockUs = nowUs - startUs;
+                } else {
+                    // 按线路时间算 (8N1 每字节 10 位)，一次 read 可能带回失步前后的很多字节，用读到的时间不准
+                    uint64_t resyncUs = (received - lossByte) * 10 * 1000000 / result.baudRate;
+                    result.maxResyncUs = std::max(result.maxResyncUs, resyncUs);
+                }
+            }
+        }
+    }
+};
+
+struct BerPort {
+    int fd = -1;
+    Prbs tx;
+    PrbsChecker rx;
+    bool txDone = false;
+    bool done = false;
+    uint64_t txDeadlineUs = 0;
+    uint64_t txDoneUs = 0;
+    uint64_t lastRxUs = 0;
+    uint8_t txBuf[4096];
+    size_t txLen = 0;
+    size_t txOff = 0;
+    struct serial_icounter_struct icount;
+
+    explicit BerPort(int order) : tx(order), rx(order) {
+        memset(&icount, 0, sizeof(icount));
+    }
+};
+
+}
+
+// 原始模式 8N1、无流控、非阻塞，波特率用 BOTHER 直接给数值；返回驱动实际采用的波特率
+static int open_ber_port(const char* device, uint32_t baudRate, uint32_t& actualBaud, std::string& error) {
+    if (baudRate == 0) {
+        error = "invalid baud rate 0";
+        return -1;
+    }
+    int fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        error = std::string("open failed: ") + strerror(errno);
+        return -1;
+    }
+    struct termios2 tio;
+    if (ioctl(fd, TCGETS2, &tio) < 0) {
+        error = std::string("TCGETS2 failed: ") + strerror(errno);
+        close(fd);
+        return -1;
+    }
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT) | CSIZE | PARENB | CSTOPB | CRTSCTS);
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT) | CS8 | CREAD | CLOCAL;
+    tio.c_ispeed = baudRate;
+    tio.c_ospeed = baudRate;
+    tio.c_iflag = 0;                        // 帧错误的字节按 0 读出，在比较中计为错误位
+    tio.c_oflag = 0;
+    tio.c_lflag = 0;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (ioctl(fd, TCSETS2, &tio) < 0 || ioctl(fd, TCGETS2, &tio) < 0) {
+        error = std::string("TCSETS2 failed: ") + strerror(errno);
+        close(fd);
+        return -1;
+    }
+    actualBaud = tio.c_ospeed ? tio.c_ospeed : baudRate;        // pty 不记录波特率
+    ioctl(fd, TCFLSH, TCIOFLUSH);
+    return fd;
+}
+
+SerialBer::SerialBer(const SerialBerConfig& config) : config_(config) {
+
+}
+
+bool SerialBer::run(const std::vector<std::string>& devices, std::vector<SerialBerResult>& results,
+                    const interrupt_flag* interrupt) {
+    results.assign(devices.size(), SerialBerResult());
+    std::vector<BerPort> ports;
+    ports.reserve(devices.size());
+    for (size_t i = 0; i < devices.size(); ++i) {
+        ports.emplace_back(config_.prbs);
+    }
+    if (devices.empty()) {
+        return true;
+    }
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        LogError(SERIAL_BER_TAG, "epoll_create1 failed: %s", strerror(errno));
+        return false;
+    }
+
+    uint32_t durationMs = config_.durationMs;
+    if (durationMs == 0 && config_.byteCount == 0) {
+        durationMs = 2000;
+    }
+    const uint64_t startUs = now_us();
+    size_t remaining = 0;
+    for (size_t i = 0; i < devices.size(); ++i) {
+        BerPort& port = ports[i];
+        SerialBerResult& result = results[i];
+        result.device = devices[i];
+        result.prbs = port.tx.order;
+        port.fd = open_ber_port(devices[i].c_str(), config_.baudRate, result.baudRate, result.error);
+        if (port.fd < 0) {
+            LogError(SERIAL_BER_TAG, "%s: %s", devices[i].c_str(), result.error.c_str());
+            port.done = true;
+            continue;
+        }
+        result.icountValid = ioctl(port.fd, TIOCGICOUNT, &port.icount) == 0;
+
+        // 只按字节数时也给一个上限: 线路时间的两倍再加 2 秒，防止发不出去时一直等
+        uint64_t limitUs = durationMs ? (uint64_t)durationMs * 1000 :
+            config_.byteCount * 10 * 1000000 / result.baudRate * 2 + 2000000;
+        port.txDeadlineUs = startUs + limitUs;
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.u64 = i;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, port.fd, &ev) < 0) {
+            result.error = std::string("epoll_ctl failed: ") + strerror(errno);
+            close(port.fd);
+            port.fd = -1;
+            port.done = true;
+            continue;
+        }
+        remaining++;
+    }
+
+    auto stop_tx = [&](size_t i, uint64_t now) {
+        BerPort& port = ports[i];
+        port.txDone = true;
+        port.txDoneUs = now;
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, port.fd, &ev);
+    };
+    auto on_writable = [&](size_t i) {
+        BerPort& port = ports[i];
+        SerialBerResult& result = results[i];
+        for (;;) {
+            if (port.txOff == port.txLen) {
+                uint64_t left = config_.byteCount ? config_.byteCount - result.bytesSent : sizeof(port.txBuf);
+                if (left == 0 || now_us() >= port.txDeadlineUs) {
+                    stop_tx(i, now_us());
+                    return;
+                }
+                port.txLen = left < sizeof(port.txBuf) ? (size_t)left : sizeof(port.txBuf);
+                for (size_t k = 0; k < port.txLen; ++k) {
+                    port.txBuf[k] = port.tx.nextByte();
+                }
+                port.txOff = 0;
+            }
+            ssize_t n = write(port.fd, port.txBuf + port.txOff, port.txLen - port.txOff);
+            if (n < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    result.error = std::string("write failed: ") + strerror(errno);
+                    stop_tx(i, now_us());
+                }
+                return;
+            }
+            port.txOff += n;
+            result.bytesSent += n;
+        }
+    };
+    auto on_readable = [&](size_t i) {
+        BerPort& port = ports[i];
+        SerialBerResult& result = results[i];
+        uint8_t buffer[4096];
+        for (;;) {
+            ssize_t n = read(port.fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                uint64_t now = now_us();
+                port.rx.feed(buffer, n, now, startUs, result);
+                result.bytesReceived += n;
+                port.lastRxUs = now;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && result.error.empty()) {
+                result.error = std::string("read failed: ") + strerror(errno);
+            }
+            return;
+        }
+    };
+    auto finish = [&](size_t i) {
+        BerPort& port = ports[i];
+        SerialBerResult& result = results[i];
+        struct serial_icounter_struct after;
+        if (result.icountValid && ioctl(port.fd, TIOCGICOUNT, &after) == 0) {
+            result.frameErrors = after.frame - port.icount.frame;
+            result.overruns = after.overrun - port.icount.overrun;
+            result.bufOverruns = after.buf_overrun - port.icount.buf_overrun;
+            result.parityErrors = after.parity - port.icount.parity;
+            result.breaks = after.brk - port.icount.brk;
+        }
+        epoll_ctl(epfd, EPOLL_CTL_DEL, port.fd, nullptr);
+        close(port.fd);
+        port.fd = -1;
+        port.done = true;
+        remaining--;
+
+        if (port.rx.locked) {
+            port.rx.flush(result);
+        }
+        if (port.lastRxUs > startUs) {
+            result.elapsedUs = port.lastRxUs - startUs;
+            result.throughputBps = (double)result.bytesReceived * 1000000.0 / result.elapsedUs;
+            result.efficiency = result.throughputBps / (result.baudRate / 10.0);
+        }
+        if (result.checkedBytes) {
+            result.byteErrorRate = (double)result.byteErrors / result.checkedBytes;
+        }
+        if (!result.locked && result.error.empty()) {
+            result.error = result.bytesReceived ? "never locked to prbs pattern" : "no data received";
+        }
+        LogInfo(SERIAL_BER_TAG, "%s %u baud prbs%d: sent %llu, received %llu, %.0f B/s (%.1f%%), byte errors %llu / %llu, "
+            "resyncs %d, frame %u, overrun %u, buf overrun %u",
+            result.device.c_str(), result.baudRate, result.prbs, (unsigned long long)result.bytesSent,
+            (unsigned long long)result.bytesReceived, result.throughputBps, result.efficiency * 100,
+            (unsigned long long)result.byteErrors, (unsigned long long)result.checkedBytes, result.resyncs,
+            result.frameErrors, result.overruns, result.bufOverruns);
+    };
+
+    struct epoll_event events[16];
+    while (remaining > 0) {
+        if (interrupt && interrupt->is_stop_requested()) {
+            for (size_t i = 0; i < ports.size(); ++i) {
+                if (!ports[i].done) {
+                    results[i].error = "cancelled";
+                    finish(i);
+                }
+            }
+            break;
+        }
+        uint64_t now = now_us();
+        uint64_t nearest = UINT64_MAX;
+        for (size_t i = 0; i < ports.size(); ++i) {
+            if (ports[i].done) {
+                continue;
+            }
+            uint64_t deadline = ports[i].txDone ?
+                std::max(ports[i].lastRxUs, ports[i].txDoneUs) + (uint64_t)config_.drainMs * 1000 : ports[i].txDeadlineUs;
+            nearest = std::min(nearest, deadline);
+        }
+        int timeoutMs = nearest > now ? (int)((nearest - now + 999) / 1000) : 0;
+        if (interrupt) {
+            timeoutMs = std::min(timeoutMs, BER_INTERRUPT_POLL_MS);
+        }
+
+        int n = epoll_wait(epfd, events, sizeof(events) / sizeof(events[0]), timeoutMs);
+        if (n < 0 && errno != EINTR) {
+            LogError(SERIAL_BER_TAG, "epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+        for (int k = 0; k < n; ++k) {
+            size_t i = (size_t)events[k].data.u64;
+            if (ports[i].done) {
+                continue;
+            }
+            if (events[k].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                on_readable(i);
+            }
+            if (!ports[i].txDone && (events[k].events & EPOLLOUT)) {
+                on_writable(i);
+            }
+        }
+
+        now = now_us();
+        for (size_t i = 0; i < ports.size(); ++i) {
+            BerPort& port = ports[i];
+            if (port.done) {
+                continue;
+            }
+            if (!port.txDone && now >= port.txDeadlineUs) {
+                stop_tx(i, now);
+            }
+            bool drained = results[i].bytesReceived >= results[i].bytesSent;
+            if (port.txDone && (drained || now >= std::max(port.lastRxUs, port.txDoneUs) + (uint64_t)config_.drainMs * 1000)) {
+                finish(i);
+            }
+        }
+    }
+
+    bool allOk = true;
+    for (size_t i = 0; i < ports.size(); ++i) {
+        if (!ports[i].done) {
+            finish(i);                              // epoll 出错时中止
+        }
+        allOk = allOk && results[i].locked && results[i].error.empty();
+    }
+    close(epfd);
+    return allOk;
+}
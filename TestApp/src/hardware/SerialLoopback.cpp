@@ -0,0 +1,279 @@
+#include "hardware/SerialLoopback.h"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <unistd.h>
+
+static uint64_t now_us() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static speed_t baud_to_speed(int baudRate) {
+    switch (baudRate) {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        case 1500000: return B1500000;
+        default:      return B0;
+    }
+}
+
+SerialLoopback::SerialLoopback(const SerialLoopbackConfig& config) : config_(config) {
+
+}
+
+int SerialLoopback::openRaw(const char* device, int baudRate) {
+    speed_t speed = baud_to_speed(baudRate);
+    if (speed == B0) {
+        errno = EINVAL;
+        return -1;
+    }
+    int fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct termios options;
+    if (tcgetattr(fd, &options) < 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    cfsetispeed(&options, speed);
+    cfsetospeed(&options, speed);
+    options.c_cflag &= ~(PARENB | CSTOPB | CSIZE | CRTSCTS);       // 8N1，无硬件流控
+    options.c_cflag |= CS8 | CREAD | CLOCAL;
+    options.c_iflag &= ~(IXON | IXOFF | IXANY | ICRNL | INLCR | IGNCR | ISTRIP);
+    options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG | IEXTEN);
+    options.c_oflag &= ~OPOST;
+    options.c_cc[VTIME] = 0;                                        // 非阻塞读，等待由 epoll 完成
+    options.c_cc[VMIN] = 0;
+    if (tcsetattr(fd, TCSANOW, &options) < 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+namespace {
+
+enum PortState {
+    PORT_WAIT_DATA,         // 已发出标记，等回传
+    PORT_WAIT_RETRY,        // 失败了，等到 deadlineUs 重新打开
+    PORT_DONE,
+};
+
+struct LoopbackPort {
+    int fd = -1;
+    PortState state = PORT_WAIT_RETRY;
+    int round = 0;
+    std::string token;
+    std::string received;
+    uint64_t sentUs = 0;
+    uint64_t deadlineUs = 0;
+    uint64_t maxRoundTripUs = 0;
+};
+
+}
+
+bool SerialLoopback::run(const std::vector<std::string>& devices, std::vector<SerialLoopbackResult>& results) {
+    results.assign(devices.size(), SerialLoopbackResult());
+    std::vector<LoopbackPort> ports(devices.size());
+    if (devices.empty()) {
+        return true;
+    }
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        LogError(SERIAL_LOOPBACK_TAG, "epoll_create1 failed: %s", strerror(errno));
+        for (size_t i = 0; i < devices.size(); ++i) {
+            results[i].device = devices[i];
+            results[i].error = "epoll_create1 failed";
+        }
+        return false;
+    }
+
+    std::random_device rd;
+    const uint32_t nonce = rd();                    // 区分不同次测试，避免读到上一次残留的数据也能匹配
+    const uint64_t startUs = now_us();
+    size_t remaining = devices.size();
+
+    auto close_port = [&](size_t i) {
+        if (ports[i].fd >= 0) {
+            epoll_ctl(epfd, EPOLL_CTL_DEL, ports[i].fd, nullptr);
+            close(ports[i].fd);
+            ports[i].fd = -1;
+        }
+    };
+    auto finish = [&](size_t i, bool ok) {
+        close_port(i);
+        ports[i].state = PORT_DONE;
+        results[i].ok = ok;
+        if (ok) {
+            results[i].error.clear();
+        }
+        results[i].rounds = ports[i].round;
+        results[i].maxRoundTripUs = ports[i].maxRoundTripUs;
+        results[i].elapsedUs = now_us() - startUs;
+        remaining--;
+    };
+    auto fail = [&](size_t i, const std::string& reason) {
+        results[i].error = reason;
+        LogError(SERIAL_LOOPBACK_TAG, "%s attempt %d failed: %s", devices[i].c_str(), results[i].attempts, reason.c_str());
+        if (results[i].attempts > config_.retries) {
+            finish(i, false);
+            return;
+        }
+        close_port(i);
+        ports[i].state = PORT_WAIT_RETRY;
+        ports[i].deadlineUs = now_us() + (uint64_t)config_.retryDelayMs * 1000;
+    };
+    auto send_token = [&](size_t i) {
+        LoopbackPort& port = ports[i];
+        char token[32];
+        int len = snprintf(token, sizeof(token), "<%08x:%02zu:%04d>", nonce, i, port.round);
+        port.token.assign(token, len);
+        port.received.clear();
+        port.sentUs = now_us();
+        port.deadlineUs = port.sentUs + (uint64_t)config_.timeoutMs * 1000;
+        port.state = PORT_WAIT_DATA;
+        ssize_t written = write(port.fd, port.token.data(), port.token.size());     // 标记远小于发送缓冲区，一次写完
+        if (written != (ssize_t)port.token.size()) {
+            fail(i, written < 0 ? std::string("write failed: ") + strerror(errno) : "short write");
+        }
+    };
+    auto start_attempt = [&](size_t i) {
+        LoopbackPort& port = ports[i];
+        results[i].attempts++;
+        port.round = 0;
+        port.maxRoundTripUs = 0;
+        port.fd = openRaw(devices[i].c_str(), config_.baudRate);
+        if (port.fd < 0) {
+            fail(i, std::string("open failed: ") + strerror(errno));
+            return;
+        }
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, port.fd, &ev) < 0) {
+            fail(i, std::string("epoll_ctl failed: ") + strerror(errno));
+            return;
+        }
+        send_token(i);
+    };
+    auto on_readable = [&](size_t i) {
+        LoopbackPort& port = ports[i];
+        char buffer[256];
+        for (;;) {
+            ssize_t n = read(port.fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                port.received.append(buffer, n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(i, std::string("read failed: ") + strerror(errno));
+                return;
+            }
+            break;
+        }
+
+        size_t len = std::min(port.received.size(), port.token.size());
+        if (port.received.compare(0, len, port.token, 0, len) != 0 || port.received.size() > port.token.size()) {
+            fail(i, "round " + std::to_string(port.round) + " expected \"" + port.token + "\", got \"" + port.received + "\"");
+            return;
+        }
+        if (port.received.size() < port.token.size()) {
+            return;                                 // 还没收齐
+        }
+
+        uint64_t roundTripUs = now_us() - port.sentUs;
+        if (roundTripUs > port.maxRoundTripUs) {
+            port.maxRoundTripUs = roundTripUs;
+        }
+        port.round++;
+        if (port.round >= config_.rounds) {
+            finish(i, true);
+        } else {
+            send_token(i);
+        }
+    };
+
+    for (size_t i = 0; i < devices.size(); ++i) {
+        results[i].device = devices[i];
+        start_attempt(i);
+    }
+
+    struct epoll_event events[16];
+    while (remaining > 0) {
+        uint64_t now = now_us();
+        uint64_t nearest = UINT64_MAX;
+        for (size_t i = 0; i < ports.size(); ++i) {
+            if (ports[i].state != PORT_DONE && ports[i].deadlineUs < nearest) {
+                nearest = ports[i].deadlineUs;
+            }
+        }
+        int timeoutMs = nearest > now ? (int)((nearest - now + 999) / 1000) : 0;
+
+        int n = epoll_wait(epfd, events, sizeof(events) / sizeof(events[0]), timeoutMs);
+        if (n < 0 && errno != EINTR) {
+            LogError(SERIAL_LOOPBACK_TAG, "epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+        for (int k = 0; k < n; ++k) {
+            size_t i = (size_t)events[k].data.u64;
+            if (ports[i].state != PORT_WAIT_DATA) {
+                continue;                           // 同一批事件中前面已经处理掉
+            }
+            if (events[k].events & EPOLLIN) {
+                on_readable(i);
+            } else if (events[k].events & (EPOLLERR | EPOLLHUP)) {
+                fail(i, "port hung up");
+            }
+        }
+
+        now = now_us();
+        for (size_t i = 0; i < ports.size(); ++i) {
+            if (ports[i].state == PORT_WAIT_DATA && now >= ports[i].deadlineUs) {
+                fail(i, "round " + std::to_string(ports[i].round) + " timeout, received " +
+                    std::to_string(ports[i].received.size()) + " of " + std::to_string(ports[i].token.size()) + " bytes");
+            } else if (ports[i].state == PORT_WAIT_RETRY && now >= ports[i].deadlineUs) {
+                start_attempt(i);
+            }
+        }
+    }
+
+    bool allOk = true;
+    for (size_t i = 0; i < ports.size(); ++i) {
+        if (ports[i].state != PORT_DONE) {
+            finish(i, false);                       // epoll 出错时中止
+            results[i].error = "aborted";
+        }
+        allOk = allOk && results[i].ok;
+        LogInfo(SERIAL_LOOPBACK_TAG, "%s %s: %d rounds, max round trip %llu us, attempts %d, finished at %llu ms",
+            devices[i].c_str(), results[i].ok ? "OK" : "NG", results[i].rounds, (unsigned long long)results[i].maxRoundTripUs,
+            results[i].attempts, (unsigned long long)(results[i].elapsedUs / 1000));
+    }
+    close(epfd);
+    return allOk;
+}
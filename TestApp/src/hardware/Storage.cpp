@@ -1,8 +1,9 @@
 #include "hardware/Storage.h"
+#include <algorithm>
 
-Storage::Storage(const char* mmcDeviceSizePath, const char* pcieDeviceSizePath) 
+Storage::Storage(const char* mmcDeviceSizePath, const char* pcieDeviceSizePath, const char* usbSysfsRoot) 
     : MMC_DEVICE_SIZE_PATH(mmcDeviceSizePath), PCIE_DEVICE_SIZE_PATH(pcieDeviceSizePath) ,
-    usbDiskSizeList(10), facilityUsbInfoList2_0(10), facilityUsbInfoList3_0(10), lsusbFacilityUsbInfoList(30) {
+    usbDiskSizeList(10), facilityUsbInfoList2_0(10), facilityUsbInfoList3_0(10), usbSysfs(usbSysfsRoot) {
 
 }
 
@@ -21,7 +22,25 @@ float Storage::getDdrSize() {
     return roundedGb;
 }
 
+// 登记表中按角色找到的磁盘容量，GB 保留两位小数，没有该设备返回 -1
+static float role_disk_size_gb(const char* tag, const BlockDeviceInfo* disk, const char* role) {
+    if (disk == nullptr) {
+        log_thread_safe(LOG_LEVEL_ERROR, tag, "no %s device found", role);
+        return -1;
+    }
+    float totalGb = static_cast<float>(disk->sizeBytes) / (1024.0f * 1024.0f * 1024.0f);
+    float roundedGb = round(totalGb * 100.0f) / 100.0f;
+    log_thread_safe(LOG_LEVEL_INFO, tag, "%s %s total size: %llu KB (%.2f GB)", role, disk->name.c_str(),
+        (unsigned long long)(disk->sizeBytes / 1024), roundedGb);
+    return roundedGb;
+}
+
 float Storage::getEmmcSize() {
+    std::shared_ptr<const DeviceSnapshot> snapshot = deviceRegistry ? deviceRegistry->snapshot() : nullptr;
+    if (snapshot) {
+        return role_disk_size_gb(STORAGE_TAG, snapshot->emmc(), "emmc");
+    }
+
     FILE* fp = fopen(MMC_DEVICE_SIZE_PATH, "r");
     if (!fp) {
         log_thread_safe(LOG_LEVEL_ERROR, STORAGE_TAG, "can not open : %s", MMC_DEVICE_SIZE_PATH);
@@ -48,6 +67,11 @@ float Storage::getEmmcSize() {
 } 
 
 float Storage::getPcieSize() {
+    std::shared_ptr<const DeviceSnapshot> snapshot = deviceRegistry ? deviceRegistry->snapshot() : nullptr;
+    if (snapshot) {
+        return role_disk_size_gb(STORAGE_TAG, snapshot->nvme(), "pcie");
+    }
+
     FILE* fp = fopen(PCIE_DEVICE_SIZE_PATH, "r");
     if (!fp) {
         log_thread_safe(LOG_LEVEL_ERROR, STORAGE_TAG, "can not open : %s", PCIE_DEVICE_SIZE_PATH);
@@ -85,7 +109,23 @@ bool Storage::isUsbDevice(struct udev_device *dev) {
     return false; 
 }
 
+void Storage::setDeviceRegistry(const DeviceRegistry* registry) {
+    deviceRegistry = registry;
+}
+
 float Storage::getUdiskSize() {
+    std::shared_ptr<const DeviceSnapshot> snapshot = deviceRegistry ? deviceRegistry->snapshot() : nullptr;
+    if (snapshot) {
+        std::vector<const BlockDeviceInfo*> disks = snapshot->usbDisks();
+        if (disks.empty()) {
+            LogDebug(STORAGE_TAG, "no usb device found");
+            return -1;
+        }
+        double gb = (double)disks.back()->sizeBytes / (1024 * 1024 * 1024);     // 和 udev 遍历一样取最后一个
+        LogDebug(STORAGE_TAG, "udisk %s total size: %.2f GB", disks.back()->name.c_str(), gb);
+        return gb;
+    }
+
     struct udev *udev = udev_new();
     if (!udev) {
         log_thread_safe(LOG_LEVEL_ERROR, STORAGE_TAG, "can not create udev");
@@ -521,160 +561,32 @@ void Storage::scan_usb_with_libusb() {
         facilityUsbInfoList2_0[i].pid = 0;
     }
 
-    libusb_device** devs;
-    libusb_context* ctx = NULL;
-    ssize_t cnt;
-    int r, i;
-    
-    r = libusb_init(&ctx);
-    if (r < 0) {
-        log_thread_safe(LOG_LEVEL_ERROR, STORAGE_TAG, "init libusb failed");
+    // 常驻的 libusb 上下文和描述符缓存，不再每次 libusb_init、打开每个设备读字符串
+    std::vector<std::shared_ptr<UsbDescriptorEntry>> devices = usbDescriptorCache.devices();
+    if (devices.empty()) {
+        log_thread_safe(LOG_LEVEL_ERROR, STORAGE_TAG, "no usb devices from libusb");
         return;
     }
-    
-    cnt = libusb_get_device_list(ctx, &devs);
-    if (cnt < 0) {
-        log_thread_safe(LOG_LEVEL_ERROR, STORAGE_TAG, "get device list failed");
-        libusb_exit(ctx);
-        return;
-    }
-    
-    log_thread_safe(LOG_LEVEL_INFO, STORAGE_TAG, "found %ld usb devices", cnt);
-    
-    for (i = 0; i < cnt; i++) {
-        libusb_device* dev = devs[i];
-        struct libusb_device_descriptor desc;
-        libusb_device_handle* handle = NULL;
-        unsigned char manufacturer[256] = {0};
-        unsigned char product[256] = {0};
-        unsigned char serial[256] = {0};
-        char type_desc[100] = {0};
-        int r;
-        
-        r = libusb_get_device_descriptor(dev, &desc);
-        if (r < 0) {
-            continue;
-        }
-        
-        // 获取详细设备类型
-        get_detailed_device_type(dev, desc.bDeviceClass, desc.bDeviceSubClass, 
-                                desc.bDeviceProtocol, type_desc);
-        
-        // printf("设备 %d:\n", i+1);
-        // printf("  Vendor ID: 0x%04x\n", desc.idVendor);
-        // printf("  Product ID: 0x%04x\n", desc.idProduct);
-        // printf("  设备类: 0x%02x (%s)\n", desc.bDeviceClass, get_device_class_name(desc.bDeviceClass));
-        // printf("  设备子类: 0x%02x\n", desc.bDeviceSubClass);
-        // printf("  设备协议: 0x%02x\n", desc.bDeviceProtocol);
-        // printf("  设备类型: %s\n", type_desc);
-        
-        // USB版本信息
-        // printf("  USB版本: %d.%d\n", desc.bcdUSB >> 8, desc.bcdUSB & 0xFF);
-        
-        // 尝试打开设备获取详细信息
-        r = libusb_open(dev, &handle);
-        if (r == 0) {
-            // 获取制造商字符串
-            if (desc.iManufacturer) {
-                r = libusb_get_string_descriptor_ascii(handle, desc.iManufacturer, 
-                                                      manufacturer, sizeof(manufacturer));
-                // if (r > 0) {
-                //     printf("  制造商: %s\n", manufacturer);
-                // }
-            }
-            
-            // 获取产品字符串
-            if (desc.iProduct) {
-                r = libusb_get_string_descriptor_ascii(handle, desc.iProduct, 
-                                                      product, sizeof(product));
-                // if (r > 0) {
-                //     printf("  产品: %s\n", product);
-                // }
-            }
-            
-            // 获取序列号
-            if (desc.iSerialNumber) {
-                r = libusb_get_string_descriptor_ascii(handle, desc.iSerialNumber, 
-                                                      serial, sizeof(serial));
-                // if (r > 0) {
-                //     printf("  序列号: %s\n", serial);
-                // }
-            }
-            
-            libusb_close(handle);
-        }
-        
-        // 获取总线号和设备地址
-        // printf("  总线: %d, 设备: %d\n", 
-        //        libusb_get_bus_number(dev), 
-        //        libusb_get_device_address(dev));
-        
-        // 如果是存储设备，查找设备节点和挂载路径并显示容量
-        if (is_mass_storage_device_by_interface(dev)) {
-            // printf("  [存储设备] 可安全移除\n");
-
-            DIR* dir = opendir("/sys/bus/usb/devices/");
-            if (!dir) {
-                perror("opendir failed");
-                return;
-            }
-            struct dirent* entry;
-            while ((entry = readdir(dir)) != NULL) {
-                // 跳过.和..
-                if (entry->d_name[0] == '.')
-                    continue;
-                
-                // 构建设备路径
-                char dev_path[PATH_MAX];
-                snprintf(dev_path, sizeof(dev_path), 
-                        "/sys/bus/usb/devices/%s", entry->d_name);
-                
-                // 读取VID和PID
-                char vid_path[PATH_MAX], pid_path[PATH_MAX];
-                snprintf(vid_path, sizeof(vid_path), "%s/idVendor", dev_path);
-                snprintf(pid_path, sizeof(pid_path), "%s/idProduct", dev_path);
-
-                int fd_vid = open(vid_path, O_RDONLY);
-                int fd_pid = open(pid_path, O_RDONLY);
-                if (fd_vid < 0 || fd_pid < 0) {
-                    if (fd_vid >= 0) close(fd_vid);
-                    if (fd_pid >= 0) close(fd_pid);
-                    continue;
-                }
-                char vid_str[10], pid_str[10];
-                read(fd_vid, vid_str, sizeof(vid_str)-1);
-                read(fd_pid, pid_str, sizeof(pid_str)-1);
-                close(fd_vid);
-                close(fd_pid);
+    uint64_t fetches = usbDescriptorCache.stringFetches();
 
-                uint16_t found_vid = (uint16_t)strtoul(vid_str, NULL, 16);
-                uint16_t found_pid = (uint16_t)strtoul(pid_str, NULL, 16);
-                if (found_vid == desc.idVendor && found_pid == desc.idProduct) {
-                    // printf("找到匹配的USB设备: %s\n", entry->d_name);
-                    // printf("VID: 0X%x, PID: 0X%0x\n", found_vid, found_pid);
-                    // entry->d_name 目录下递归查找size文件，并计算容量
-                    char usb_device_path[PATH_MAX];
-                    snprintf(usb_device_path, sizeof(usb_device_path), 
-                            "/sys/bus/usb/devices/%s", entry->d_name);
-                    // printf("USB设备路径: %s\n", usb_device_path);
+    for (const std::shared_ptr<UsbDescriptorEntry>& entry : devices) {
+        const struct libusb_device_descriptor& desc = entry->desc;
 
-
-
-                    g_size_found = false; // 重置标志
-                    search_directory(usb_device_path);
-
-                    break;
-                }
-            }
-            closedir(dir);
+        // 如果是存储设备，在它的 sysfs 目录下查找容量
+        if (entry->massStorage) {
+            // 端口路径就是 sysfs 目录名，不再按 vid / pid 在所有设备中查找 (两个同型号的 u 盘会找到同一个)
+            std::string usb_device_path = usbSysfs.root() + "/" + entry->path;
+            g_size_found = false; // 重置标志
+            search_directory(usb_device_path.c_str());
         }
         else if (desc.bDeviceClass == 0x03) {
             // printf("  [输入设备] 键盘/鼠标等\n");
         }
         else if (desc.bDeviceClass == 0x09) {
             // printf("  [集线器] 端口扩展设备\n");
-        } else if (desc.bDeviceClass == 0x02 && desc.bDeviceSubClass == 0x02 && desc.bDeviceProtocol == 0x01 && strcmp(reinterpret_cast<const char*>(manufacturer), "WCH") == 0) {
-            // printf("发现usb小板\n");
+        } else if (desc.bDeviceClass == 0x02 && desc.bDeviceSubClass == 0x02 && desc.bDeviceProtocol == 0x01 &&
+                   usbDescriptorCache.fetchStrings(*entry) && entry->manufacturer == "WCH") {
+            // 只有可能是 usb 小板的设备才读字符串描述符，读过一次就缓存到拔出
             FacilityusbInfo info;
             info.vid = desc.idVendor;
             info.pid = desc.idProduct;
@@ -692,56 +604,52 @@ void Storage::scan_usb_with_libusb() {
         } else {
             // printf("  [其他设备] \n");
         }
-        
-        // printf("\n");
     }
-    
-    libusb_free_device_list(devs, 1);
-    libusb_exit(ctx);
+
+    log_thread_safe(LOG_LEVEL_INFO, STORAGE_TAG, "found %zu usb devices, %llu string descriptor reads this scan",
+        devices.size(), (unsigned long long)(usbDescriptorCache.stringFetches() - fetches));
 }
 
-bool Storage::lsusbGetVidPidInfo() {
-    lsusbFacilityUsbCount = 0;
-    // 清空之前的数据
-    for (auto& info : lsusbFacilityUsbInfoList) {
-        info.vid = 0;
-        info.pid = 0;
+void Storage::scanUsbDisks() {
+    std::shared_ptr<const DeviceSnapshot> devices = deviceRegistry ? deviceRegistry->snapshot() : nullptr;
+    if (!devices) {
+        scan_usb_with_libusb();
+        return;
     }
 
+    usbDiskCount = 0;
+    std::fill(usbDiskSizeList.begin(), usbDiskSizeList.end(), 0.0f);
+    for (const BlockDeviceInfo* disk : devices->usbDisks()) {
+        if (usbDiskCount + 1 >= (int)usbDiskSizeList.size()) {             // 有效索引从 1 开始
+            break;
+        }
+        usbDiskSizeList[++usbDiskCount] = (float)((double)disk->sizeBytes / (1024.0 * 1024.0 * 1024.0));
+        log_thread_safe(LOG_LEVEL_INFO, STORAGE_TAG, "udisk (%d): %s on usb %s, %.2f GB",
+            usbDiskCount, disk->devnode.c_str(), disk->usbPort.c_str(), usbDiskSizeList[usbDiskCount]);
+    }
+}
 
-    FILE* pipe = popen("lsusb", "r");
-    if (!pipe) {
-        log_thread_safe(LOG_LEVEL_ERROR, STORAGE_TAG, "popen lsusb failed");
+bool Storage::lsusbGetVidPidInfo() {
+    lsusbFacilityUsbCount = 0;
+    lsusbFacilityUsbInfoList.clear();                                       // 只保留本次找到的设备，不再有固定 30 项和越界写
+
+    std::shared_ptr<const DeviceSnapshot> devices = deviceRegistry ? deviceRegistry->snapshot() : nullptr;
+    if (devices) {
+        usbDevices = devices->usb;
+    } else if (!usbSysfs.scan(usbDevices)) {
+        log_thread_safe(LOG_LEVEL_ERROR, STORAGE_TAG, "scan usb devices in %s failed", usbSysfs.root().c_str());
         return false;
     }
-    
-    char buffer[512];
-    std::regex pattern(R"(ID\s+([0-9a-fA-F]{4}):([0-9a-fA-F]{4}))");
-    
-    while (fgets(buffer, sizeof(buffer), pipe)) {
-        std::string line(buffer);
-        std::smatch matches;
-        
-        if (std::regex_search(line, matches, pattern) && matches.size() == 3) {
-            try {
-                lsusbFacilityusbInfo info;
-                info.vid = static_cast<uint16_t>(std::stoul(matches[1].str(), nullptr, 16));
-                info.pid = static_cast<uint16_t>(std::stoul(matches[2].str(), nullptr, 16));
-                lsusbFacilityUsbInfoList[++lsusbFacilityUsbCount] = info;
-            } catch (...) {
-                continue;
-            }
-        }
-    }
-    pclose(pipe);
 
-    // 打印结果以验证
-    for (int i = 1; i <= lsusbFacilityUsbCount; i++) {
-        log_thread_safe(LOG_LEVEL_INFO, STORAGE_TAG, 
-            "lsusb 设备 %d: VID=0x%04x, PID=0x%04x", 
-            i, 
-            lsusbFacilityUsbInfoList[i].vid, 
-            lsusbFacilityUsbInfoList[i].pid);
+    for (const UsbDeviceInfo& device : usbDevices) {
+        lsusbFacilityusbInfo info;
+        info.vid = device.vid;
+        info.pid = device.pid;
+        lsusbFacilityUsbInfoList.push_back(info);
+        lsusbFacilityUsbCount++;
+        log_thread_safe(LOG_LEVEL_INFO, STORAGE_TAG,
+            "usb 设备 %d: VID=0x%04x, PID=0x%04x, bus %d port %s, %u Mbps",
+            lsusbFacilityUsbCount, device.vid, device.pid, device.busnum, device.devpath.c_str(), device.speedMbps);
     }
 
     return lsusbFacilityUsbCount > 0;
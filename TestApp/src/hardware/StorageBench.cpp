@@ -0,0 +1,310 @@
+#include "hardware/StorageBench.h"
+#include "util/Clock.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+static const uint64_t BENCH_ALIGN = 4096;
+
+static uint64_t xorshift64(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/*
+ * 保持 depth 个请求在途，直到 next 没有新的偏移
+ * next(offset, len) 返回 false 表示不再提交；latencies 不为空时记录每个请求的延迟 (ns)
+ * interrupt 置位后不再提交，在途的请求结束后返回 false
+ */
+template <typename Next>
+static bool run_phase(IoEngine& engine, int fd, bool write, char* buffers, uint32_t slot_size, unsigned depth,
+                      Next next, std::vector<uint64_t>* latencies, uint64_t& bytes, std::string& error,
+                      const interrupt_flag* interrupt) {
+    std::vector<uint64_t> started(depth);
+    std::vector<uint32_t> lengths(depth);
+    std::vector<uint64_t> offsets(depth);
+    std::vector<IoCompletion> done;
+    unsigned inflight = 0;
+    bool more = true;
+
+    auto issue = [&](uint32_t tag) {
+        uint64_t offset;
+        uint32_t len;
+        if (!more || !(more = next(offset, len))) {
+            return;
+        }
+        offsets[tag] = offset;
+        lengths[tag] = len;
+        started[tag] = monotonic_ns();
+        engine.queue(write, fd, buffers + (size_t)tag * slot_size, len, offset, tag);
+        inflight++;
+    };
+
+    for (uint32_t tag = 0; tag < depth; ++tag) {
+        issue(tag);
+    }
+    bool ok = true;
+    while (inflight > 0) {
+        done.clear();
+        int ret = engine.submitAndWait(1, done);
+        if (ret < 0) {
+            error = std::string(engine.name()) + " submit failed: " + strerror(-ret);
+            return false;                                                   // 引擎销毁时等在途的请求结束
+        }
+        if (more && interrupt && interrupt->is_stop_requested()) {
+            if (ok) {
+                error = "cancelled";
+            }
+            ok = false;
+            more = false;
+        }
+        uint64_t now = monotonic_ns();
+        for (const IoCompletion& completion : done) {
+            uint32_t tag = completion.tag;
+            inflight--;
+            if (completion.result != (int64_t)lengths[tag]) {
+                if (ok) {
+                    char buf[128];
+                    snprintf(buf, sizeof(buf), "%s at offset %llu: %s", write ? "write" : "read",
+                        (unsigned long long)offsets[tag],
+                        completion.result < 0 ? strerror((int)-completion.result) : "short transfer");
+                    error = buf;
+                }
+                ok = false;
+                more = false;                                               // 不再提交，等在途的请求结束
+                continue;
+            }
+            bytes += lengths[tag];
+            if (latencies) {
+                latencies->push_back(now - started[tag]);
+            }
+            issue(tag);
+        }
+    }
+    return ok;
+}
+
+static double percentile_us(std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index] / 1000.0;
+}
+
+StorageBench::StorageBench(const StorageBenchConfig& config)
+    : config_(config), fd_(-1), canWrite_(false), direct_(false), region_(0), buffers_(nullptr), slotSize_(0), seed_(0), interrupt_(nullptr) {
+
+}
+
+StorageBench::~StorageBench() {
+    release();
+}
+
+bool StorageBench::openTarget(StorageBenchResult& result) {
+    // 块设备只读，从不写裸设备；临时文件必须先写才有数据可读
+    IoTarget target;
+    if (!io_target_open(config_.path, ".storage_bench", config_.write, false, target, result.error)) {
+        return false;
+    }
+    fd_ = target.fd;
+    result.direct = target.direct;
+    canWrite_ = target.temporary || (!target.blockDevice && config_.write);
+
+    uint64_t offset = config_.offset & ~(BENCH_ALIGN - 1);
+    uint64_t region = config_.sizeBytes;
+    if (target.temporary && fallocate(fd_, 0, (off_t)offset, (off_t)region) != 0) {
+        LogDebug(STORAGE_BENCH_TAG, "fallocate in %s failed: %s", config_.path.c_str(), strerror(errno));
+    }
+    if (!canWrite_) {
+        region = (target.size > offset) ? std::min(region, target.size - offset) : 0;
+    }
+    region &= ~(BENCH_ALIGN - 1);
+    if (region < config_.randBlockSize) {
+        result.error = config_.path + ": test region too small";
+        return false;
+    }
+    config_.offset = offset;
+    result.regionBytes = region;
+    return true;
+}
+
+bool StorageBench::prepare(StorageBenchResult& result, const interrupt_flag* interrupt) {
+    release();
+    result = StorageBenchResult();
+    interrupt_ = interrupt;
+    config_.seqBlockSize = std::max<uint32_t>(config_.seqBlockSize & ~(uint32_t)(BENCH_ALIGN - 1), BENCH_ALIGN);
+    config_.randBlockSize = std::max<uint32_t>(config_.randBlockSize & ~(uint32_t)(BENCH_ALIGN - 1), BENCH_ALIGN);
+    config_.seqQueueDepth = std::max<uint32_t>(config_.seqQueueDepth, 1);
+    config_.randQueueDepth = std::max<uint32_t>(config_.randQueueDepth, 1);
+
+    if (!openTarget(result)) {
+        LogError(STORAGE_BENCH_TAG, "%s", result.error.c_str());
+        release();
+        return false;
+    }
+    direct_ = result.direct;
+    region_ = result.regionBytes;
+
+    unsigned depth = std::max(config_.seqQueueDepth, config_.randQueueDepth);
+    engine_ = IoEngine::create(config_.engine, depth);
+    if (!engine_) {
+        result.error = std::string(IoEngine::typeName(config_.engine)) + " is not available";
+        LogError(STORAGE_BENCH_TAG, "%s", result.error.c_str());
+        release();
+        return false;
+    }
+    result.engine = engine_->name();
+
+    slotSize_ = std::max(config_.seqBlockSize, config_.randBlockSize);
+    if (posix_memalign((void**)&buffers_, BENCH_ALIGN, (size_t)slotSize_ * depth) != 0) {
+        buffers_ = nullptr;
+        result.error = "out of memory";
+        release();
+        return false;
+    }
+    seed_ = 0x9E3779B97F4A7C15ULL ^ monotonic_ns();
+    for (size_t i = 0; i < (size_t)slotSize_ * depth / sizeof(uint64_t); ++i) {
+        ((uint64_t*)buffers_)[i] = xorshift64(seed_);                       // 随机数据，避免控制器压缩或跳过全零块
+    }
+    return true;
+}
+
+void StorageBench::release() {
+    engine_.reset();                                                        // 先销毁引擎 (等在途请求结束) 再释放缓冲区、关闭 fd
+    free(buffers_);
+    buffers_ = nullptr;
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+void StorageBench::dropCache() {
+    if (!direct_) {
+        posix_fadvise(fd_, (off_t)config_.offset, (off_t)region_, POSIX_FADV_DONTNEED);
+    }
+}
+
+bool StorageBench::sequentialPass(bool write, double& mbps, std::string& error) {
+    uint64_t cursor = 0;
+    auto sequential = [&](uint64_t& offset, uint32_t& len) {
+        if (cursor >= region_) {
+            return false;
+        }
+        offset = config_.offset + cursor;
+        len = (uint32_t)std::min<uint64_t>(config_.seqBlockSize, region_ - cursor);
+        cursor += len;
+        return true;
+    };
+
+    dropCache();
+    uint64_t bytes = 0;
+    uint64_t start = monotonic_ns();
+    if (!run_phase(*engine_, fd_, write, buffers_, slotSize_, config_.seqQueueDepth, sequential, nullptr, bytes, error, interrupt_)) {
+        return false;
+    }
+    if (write && fdatasync(fd_) != 0) {                                     // 写入时间包括落盘
+        error = std::string("fdatasync: ") + strerror(errno);
+        return false;
+    }
+    mbps = bytes * 1000.0 / (monotonic_ns() - start);
+    return true;
+}
+
+bool StorageBench::sequentialUntil(bool write, uint64_t deadlineNs, double& mbps, std::string& error) {
+    if (write && !canWrite_) {
+        error = config_.path + ": read-only target";
+        return false;
+    }
+    uint64_t cursor = 0;
+    uint64_t submitted = 0;
+    auto sequential = [&](uint64_t& offset, uint32_t& len) {
+        if ((++submitted & 7) == 0 && monotonic_ns() >= deadlineNs) {
+            return false;
+        }
+        if (cursor >= region_) {
+            cursor = 0;                                                     // 到末尾从头再来
+            dropCache();
+        }
+        offset = config_.offset + cursor;
+        len = (uint32_t)std::min<uint64_t>(config_.seqBlockSize, region_ - cursor);
+        cursor += len;
+        return true;
+    };
+
+    dropCache();
+    uint64_t bytes = 0;
+    uint64_t start = monotonic_ns();
+    if (!run_phase(*engine_, fd_, write, buffers_, slotSize_, config_.seqQueueDepth, sequential, nullptr, bytes, error, interrupt_)) {
+        return false;
+    }
+    if (write && fdatasync(fd_) != 0) {
+        error = std::string("fdatasync: ") + strerror(errno);
+        return false;
+    }
+    mbps = bytes * 1000.0 / (monotonic_ns() - start);
+    return true;
+}
+
+
+bool StorageBench::run(StorageBenchResult& result, const interrupt_flag* interrupt) {
+    if (!prepare(result, interrupt)) {
+        return false;
+    }
+
+    bool ok = true;
+    if (canWrite_) {
+        ok = sequentialPass(true, result.seqWriteMBps, result.error);
+    }
+    if (ok) {
+        ok = sequentialPass(false, result.seqReadMBps, result.error);
+    }
+
+    if (ok) {
+        dropCache();
+        const uint64_t blocks = region_ / config_.randBlockSize;
+        const uint64_t start = monotonic_ns();
+        const uint64_t deadline = start + (uint64_t)config_.randDurationMs * 1000000ULL;
+        uint64_t submitted = 0;
+        auto random = [&](uint64_t& offset, uint32_t& len) {
+            if ((++submitted & 63) == 0 && monotonic_ns() >= deadline) {           // 每 64 个请求看一次时间
+                return false;
+            }
+            offset = config_.offset + (xorshift64(seed_) % blocks) * config_.randBlockSize;
+            len = config_.randBlockSize;
+            return true;
+        };
+        std::vector<uint64_t> latencies;
+        latencies.reserve(1 << 16);
+        uint64_t bytes = 0;
+        ok = run_phase(*engine_, fd_, false, buffers_, slotSize_, config_.randQueueDepth, random, &latencies, bytes, result.error, interrupt_);
+        if (ok) {
+            result.randReadIops = latencies.size() * 1e9 / (monotonic_ns() - start);
+            std::sort(latencies.begin(), latencies.end());
+            result.latP50Us = percentile_us(latencies, 0.50);
+            result.latP99Us = percentile_us(latencies, 0.99);
+            result.latP999Us = percentile_us(latencies, 0.999);
+            result.latMaxUs = latencies.empty() ? 0 : latencies.back() / 1000.0;
+        }
+    }
+
+    release();
+
+    if (ok) {
+        LogInfo(STORAGE_BENCH_TAG, "%s [%s%s] %llu MB: write %.1f MB/s, read %.1f MB/s, 4K QD%u %.0f IOPS, lat p50 %.0f us p99 %.0f us p99.9 %.0f us",
+            config_.path.c_str(), result.engine.c_str(), result.direct ? ", direct" : "", (unsigned long long)(region_ >> 20),
+            result.seqWriteMBps, result.seqReadMBps, config_.randQueueDepth, result.randReadIops,
+            result.latP50Us, result.latP99Us, result.latP999Us);
+    } else {
+        LogError(STORAGE_BENCH_TAG, "%s [%s]: %s", config_.path.c_str(), result.engine.c_str(), result.error.c_str());
+    }
+    return ok;
+}
@@ -0,0 +1,534 @@
+#include "hardware/StorageVerify.h"
+#include "util/Clock.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <errno.h>
+#include <fcntl.h>
+#include <functional>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#if !defined(STORAGE_VERIFY_SCALAR) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VERIFY_HASH_NEON 1
+#elif !defined(STORAGE_VERIFY_SCALAR) && defined(__SSE2__)
+#include <emmintrin.h>
+#define VERIFY_HASH_SSE2 1
+#endif
+
+static const uint32_t SECTOR_SIZE = 4096;
+
+/* ---------------- 哈希: xxh3 风格的 8 路 32x32->64 乘加，NEON / SSE2 每条指令处理两路 ---------------- */
+
+static const uint64_t PRIME32_1 = 0x9E3779B1ULL;
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const size_t STRIPE = 64;
+static const size_t STRIPES_PER_ROUND = 16;                 // 每 1K 打乱一次累加器
+
+alignas(16) static const uint64_t HASH_SECRET[8] = {
+    0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+    0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL,
+};
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline void accumulate_stripe(uint64_t* acc, const uint8_t* p, const uint64_t* key) {
+#if defined(VERIFY_HASH_NEON)
+    uint64x2_t* xacc = (uint64x2_t*)acc;
+    for (int i = 0; i < 4; ++i) {
+        uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(p + 16 * i));
+        uint64x2_t k = veorq_u64(data, vld1q_u64(key + 2 * i));
+        uint64x2_t product = vmull_u32(vmovn_u64(k), vshrn_n_u64(k, 32));
+        xacc[i] = vaddq_u64(xacc[i], vaddq_u64(vextq_u64(data, data, 1), product));
+    }
+#elif defined(VERIFY_HASH_SSE2)
+    __m128i* xacc = (__m128i*)acc;
+    for (int i = 0; i < 4; ++i) {
+        __m128i data = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+        __m128i k = _mm_xor_si128(data, _mm_load_si128((const __m128i*)(key + 2 * i)));
+        __m128i product = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+        __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        xacc[i] = _mm_add_epi64(xacc[i], _mm_add_epi64(swapped, product));
+    }
+#else
+    for (int i = 0; i < 8; ++i) {
+        uint64_t data = read64(p + 8 * i);
+        uint64_t k = data ^ key[i];
+        acc[i ^ 1] += data;
+        acc[i] += (k & 0xFFFFFFFFULL) * (k >> 32);
+    }
+#endif
+}
+
+static inline void scramble(uint64_t* acc) {
+#if defined(VERIFY_HASH_NEON)
+    uint64x2_t* xacc = (uint64x2_t*)acc;
+    uint32x2_t prime = vdup_n_u32((uint32_t)PRIME32_1);
+    for (int i = 0; i < 4; ++i) {
+        uint64x2_t a = veorq_u64(xacc[i], vshrq_n_u64(xacc[i], 47));
+        a = veorq_u64(a, vld1q_u64(HASH_SECRET + 2 * i));
+        uint64x2_t lo = vmull_u32(vmovn_u64(a), prime);
+        uint64x2_t hi = vmull_u32(vshrn_n_u64(a, 32), prime);
+        xacc[i] = vaddq_u64(lo, vshlq_n_u64(hi, 32));
+    }
+#elif defined(VERIFY_HASH_SSE2)
+    __m128i* xacc = (__m128i*)acc;
+    const __m128i prime = _mm_set1_epi32((int)PRIME32_1);
+    for (int i = 0; i < 4; ++i) {
+        __m128i a = _mm_xor_si128(xacc[i], _mm_srli_epi64(xacc[i], 47));
+        a = _mm_xor_si128(a, _mm_load_si128((const __m128i*)(HASH_SECRET + 2 * i)));
+        __m128i lo = _mm_mul_epu32(a, prime);
+        __m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        xacc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+    }
+#else
+    for (int i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= HASH_SECRET[i];
+        acc[i] = a * PRIME32_1;
+    }
+#endif
+}
+
+static inline uint64_t mul_fold64(uint64_t a, uint64_t b) {
+    unsigned __int128 product = (unsigned __int128)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+static inline uint64_t avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t StorageVerify::hash64(const void* data, size_t len, uint64_t seed) {
+    alignas(16) uint64_t acc[8] = {
+        0xC2B2AE3DULL, PRIME64_1, PRIME64_2, 0x165667B19E3779F9ULL,
+        0x85EBCA77C2B2AE63ULL, 0x85EBCA77ULL, 0x27D4EB2F165667C5ULL, PRIME32_1,
+    };
+    alignas(16) uint64_t key[8];
+    for (int i = 0; i < 8; ++i) {
+        key[i] = HASH_SECRET[i] + seed;
+    }
+
+    const uint8_t* p = (const uint8_t*)data;
+    size_t remaining = len;
+    while (remaining >= STRIPE * STRIPES_PER_ROUND) {
+        for (size_t s = 0; s < STRIPES_PER_ROUND; ++s) {
+            accumulate_stripe(acc, p + s * STRIPE, key);
+        }
+        scramble(acc);
+        p += STRIPE * STRIPES_PER_ROUND;
+        remaining -= STRIPE * STRIPES_PER_ROUND;
+    }
+    while (remaining >= STRIPE) {
+        accumulate_stripe(acc, p, key);
+        p += STRIPE;
+        remaining -= STRIPE;
+    }
+    if (remaining > 0) {
+        alignas(16) uint8_t tail[STRIPE] = {0};
+        memcpy(tail, p, remaining);
+        accumulate_stripe(acc, tail, key);
+    }
+
+    uint64_t h = (uint64_t)len * PRIME64_1;
+    for (int i = 0; i < 4; ++i) {
+        h += mul_fold64(acc[2 * i] ^ key[2 * i], acc[2 * i + 1] ^ key[2 * i + 1]);
+    }
+    return avalanche(h);
+}
+
+/* ---------------- 测试数据: 每个 4K 扇区 = {偏移, 标记, 伪随机数据}，任意扇区可以单独重新生成 ---------------- */
+
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t sector_tag(uint64_t seed, uint64_t offset) {
+    return mix64(seed ^ (offset * PRIME64_2));
+}
+
+static void fill_sector(uint64_t* words, uint64_t seed, uint64_t offset) {
+    words[0] = offset;
+    words[1] = sector_tag(seed, offset);
+    uint64_t base = mix64(seed + offset);
+    for (uint32_t i = 2; i < SECTOR_SIZE / sizeof(uint64_t); ++i) {
+        words[i] = mix64(base + i * PRIME64_1);
+    }
+}
+
+static void fill_block(char* buffer, uint32_t len, uint64_t seed, uint64_t offset) {
+    for (uint32_t pos = 0; pos < len; pos += SECTOR_SIZE) {
+        fill_sector((uint64_t*)(buffer + pos), seed, offset + pos);
+    }
+}
+
+/* ---------------- 常驻的计算线程，每批数据分给所有线程，run 之后 wait ---------------- */
+
+class BlockWorkers {
+public:
+    explicit BlockWorkers(unsigned count) : count_(count) {
+        for (unsigned i = 0; i < count_; ++i) {
+            threads_.emplace_back([this, i]() { loop(i); });
+        }
+    }
+
+    ~BlockWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    // 异步开始一批，fn(worker) 在每个线程中调用一次
+    void run(std::function<void(unsigned worker)> fn) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = std::move(fn);
+            pending_ = count_;
+            generation_++;
+        }
+        cv_.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this]() { return pending_ == 0; });
+    }
+
+    unsigned count() const { return count_; }
+
+private:
+    void loop(unsigned worker) {
+        uint64_t seen = 0;
+        for (;;) {
+            std::function<void(unsigned)> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this, seen]() { return stop_ || generation_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+                job = job_;
+            }
+            job(worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0) {
+                    done_cv_.notify_all();
+                }
+            }
+        }
+    }
+
+    unsigned count_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    std::function<void(unsigned)> job_;
+    unsigned pending_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+StorageVerify::StorageVerify(const StorageVerifyConfig& config) : config_(config) {
+
+}
+
+int StorageVerify::openTarget(StorageVerifyResult& result) {
+    struct stat st;
+    if (!config_.allowDevice && stat(config_.path.c_str(), &st) == 0 && S_ISBLK(st.st_mode)) {
+        result.error = config_.path + ": writing a raw device needs allowDevice";
+        return -1;
+    }
+    IoTarget target;
+    if (!io_target_open(config_.path, ".storage_verify", true, true, target, result.error)) {
+        return -1;
+    }
+    result.direct = target.direct;
+
+    uint64_t capacity = target.blockDevice ? target.size : 0;                   // 普通文件写到多大都行
+    if (target.temporary) {
+        struct statvfs vfs;
+        if (statvfs(config_.path.c_str(), &vfs) == 0) {
+            capacity = (uint64_t)vfs.f_bavail * vfs.f_frsize / 10 * 9;         // 留 10% 给系统
+        }
+    }
+
+    uint64_t region = config_.sizeBytes;
+    if (capacity > 0) {
+        uint64_t available = (capacity > config_.offset) ? capacity - config_.offset : 0;
+        region = (region == 0) ? available : std::min(region, available);
+    }
+    region -= region % config_.blockSize;
+    if (region == 0) {
+        result.error = config_.path + ": test region is empty";
+        close(target.fd);
+        return -1;
+    }
+    result.regionBytes = region;
+    return target.fd;
+}
+
+bool StorageVerify::run(StorageVerifyResult& result, const interrupt_flag* interrupt) {
+    result = StorageVerifyResult();
+    config_.blockSize = std::max<uint32_t>(config_.blockSize - config_.blockSize % SECTOR_SIZE, SECTOR_SIZE);
+    config_.offset -= config_.offset % config_.blockSize;
+    if (config_.seed == 0) {
+        config_.seed = mix64(monotonic_ns() ^ ((uint64_t)getpid() << 32));
+    }
+    unsigned threads = config_.threads ? config_.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    int fd = openTarget(result);
+    if (fd < 0) {
+        LogError(STORAGE_VERIFY_TAG, "%s", result.error.c_str());
+        return false;
+    }
+
+    const uint32_t blockSize = config_.blockSize;
+    const uint32_t batchBlocks = std::max(threads, 4u);
+    const uint64_t blocks = result.regionBytes / blockSize;
+    const uint64_t batches = (blocks + batchBlocks - 1) / batchBlocks;
+    const size_t batchBytes = (size_t)batchBlocks * blockSize;
+
+    std::unique_ptr<IoEngine> engine = IoEngine::create(config_.engine, batchBlocks);
+    char* buffers[2] = {nullptr, nullptr};
+    if (!engine || posix_memalign((void**)&buffers[0], SECTOR_SIZE, batchBytes) != 0 ||
+        posix_memalign((void**)&buffers[1], SECTOR_SIZE, batchBytes) != 0) {
+        result.error = engine ? "out of memory" : std::string(IoEngine::typeName(config_.engine)) + " is not available";
+        LogError(STORAGE_VERIFY_TAG, "%s", result.error.c_str());
+        free(buffers[0]);
+        free(buffers[1]);
+        close(fd);
+        return false;
+    }
+    result.engine = engine->name();
+
+    std::vector<uint64_t> hashes(blocks);                                   // 每块 8 字节，64 GB 也只要 512 KB
+    std::vector<int64_t> status(batchBlocks);                               // 当前批每块的读写结果
+    BlockWorkers workers(threads);
+    const uint64_t seed = config_.seed;
+    const uint64_t base = config_.offset;
+
+    auto batch_count = [&](uint64_t batch) {
+        return (uint32_t)std::min<uint64_t>(batchBlocks, blocks - batch * batchBlocks);
+    };
+    // 提交一批读写并等待全部完成，失败的块记录在 status 中
+    auto submit_batch = [&](bool write, uint64_t batch, char* buffer) {
+        uint32_t count = batch_count(batch);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint64_t offset = base + (batch * batchBlocks + i) * blockSize;
+            engine->queue(write, fd, buffer + (size_t)i * blockSize, blockSize, offset, i);
+        }
+        return count;
+    };
+    std::vector<IoCompletion> done;
+    auto wait_batch = [&](uint32_t count) {
+        uint32_t completed = 0;
+        while (completed < count) {
+            done.clear();
+            int ret = engine->submitAndWait(1, done);
+            if (ret < 0) {
+                for (uint32_t i = 0; i < count; ++i) {
+                    status[i] = ret;
+                }
+                return;
+            }
+            for (const IoCompletion& completion : done) {
+                status[completion.tag] = completion.result;
+                completed++;
+            }
+        }
+    };
+    auto generate = [&](uint64_t batch, char* buffer) {
+        uint32_t count = batch_count(batch);
+        workers.run([&, batch, buffer, count](unsigned worker) {
+            for (uint32_t i = worker; i < count; i += workers.count()) {
+                uint64_t block = batch * batchBlocks + i;
+                char* data = buffer + (size_t)i * blockSize;
+                fill_block(data, blockSize, seed, base + block * blockSize);
+                hashes[block] = hash64(data, blockSize, seed);
+            }
+        });
+    };
+
+    auto cancelled = [&]() {
+        if (interrupt && interrupt->is_stop_requested()) {
+            result.error = "cancelled";
+            return true;
+        }
+        return false;
+    };
+
+    // 写: 写第 n 批的同时生成第 n + 1 批
+    uint64_t start = monotonic_ns();
+    generate(0, buffers[0]);
+    workers.wait();
+    for (uint64_t batch = 0; batch < batches; ++batch) {
+        if (cancelled()) {
+            break;
+        }
+        uint32_t count = submit_batch(true, batch, buffers[batch & 1]);
+        if (batch + 1 < batches) {
+            generate(batch + 1, buffers[(batch + 1) & 1]);
+        }
+        wait_batch(count);
+        workers.wait();
+        for (uint32_t i = 0; i < count; ++i) {
+            if (status[i] != (int64_t)blockSize) {
+                result.ioErrors++;                                          // 写失败的块在读回时一定校验不过
+            }
+        }
+    }
+    if (fdatasync(fd) != 0) {
+        LogError(STORAGE_VERIFY_TAG, "fdatasync %s: %s", config_.path.c_str(), strerror(errno));
+    }
+    result.writeMBps = result.regionBytes * 1000.0 / (monotonic_ns() - start);
+    if (!result.error.empty()) {                                            // 没写完的区域读回来没有意义
+        LogError(STORAGE_VERIFY_TAG, "%s: %s", config_.path.c_str(), result.error.c_str());
+        engine.reset();
+        free(buffers[0]);
+        free(buffers[1]);
+        close(fd);
+        return false;
+    }
+    if (!result.direct) {
+        posix_fadvise(fd, (off_t)base, (off_t)result.regionBytes, POSIX_FADV_DONTNEED);
+    }
+
+    // 读: 读第 n + 1 批的同时校验第 n 批
+    struct WorkerErrors {
+        uint64_t blocks = 0;
+        uint64_t sectors = 0;
+        int64_t firstBad = -1;
+        int64_t alias = -1;
+    };
+    std::vector<WorkerErrors> errors(threads);
+    std::vector<char*> scratch(threads, nullptr);
+    for (unsigned i = 0; i < threads; ++i) {
+        if (posix_memalign((void**)&scratch[i], SECTOR_SIZE, SECTOR_SIZE) != 0) {
+            scratch[i] = nullptr;
+        }
+    }
+    std::vector<int64_t> verifyStatus(batchBlocks);
+    auto check = [&](uint64_t batch, char* buffer) {
+        uint32_t count = batch_count(batch);
+        workers.run([&, batch, buffer, count](unsigned worker) {
+            WorkerErrors& err = errors[worker];
+            for (uint32_t i = worker; i < count; i += workers.count()) {
+                uint64_t block = batch * batchBlocks + i;
+                uint64_t blockOffset = base + block * blockSize;
+                char* data = buffer + (size_t)i * blockSize;
+                if (verifyStatus[i] != (int64_t)blockSize) {                // 读失败，整块算坏
+                    err.blocks++;
+                    err.sectors += blockSize / SECTOR_SIZE;
+                    if (err.firstBad < 0 || (int64_t)blockOffset < err.firstBad) {
+                        err.firstBad = (int64_t)blockOffset;
+                        err.alias = -1;
+                    }
+                    continue;
+                }
+                if (hash64(data, blockSize, seed) == hashes[block]) {
+                    continue;
+                }
+
+                // 哈希不符时逐扇区重新生成比较，找出坏扇区和第一个出错的字节
+                err.blocks++;
+                for (uint32_t pos = 0; pos < blockSize && scratch[worker]; pos += SECTOR_SIZE) {
+                    uint64_t sectorOffset = blockOffset + pos;
+                    fill_sector((uint64_t*)scratch[worker], seed, sectorOffset);
+                    const char* actual = data + pos;
+                    if (memcmp(actual, scratch[worker], SECTOR_SIZE) == 0) {
+                        continue;
+                    }
+                    err.sectors++;
+                    uint32_t byte = 0;
+                    while (actual[byte] == scratch[worker][byte]) {
+                        byte++;
+                    }
+                    int64_t badOffset = (int64_t)(sectorOffset + byte);
+                    if (err.firstBad < 0 || badOffset < err.firstBad) {
+                        err.firstBad = badOffset;
+                        uint64_t writtenAt = read64((const uint8_t*)actual);
+                        bool tagged = read64((const uint8_t*)actual + 8) == sector_tag(seed, writtenAt);
+                        err.alias = (tagged && writtenAt != sectorOffset) ? (int64_t)writtenAt : -1;
+                    }
+                }
+            }
+        });
+    };
+
+    start = monotonic_ns();
+    uint64_t verified = 0;                                                  // 已经校验完的批数，取消时只按这部分算速度
+    wait_batch(submit_batch(false, 0, buffers[0]));
+    for (uint64_t batch = 0; batch < batches; ++batch) {
+        std::copy(status.begin(), status.end(), verifyStatus.begin());      // 本批的读结果交给校验线程
+        for (uint32_t i = 0; i < batch_count(batch); ++i) {
+            if (verifyStatus[i] != (int64_t)blockSize) {
+                result.ioErrors++;
+            }
+        }
+        check(batch, buffers[batch & 1]);
+        bool stop = cancelled();
+        if (batch + 1 < batches && !stop) {
+            wait_batch(submit_batch(false, batch + 1, buffers[(batch + 1) & 1]));
+        }
+        workers.wait();
+        verified = batch + 1;
+        if (stop) {
+            break;
+        }
+    }
+    result.verifyMBps = std::min<uint64_t>(verified * batchBytes, result.regionBytes) * 1000.0 / (monotonic_ns() - start);
+
+    for (const WorkerErrors& err : errors) {
+        result.errorBlocks += err.blocks;
+        result.errorSectors += err.sectors;
+        if (err.firstBad >= 0 && (result.firstBadOffset < 0 || err.firstBad < result.firstBadOffset)) {
+            result.firstBadOffset = err.firstBad;
+            result.aliasOffset = err.alias;
+        }
+    }
+    for (char* buffer : scratch) {
+        free(buffer);
+    }
+    engine.reset();
+    free(buffers[0]);
+    free(buffers[1]);
+    close(fd);
+
+    bool ok = result.errorBlocks == 0 && result.ioErrors == 0 && result.error.empty();
+    if (ok) {
+        LogInfo(STORAGE_VERIFY_TAG, "%s [%s%s] %llu MB verified: write %.1f MB/s, verify %.1f MB/s",
+            config_.path.c_str(), result.engine.c_str(), result.direct ? ", direct" : "",
+            (unsigned long long)(result.regionBytes >> 20), result.writeMBps, result.verifyMBps);
+    } else {
+        LogError(STORAGE_VERIFY_TAG, "%s%s%s: %llu bad blocks, %llu bad sectors, %llu io errors, first bad offset %lld, alias of %lld",
+            config_.path.c_str(), result.error.empty() ? "" : " ", result.error.c_str(), (unsigned long long)result.errorBlocks, (unsigned long long)result.errorSectors,
+            (unsigned long long)result.ioErrors, (long long)result.firstBadOffset, (long long)result.aliasOffset);
+    }
+    return ok;
+}
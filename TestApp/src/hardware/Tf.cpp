@@ -1,10 +1,27 @@
 #include "hardware/Tf.h"
+#include "hardware/DeviceRegistry.h"
 
 Tf::Tf(const char* tfCardDeviceSizePath) 
     : TF_CARD_DEVICE_SIZE_PATH(tfCardDeviceSizePath) {
 }
 
+void Tf::setTfDeviceRegistry(const DeviceRegistry* registry) {
+    tfDeviceRegistry = registry;
+}
+
 float Tf::getTfCardSize() {
+    std::shared_ptr<const DeviceSnapshot> snapshot = tfDeviceRegistry ? tfDeviceRegistry->snapshot() : nullptr;
+    if (snapshot) {
+        const BlockDeviceInfo* card = snapshot->tf();
+        if (card == nullptr) {
+            LogError(TF_TAG, "no tf card found");
+            return -1;
+        }
+        float roundedGb = round(card->sizeBytes / (1024.0f * 1024.0f * 1024.0f) * 100.0f) / 100.0f;
+        LogInfo(TF_TAG, "tf %s total size: %llu KB (%.2f GB)", card->name.c_str(), (unsigned long long)(card->sizeBytes / 1024), roundedGb);
+        return roundedGb;
+    }
+
     FILE* fp = fopen(TF_CARD_DEVICE_SIZE_PATH, "r");
     if (!fp) {
         LogError(TF_TAG, "can not open : %s", TF_CARD_DEVICE_SIZE_PATH);
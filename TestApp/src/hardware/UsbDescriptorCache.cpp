@@ -0,0 +1,300 @@
+#include "hardware/UsbDescriptorCache.h"
+
+#include <algorithm>
+#include <sys/time.h>
+
+static const unsigned STRINGS_RETRY_MAX_SHIFT = 6;          // 1s, 2s, 4s ... 最长 64s
+
+// UsbDescriptorEntry::stringsRead 的位
+static const uint8_t STRING_MANUFACTURER = 1 << 0;
+static const uint8_t STRING_PRODUCT = 1 << 1;
+static const uint8_t STRING_SERIAL = 1 << 2;
+
+UsbDescriptorCache::UsbDescriptorCache() : ctx_(nullptr), started_(false), hotplug_(false),
+    hotplug_handle_(0), stop_(false), string_fetches_(0) {
+
+}
+
+UsbDescriptorCache::~UsbDescriptorCache() {
+    stop();
+}
+
+std::string UsbDescriptorCache::portPath(libusb_device* device) {
+    uint8_t ports[8];
+    int count = libusb_get_port_numbers(device, ports, sizeof(ports));
+    std::string path;
+    if (count <= 0) {
+        return "usb" + std::to_string(libusb_get_bus_number(device));   // root hub
+    }
+    path = std::to_string(libusb_get_bus_number(device)) + "-";
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) {
+            path += ".";
+        }
+        path += std::to_string(ports[i]);
+    }
+    return path;
+}
+
+static bool has_mass_storage_interface(libusb_device* device) {
+    struct libusb_config_descriptor* config;
+    if (libusb_get_config_descriptor(device, 0, &config) != 0) {
+        return false;
+    }
+    bool found = false;
+    for (int i = 0; i < config->bNumInterfaces && !found; i++) {
+        const struct libusb_interface* interface = &config->interface[i];
+        for (int j = 0; j < interface->num_altsetting && !found; j++) {
+            found = interface->altsetting[j].bInterfaceClass == 0x08;
+        }
+    }
+    libusb_free_config_descriptor(config);
+    return found;
+}
+
+bool UsbDescriptorCache::start() {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    if (started_) {
+        return ctx_ != nullptr;
+    }
+    started_ = true;
+
+    int r = libusb_init(&ctx_);
+    if (r < 0) {
+        LogError(USB_CACHE_TAG, "init libusb failed: %s", libusb_error_name(r));
+        ctx_ = nullptr;
+        return false;
+    }
+
+    if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+        // ENUMERATE: 已有的设备在注册过程中就回调 add
+        r = libusb_hotplug_register_callback(ctx_,
+            (libusb_hotplug_event)(LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT),
+            LIBUSB_HOTPLUG_ENUMERATE, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+            &UsbDescriptorCache::onHotplug, this, &hotplug_handle_);
+        hotplug_ = (r == LIBUSB_SUCCESS);
+        if (!hotplug_) {
+            LogError(USB_CACHE_TAG, "register hotplug callback failed: %s, rescan on every query", libusb_error_name(r));
+        }
+    }
+    if (hotplug_) {
+        stop_ = false;
+        event_thread_ = std::thread(&UsbDescriptorCache::eventLoop, this);
+    }
+    LogInfo(USB_CACHE_TAG, "libusb started, hotplug %s", hotplug_ ? "on" : "off");
+    return true;
+}
+
+void UsbDescriptorCache::stop() {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    if (!ctx_) {
+        started_ = false;
+        return;
+    }
+    stop_ = true;
+    if (hotplug_) {
+        libusb_hotplug_deregister_callback(ctx_, hotplug_handle_);
+        hotplug_ = false;
+    }
+    if (event_thread_.joinable()) {
+        event_thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> entriesLock(mutex_);
+        for (auto& entry : entries_) {
+            libusb_unref_device(entry.second->device);
+            entry.second->device = nullptr;
+        }
+        entries_.clear();
+    }
+    libusb_exit(ctx_);
+    ctx_ = nullptr;
+    started_ = false;
+}
+
+void UsbDescriptorCache::eventLoop() {
+    while (!stop_) {
+        struct timeval tv = {0, 500 * 1000};                // 超时只为检查 stop_，热插拔事件会立即唤醒
+        libusb_handle_events_timeout_completed(ctx_, &tv, nullptr);
+    }
+}
+
+int LIBUSB_CALL UsbDescriptorCache::onHotplug(libusb_context* ctx, libusb_device* device, libusb_hotplug_event event, void* user) {
+    (void)ctx;
+    UsbDescriptorCache* self = static_cast<UsbDescriptorCache*>(user);
+    if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED) {
+        self->add(device);
+    } else if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT) {
+        self->remove(device);
+    }
+    return 0;                                               // 保持注册
+}
+
+void UsbDescriptorCache::add(libusb_device* device) {
+    std::shared_ptr<UsbDescriptorEntry> entry = std::make_shared<UsbDescriptorEntry>();
+    if (libusb_get_device_descriptor(device, &entry->desc) < 0) {
+        return;
+    }
+    entry->path = portPath(device);
+    entry->bus = libusb_get_bus_number(device);
+    entry->address = libusb_get_device_address(device);
+    entry->device = libusb_ref_device(device);
+    entry->massStorage = has_mass_storage_interface(device);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(entry->path);
+    if (it != entries_.end()) {
+        libusb_unref_device(it->second->device);           // 同一端口上换了设备，旧的 LEFT 事件丢失时
+        it->second->device = nullptr;
+    }
+    entries_[entry->path] = entry;
+    LogDebug(USB_CACHE_TAG, "usb %s arrived: %04x:%04x", entry->path.c_str(), entry->desc.idVendor, entry->desc.idProduct);
+}
+
+void UsbDescriptorCache::remove(libusb_device* device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->second->device == device) {
+            LogDebug(USB_CACHE_TAG, "usb %s left", it->first.c_str());
+            libusb_unref_device(it->second->device);
+            it->second->device = nullptr;
+            entries_.erase(it);
+            return;
+        }
+    }
+}
+
+// 没有热插拔时重新枚举，端口路径和设备地址都没变的设备沿用缓存项 (包括已经取到的字符串)
+void UsbDescriptorCache::rescan() {
+    libusb_device** list;
+    ssize_t count = libusb_get_device_list(ctx_, &list);
+    if (count < 0) {
+        LogError(USB_CACHE_TAG, "get device list failed: %s", libusb_error_name((int)count));
+        return;
+    }
+
+    std::map<std::string, std::shared_ptr<UsbDescriptorEntry>> fresh;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (ssize_t i = 0; i < count; ++i) {
+            std::string path = portPath(list[i]);
+            auto it = entries_.find(path);
+            if (it != entries_.end() && it->second->bus == libusb_get_bus_number(list[i]) &&
+                it->second->address == libusb_get_device_address(list[i])) {
+                fresh[path] = it->second;
+                entries_.erase(it);
+                continue;
+            }
+            std::shared_ptr<UsbDescriptorEntry> entry = std::make_shared<UsbDescriptorEntry>();
+            if (libusb_get_device_descriptor(list[i], &entry->desc) < 0) {
+                continue;
+            }
+            entry->path = path;
+            entry->bus = libusb_get_bus_number(list[i]);
+            entry->address = libusb_get_device_address(list[i]);
+            entry->device = libusb_ref_device(list[i]);
+            entry->massStorage = has_mass_storage_interface(list[i]);
+            fresh[path] = entry;
+        }
+        for (auto& stale : entries_) {
+            libusb_unref_device(stale.second->device);
+            stale.second->device = nullptr;
+        }
+        entries_.swap(fresh);
+    }
+    libusb_free_device_list(list, 1);
+}
+
+std::vector<std::shared_ptr<UsbDescriptorEntry>> UsbDescriptorCache::devices() {
+    std::vector<std::shared_ptr<UsbDescriptorEntry>> result;
+    if (!start()) {
+        return result;
+    }
+    if (!hotplug_) {
+        rescan();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.reserve(entries_.size());
+    for (auto& entry : entries_) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+bool UsbDescriptorCache::fetchStrings(UsbDescriptorEntry& entry) {
+    std::lock_guard<std::mutex> lock(strings_mutex_);
+    if (entry.stringsFetched) {
+        return entry.stringsValid;
+    }
+    if (!(entry.desc.iManufacturer || entry.desc.iProduct || entry.desc.iSerialNumber)) {
+        entry.stringsFetched = true;
+        entry.stringsValid = true;                          // 设备没有字符串描述符
+        return true;
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (entry.stringsFailures > 0 && now < entry.stringsRetryAt) {
+        return false;
+    }
+
+    // 读取过程中设备可能被拔出，device 只在 mutex_ 下访问，这里自己持有一个引用
+    libusb_device* device = nullptr;
+    {
+        std::lock_guard<std::mutex> entriesLock(mutex_);
+        if (entry.device) {
+            device = libusb_ref_device(entry.device);
+        }
+    }
+    if (!device) {
+        return false;
+    }
+
+    // 打开失败和有字符串没读到一样处理: 不缓存失败，按退避间隔重试
+    auto retry_later = [&](const char* what, int error) {
+        std::chrono::seconds backoff(1 << std::min(entry.stringsFailures, STRINGS_RETRY_MAX_SHIFT));
+        entry.stringsFailures++;
+        entry.stringsRetryAt = now + backoff;
+        LogError(USB_CACHE_TAG, "%s usb %s failed: %s, retry in %llds", what, entry.path.c_str(), libusb_error_name(error),
+            (long long)backoff.count());
+    };
+
+    libusb_device_handle* handle = nullptr;
+    int r = libusb_open(device, &handle);
+    libusb_unref_device(device);
+    string_fetches_++;
+    if (r < 0) {
+        retry_later("open", r);
+        return false;
+    }
+
+    // 只读上次没读到的字符串，读到的才缓存
+    unsigned char buffer[256];
+    int lastError = LIBUSB_SUCCESS;
+    auto read_string = [&](uint8_t index, uint8_t bit, std::string& out) {
+        if (!index || (entry.stringsRead & bit)) {
+            return;
+        }
+        int n = libusb_get_string_descriptor_ascii(handle, index, buffer, sizeof(buffer));
+        if (n < 0) {
+            lastError = n;
+            return;
+        }
+        out.assign(reinterpret_cast<const char*>(buffer), n);
+        entry.stringsRead |= bit;
+    };
+    read_string(entry.desc.iManufacturer, STRING_MANUFACTURER, entry.manufacturer);
+    read_string(entry.desc.iProduct, STRING_PRODUCT, entry.product);
+    read_string(entry.desc.iSerialNumber, STRING_SERIAL, entry.serial);
+    libusb_close(handle);
+
+    uint8_t wanted = (entry.desc.iManufacturer ? STRING_MANUFACTURER : 0) | (entry.desc.iProduct ? STRING_PRODUCT : 0) |
+                     (entry.desc.iSerialNumber ? STRING_SERIAL : 0);
+    if ((entry.stringsRead & wanted) != wanted) {
+        retry_later("read strings of", lastError);
+        return false;
+    }
+    entry.stringsFetched = true;
+    entry.stringsValid = true;
+    entry.stringsFailures = 0;
+    return true;
+}
@@ -0,0 +1,108 @@
+#include "hardware/UsbSysfs.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+UsbSysfs::UsbSysfs(const char* root) : root_(root) {
+
+}
+
+// 读取 <dir>/<attr> 的第一行，去掉换行
+static bool read_attr(int dirfd, const char* dir, const char* attr, char* buf, size_t size) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, attr);
+    int fd = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t len = read(fd, buf, size - 1);
+    close(fd);
+    if (len <= 0) {
+        return false;
+    }
+    buf[len] = '\0';
+    buf[strcspn(buf, "\r\n")] = '\0';
+    return true;
+}
+
+static bool read_hex(int dirfd, const char* dir, const char* attr, unsigned long& value) {
+    char buf[32];
+    if (!read_attr(dirfd, dir, attr, buf, sizeof(buf))) {
+        return false;
+    }
+    char* end = nullptr;
+    value = strtoul(buf, &end, 16);
+    return end != buf;
+}
+
+static bool read_dec(int dirfd, const char* dir, const char* attr, unsigned long& value) {
+    char buf[32];
+    if (!read_attr(dirfd, dir, attr, buf, sizeof(buf))) {
+        return false;
+    }
+    char* end = nullptr;
+    value = strtoul(buf, &end, 10);
+    return end != buf;
+}
+
+bool UsbSysfs::scan(std::vector<UsbDeviceInfo>& devices) const {
+    devices.clear();
+
+    DIR* dir = opendir(root_.c_str());
+    if (dir == nullptr) {
+        LogError(USB_SYSFS_TAG, "can not open %s", root_.c_str());
+        return false;
+    }
+    int root_fd = dirfd(dir);
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' || strchr(name, ':') != nullptr) {              // "1-1:1.0" 是接口，不是设备
+            continue;
+        }
+
+        unsigned long vid, pid;
+        if (!read_hex(root_fd, name, "idVendor", vid) || !read_hex(root_fd, name, "idProduct", pid)) {
+            continue;
+        }
+
+        UsbDeviceInfo info;
+        info.name = name;
+        info.vid = (uint16_t)vid;
+        info.pid = (uint16_t)pid;
+
+        unsigned long value;
+        if (read_dec(root_fd, name, "busnum", value)) {
+            info.busnum = (int)value;
+        }
+        if (read_dec(root_fd, name, "devnum", value)) {
+            info.devnum = (int)value;
+        }
+        if (read_dec(root_fd, name, "speed", value)) {                      // "1.5" 取整为 1
+            info.speedMbps = (uint32_t)value;
+        }
+        if (read_hex(root_fd, name, "bDeviceClass", value)) {
+            info.deviceClass = (uint8_t)value;
+        }
+        char buf[64];
+        if (read_attr(root_fd, name, "devpath", buf, sizeof(buf))) {
+            info.devpath = buf;
+        }
+        devices.push_back(std::move(info));
+    }
+    closedir(dir);
+
+    std::sort(devices.begin(), devices.end(), [](const UsbDeviceInfo& a, const UsbDeviceInfo& b) {
+        if (a.busnum != b.busnum) {
+            return a.busnum < b.busnum;
+        }
+        return a.devnum < b.devnum;
+    });
+    return true;
+}
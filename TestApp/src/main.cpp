@@ -4,28 +4,42 @@
 #include <atomic>
 #include <csignal>
 #include <vector>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
 
 #include "common/Constants.h"
 #include "Uart.h"
 #include "task/TaskQueue.h"
 #include "task/TaskHandler.h"
+#include "task/TaskRegistry.h"
 #include "util/Timer.h"
 #include "util/ZenityDialog.h"
+#include "util/Reactor.h"
+#include "util/TimerWheel.h"
+#include "util/LogSink.h"
+#include "util/LogPersist.h"
 #include "util/theradpoolv1/thread_pool.h"
 #include "protocol/ProtocolParser.h"
 #include "hardware/RkGenericBoard.h"
+#include "hardware/DeviceRegistry.h"
 #include "project/BoardFactory.h"
 
 const char *APP_TAG = "TestApp";    
 
 BoardFactory factory;
 
-std::queue<std::shared_ptr<interrupt_flag>> interrupt_flags_queue_main;           
 thread_pool work_thread_main(8);                                             
 
-std::queue<std::shared_ptr<interrupt_flag>> interrupt_flags_queue_task;      
+TaskRegistry task_registry;                                                 // 测试任务登记表，按 cmdIndex 管理任务，也持有常驻任务的中断标志
 thread_pool work_thread_task(8);                                            
 
+Reactor main_reactor;                                                       // 承载 signalfd、交互式测试的异步等待等事件源
+TimerWheel main_timer_wheel(main_reactor);                                  // 全局共享时间轮，LED 闪烁、测试中的延时和超时都挂在上面
+DeviceRegistry device_registry(main_reactor);                               // usb / 块设备登记表，由 udev 热插拔事件更新
+
 void test(std::shared_ptr<RkGenericBoard> Board) {
     // Board->getDdrSize();
     // Board->getEmmcSize();
@@ -56,9 +70,27 @@ void test(std::shared_ptr<RkGenericBoard> Board) {
     // }
 }
 void signal_handler(int signum);
+int setup_signalfd();
+void setup_file_log();
 
 
 int main() {
+    // 在创建任何线程之前屏蔽 SIGINT，之后创建的线程都会继承，由 signalfd 统一接收
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    setup_file_log();
+
+    if (!main_reactor.start()) {
+        log_thread_safe(LOG_LEVEL_ERROR, APP_TAG, "reactor 启动失败，程序退出");
+        return 0;
+    }
+    if (!device_registry.start()) {
+        log_thread_safe(LOG_LEVEL_ERROR, APP_TAG, "设备登记表启动失败，usb / u 盘测试回退到每次扫描");
+    }
+
     char *val = getenv("BUILD_VER");
     log_thread_safe(LOG_LEVEL_INFO, APP_TAG, "固件版本: %s", val ? val : "未知");
 
@@ -71,6 +103,13 @@ int main() {
     }
     log_thread_safe(LOG_LEVEL_INFO, APP_TAG, "创建板卡实例: %s", detected_board_name.c_str());
     Board->set_firmware_version(val ? val : "unknown");
+    Board->setDeviceRegistry(&device_registry);
+
+    uint8_t ln_buffer[512];
+    uint16_t ln_len = sizeof(ln_buffer);
+    if (Board->vendor_storage_read(VENDOR_CUSTOM_ID_1, ln_buffer, &ln_len) == 0 && ln_len > 0) {
+        log_set_ln(std::string((char*)ln_buffer, strnlen((char*)ln_buffer, ln_len)));   // 结构化日志按 LN 区分板卡
+    }
 
     test(Board);
 
@@ -79,10 +118,7 @@ int main() {
     TaskHandler taskHandler(protocol);
 
     std::shared_ptr<interrupt_flag> recv_flag = std::make_shared<interrupt_flag>();
-    interrupt_flags_queue_main.push(recv_flag);
-
-    std::signal(SIGINT, signal_handler);
-    log_thread_safe(LOG_LEVEL_INFO, APP_TAG, "已注册 SIGINT 信号处理函数，等待退出信号...");
+    task_registry.addResident(recv_flag);
 
     std::shared_ptr<interrupt_flag> task_handler_flag = 
         work_thread_main.submit_interruptible([&taskQueue, &taskHandler, &Board](interrupt_flag& flag) {
@@ -95,11 +131,15 @@ int main() {
             }
             log_thread_safe(LOG_LEVEL_INFO, APP_TAG, "任务处理线程退出");
         });
-    interrupt_flags_queue_main.push(task_handler_flag);
+    task_registry.addResident(task_handler_flag);
 
     std::shared_ptr<interrupt_flag> sleep_for_main = std::make_shared<interrupt_flag>();
-    interrupt_flags_queue_main.push(sleep_for_main);
-    
+    task_registry.addResident(sleep_for_main);
+
+    int sig_fd = setup_signalfd();
+    if (sig_fd >= 0) {
+        log_thread_safe(LOG_LEVEL_INFO, APP_TAG, "已注册 SIGINT signalfd，等待退出信号...");
+    }
 
     uint8_t buffer[1024];
     while(!recv_flag->is_stop_requested()) {
@@ -119,26 +159,89 @@ int main() {
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
+    main_reactor.stop();
+    device_registry.stop();
+    if (sig_fd >= 0) {
+        close(sig_fd);
+    }
+
     log_thread_safe(LOG_LEVEL_INFO, APP_TAG, "接收数据，解析线程退出");
     log_thread_safe(LOG_LEVEL_INFO, APP_TAG, "退出主循环，程序结束");
     return 0;
 }
 
-void signal_handler(int signal) {
-    if (signal == SIGINT) {
-        log_thread_safe(LOG_LEVEL_INFO, APP_TAG, " ctrl + c 按下，准备退出...");
-        while (!interrupt_flags_queue_main.empty()) {
-            std::shared_ptr<interrupt_flag> flag = interrupt_flags_queue_main.front();
-            flag->request_stop();
-            interrupt_flags_queue_main.pop();
+/*
+ * @brief 创建 SIGINT 的 signalfd 并注册到 main_reactor
+ *        信号在 reactor 线程中以普通事件处理，不再受异步信号安全的限制
+ * @return signalfd，失败返回 -1
+ */
+int setup_signalfd() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+
+    int sig_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sig_fd < 0) {
+        log_thread_safe(LOG_LEVEL_ERROR, APP_TAG, "signalfd 创建失败: %s", strerror(errno));
+        return -1;
+    }
+
+    bool ok = main_reactor.add_fd(sig_fd, EPOLLIN, [sig_fd](uint32_t events) {
+        struct signalfd_siginfo info;
+        while (read(sig_fd, &info, sizeof(info)) == sizeof(info)) {
+            signal_handler(info.ssi_signo);
         }
+    });
+    if (!ok) {
+        close(sig_fd);
+        return -1;
+    }
+    return sig_fd;
+}
 
-        while(!interrupt_flags_queue_task.empty()) {
-            std::shared_ptr<interrupt_flag> flag = interrupt_flags_queue_task.front();
-            flag->request_stop();
-            interrupt_flags_queue_task.pop();
+/*
+ * @brief 日志直接写入文件 (TEST_APP_LOG 环境变量可指定路径)，按大小轮转
+ *        stdout 仍被重定向到同一个文件时关闭控制台输出，避免每行写两遍
+ *        同时写一份到 mmap 持久化环形缓冲区，掉电后用 log_recover 找回最后的日志
+ *        设置了 TEST_APP_JSON_LOG 时再输出一份 JSON Lines 结构化日志 (值为空时用默认路径)，用 log_index 检索
+ */
+void setup_file_log() {
+    const char* json_path = getenv("TEST_APP_JSON_LOG");
+    if (json_path != nullptr) {
+        auto json = std::make_shared<JsonLogSink>(*json_path ? json_path : LOG_JSON_FILE_PATH, LOG_FILE_MAX_SIZE,
+                                                  LOG_FILE_COUNT, LOG_FILE_SYNC_MS);
+        if (json->is_open()) {
+            log_add_sink(json);
         }
     }
+
+    auto ring = std::make_shared<PersistentLogSink>(LOG_RING_FILE_PATH, LOG_RING_FILE_SIZE);
+    if (ring->is_open()) {
+        log_add_sink(ring);
+    }
+
+    const char* path = getenv("TEST_APP_LOG");
+    auto sink = std::make_shared<FileLogSink>(path ? path : LOG_FILE_PATH, LOG_FILE_MAX_SIZE, LOG_FILE_COUNT,
+                                              LOG_FILE_SYNC_MS);
+    if (!sink->is_open()) {
+        log_thread_safe(LOG_LEVEL_ERROR, APP_TAG, "无法打开日志文件 %s，只输出到控制台", sink->path().c_str());
+        return;
+    }
+
+    struct stat log_st;
+    struct stat out_st;
+    if (stat(sink->path().c_str(), &log_st) == 0 && fstat(STDOUT_FILENO, &out_st) == 0 &&
+        log_st.st_dev == out_st.st_dev && log_st.st_ino == out_st.st_ino) {
+        log_enable_console(false);
+    }
+    log_add_sink(sink);
+}
+
+void signal_handler(int signal) {
+    if (signal == SIGINT) {
+        log_thread_safe(LOG_LEVEL_INFO, APP_TAG, " ctrl + c 按下，准备退出...");
+        task_registry.shutdown();
+    }
 }
 
     // key detect task v3.0, need to move to TaskHandler
@@ -9,8 +9,11 @@
 #include "Uart.h"
 #include "task/TaskQueue.h"
 #include "task/TaskHandler.h"
+#include "task/TaskRegistry.h"
 #include "util/Timer.h"
 #include "util/ZenityDialog.h"
+#include "util/Reactor.h"
+#include "util/TimerWheel.h"
 #include "util/theradpoolv1/thread_pool.h"
 #include "protocol/ProtocolParser.h"
 #include "hardware/RkGenericBoard.h"
@@ -23,8 +26,11 @@ BoardFactory factory;
 std::vector<std::shared_ptr<interrupt_flag>> interrupt_flags_vector;           
 thread_pool work_thread(8);                                             
 
-std::queue<std::shared_ptr<interrupt_flag>> interrupt_flags_queue_task;      
-thread_pool work_thread_task(8);                                            
+TaskRegistry task_registry;
+thread_pool work_thread_task(8);
+
+Reactor main_reactor;
+TimerWheel main_timer_wheel(main_reactor);                                            
 
 void signal_handler(int signum);
 
@@ -82,11 +88,7 @@ void signal_handler(int signal) {
             flag->request_stop();
         }
 
-        while(!interrupt_flags_queue_task.empty()) {
-            std::shared_ptr<interrupt_flag> flag = interrupt_flags_queue_task.front();
-            flag->request_stop();
-            interrupt_flags_queue_task.pop();
-        }
+        task_registry.cancelAll();
     }
 }
 
@@ -4,7 +4,9 @@
 #include "Uart.h"
 #include "task/TaskQueue.h"
 #include "task/TaskHandler.h"
+#include "task/TaskRegistry.h"
 #include "util/Timer.h"
+#include "util/TimerWheel.h"
 #include "util/ZenityDialog.h"
 #include "util/theradpoolv1/thread_pool.h"
 #include "protocol/ProtocolParser.h"
@@ -15,8 +17,9 @@
 
 const char *BOARD_FACTORY_TAG = "BoardFactory";
   
-extern std::queue<std::shared_ptr<interrupt_flag>> interrupt_flags_queue_main;
+extern TaskRegistry task_registry;
 extern thread_pool work_thread_main;
+extern TimerWheel main_timer_wheel;
 
 
 std::shared_ptr<RkGenericBoard> BoardFactory::create_board_v1(const std::string& board_name) {
@@ -38,6 +41,7 @@ std::shared_ptr<RkGenericBoard> BoardFactory::create_board_v1(const std::string&
                 delete uart;
                 return nullptr;
             }
+            // 设备登记表启动后 emmc / tf / pcie 按总线识别，下面的路径只在登记表不可用时使用
             std::shared_ptr<RkGenericBoard> board = std::make_shared<ZY3588>(
                 "/sys/class/block/mmcblk0/size", "/sys/class/block/nvme0n1/size",                                       /* Storage  : emmc path, pcie path*/
                 "/sys/class/block/mmcblk1/size",                                                                        /* Tf       : tf card path */
@@ -49,19 +53,15 @@ std::shared_ptr<RkGenericBoard> BoardFactory::create_board_v1(const std::string&
                 "/dev/rtc0"                                                                                             /* Rtc      : rtc device path */
             );
 
-            std::shared_ptr<interrupt_flag> led_shink_flag = 
-                work_thread_main.submit_interruptible([board_ptr = board](interrupt_flag& flag) {                                                                                                              // board_ptr 指向的是堆区对象，后面std::move(board);了。 
-                                                                                                                                                                                                                // 外面函数千万不要reset这个指针，让它自然析构，设计缺陷请后面再优化   /(ㄒoㄒ)/~~
-                                                                                                                                                                                   // 目前情况是大部分线程持有的board指针都是这个board_ptr指针，而线程池只有在程序退出时才析构，所以不会有野指针问题。
-                    while (!flag.is_stop_requested()) {
-                        board_ptr->setRledStatus(LED_ON);
-                        sleep(1);
-                        board_ptr->setRledStatus(LED_OFF);
-                        sleep(1);
-                    }
-                    log_thread_safe(LOG_LEVEL_INFO, BOARD_FACTORY_TAG, "led shink task exit, thread end");
-                });
-            interrupt_flags_queue_main.push(led_shink_flag);
+            // 红灯闪烁挂在共用的时间轮上，不再占着一个线程池线程 sleep(1)
+            std::shared_ptr<interrupt_flag> led_shink_flag = std::make_shared<interrupt_flag>();
+            std::shared_ptr<bool> rled_on = std::make_shared<bool>(true);
+            board->setRledStatus(LED_ON);
+            main_timer_wheel.schedule_periodic(1000, [board_ptr = board, rled_on]() {                                                                                                                   // board_ptr 指向的是堆区对象，定时器持有到程序退出
+                *rled_on = !*rled_on;
+                board_ptr->setRledStatus(*rled_on ? LED_ON : LED_OFF);
+            }, led_shink_flag);
+            task_registry.addResident(led_shink_flag);
 
             std::shared_ptr<interrupt_flag> audio_test_flag = 
                 work_thread_main.submit_interruptible([board_ptr = board](interrupt_flag& flag) {
@@ -74,7 +74,7 @@ std::shared_ptr<RkGenericBoard> BoardFactory::create_board_v1(const std::string&
                     }
                     log_thread_safe(LOG_LEVEL_INFO, BOARD_FACTORY_TAG, "audio test task exit, thread end");
                 });
-            interrupt_flags_queue_main.push(audio_test_flag);
+            task_registry.addResident(audio_test_flag);
 
             return board;
         }        
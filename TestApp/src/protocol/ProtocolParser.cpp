@@ -121,15 +121,13 @@ int ProtocolParser::parseFrame() {
                     if (!parseJson(jsonStr)) {
                         buffer_.consume(totalFrameLen_);
                         std::cerr << "JSON解析失败" << std::endl;
+                        log_thread_safe(LOG_LEVEL_ERROR, PROTOCOL_TAG, "json parse failed: %s", request_.error().c_str());
                         state_ = STATE_IDLE;
                         return 0;
                     }
 
-                    // 转化为json打印
-                    Json::StreamWriterBuilder writer;      //格式化
-                    std::string json = Json::writeString(writer, jsonRoot_);
-                    // std::cout << "解析的数据: " << std::endl << json << std::endl;
-                    log_thread_safe(LOG_LEVEL_INFO, PROTOCOL_TAG, "recv : %s", json.c_str());
+                    // 直接打印收到的原文，不再重新格式化
+                    log_thread_safe(LOG_LEVEL_INFO, PROTOCOL_TAG, "recv : %s", jsonStr.c_str());
                     // std::cout << "cmdIndex: " << cmdIndex_ << std::endl;
                     log_thread_safe(LOG_LEVEL_INFO, PROTOCOL_TAG, "cmdIndex : %d", cmdIndex_);
                 }
@@ -139,8 +137,8 @@ int ProtocolParser::parseFrame() {
             case STATE_BUILD_TASK:
                 // 构造任务
                 currentTask_.cmdIndex = cmdIndex_;
-                currentTask_.subCommand = static_cast<SubCommand>(jsonRoot_["subCommand"].asInt());
-                currentTask_.data = jsonRoot_["data"];
+                currentTask_.subCommand = static_cast<SubCommand>(request_["subCommand"].as_int());
+                JsonDocument::to_value(request_["data"], currentTask_.data);   // 处理函数还在用 Json::Value
                 state_ = STATE_CONSUME_DATA;
                 break;
 
@@ -167,13 +165,35 @@ int ProtocolParser::parseFrame() {
     }
 }
 
+// 应答在多个线程中发送，每个线程一个文档
+static JsonDocument& response_document() {
+    static thread_local JsonDocument document;
+    return document;
+}
+
+// 紧凑格式，输出和 jsoncpp 相同只是没有缩进
+static std::string write_response(const Json::Value& root) {
+    JsonDocument& document = response_document();
+    document.from_value(root);
+    std::string jsonStr;
+    jsonStr.reserve(512);
+    document.write(jsonStr);
+    document.clear();
+    return jsonStr;
+}
+
 bool ProtocolParser::packData(std::vector<uint8_t>& pack, const std::string& jsonData, uint16_t cmdIndex) {
     // 验证JSON格式
-    Json::Value temp;
-    if (!JsonHelper::parse(jsonData, temp)) {
-        std::cerr << "JSON格式错误: " << JsonHelper::getError() << std::endl;
+    JsonDocument& document = response_document();
+    bool valid = document.parse(jsonData);
+    if (!valid) {
+        std::string error = document.error();                               // clear() 会清空错误信息
+        document.clear();
+        std::cerr << "JSON格式错误: " << error << std::endl;
+        log_thread_safe(LOG_LEVEL_ERROR, PROTOCOL_TAG, "invalid json: %s", error.c_str());
         return false;
     }
+    document.clear();
 
     // 计算包大小
     uint16_t contentLen = jsonData.length() + 1;
@@ -210,8 +230,7 @@ Task ProtocolParser::getTask() const {
 }
 
 bool ProtocolParser::sendResponse(const Json::Value& root) {
-    Json::StreamWriterBuilder writer;      //格式化
-    std::string jsonStr = Json::writeString(writer, root);
+    std::string jsonStr = write_response(root);
     log_thread_safe(LOG_LEVEL_INFO, PROTOCOL_TAG, "test result: %s", jsonStr.c_str());
     std::vector<uint8_t> sendPack(jsonStr.length() + 9);
     if (!packData(sendPack, jsonStr, reportCmdIndex_++)) {
@@ -219,13 +238,12 @@ bool ProtocolParser::sendResponse(const Json::Value& root) {
         log_thread_safe(LOG_LEVEL_ERROR, PROTOCOL_TAG, "packData Error");
         return false;
     }
-    log_thread_safe(LOG_LEVEL_INFO, PROTOCOL_TAG, "send data length : %d", jsonStr.length() + 9);
+    log_thread_safe(LOG_LEVEL_INFO, PROTOCOL_TAG, "send data length : %zu", jsonStr.length() + 9);
     return uart_->sendData(sendPack.data(), sendPack.size()) == sendPack.size();
 }
 
 bool ProtocolParser::sendResponse(const Json::Value& root, int cmdIndex) {
-    Json::StreamWriterBuilder writer;      //格式化
-    std::string jsonStr = Json::writeString(writer, root);
+    std::string jsonStr = write_response(root);
     // std::cout << "回复应答：" << jsonStr << std::endl;
     log_thread_safe(LOG_LEVEL_INFO, PROTOCOL_TAG, "response data: %s", jsonStr.c_str());
     std::vector<uint8_t> sendPack(jsonStr.length() + 9);
@@ -234,7 +252,7 @@ bool ProtocolParser::sendResponse(const Json::Value& root, int cmdIndex) {
         log_thread_safe(LOG_LEVEL_ERROR, PROTOCOL_TAG, "packData Error");
         return false;
     }
-    log_thread_safe(LOG_LEVEL_INFO, PROTOCOL_TAG, "response cmdIndex : %d, data length : %d", cmdIndex, jsonStr.length() + 9);
+    log_thread_safe(LOG_LEVEL_INFO, PROTOCOL_TAG, "response cmdIndex : %d, data length : %zu", cmdIndex, jsonStr.length() + 9);
 
     // for (int i = 0; i < sendPack.size(); i++) {
     //     printf("%02X ", sendPack[i]);
@@ -244,26 +262,16 @@ bool ProtocolParser::sendResponse(const Json::Value& root, int cmdIndex) {
 }
 
 bool ProtocolParser::sendResponse(const Json::Value& root, CmdType cmdType) {
-    // Json::Value response = root;
-    // response["cmdType"] = cmdType;
-
-    // std::string jsonStr = JsonHelper::stringify(response);
-    // std::vector<uint8_t> sendPack;
-
-    // uint16_t cmdIndex = reportCmdIndex_++;
-    // if (!packData(sendPack, jsonStr, cmdIndex)) {
-    //     std::cerr << "packData Error " << std::endl;
-    //     return false;
-    // }
-    // std::cout << "report jsonStr data: " << jsonStr.data() << std::endl;
-    // return uart_.sendData(sendPack.data(), sendPack.size()) == sendPack.size();
+    // 没有调用者，主动上报用 sendResponse(root)
+    (void)root;
+    (void)cmdType;
     return false;
 }
 
 void ProtocolParser::reset() {
     std::lock_guard<std::mutex> lock(mutex_);
     buffer_.clear();
-    jsonRoot_.clear();
+    request_.clear();
     lastCmdIndex_ = 65535;
     currentTask_.subCommand = static_cast<SubCommand>(0);
     currentTask_.data = Json::Value();
@@ -271,6 +279,6 @@ void ProtocolParser::reset() {
 }
 
 bool ProtocolParser::parseJson(const std::string& jsonStr) {
-    return JsonHelper::parse(jsonStr, jsonRoot_);
+    return request_.parse(jsonStr);
 }
 
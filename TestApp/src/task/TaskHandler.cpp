@@ -1,28 +1,48 @@
 #include "task/TaskHandler.h"
 #include "hardware/TestInterface.h"
 #include <iostream>
+#include <algorithm>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include "util/theradpoolv1/thread_pool.h"
+#include "util/theradpoolv1/future_utils.h"
 #include "util/ZenityDialog.h"
     
-extern std::queue<std::shared_ptr<interrupt_flag>> interrupt_flags_queue_task; 
+extern TaskRegistry task_registry;
 extern thread_pool work_thread_task;
+extern Reactor main_reactor;
+extern TimerWheel main_timer_wheel;
 
 ZenityDialog dialog;               // A graphical dialog box suitable for the Ubuntu Gnome desktop. It doesn't matter if it doesn't exist.
 
-TaskHandler::TaskHandler(ProtocolParser& protocol) : protocol_(protocol), keyThreadStopFlag_(false) {
+TaskHandler::TaskHandler(ProtocolParser& protocol) : protocol_(protocol), keyThreadStopFlag_(false), waiter_(main_reactor, main_timer_wheel) {
 
 }
 
 void TaskHandler::stop_all_tasks() {
     log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "Stopping all ongoing test tasks...");
-    while(!interrupt_flags_queue_task.empty()) {
-        std::shared_ptr<interrupt_flag> flag = interrupt_flags_queue_task.front();
-        flag->request_stop();
-        interrupt_flags_queue_task.pop();
-    }
+    task_registry.cancelAll();
+}
+
+void TaskHandler::submit_test(const Task& task, const std::string& name, std::function<void(interrupt_flag&)> fn) {
+    uint16_t cmdIndex = task.cmdIndex;
+    std::shared_ptr<interrupt_flag> flag = task_registry.add(cmdIndex, name);
+
+    work_thread_task.submit_interruptible(flag, [cmdIndex, fn](interrupt_flag& flag) {
+        LogCmdScope log_scope(cmdIndex);
+        if (flag.is_stop_requested()) {                                // cancelled while still queued
+            task_registry.markDone(cmdIndex, flag);
+            return;
+        }
+        task_registry.markRunning(cmdIndex, flag);
+        fn(flag);
+        task_registry.markDone(cmdIndex, flag);
+    });
 }
 
 void TaskHandler::processTask(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    LogCmdScope log_scope(task.cmdIndex);                                   // tag every log line of this command with its cmdIndex
     switch (task.subCommand) {
         case CMD_HANDSHAKE:                         
             log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "CMD_HANDSHAKE : 0x01");
@@ -64,6 +84,16 @@ void TaskHandler::processTask(const Task& task, std::shared_ptr<RkGenericBoard>
             executeTestAndRespond(task, Board);
             break;
 
+        case CMD_CANCEL_TEST:
+            log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "CMD_CANCEL_TEST : 0x11");
+            handleCancelTest(task);
+            break;
+
+        case CMD_QUERY_TEST_STATUS:
+            log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "CMD_QUERY_TEST_STATUS : 0x12");
+            handleQueryTestStatus(task);
+            break;
+
         default:
             log_thread_safe(LOG_LEVEL_WARN, TaskHandlerTag, "unknown command: 0x%02X", task.subCommand);
             break;
@@ -162,6 +192,13 @@ void TaskHandler::executeTestAndRespond(const Task& task, std::shared_ptr<RkGene
 }
 
 void TaskHandler::switchs_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    SwitchTestCase testCase;
+    JsonDecodeContext ctx;
+    if (!json_decode_member(task.data, "testCase", testCase, ctx)) {
+        respondInvalidParam(task, ctx.error());
+        return;
+    }
+
     Json::Value response;
     Json::Value responseData;
     responseData = task.data;
@@ -171,15 +208,13 @@ void TaskHandler::switchs_test(const Task& task, std::shared_ptr<RkGenericBoard>
     response["result"] = "true";        
 
     std::map<int, std::string> keyMap;
-    for (Json::Value& item : itemList) {                            // boot_11  power_12  Fixed format separation  Boot key-value name, 11 key-value
-        if (item["enable"].asBool() == false) {                     // keys that are not enabled in the test items will be skipped during the detection.
-            item["testResult"] = "SKIP";
+    for (size_t i = 0; i < testCase.itemList.size(); ++i) {         // boot_11  power_12  Fixed format separation  Boot key-value name, 11 key-value
+        const SwitchItem& item = testCase.itemList[i];
+        if (item.enable == false) {                                 // keys that are not enabled in the test items will be skipped during the detection.
+            itemList[(Json::ArrayIndex)i]["testResult"] = "SKIP";
             continue;
         }
-        size_t underscorePos = item["type"].asString().find('_');                    // find out where is the underline is
-        std::string keyName = item["type"].asString().substr(0, underscorePos);      // extract key name
-        int keyCode = std::stoi(item["type"].asString().substr(underscorePos + 1));  // extract key code and convert to int
-        keyMap[keyCode] = keyName;                                                   // store in map for later detection
+        keyMap[item.type.code] = item.type.name;                    // store in map for later detection
     }
 
     log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test :  buttons pre-configured within the app are ....");
@@ -198,132 +233,142 @@ void TaskHandler::switchs_test(const Task& task, std::shared_ptr<RkGenericBoard>
     int detectCount = keyMap.size();
     log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : Total number of buttons to be detected: %d", detectCount);
 
-    // switch test version 1.0: using std::thread
-    // std::thread keyThread ([this, Board = Board.get(), detectCount, keyMap, responseData]() mutable {
-    //     int remainingCount = detectCount;
-    //     Json::Value localResponseData = responseData;
-    //     Json::Value localResponse;
-    //     localResponse["result"] = "true";
-        
-    //     while(remainingCount > 0) {
-    //         if (Board == nullptr) {
-    //             std::cout << "Board指针无效" << std::endl;
-    //             break;
-    //         }
-            
-    //         int ret = Board->Key::waitForKeyAndIrPress();
-    //         if (ret == -1) {
-    //             // continue; // 超时或错误，继续等待
-    //             std::cout << "按键检测错误或超时，线程退出" << std::endl;
-    //             break;
-    //         }
+    std::vector<int> itemCodes;                                     // key code of each item, same index as itemList
+    for (const SwitchItem& item : testCase.itemList) {
+        itemCodes.push_back(item.type.code);
+    }
 
-    //         if (Board->Key::keyMap.count(ret) && keyMap.count(ret) && Board->Key::keyMap[ret] == keyMap[ret]) {
-    //             std::cout << "按键: " << Board->Key::keyMap[ret] << "按下，测试通过" << std::endl;
-                
-    //             Json::Value& itemList = localResponseData["testCase"]["itemList"];
-    //             for (Json::Value& item : itemList) {
-    //                 size_t underscorePos = item["type"].asString().find('_');
-    //                 std::string keyName = item["type"].asString().substr(0, underscorePos);
-    //                 int keyCode = std::stoi(item["type"].asString().substr(underscorePos + 1));
-    //                 if (keyCode == ret) {
-    //                     item["testResult"] = "OK";
-    //                     break;
-    //                 }
-    //             }
+    // 等待按键期间不占用线程，测试写成协程在 reactor 线程中执行
+    std::shared_ptr<interrupt_flag> flag = start_async_test(task, "switchs");
+    switchs_wait_keys(Board, flag, task.cmdIndex, keyMap, itemCodes, responseData, patchRequest(task));
+}
 
-    //             if (keyMap.count(ret)) {
-    //                 // 从待测按键映射表中移除已测试按键
-    //                 keyMap.erase(ret);
-    //                 remainingCount--;
-    //                 std::cout << "按键移除 " << Board->Key::keyMap[ret] << std::endl;
-    //                 std::cout << "剩余待测按键数量: " << remainingCount << std::endl;
-    //             }
+AsyncTask TaskHandler::switchs_wait_keys(std::shared_ptr<RkGenericBoard> Board, std::shared_ptr<interrupt_flag> flag,
+                                         uint16_t cmdIndex, std::map<int, std::string> keyMap, std::vector<int> itemCodes,
+                                         Json::Value responseData, std::shared_ptr<const PatchRequest> patch) {
+    std::vector<int> fds;
+    if (!Board->Key::openKeyEventDevices(fds, true)) {
+        log_thread_safe(LOG_LEVEL_ERROR, TaskHandlerTag, "-> switch test : Key detection config error, exiting key test");
+        task_registry.markDone(cmdIndex, *flag);
+        co_return;
+    }
+    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test :  switch test started");
 
-    //             if (remainingCount == 0) {
-    //                 std::cout << "所有按键测试完成，发送响应" << std::endl;
-    //                 localResponse["cmdType"] = 1;
-    //                 localResponse["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
-    //                 localResponse["data"] = localResponseData;
-    //                 this->protocol_.sendResponse(localResponse);
-    //             }
-    //         }
-    //     }
-        
-    // });
-    // keyThread.detach();
-
-    // switch test version 2.0: using thread pool with interruptible task
-    std::shared_ptr<interrupt_flag> keyThreadStopFlag =
-        work_thread_task.submit_interruptible([this, Board, detectCount, keyMap, responseData](interrupt_flag& flag) mutable {
-            // create key test thread, return interrupt_flag ptr
-
-            log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test :  switch test thread started");
-            int remainingCount = detectCount;                             // remaining keys to test
-            Json::Value localResponseData = responseData;          
-            Json::Value localResponse;
-            localResponse["result"] = "true";
-
-            while(remainingCount > 0 && !flag.is_stop_requested()) {      // check if need to stop.
-                if (Board == nullptr) {
-                    log_thread_safe(LOG_LEVEL_ERROR, TaskHandlerTag, "-> switch test : Board pointer is invalid, exiting key test thread");
-                    break;
-                }
-                
-                int ret = Board->Key::waitForKeyPress(120);
-                if (ret == -1) {
-                    log_thread_safe(LOG_LEVEL_ERROR, TaskHandlerTag, "-> switch test : Key detection config error, exiting key test thread");
+    int detectCount = keyMap.size();
+    int remainingCount = detectCount;
+    while (remainingCount > 0) {
+        AsyncWaiter::fd_event event = co_await waiter_.wait_fds(fds, EPOLLIN, 120 * 1000, flag);
+        if (event.result == ASYNC_WAIT_TIMEOUT) {
+            log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : Key detection wait timeout, continue to wait for key press...");
+            continue;
+        }
+        if (event.result != ASYNC_WAIT_READY) {                             // cancelled or error
+            break;
+        }
+
+        int ret = Board->Key::readKeyCode(event.fd);
+        if (ret != -1 && Board->Key::keyMap.count(ret) && keyMap.count(ret) && Board->Key::keyMap[ret] == keyMap[ret]) {
+            log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : Key: %s pressed, test passed", Board->Key::keyMap[ret].c_str());
+
+            Json::Value& itemList = responseData["testCase"]["itemList"];
+            for (size_t i = 0; i < itemCodes.size(); ++i) {
+                if (itemCodes[i] == ret) {
+                    itemList[(Json::ArrayIndex)i]["testResult"] = "OK";
                     break;
-                } else if (ret == 0) {
-                    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : Key detection wait timeout, continue to wait for key press...");
-                    continue;
                 }
+            }
 
-                if (Board->Key::keyMap.count(ret) && keyMap.count(ret) && Board->Key::keyMap[ret] == keyMap[ret]) {
-                    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : Key: %s pressed, test passed", Board->Key::keyMap[ret].c_str());
-                    
-                    Json::Value& itemList = localResponseData["testCase"]["itemList"];
-                    for (Json::Value& item : itemList) {
-                        size_t underscorePos = item["type"].asString().find('_');
-                        std::string keyName = item["type"].asString().substr(0, underscorePos);
-                        int keyCode = std::stoi(item["type"].asString().substr(underscorePos + 1));
-                        if (keyCode == ret) {
-                            item["testResult"] = "OK";
-                            break;
-                        }
-                    }
+            keyMap.erase(ret);                                              // remove tested key from to-be-tested key map
+            remainingCount--;
+            task_registry.setProgress(cmdIndex, *flag, (detectCount - remainingCount) * 100 / detectCount);
+            log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : Key %s removed from to-be-tested key map", Board->Key::keyMap[ret].c_str());
+            log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : Remaining number of keys to be tested: %d", remainingCount);
+        }
+    }
 
-                    if (keyMap.count(ret)) {                                // remove tested key from to-be-tested key map
-                        keyMap.erase(ret);  
-                        remainingCount--;
-                        log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : Key %s removed from to-be-tested key map", Board->Key::keyMap[ret].c_str());
-                        log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : Remaining number of keys to be tested: %d", remainingCount);
-                    }
+    if (remainingCount == 0) {
+        log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : All key tests completed, sending test result");
+        Json::Value localResponse;
+        localResponse["result"] = "true";
+        localResponse["cmdType"] = 1;
+        localResponse["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
+        localResponse["data"] = responseData;
+        sendTestResult(localResponse, patch);
+    }
+    Board->Key::closeKeyEventDevices(fds);
+    task_registry.markDone(cmdIndex, *flag);
+    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : switch test exited");
+}
 
-                    if (remainingCount == 0) {
-                        log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : All key tests completed, sending test result");
-                        localResponse["cmdType"] = 1;
-                        localResponse["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
-                        localResponse["data"] = localResponseData;
-                        this->protocol_.sendResponse(localResponse);
-                    }
-                }
-            }
-            log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "-> switch test : switch test thread exited");
+void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    StorageTestCase testCase;
+    JsonDecodeContext ctx;
+    if (!json_decode_member(task.data, "testCase", testCase, ctx)) {
+        respondInvalidParam(task, ctx.error());
+        return;
+    }
+
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
+
+    // 探测、测速和校验都可能要几秒到几分钟，整个放到任务线程池，不占住命令处理线程
+    submit_test(task, "storage", [this, Board, testCase, responseData = task.data, patch](interrupt_flag& flag) {
+        storage_run(testCase, responseData, patch, Board, flag);
     });
-    interrupt_flags_queue_task.push(keyThreadStopFlag);
 }
 
-void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+void TaskHandler::storage_run(const StorageTestCase& testCase, Json::Value responseData,
+                              std::shared_ptr<const PatchRequest> patch, std::shared_ptr<RkGenericBoard> Board,
+                              interrupt_flag& flag) {
     Json::Value response;
-    Json::Value responseData;
-    responseData = task.data;
-
     Json::Value& store = responseData["testCase"]["store"];
     response["result"] = "true";
 
-    int i = 0, j = 0, k = 0;
-    Board->scan_usb_with_libusb();
+    int i = 0;
+
+    // 各项探测互不依赖，同时提交到任务线程池再统一等待，存储测试的耗时取决于最慢的一项，而不是所有探测之和
+    // usb 扫描和 lsusb 只需要完成，容量探测按测试项去重，结果按 TestItem 汇总；
+    // 等待的是本测试所在的任务线程，命令处理线程不受影响
+    std::vector<std::future<bool>> usbProbes;
+    usbProbes.push_back(work_thread_task.submit([Board]() {
+        Board->scanUsbDisks();
+        return true;
+    }));
+    usbProbes.push_back(work_thread_task.submit([Board]() {
+        return Board->lsusbGetVidPidInfo();
+    }));
+
+    std::vector<TestItem> sizeItems;
+    std::vector<std::future<float>> sizeProbes;
+    for (const StorageItem& item : testCase.store) {
+        TestItem type = stringToTestItem(item.name);
+        if (item.enable == false ||
+            std::find(sizeItems.begin(), sizeItems.end(), type) != sizeItems.end()) {
+            continue;
+        }
+
+        std::function<float()> probe;
+        switch (type) {
+            case DDR:      probe = [Board]() { return Board->getDdrSize(); };    break;
+            case EMMC:     probe = [Board]() { return Board->getEmmcSize(); };   break;
+            case TF:       probe = [Board]() { return Board->getTfCardSize(); }; break;
+            case USB_PCIE: probe = [Board]() { return Board->getPcieSize(); };   break;
+            default:       continue;
+        }
+        sizeItems.push_back(type);
+        sizeProbes.push_back(work_thread_task.submit(probe));
+    }
+
+    std::future<std::map<TestItem, float>> sizeMapFuture =
+        then(when_all(std::move(sizeProbes)), [sizeItems](std::vector<float> sizes) {
+            std::map<TestItem, float> sizeMap;
+            for (size_t n = 0; n < sizeItems.size(); ++n) {
+                sizeMap[sizeItems[n]] = sizes[n];
+            }
+            return sizeMap;
+        });
+
+    std::map<TestItem, float> probedSizes = sizeMapFuture.get();
+    when_all(std::move(usbProbes)).get();
 
     // for (const auto& size : Board->usbDiskSizeList) {
     //     log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "udisk size: %.2f GB", size);
@@ -340,23 +385,51 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
     // }
 
 
-    Board->lsusbGetVidPidInfo();
-
-
-    for (Json::Value& item : store) {
-        switch (stringToTestItem(item["name"].asString())) {
+    for (size_t n = 0; n < testCase.store.size(); ++n) {
+        const StorageItem& config = testCase.store[n];
+        Json::Value& item = store[(Json::ArrayIndex)n];
+        switch (stringToTestItem(config.name)) {
             case DDR: {
-                if (item["enable"].asBool() == false) {
+                if (config.enable == false) {
                     item["testResult"] = "SKIP";
                     break;
                 }
 
-                float size = Board->getDdrSize();
+                float size = probedSizes[DDR];
                 char buffer[32];
                 snprintf(buffer, sizeof(buffer), "%.2f", size);    // reserve two decimal fractions
                 std::string strSize(buffer);
                 item["testValue"] = strSize;
-                if (size >= item["min"].asDouble() && size <= item["max"].asDouble()) {
+                if (size >= config.min && size <= config.max) {
+                    item["testResult"] = "OK";
+                } else {
+                    item["testResult"] = "NG";
+                    response["result"] = "false";
+                }
+            } break;
+
+            case DDR_BANDWIDTH: {
+                if (config.enable == false) {
+                    item["testResult"] = "SKIP";
+                    break;
+                }
+
+                // 容量探测都已结束，这时只有带宽测试在访问内存
+                if (ddr_bandwidth(config, item, flag)) {
+                    item["testResult"] = "OK";
+                } else {
+                    item["testResult"] = "NG";
+                    response["result"] = "false";
+                }
+            } break;
+
+            case DDR_MEMTEST: {
+                if (config.enable == false) {
+                    item["testResult"] = "SKIP";
+                    break;
+                }
+
+                if (ddr_memtest(config, item, flag)) {
                     item["testResult"] = "OK";
                 } else {
                     item["testResult"] = "NG";
@@ -365,17 +438,17 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
             } break;
 
             case EMMC: {
-                if (item["enable"].asBool() == false) {
+                if (config.enable == false) {
                     item["testResult"] = "SKIP";
                     break;
                 }
 
-                double size = Board->getEmmcSize();
+                double size = probedSizes[EMMC];
                 char buffer[32];
                 snprintf(buffer, sizeof(buffer), "%.2f", size);  // reserve two decimal fractions
                 std::string strSize(buffer);
                 item["testValue"] = strSize;
-                if (size >= item["min"].asDouble() && size <= item["max"].asDouble()) {
+                if (size >= config.min && size <= config.max) {
                     item["testResult"] = "OK";
                 } else {
                     item["testResult"] = "NG";
@@ -384,17 +457,17 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
             } break;
 
             case TF: {
-                if (item["enable"].asBool() == false) {
+                if (config.enable == false) {
                     item["testResult"] = "SKIP";
                     break;
                 }
 
-                double size = Board->getTfCardSize();
+                double size = probedSizes[TF];
                 char buffer[32];
                 snprintf(buffer, sizeof(buffer), "%.2f", size);   // reserve two decimal fractions
                 std::string strSize(buffer);
                 item["testValue"] = strSize;
-                if (size >= item["min"].asDouble() && size <= item["max"].asDouble()) {
+                if (size >= config.min && size <= config.max) {
                     item["testResult"] = "OK";
                 } else {
                     item["testResult"] = "NG";
@@ -403,7 +476,7 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
             } break;
 
             case USB: {
-                if (item["enable"].asBool() == false) {
+                if (config.enable == false) {
                     item["testResult"] = "OK";
                     item["testValue"] = "SKIP";
                     break;
@@ -415,7 +488,7 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
                     char buffer[32];
                     snprintf(buffer, sizeof(buffer), "%.2f", size);     // reserve two decimal fractions
                     std::string strSize(buffer);
-                    if (size >= item["min"].asDouble() && size <= item["max"].asDouble()) {
+                    if (size >= config.min && size <= config.max) {
                         item["testValue"] = strSize;
                         item["testResult"] = "OK";
                     } else {
@@ -432,16 +505,16 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
             } break;
 
             case USB_PCIE: {
-                if (item["enable"].asBool() == false) {
+                if (config.enable == false) {
                     item["testResult"] = "SKIP";
                     break;
                 }
 
-                double size = Board->getPcieSize();
+                double size = probedSizes[USB_PCIE];
                 char buffer[32];
                 snprintf(buffer, sizeof(buffer), "%.2f", size);     // reserve two decimal fractions
                 std::string strSize(buffer);
-                if (size >= item["min"].asDouble() && size <= item["max"].asDouble()) {
+                if (size >= config.min && size <= config.max) {
                     item["testValue"] = strSize;
                     item["testResult"] = "OK";
                 } else {
@@ -452,14 +525,14 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
             } break;
 
             case FACILITYUSB3_0: {
-                if (item["enable"].asBool() == false) {
+                if (config.enable == false) {
                     item["testResult"] = "SKIP";
                     break;
                 }
 
                 for (auto & lsusbInfo : Board->lsusbFacilityUsbInfoList) {
-                    if (lsusbInfo.vid == std::stoi(item["isVid"].asString()) &&
-                        lsusbInfo.pid == std::stoi(item["isPid"].asString())) {
+                    if (lsusbInfo.vid == config.isVid &&
+                        lsusbInfo.pid == config.isPid) {
                             item["testResult"] = "OK";
                             break;
                     }
@@ -467,14 +540,14 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
             } break;
 
             case FACILITYUSB2_0: {
-                if (item["enable"].asBool() == false) {
+                if (config.enable == false) {
                     item["testResult"] = "SKIP";
                     break;
                 }
 
                 for (auto & lsusbInfo : Board->lsusbFacilityUsbInfoList) {
-                    if (lsusbInfo.vid == std::stoi(item["isVid"].asString()) &&
-                        lsusbInfo.pid == std::stoi(item["isPid"].asString())) {
+                    if (lsusbInfo.vid == config.isVid &&
+                        lsusbInfo.pid == config.isPid) {
                             item["testResult"] = "OK";
                             break;
                     }
@@ -485,10 +558,417 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
                 break;
         }
     }
+
+    // 测速和校验在容量检查之后逐个进行，几个盘同时测会互相抢总线带宽
+    size_t usbIndex = 0;
+    for (size_t n = 0; n < testCase.store.size(); ++n) {
+        const StorageItem& config = testCase.store[n];
+        TestItem type = stringToTestItem(config.name);
+        if (type != EMMC && type != TF && type != USB && type != USB_PCIE) {
+            continue;
+        }
+        size_t index = (type == USB && config.enable) ? usbIndex++ : 0;    // 和容量检查一样，u 盘按启用的顺序对应
+        if (config.enable == false || (config.benchEnabled() == false && config.verifySizeMB <= 0)) {
+            continue;
+        }
+
+        if (flag.is_stop_requested()) {
+            log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "storage test cancelled, skip remaining bench / verify");
+            response["result"] = "false";
+            break;
+        }
+
+        Json::Value& item = store[(Json::ArrayIndex)n];
+        std::string target = storage_bench_target(config, type, index, Board);
+        if (config.benchEnabled() && !storage_bench(config, target, item, flag)) {
+            item["testResult"] = "NG";
+            response["result"] = "false";
+        }
+        if (config.verifySizeMB > 0 && !storage_verify(config, target, item, flag)) {
+            item["testResult"] = "NG";
+            response["result"] = "false";
+        }
+    }
+
+    if (testCase.concurrentBench.enable && !flag.is_stop_requested() &&
+        !storage_concurrent_bench(testCase, store, responseData["testCase"]["concurrentBench"], Board, flag)) {
+        response["result"] = "false";
+    }
+
     response["cmdType"] = 1;
     response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
     response["data"] = responseData;
-    protocol_.sendResponse(response);
+    sendTestResult(response, patch);
+}
+
+// 从 "/sys/block/mmcblk1/size" 取出 "mmcblk1"
+static std::string sysfs_block_name(const char* sizePath) {
+    std::string path = sizePath ? sizePath : "";
+    std::string::size_type end = path.rfind('/');
+    std::string::size_type begin = (end == std::string::npos || end == 0) ? std::string::npos : path.rfind('/', end - 1);
+    if (begin == std::string::npos) {
+        return "";
+    }
+    return path.substr(begin + 1, end - begin - 1);
+}
+
+// path 所在的文件系统是否在磁盘 disk 或它的分区上：按 st_dev 找 /sys/dev/block/主:次 指向的块设备
+// overlayfs 等没有块设备的文件系统 st_dev 是匿名设备号，找不到，返回 false
+static bool path_on_disk(const char* path, const std::string& disk) {
+    struct stat st;
+    if (disk.empty() || stat(path, &st) != 0) {
+        return false;
+    }
+    char link[64];
+    snprintf(link, sizeof(link), "/sys/dev/block/%u:%u", major(st.st_dev), minor(st.st_dev));
+    char resolved[PATH_MAX];
+    if (realpath(link, resolved) == nullptr) {
+        return false;
+    }
+    // ".../block/mmcblk0" 或 ".../block/mmcblk0/mmcblk0p6"
+    std::string sysPath = resolved;
+    std::string::size_type slash = sysPath.rfind('/');
+    std::string name = sysPath.substr(slash + 1);
+    std::string parent = (slash == std::string::npos || slash == 0) ? "" : sysfs_block_name((sysPath.substr(0, slash) + "/size").c_str());
+    return name == disk || parent == disk;
+}
+
+std::string TaskHandler::storage_bench_target(const StorageItem& config, TestItem type, size_t usbIndex, std::shared_ptr<RkGenericBoard> Board) {
+    if (!config.benchPath.empty()) {
+        return config.benchPath;
+    }
+
+    std::shared_ptr<const DeviceSnapshot> devices = Board->deviceRegistry ? Board->deviceRegistry->snapshot() : nullptr;
+    if (type == EMMC) {
+        // 不直接读写系统盘：根文件系统在 emmc 上时用 /var/tmp，否则用 emmc 上挂载了的分区，都不是就没有测速对象
+        const BlockDeviceInfo* emmc = devices ? devices->emmc() : nullptr;
+        std::string disk = emmc ? emmc->name : (devices ? "" : sysfs_block_name(Board->MMC_DEVICE_SIZE_PATH));
+        if (path_on_disk("/var/tmp", disk)) {
+            return "/var/tmp";
+        }
+        if (devices) {
+            for (const BlockDeviceInfo& block : devices->block) {
+                if ((block.name == disk || block.parent == disk) && !disk.empty() && !block.mountPoint.empty()) {
+                    return block.mountPoint;
+                }
+            }
+        }
+        log_thread_safe(LOG_LEVEL_ERROR, TaskHandlerTag, "emmc %s: /var/tmp is not on it and no partition is mounted",
+            disk.empty() ? "(not found)" : disk.c_str());
+        return "";
+    }
+
+    std::string disk;
+    if (type == USB) {
+        if (!devices) {
+            return "";
+        }
+        std::vector<const BlockDeviceInfo*> disks = devices->usbDisks();
+        if (usbIndex >= disks.size()) {
+            return "";
+        }
+        disk = disks[usbIndex]->name;
+    } else if (devices) {
+        const BlockDeviceInfo* block = (type == TF) ? devices->tf() : devices->nvme();     // 按总线识别，不依赖 mmcblk 编号
+        if (block == nullptr) {
+            return "";
+        }
+        disk = block->name;
+    } else {
+        disk = sysfs_block_name(type == TF ? Board->TF_CARD_DEVICE_SIZE_PATH : Board->PCIE_DEVICE_SIZE_PATH);
+        if (disk.empty()) {
+            return "";
+        }
+    }
+
+    if (devices) {
+        for (const BlockDeviceInfo& block : devices->block) {
+            if ((block.name == disk || block.parent == disk) && !block.mountPoint.empty()) {
+                return block.mountPoint;
+            }
+        }
+    }
+    return "/dev/" + disk;
+}
+
+bool TaskHandler::storage_concurrent_bench(const StorageTestCase& testCase, Json::Value& store, Json::Value& summary, std::shared_ptr<RkGenericBoard> Board,
+                                           const interrupt_flag& flag) {
+    const StorageConcurrentCase& concurrent = testCase.concurrentBench;
+    std::shared_ptr<const DeviceSnapshot> devices = Board->deviceRegistry ? Board->deviceRegistry->snapshot() : nullptr;
+    std::vector<const BlockDeviceInfo*> usbDisks;
+    if (devices) {
+        usbDisks = devices->usbDisks();
+    }
+
+    bool ok = true;
+    std::vector<MultiDiskTarget> targets;
+    std::vector<size_t> itemIndex;                                          // targets[k] 对应 store 中的下标
+    std::vector<uint32_t> linkMbps;
+    size_t usbIndex = 0;
+    for (size_t n = 0; n < testCase.store.size(); ++n) {
+        const StorageItem& config = testCase.store[n];
+        TestItem type = stringToTestItem(config.name);
+        if (config.enable == false || (type != TF && type != USB && type != USB_PCIE)) {
+            continue;
+        }
+        size_t index = (type == USB) ? usbIndex++ : 0;
+        std::string target = storage_bench_target(config, type, index, Board);
+        if (target.empty()) {
+            Json::Value& item = store[(Json::ArrayIndex)n];
+            item["concurrent"]["error"] = "no bench target";
+            item["testResult"] = "NG";
+            ok = false;
+            continue;
+        }
+        uint32_t speed = 0;
+        if (type == USB && devices && index < usbDisks.size()) {
+            const UsbDeviceInfo* usb = devices->findUsb(usbDisks[index]->usbPort);
+            speed = usb ? usb->speedMbps : 0;
+        }
+        targets.push_back(MultiDiskTarget{config.name, target});
+        itemIndex.push_back(n);
+        linkMbps.push_back(speed);
+    }
+    if (targets.size() < 2) {
+        summary["error"] = "less than two disks";
+        summary["testResult"] = "NG";
+        return false;
+    }
+
+    MultiDiskConfig benchConfig;
+    benchConfig.sizeBytes = (uint64_t)std::max(concurrent.sizeMB, 1) << 20;
+    benchConfig.concurrentMs = (uint32_t)std::max(concurrent.durationMs, 100);
+    benchConfig.soloMs = benchConfig.concurrentMs / 2;
+    benchConfig.write = concurrent.write;
+    benchConfig.collapseRatio = concurrent.collapseRatio;
+    MultiDiskResult result;
+    if (!MultiDiskBench(benchConfig).run(targets, result, &flag)) {
+        ok = false;
+    }
+
+    char buffer[32];
+    auto format = [&buffer](double value) {
+        snprintf(buffer, sizeof(buffer), "%.1f", value);
+        return std::string(buffer);
+    };
+    for (size_t k = 0; k < result.devices.size(); ++k) {
+        const MultiDiskDeviceResult& device = result.devices[k];
+        const StorageItem& config = testCase.store[itemIndex[k]];
+        Json::Value& item = store[(Json::ArrayIndex)itemIndex[k]];
+        Json::Value& value = item["concurrent"];
+        value["path"] = device.path;
+        if (linkMbps[k] > 0) {
+            value["linkMbps"] = linkMbps[k];
+        }
+        if (!device.error.empty()) {
+            value["error"] = device.error;
+            item["testResult"] = "NG";
+            continue;
+        }
+        value["cpu"] = device.cpu;
+        value["soloMBps"] = format(device.soloMBps);
+        value["concurrentMBps"] = format(device.concurrentMBps);
+        value["expectedMBps"] = format(device.expectedMBps);
+        value["collapsed"] = device.collapsed;
+        if (device.collapsed || (config.minConcurrentMBps > 0 && device.concurrentMBps < config.minConcurrentMBps)) {
+            item["testResult"] = "NG";
+            ok = false;
+        }
+    }
+
+    summary["soloSumMBps"] = format(result.soloSumMBps);
+    summary["aggregateMBps"] = format(result.aggregateMBps);
+    if (concurrent.minAggregateMBps > 0 && result.aggregateMBps < concurrent.minAggregateMBps) {
+        ok = false;
+    }
+    summary["testResult"] = ok ? "OK" : "NG";
+    return ok;
+}
+
+bool TaskHandler::storage_bench(const StorageItem& config, const std::string& target, Json::Value& item, const interrupt_flag& flag) {
+    Json::Value& bench = item["bench"];
+    if (target.empty()) {
+        bench["error"] = "no bench target";
+        log_thread_safe(LOG_LEVEL_ERROR, TaskHandlerTag, "%s: no bench target", config.name.c_str());
+        return false;
+    }
+
+    StorageBenchConfig benchConfig;
+    benchConfig.path = target;
+    benchConfig.sizeBytes = (uint64_t)std::max(config.benchSizeMB, 1) << 20;
+    benchConfig.randQueueDepth = (uint32_t)std::max(config.queueDepth, 1);
+    StorageBenchResult result;
+    bench["path"] = target;
+    if (!StorageBench(benchConfig).run(result, &flag)) {
+        bench["error"] = result.error;
+        return false;
+    }
+
+    char buffer[32];
+    auto put = [&bench, &buffer](const char* key, const char* format, double value) {
+        snprintf(buffer, sizeof(buffer), format, value);
+        bench[key] = std::string(buffer);
+    };
+    bench["engine"] = result.engine;
+    bench["direct"] = result.direct;
+    if (result.seqWriteMBps >= 0) {
+        put("seqWriteMBps", "%.1f", result.seqWriteMBps);
+    }
+    put("seqReadMBps", "%.1f", result.seqReadMBps);
+    put("randReadIops", "%.0f", result.randReadIops);
+    put("latP50Us", "%.0f", result.latP50Us);
+    put("latP99Us", "%.0f", result.latP99Us);
+    put("latP999Us", "%.0f", result.latP999Us);
+
+    Json::Value failed(Json::arrayValue);
+    if (config.minReadMBps > 0 && result.seqReadMBps < config.minReadMBps) {
+        failed.append("minReadMBps");
+    }
+    if (config.minWriteMBps > 0 && result.seqWriteMBps >= 0 && result.seqWriteMBps < config.minWriteMBps) {
+        failed.append("minWriteMBps");
+    }
+    if (config.minRandIops > 0 && result.randReadIops < config.minRandIops) {
+        failed.append("minRandIops");
+    }
+    if (config.maxLatencyUs > 0 && result.latP99Us > config.maxLatencyUs) {
+        failed.append("maxLatencyUs");
+    }
+    if (!failed.empty()) {
+        bench["failed"] = failed;
+        log_thread_safe(LOG_LEVEL_ERROR, TaskHandlerTag, "%s bench below threshold on %s", config.name.c_str(), target.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool TaskHandler::ddr_bandwidth(const StorageItem& config, Json::Value& item, const interrupt_flag& flag) {
+    DdrBenchConfig benchConfig;
+    benchConfig.arrayBytes = (uint64_t)std::max(config.bandwidthSizeMB, 1) << 20;
+    DdrBenchResult result;
+    bool ok = DdrBench(benchConfig).run(result, &flag);
+
+    Json::Value& bandwidth = item["bandwidth"];
+    bandwidth["isa"] = result.isa;
+    bandwidth["threads"] = std::to_string(result.threads);
+    if (!result.error.empty()) {
+        bandwidth["error"] = result.error;
+    }
+    if (result.arrayBytes == 0 || result.triadGBps <= 0) {                 // 没分配到内存或被取消，没有带宽数据
+        return false;
+    }
+
+    char buffer[32];
+    auto put = [&bandwidth, &buffer](const char* key, double value) {
+        snprintf(buffer, sizeof(buffer), "%.2f", value);
+        bandwidth[key] = std::string(buffer);
+    };
+    put("copyGBps", result.copyGBps);
+    put("scaleGBps", result.scaleGBps);
+    put("addGBps", result.addGBps);
+    put("triadGBps", result.triadGBps);
+    item["testValue"] = bandwidth["triadGBps"];
+
+    Json::Value failed(Json::arrayValue);
+    if (config.minCopyGBps > 0 && result.copyGBps < config.minCopyGBps) {
+        failed.append("minCopyGBps");
+    }
+    if (config.minScaleGBps > 0 && result.scaleGBps < config.minScaleGBps) {
+        failed.append("minScaleGBps");
+    }
+    if (config.minAddGBps > 0 && result.addGBps < config.minAddGBps) {
+        failed.append("minAddGBps");
+    }
+    if (config.minTriadGBps > 0 && result.triadGBps < config.minTriadGBps) {
+        failed.append("minTriadGBps");
+    }
+    if (!failed.empty()) {
+        bandwidth["failed"] = failed;
+        log_thread_safe(LOG_LEVEL_ERROR, TaskHandlerTag, "ddr bandwidth below threshold: triad %.2f GB/s", result.triadGBps);
+        return false;
+    }
+    return ok;
+}
+
+bool TaskHandler::ddr_memtest(const StorageItem& config, Json::Value& item, const interrupt_flag& flag) {
+    DramTestConfig testConfig;
+    testConfig.sizeBytes = (uint64_t)std::max(config.memtestSizeMB, 1) << 20;
+    testConfig.durationMs = (uint32_t)std::max(config.memtestDurationMs, 0);
+    DramTestResult result;
+    bool ok = DramTest(testConfig).run(result, &flag);
+
+    Json::Value& memtest = item["memtest"];
+    if (!result.error.empty()) {
+        memtest["error"] = result.error;
+    }
+    if (result.testedBytes == 0) {                                          // 没分配到内存，没有别的结果
+        return false;
+    }
+    memtest["backing"] = result.backing;
+    memtest["threads"] = std::to_string(result.threads);
+    memtest["sizeMB"] = std::to_string(result.testedBytes >> 20);
+    memtest["passes"] = std::to_string(result.passes);
+    memtest["verifiedMB"] = std::to_string(result.verifiedBytes >> 20);
+    memtest["elapsedMs"] = std::to_string(result.elapsedMs);
+    memtest["timedOut"] = result.timedOut;
+    memtest["errors"] = std::to_string(result.errors);
+    item["testValue"] = memtest["errors"];
+
+    if (!result.ranges.empty()) {
+        char buffer[64];
+        Json::Value ranges(Json::arrayValue);
+        for (const DramFaultRange& range : result.ranges) {
+            Json::Value entry;
+            snprintf(buffer, sizeof(buffer), "0x%llx", (unsigned long long)range.start);
+            entry["start"] = std::string(buffer);
+            snprintf(buffer, sizeof(buffer), "0x%llx", (unsigned long long)range.end);
+            entry["end"] = std::string(buffer);
+            snprintf(buffer, sizeof(buffer), "0x%016llx", (unsigned long long)range.bits);
+            entry["bits"] = std::string(buffer);
+            entry["count"] = std::to_string(range.count);
+            ranges.append(entry);
+        }
+        memtest["physical"] = result.physical;          // false 时是测试缓冲区内的偏移 (没有 root 权限读 pagemap)
+        memtest["ranges"] = ranges;
+    }
+    return ok;
+}
+
+bool TaskHandler::storage_verify(const StorageItem& config, const std::string& target, Json::Value& item, const interrupt_flag& flag) {
+    Json::Value& verify = item["verify"];
+    if (target.empty()) {
+        verify["error"] = "no verify target";
+        log_thread_safe(LOG_LEVEL_ERROR, TaskHandlerTag, "%s: no verify target", config.name.c_str());
+        return false;
+    }
+
+    StorageVerifyConfig verifyConfig;
+    verifyConfig.path = target;
+    verifyConfig.sizeBytes = (uint64_t)config.verifySizeMB << 20;
+    verifyConfig.allowDevice = config.verifyRawDevice;
+    StorageVerifyResult result;
+    bool ok = StorageVerify(verifyConfig).run(result, &flag);
+    verify["path"] = target;
+    if (!result.error.empty()) {
+        verify["error"] = result.error;
+        return false;
+    }
+
+    char buffer[32];
+    verify["engine"] = result.engine;
+    verify["sizeMB"] = std::to_string(result.regionBytes >> 20);
+    snprintf(buffer, sizeof(buffer), "%.1f", result.writeMBps);
+    verify["writeMBps"] = std::string(buffer);
+    snprintf(buffer, sizeof(buffer), "%.1f", result.verifyMBps);
+    verify["verifyMBps"] = std::string(buffer);
+    verify["ioErrors"] = std::to_string(result.ioErrors);
+    verify["errorSectors"] = std::to_string(result.errorSectors);
+    if (result.firstBadOffset >= 0) {
+        verify["firstBadOffset"] = std::to_string(result.firstBadOffset);
+    }
+    if (result.aliasOffset >= 0) {
+        verify["aliasOffset"] = std::to_string(result.aliasOffset);     // 假容量盘: 读到的是写往这个偏移的数据
+    }
+    return ok;
 }
 
 // void TaskHandler::serial_test(const Task& task, std::unique_ptr<RkGenericBoard>& Board) {
@@ -642,20 +1122,105 @@ void TaskHandler::storage_test(const Task& task, std::shared_ptr<RkGenericBoard>
 //     serialThread.detach();
 // }
 
+// CAN 接口的状态和错误统计，写入 item["canStatus"]
+static void put_can_status(const CanLinkStatus& status, Json::Value& item) {
+    Json::Value& value = item["canStatus"];
+    value["state"] = can_state_name(status.state);
+    value["bitrate"] = std::to_string(status.bitrate);
+    value["samplePoint"] = std::to_string(status.samplePoint);
+    value["txErrors"] = std::to_string(status.txErrors);
+    value["rxErrors"] = std::to_string(status.rxErrors);
+    if (status.statsValid) {
+        value["busErrors"] = std::to_string(status.busErrors);
+        value["errorWarning"] = std::to_string(status.errorWarning);
+        value["errorPassive"] = std::to_string(status.errorPassive);
+        value["busOff"] = std::to_string(status.busOff);
+        value["arbitrationLost"] = std::to_string(status.arbitrationLost);
+        value["restarts"] = std::to_string(status.restarts);
+    }
+}
+
+bool TaskHandler::serial_ber(const SerialItem& config, const std::vector<std::string>& devices, const std::vector<Json::Value*>& items,
+                             const interrupt_flag& flag) {
+    SerialBerConfig berConfig;
+    berConfig.baudRate = (uint32_t)std::max(config.berBaudRate, 1);
+    berConfig.prbs = config.berPrbs;
+    berConfig.durationMs = (uint32_t)std::max(config.berDurationMs, 0);
+    berConfig.byteCount = (uint64_t)std::max(config.berBytes, 0);
+    std::vector<SerialBerResult> results;
+    SerialBer(berConfig).run(devices, results, &flag);
+
+    bool allOk = true;
+    char buffer[32];
+    for (size_t k = 0; k < results.size() && k < items.size(); ++k) {
+        const SerialBerResult& result = results[k];
+        Json::Value& item = *items[k];
+        Json::Value& ber = item["ber"];
+        ber["baudRate"] = std::to_string(result.baudRate);
+        ber["prbs"] = std::to_string(result.prbs);
+        ber["bytesSent"] = std::to_string(result.bytesSent);
+        ber["bytesReceived"] = std::to_string(result.bytesReceived);
+        snprintf(buffer, sizeof(buffer), "%.0f", result.throughputBps);
+        ber["throughputBps"] = buffer;
+        snprintf(buffer, sizeof(buffer), "%.3f", result.efficiency);
+        ber["efficiency"] = buffer;
+        ber["checkedBytes"] = std::to_string(result.checkedBytes);
+        ber["byteErrors"] = std::to_string(result.byteErrors);
+        ber["bitErrors"] = std::to_string(result.bitErrors);
+        snprintf(buffer, sizeof(buffer), "%.3e", result.byteErrorRate);
+        ber["byteErrorRate"] = buffer;
+        ber["resyncs"] = std::to_string(result.resyncs);
+        ber["slipBytes"] = std::to_string(result.slipBytes);
+        ber["firstLockUs"] = std::to_string(result.firstLockUs);
+        ber["maxResyncUs"] = std::to_string(result.maxResyncUs);
+        if (result.icountValid) {
+            ber["frameErrors"] = std::to_string(result.frameErrors);
+            ber["overruns"] = std::to_string(result.overruns);
+            ber["bufOverruns"] = std::to_string(result.bufOverruns);
+            ber["parityErrors"] = std::to_string(result.parityErrors);
+            ber["breaks"] = std::to_string(result.breaks);
+        }
+        if (!result.error.empty()) {
+            ber["error"] = result.error;
+        }
+
+        bool ok = result.locked && result.error.empty() && result.resyncs == 0 && result.byteErrorRate <= config.berMaxErrorRate;
+        if (!ok) {
+            item["testResult"] = "NG";
+            allOk = false;
+        } else if (!item.isMember("testResult")) {
+            item["testResult"] = "OK";
+        }
+    }
+    return allOk;
+}
+
 void TaskHandler::serial_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    SerialTestCase testCase;
+    JsonDecodeContext ctx;
+    if (!json_decode_member(task.data, "testCase", testCase, ctx)) {
+        respondInvalidParam(task, ctx.error());
+        return;
+    }
+
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
+
     Json::Value response;
     Json::Value responseData;
     responseData = task.data;
 
-    std::shared_ptr<interrupt_flag> serialThreadStopFlag =
-        work_thread_task.submit_interruptible([this, Board, responseData](interrupt_flag& flag) mutable {
+    submit_test(task, "serial", [this, Board, responseData, testCase, patch](interrupt_flag& flag) mutable {
             Json::Value response;
-            if (responseData["testCase"]["enable"].asBool() == false) {
+            if (testCase.enable == false) {
                 return;
             }
 
             Json::Value& groupList = responseData["testCase"]["groupList"];
 
+            std::vector<std::string> rs232DeviceList;                 // 232 口全部收集后同时回环测试
+            std::vector<std::pair<size_t, size_t>> rs232ItemIndex;
+            std::vector<std::pair<size_t, size_t>> berItemIndex;      // 配置了误码率测试的项
+
             int serial485Count = 0;
             std::vector<std::string> deviceList;
             std::vector<bool> sendResult;
@@ -666,38 +1231,30 @@ void TaskHandler::serial_test(const Task& task, std::shared_ptr<RkGenericBoard>
             std::vector<bool> canSendResult;
             std::vector<bool> canRecvResult;
 
-            for (Json::ArrayIndex i = 0; i < groupList.size(); ++i) {
-                Json::Value& group = groupList[i];
+            for (size_t i = 0; i < testCase.groupList.size(); ++i) {
+                const std::vector<SerialItem>& items = testCase.groupList[i].itemList;
+                Json::Value& itemList = groupList[(Json::ArrayIndex)i]["itemList"];
 
-                // get itemList array
-                Json::Value& itemList = group["itemList"];
-                
                 // iterate through each item
-                for (Json::ArrayIndex j = 0; j < itemList.size(); ++j) {
-                    Json::Value& item = itemList[j];
-                    if (item["enable"].asBool() == false) {
+                for (size_t j = 0; j < items.size(); ++j) {
+                    Json::Value& item = itemList[(Json::ArrayIndex)j];
+                    if (items[j].enable == false) {
                         item["testResult"] = "SKIP";
                         continue;
                     }
 
-                    if (item.isMember("serialPath") && item["serialPath"].isString()) {
-                        std::string serialPath = item["serialPath"].asString();
-                        std::string serialName = item["serialName"].asString();
-                        int mode = 0;
-                        if (item["mode"].isInt()) {
-                            mode = item["mode"].asInt();
-                        } else if (item["mode"].isString()) {
-                            mode = std::stoi(item["mode"].asString());
+                    if (!items[j].serialPath.empty()) {
+                        const std::string& serialPath = items[j].serialPath;
+                        const std::string& serialName = items[j].serialName;
+                        int mode = items[j].mode;
+
+                        if (items[j].berDurationMs > 0 || items[j].berBytes > 0) {
+                            berItemIndex.push_back(std::make_pair(i, j));
                         }
 
                         if (strstr(serialName.c_str(), "232") != NULL) {
-                            bool ret = Board->serialTest(serialPath.c_str());
-                            if (ret) {
-                                item["testResult"] = "OK";
-                            } else {
-                                item["testResult"] = "NG";
-                                response["result"] = "false";
-                            }
+                            rs232DeviceList.push_back(serialPath);
+                            rs232ItemIndex.push_back(std::make_pair(i, j));
                         } else if (strstr(serialName.c_str(), "485") != NULL && mode == 2) {
                             int fd = Board->openSerial(serialPath.c_str(), 115200);
                             if (fd < 0) {
@@ -730,6 +1287,10 @@ void TaskHandler::serial_test(const Task& task, std::shared_ptr<RkGenericBoard>
                             } else {
                                 log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "%s fd : %d", serialPath.c_str(), can_fd);
                                 bool ret = Board->can_test(can_fd, 3);
+                                std::vector<CanLinkStatus> status;
+                                if (Board->can_link_status(std::vector<std::string>(1, serialPath), status)) {
+                                    put_can_status(status[0], item);
+                                }
                                 if (ret) {
                                     log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "can device %s test success", serialPath.c_str());
                                     item["testResult"] = "OK";
@@ -749,6 +1310,50 @@ void TaskHandler::serial_test(const Task& task, std::shared_ptr<RkGenericBoard>
                 }
             }
 
+            if (!rs232DeviceList.empty()) {
+                std::vector<SerialLoopbackResult> results;
+                SerialLoopback(SerialLoopbackConfig()).run(rs232DeviceList, results);
+                for (size_t k = 0; k < results.size(); ++k) {
+                    Json::Value& item = groupList[(Json::ArrayIndex)rs232ItemIndex[k].first]["itemList"][(Json::ArrayIndex)rs232ItemIndex[k].second];
+                    item["testResult"] = results[k].ok ? "OK" : "NG";
+                    Json::Value& loopback = item["loopback"];
+                    loopback["rounds"] = std::to_string(results[k].rounds);
+                    loopback["attempts"] = std::to_string(results[k].attempts);
+                    loopback["maxRoundTripUs"] = std::to_string(results[k].maxRoundTripUs);
+                    if (!results[k].ok) {
+                        loopback["error"] = results[k].error;
+                        response["result"] = "false";
+                    }
+                }
+            }
+
+            // 误码率测试在回环测试之后，参数相同的端口一起跑
+            while (!berItemIndex.empty()) {
+                if (flag.is_stop_requested()) {
+                    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "serial test cancelled, skip remaining ber groups");
+                    response["result"] = "false";
+                    break;
+                }
+                const SerialItem& config = testCase.groupList[berItemIndex[0].first].itemList[berItemIndex[0].second];
+                std::vector<std::string> berDevices;
+                std::vector<Json::Value*> berJson;
+                std::vector<std::pair<size_t, size_t>> rest;
+                for (const std::pair<size_t, size_t>& index : berItemIndex) {
+                    const SerialItem& other = testCase.groupList[index.first].itemList[index.second];
+                    if (other.berBaudRate == config.berBaudRate && other.berPrbs == config.berPrbs &&
+                        other.berDurationMs == config.berDurationMs && other.berBytes == config.berBytes) {
+                        berDevices.push_back(other.serialPath);
+                        berJson.push_back(&groupList[(Json::ArrayIndex)index.first]["itemList"][(Json::ArrayIndex)index.second]);
+                    } else {
+                        rest.push_back(index);
+                    }
+                }
+                if (!serial_ber(config, berDevices, berJson, flag)) {
+                    response["result"] = "false";
+                }
+                berItemIndex.swap(rest);
+            }
+
             // test 485 and CAN devices collected before
             if (!deviceList.empty() || !canDeviceList.empty()) {
                 Board->serial485TestRetry(deviceList, sendResult, recvResult);
@@ -760,6 +1365,8 @@ void TaskHandler::serial_test(const Task& task, std::shared_ptr<RkGenericBoard>
                 }
 
                 Board->serialCanTestRetry(canDeviceList, canSendResult, canRecvResult);
+                std::vector<CanLinkStatus> canStatus;
+                Board->can_link_status(canDeviceList, canStatus);
                 for (size_t i = 0; i < canDeviceList.size(); ++i) {
                     log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "CAN device: %s, send: %s, recv: %s",
                         canDeviceList[i].c_str(),
@@ -770,24 +1377,19 @@ void TaskHandler::serial_test(const Task& task, std::shared_ptr<RkGenericBoard>
                 // set test result for 485 and CAN devices
                 int index = 0;
                 int canIndex = 0;
-                for (Json::ArrayIndex i = 0; i < groupList.size(); ++i) {
-                    Json::Value& group = groupList[i];
-                    Json::Value& itemList = group["itemList"];
+                for (size_t i = 0; i < testCase.groupList.size(); ++i) {
+                    const std::vector<SerialItem>& items = testCase.groupList[i].itemList;
+                    Json::Value& itemList = groupList[(Json::ArrayIndex)i]["itemList"];
 
-                    for (Json::ArrayIndex j = 0; j < itemList.size(); ++j) {
-                        Json::Value& item = itemList[j];
-                        if (item["enable"].asBool() == false) {
+                    for (size_t j = 0; j < items.size(); ++j) {
+                        Json::Value& item = itemList[(Json::ArrayIndex)j];
+                        if (items[j].enable == false) {
                             continue;
                         }
-                        if (item.isMember("serialPath") && item["serialPath"].isString()) {
-                            std::string serialName = item["serialName"].asString();
-                            int mode = 0;
-                            if (item["mode"].isInt()) {
-                                mode = item["mode"].asInt();
-                            } else if (item["mode"].isString()) {
-                                mode = std::stoi(item["mode"].asString());
-                            }
-                            
+                        if (!items[j].serialPath.empty()) {
+                            const std::string& serialName = items[j].serialName;
+                            int mode = items[j].mode;
+
                             if (strstr(serialName.c_str(), "485") != NULL && mode == 0) {
                                 if (index < (int)deviceList.size()) {
                                     if (sendResult[index] && recvResult[index]) {
@@ -803,6 +1405,9 @@ void TaskHandler::serial_test(const Task& task, std::shared_ptr<RkGenericBoard>
                                 }
                             } else if ((strstr(serialName.c_str(), "CAN") != NULL || strstr(serialName.c_str(), "can") != NULL) && mode == 0) {
                                 if (canIndex < (int)canDeviceList.size()) {
+                                    if (canStatus[canIndex].ok) {
+                                        put_can_status(canStatus[canIndex], item);
+                                    }
                                     if (canSendResult[canIndex] && canRecvResult[canIndex]) {
                                         item["testResult"] = "OK";
                                     } else {
@@ -823,13 +1428,13 @@ void TaskHandler::serial_test(const Task& task, std::shared_ptr<RkGenericBoard>
             response["cmdType"] = 1;
             response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
             response["data"] = responseData;
-            protocol_.sendResponse(response);
+            sendTestResult(response, patch);
         });
-    interrupt_flags_queue_task.push(serialThreadStopFlag);
 
 }
 
 void TaskHandler::rtc_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
     Json::Value response;
     Json::Value responseData;
     responseData = task.data;
@@ -849,13 +1454,16 @@ void TaskHandler::rtc_test(const Task& task, std::shared_ptr<RkGenericBoard> Boa
     set_tm.tm_min = minute;
     set_tm.tm_sec = second;
 
-    std::thread rtcThread([this, Board, set_tm, responseData]() mutable {
-        Json::Value response;  // 在lambda内部定义response
+    // the 2 seconds wait runs on the timer wheel, the test holds no thread while waiting
+    uint16_t cmdIndex = task.cmdIndex;
+    std::shared_ptr<interrupt_flag> flag = start_async_test(task, "rtc");
+    auto respond = [this, responseData, flag, cmdIndex, patch](bool ok, const struct rtc_time& tm) mutable {
+        Json::Value response;
 
-        if (Board->setAndWait(set_tm, 2)) {
+        if (ok) {
             char timeBuf[128];
             memset(timeBuf, 0, sizeof(timeBuf));
-            sprintf(timeBuf, "%d/%d/%d %d:%d:%d", set_tm.tm_year + 1900, set_tm.tm_mon + 1, set_tm.tm_mday, set_tm.tm_hour, set_tm.tm_min, set_tm.tm_sec);
+            snprintf(timeBuf, sizeof(timeBuf), "%d/%d/%d %d:%d:%d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
             std::string timeStr(timeBuf);
             responseData["testCase"]["testResult"] = "OK";
             responseData["testResult"] = "OK";
@@ -867,17 +1475,27 @@ void TaskHandler::rtc_test(const Task& task, std::shared_ptr<RkGenericBoard> Boa
             responseData["testCase"]["testValue"] = "NULL";
             response["result"] = "false";
         }
-        
+
         response["cmdType"] = 1;
         response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
         response["data"] = responseData;
-        protocol_.sendResponse(response);
-    });
+        sendTestResult(response, patch);
+        task_registry.markDone(cmdIndex, *flag);
+    };
+
+    if (!Board->setTimeBegin(set_tm)) {
+        respond(false, set_tm);
+        return;
+    }
 
-    rtcThread.detach();
+    waiter_.sleep_for(2000, flag, [Board, set_tm, respond](AsyncWaitResult result) mutable {
+        bool ok = Board->checkTimeAdvanced(set_tm, 2);                      // also closes the rtc device when cancelled
+        respond(ok && result != ASYNC_WAIT_CANCELLED, set_tm);
+    });
 }
 
 void TaskHandler::ln_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
     Json::Value response;
     Json::Value responseData;
     responseData = task.data;
@@ -889,7 +1507,7 @@ void TaskHandler::ln_test(const Task& task, std::shared_ptr<RkGenericBoard> Boar
     //   "mac" : "0C63FC412AEE", 
     std::string mac = responseData["testOrder"]["mac"].asString();
     uint8_t lan_mac[6];
-    sscanf(mac.c_str(), "%02x%02x%02x%02x%02x%02x", &lan_mac[0], &lan_mac[1], &lan_mac[2], &lan_mac[3], &lan_mac[4], &lan_mac[5]);
+    sscanf(mac.c_str(), "%2hhx%2hhx%2hhx%2hhx%2hhx%2hhx", &lan_mac[0], &lan_mac[1], &lan_mac[2], &lan_mac[3], &lan_mac[4], &lan_mac[5]);
 
     if (Board->vendor_storage_write_mac(VENDOR_LAN_MAC_ID, lan_mac, 6) == 0) {
         std::cout << "LAN MAC write successful: " << mac << std::endl;
@@ -923,6 +1541,7 @@ void TaskHandler::ln_test(const Task& task, std::shared_ptr<RkGenericBoard> Boar
     }
 
     if (Board->vendor_storage_write_ln(recv_ln.c_str()) == 0) {
+        log_set_ln(recv_ln);
         uint8_t buffer[512];
         uint16_t len;
         int ret;
@@ -950,10 +1569,11 @@ void TaskHandler::ln_test(const Task& task, std::shared_ptr<RkGenericBoard> Boar
     response["cmdType"] = 1;
     response["subCommand"] = CMD_SIGNAL_EXEC_RES;
     response["data"] = responseData;
-    protocol_.sendResponse(response);
+    sendTestResult(response, patch);
 }
 
 void TaskHandler::gpio_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {    // gpio task execute quickly, no need to add in thread pool
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
     Json::Value response;
     Json::Value responseData;
     responseData = task.data;
@@ -1003,16 +1623,17 @@ void TaskHandler::gpio_test(const Task& task, std::shared_ptr<RkGenericBoard> Bo
         response["cmdType"] = 1;
         response["subCommand"] = CMD_SIGNAL_EXEC_RES;
         response["data"] = responseData;
-        protocol_.sendResponse(response);
+        sendTestResult(response, patch);
     } else {
         response["cmdType"] = 1;
         response["subCommand"] = CMD_SIGNAL_EXEC_RES;
         response["data"] = responseData;
-        protocol_.sendResponse(response);
+        sendTestResult(response, patch);
     }
 }
 
 void TaskHandler::manual_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {   // manual task execute quickly, no need to add in thread pool
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
     Json::Value response;
     Json::Value response_data;
     response_data = task.data;
@@ -1047,10 +1668,11 @@ void TaskHandler::manual_test(const Task& task, std::shared_ptr<RkGenericBoard>
     response["cmdType"] = 1;
     response["subCommand"] = CMD_SIGNAL_EXEC_RES;
     response["data"] = response_data;
-    protocol_.sendResponse(response);
+    sendTestResult(response, patch);
 }
 
 void TaskHandler::net_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
     Json::Value response;
     Json::Value responseData;
     responseData = task.data;
@@ -1138,10 +1760,11 @@ void TaskHandler::net_test(const Task& task, std::shared_ptr<RkGenericBoard> Boa
     response["cmdType"] = 1;
     response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
     response["data"] = responseData;
-    protocol_.sendResponse(response);
+    sendTestResult(response, patch);
 }
 
 void TaskHandler::bluetooth_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
     Json::Value response;
     Json::Value responseData;
     responseData = task.data;
@@ -1150,7 +1773,7 @@ void TaskHandler::bluetooth_test(const Task& task, std::shared_ptr<RkGenericBoar
         return;
     }
 
-    std::thread bluetoothThread([this, Board, responseData]() mutable {
+    submit_test(task, "bluetooth", [this, Board, responseData, patch](interrupt_flag& flag) mutable {
         Json::Value response;  // 在lambda内部定义response
         response["result"] = "true";
         if (Board->scanBluetoothDevices()) {
@@ -1180,12 +1803,12 @@ void TaskHandler::bluetooth_test(const Task& task, std::shared_ptr<RkGenericBoar
         response["cmdType"] = 1;
         response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
         response["data"] = responseData;
-        protocol_.sendResponse(response);
+        sendTestResult(response, patch);
     });
-    bluetoothThread.detach();
 }
 
 void TaskHandler::wifi_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
     Json::Value response;
     Json::Value responseData;
     responseData = task.data;
@@ -1206,412 +1829,156 @@ void TaskHandler::wifi_test(const Task& task, std::shared_ptr<RkGenericBoard> Bo
     response["cmdType"] = 1;
     response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
     response["data"] = responseData;
-    protocol_.sendResponse(response);
+    sendTestResult(response, patch);
 }
 
 void TaskHandler::typec_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
-    Json::Value response;
+    TypecTestCase testCase;
+    JsonDecodeContext ctx;
+    if (!json_decode_member(task.data, "testCase", testCase, ctx)) {
+        respondInvalidParam(task, ctx.error());
+        return;
+    }
+
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
+
     Json::Value response_data;
     response_data = task.data;
 
     dialog.show("TYPE_C", "请插入TYPE-C设备");
 
-    // type-c v1.0
-    // std::thread typecThread([this, Board = Board.get(), responseData]() mutable {
-    //     Json::Value response;  // 在lambda内部定义response
-    //     response["result"] = "true";
-    //     responseData["testCase"]["testResult"] = "OK";
-
-    //     int count = 2;
-    //     int first = -1;
-    //     int timeOut = 60; // 60秒超时
-
-    //     // Json::Value positive2_0;
-    //     // Json::Value positive3_0;
-    //     // Json::Value reverse2_0;
-    //     // Json::Value reverse3_0;
-    //     Board->scan_usb_with_libusb();
-
-    //     bool testValue = false;  // 是否找到匹配的测试设备
-    //     bool allTestValue = true; // 是否所有测试项都已测试完毕
-    //     while(count) {
-    //         int ret = Board->typeCTest("/sys/class/typec/port0/orientation");
-    //         if ((ret == 1 || ret == 0) && count == 2) {
-    //             sleep(1);
-    //             Board->scan_usb_with_libusb();
-    //             Json::Value& groupList = responseData["testCase"]["groupData"]["testCase"]["groupList"];
-    //             for (Json::ArrayIndex i = 0; i < groupList.size(); ++i) {
-    //                 if (groupList[i]["type"].asString() == "positive") {
-    //                     for (Json::ArrayIndex j = 0; j < groupList[i]["itemList"].size(); ++j) {
-                            
-    //                         if (strstr(groupList[i]["itemList"][j]["name"].asString().c_str(), "3.0") != NULL) {
-    //                             for (const auto& info : Board->facilityUsbInfoList3_0) {
-    //                                 if (info.vid == std::stoi(groupList[i]["itemList"][j]["vid"].asString()) && 
-    //                                     info.pid == std::stoi(groupList[i]["itemList"][j]["pid"].asString())) {
-    //                                     char buf[256] = {0};
-    //                                     sprintf(buf, "%d-%d", info.pid, info.vid);
-    //                                     groupList[i]["itemList"][j]["testResult"] = "OK";
-    //                                     groupList[i]["itemList"][j]["testValue"] = std::string(buf);
-    //                                     std::cout << "找到匹配的3.0设备: VID=0x" << std::hex << info.vid 
-    //                                               << ", PID=0x" << std::hex << info.pid 
-    //                                               << ", 类型=" << info.usbType << std::dec << std::endl;
-    //                                     testValue = true;
-    //                                 } 
-    //                             }
-    //                             if (testValue == false) {
-    //                                 allTestValue = false;
-    //                                 groupList[i]["itemList"][j]["testResult"] = "NG";
-    //                                 groupList[i]["itemList"][j]["testValue"] = "NG";
-    //                                 responseData["testCase"]["testResult"] = "NG";
-    //                                 std::cout << "未找到匹配的3.0设备: VID=0x" << std::hex << std::stoi(groupList[i]["itemList"][j]["vid"].asString()) 
-    //                                           << ", PID=0x" << std::hex << std::stoi(groupList[i]["itemList"][j]["pid"].asString()) 
-    //                                           << std::dec << std::endl;
-    //                             } else {
-    //                                 testValue = false; // 重置，继续下一个设备的匹配
-    //                             }
-                                
-    //                         } else if (strstr(groupList[i]["itemList"][j]["name"].asString().c_str(), "2.0") != NULL) {
-    //                             for (const auto& info : Board->facilityUsbInfoList2_0) {
-    //                                 if (info.vid == std::stoi(groupList[i]["itemList"][j]["vid"].asString()) && 
-    //                                     info.pid == std::stoi(groupList[i]["itemList"][j]["pid"].asString())) {
-    //                                     char buf[256] = {0};
-    //                                     sprintf(buf, "%d-%d", info.pid, info.vid);
-    //                                     groupList[i]["itemList"][j]["testResult"] = "OK";
-    //                                     groupList[i]["itemList"][j]["testValue"] = std::string(buf);
-    //                                     std::cout << "找到匹配的2.0设备: VID=0x" << std::hex << info.vid 
-    //                                               << ", PID=0x" << std::hex << info.pid 
-    //                                               << ", 类型=" << info.usbType << std::dec << std::endl;
-    //                                     testValue = true;
-    //                                 } 
-    //                             }
-
-    //                             if (testValue == false) {
-    //                                 allTestValue = false;
-    //                                 groupList[i]["itemList"][j]["testResult"] = "NG";
-    //                                 groupList[i]["itemList"][j]["testValue"] = "NG";
-    //                                 responseData["testCase"]["testResult"] = "NG";
-    //                                 std::cout << "未找到匹配的2.0设备: VID=0x" << std::hex << std::stoi(groupList[i]["itemList"][j]["vid"].asString()) 
-    //                                           << ", PID=0x" << std::hex << std::stoi(groupList[i]["itemList"][j]["pid"].asString()) 
-    //                                           << std::dec << std::endl;
-    //                             } else {
-    //                                 testValue = false; // 重置，继续下一个设备的匹配
-    //                             }
-    //                         }
-    //                     }
-    //                 }
-    //             }
-
-
-    //             first = ret;
-    //             count--;
-    //             std::cout << "Type-C 设备 第一次插入" << (ret == 1 ? "正插" : "反插") << std::endl;
-    //             dialog.update("TYPE_C", "请翻转TYPE-C设备");
-    //         }
-
-    //         if (ret != -1 && ret != first && count == 1) {
-    //             sleep(1);
-    //             Board->scan_usb_with_libusb();
-    //             for (const auto& info : Board->facilityUsbInfoList3_0) {
-    //             std::cout << "设备 VID: 0x" << std::hex << info.vid 
-    //                     << ", PID: 0x" << std::hex << info.pid 
-    //                     << ", 类型: " << info.usbType << std::dec << std::endl;
-    //             }
+    std::shared_ptr<interrupt_flag> flag = start_async_test(task, "typec");
+    typec_wait_flip(Board, flag, task.cmdIndex, testCase.groupData.testCase, response_data, patch);
+}
 
-    //             for (const auto& info : Board->facilityUsbInfoList2_0) {
-    //                 std::cout << "设备 VID: 0x" << std::hex << info.vid 
-    //                         << ", PID: 0x" << std::hex << info.pid 
-    //                         << ", 类型: " << info.usbType << std::dec << std::endl;
-    //             }
+static const int TYPEC_ENUMERATE_MS = 5000;                                 // 插入后等工装设备枚举的上限
 
-    //             Json::Value& groupList = responseData["testCase"]["groupData"]["testCase"]["groupList"];
-    //             for (Json::ArrayIndex i = 0; i < groupList.size(); ++i) {
-    //                 if (groupList[i]["type"].asString() == "negative") {
-    //                     for (Json::ArrayIndex j = 0; j < groupList[i]["itemList"].size(); ++j) {
-                            
-    //                         if (strstr(groupList[i]["itemList"][j]["name"].asString().c_str(), "3.0") != NULL) {
-    //                             for (const auto& info : Board->facilityUsbInfoList3_0) {
-    //                                 if (info.vid == std::stoi(groupList[i]["itemList"][j]["vid"].asString()) && 
-    //                                     info.pid == std::stoi(groupList[i]["itemList"][j]["pid"].asString())) {
-    //                                     char buf[256] = {0};
-    //                                     sprintf(buf, "%d-%d", info.pid, info.vid);
-    //                                     groupList[i]["itemList"][j]["testResult"] = "OK";
-    //                                     groupList[i]["itemList"][j]["testValue"] = std::string(buf);
-    //                                     std::cout << "找到匹配的3.0设备: VID=0x" << std::hex << info.vid 
-    //                                               << ", PID=0x" << std::hex << info.pid 
-    //                                               << ", 类型=" << info.usbType << std::dec << std::endl;
-
-    //                                     testValue = true;
-    //                                 } 
-    //                             }
-
-    //                             if (testValue == false) {
-    //                                 allTestValue = false;
-    //                                 groupList[i]["itemList"][j]["testResult"] = "NG";
-    //                                 groupList[i]["itemList"][j]["testValue"] = "NG";
-    //                                 responseData["testCase"]["testResult"] = "NG";
-    //                                 std::cout << "未找到匹配的3.0设备: VID=0x" << std::hex << std::stoi(groupList[i]["itemList"][j]["vid"].asString()) 
-    //                                           << ", PID=0x" << std::hex << std::stoi(groupList[i]["itemList"][j]["pid"].asString()) 
-    //                                           << std::dec << std::endl;
-    //                             } else {
-    //                                 testValue = false; // 重置，继续下一个设备的匹配
-    //                             }
-
-    //                         } else if (strstr(groupList[i]["itemList"][j]["name"].asString().c_str(), "2.0") != NULL) {
-    //                             for (const auto& info : Board->facilityUsbInfoList2_0) {
-    //                                 if (info.vid == std::stoi(groupList[i]["itemList"][j]["vid"].asString()) && 
-    //                                     info.pid == std::stoi(groupList[i]["itemList"][j]["pid"].asString())) {
-    //                                     // groupList[i]["itemList"][j]["testResult"] = "OK";
-    //                                     // groupList[i]["itemList"][j]["testValue"]["vid"] = info.vid;
-    //                                     // groupList[i]["itemList"][j]["testValue"]["pid"] = info.pid;
-    //                                     // groupList[i]["itemList"][j]["testValue"]["usbType"] = info.usbType;
-    //                                     char buf[256] = {0};
-    //                                     sprintf(buf, "%d-%d", info.pid, info.vid);
-    //                                     groupList[i]["itemList"][j]["testResult"] = "OK";
-    //                                     groupList[i]["itemList"][j]["testValue"] = std::string(buf);
-    //                                     std::cout << "找到匹配的2.0设备: VID=0x" << std::hex << info.vid 
-    //                                               << ", PID=0x" << std::hex << info.pid 
-    //                                               << ", 类型=" << info.usbType << std::dec << std::endl;
-    //                                     testValue = true;
-    //                                 } 
-    //                             }
-    //                             if (testValue == false) {
-    //                                 allTestValue = false;
-    //                                 groupList[i]["itemList"][j]["testResult"] = "NG";
-    //                                 groupList[i]["itemList"][j]["testValue"] = "NG";
-    //                                 responseData["testCase"]["testResult"] = "NG";
-    //                                 std::cout << "未找到匹配的2.0设备: VID=0x" << std::hex << std::stoi(groupList[i]["itemList"][j]["vid"].asString()) 
-    //                                           << ", PID=0x" << std::hex << std::stoi(groupList[i]["itemList"][j]["pid"].asString()) 
-    //                                           << std::dec << std::endl;
-    //                             } else {
-    //                                 testValue = false; // 重置，继续下一个设备的匹配
-    //                             }
-    //                         }
-    //                     }
-    //                 }
-    //             }
+// 某一面要检查的工装设备 {vid, pid}，和 typec_check_group 一样只看名字带 3.0 / 2.0 的项
+static std::vector<std::pair<int, int>> typec_expected_ids(const TypecGroupCase& groups, const char* side) {
+    std::vector<std::pair<int, int>> ids;
+    for (const TypecGroup& group : groups.groupList) {
+        if (group.type != side) {
+            continue;
+        }
+        for (const auto& item : group.itemList) {
+            if (strstr(item.name.c_str(), "3.0") != NULL || strstr(item.name.c_str(), "2.0") != NULL) {
+                ids.push_back(std::make_pair(item.vid, item.pid));
+            }
+        }
+    }
+    return ids;
+}
 
-    //             count--;
-    //             std::cout << "Type-C 设备 第二次插入" << (ret == 1 ? "正插" : "反插") << std::endl;
-    //             dialog.close();
-           
-    //         }
-    
-    //         if (timeOut-- == 0) {
-    //             dialog.close();
-    //             responseData["testCase"] = responseData["testCase"]["groupData"]["testCase"];
+AsyncTask TaskHandler::typec_wait_flip(std::shared_ptr<RkGenericBoard> Board, std::shared_ptr<interrupt_flag> flag,
+                                       uint16_t cmdIndex, TypecGroupCase groups, Json::Value responseData,
+                                       std::shared_ptr<const PatchRequest> patch) {
+    const char* orientationPath = "/sys/class/typec/port0/orientation";
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
 
-    //             std::cout << "Type-C 测试超时" << std::endl;
-    //             responseData["testCase"]["testResult"] = "NG";
-    //             responseData["testCase"]["testValue"] = "NULL";
-    //             responseData["testResult"] = "NG";
-    //             response["result"] = "false";
-    //             break;
-    //         }
-    //         sleep(1);
-    //     }
-    //     responseData["testCase"] = responseData["testCase"]["groupData"]["testCase"];
-    //     responseData["testCase"]["testResult"] = allTestValue ? "OK" : "NG";
-    //     response["cmdType"] = 1;
-    //     response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
-    //     response["data"] = responseData;
-    //     protocol_.sendResponse(response);
-    // });
-    // typecThread.detach();
-
-    std::shared_ptr<interrupt_flag> typec_task_stop_flag = work_thread_task.submit_interruptible([this, Board, response_data](interrupt_flag& flag) mutable {
-        Json::Value local_response;
-        Json::Value local_response_data = response_data;
-        local_response["result"] = "true";
-        local_response_data["testCase"]["testResult"] = "OK";
-
-        int count = 2;
-        int first = -1;
-        int timeOut = 60; // 60秒超时
-
-        // Board->scan_usb_with_libusb();
-        Board->lsusbGetVidPidInfo();
-
-        bool testValue = false;  // 是否找到匹配的测试设备
-        bool allTestValue = true; // 是否所有测试项都已测试完毕
-        while(count && !flag.is_stop_requested()) {
-            int ret = Board->typeCTest("/sys/class/typec/port0/orientation");
-            if ((ret == 1 || ret == 0) && count == 2) {
-                sleep(2);
-                // Board->scan_usb_with_libusb();
-                Board->lsusbGetVidPidInfo();
-                Json::Value& groupList = local_response_data["testCase"]["groupData"]["testCase"]["groupList"];
-                for (Json::ArrayIndex i = 0; i < groupList.size(); ++i) {
-                    if (groupList[i]["type"].asString() == "positive") {
-                        for (Json::ArrayIndex j = 0; j < groupList[i]["itemList"].size(); ++j) {
-                            
-                            if (strstr(groupList[i]["itemList"][j]["name"].asString().c_str(), "3.0") != NULL) {
-                                for (const auto& info : Board->lsusbFacilityUsbInfoList) {
-                                    if (info.vid == std::stoi(groupList[i]["itemList"][j]["vid"].asString()) && 
-                                        info.pid == std::stoi(groupList[i]["itemList"][j]["pid"].asString())) {
-                                        char buf[256] = {0};
-                                        sprintf(buf, "%d-%d", info.pid, info.vid);
-                                        groupList[i]["itemList"][j]["testResult"] = "OK";
-                                        groupList[i]["itemList"][j]["testValue"] = std::string(buf);
-                                        log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, 
-                                            "type-c positive found matching 3.0 device: VID=0x%X, PID=0x%X", 
-                                            info.vid, info.pid);
-                                        testValue = true;
-                                    } 
-                                }
-                                if (testValue == false) {
-                                    allTestValue = false;
-                                    groupList[i]["itemList"][j]["testResult"] = "NG";
-                                    groupList[i]["itemList"][j]["testValue"] = "NG";
-                                    local_response_data["testCase"]["testResult"] = "NG";
-                                    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, 
-                                        "type-c positive no found matching 3.0 device: VID=0x%X, PID=0x%X", 
-                                        std::stoi(groupList[i]["itemList"][j]["vid"].asString()), 
-                                        std::stoi(groupList[i]["itemList"][j]["pid"].asString()));
-                                } else {
-                                    testValue = false; // 重置，继续下一个设备的匹配
-                                }
-                            } else if (strstr(groupList[i]["itemList"][j]["name"].asString().c_str(), "2.0") != NULL) {
-                                for (const auto& info : Board->lsusbFacilityUsbInfoList) {
-                                    if (info.vid == std::stoi(groupList[i]["itemList"][j]["vid"].asString()) && 
-                                        info.pid == std::stoi(groupList[i]["itemList"][j]["pid"].asString())) {
-                                        char buf[256] = {0};
-                                        sprintf(buf, "%d-%d", info.pid, info.vid);
-                                        groupList[i]["itemList"][j]["testResult"] = "OK";
-                                        groupList[i]["itemList"][j]["testValue"] = std::string(buf);
-                                        log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, 
-                                            "type-c positive found matching 2.0 device: VID=0x%X, PID=0x%X", 
-                                            info.vid, info.pid);
-                                        testValue = true;
-                                    } 
-                                }
+    // 插拔时 typec 子系统上报 partner 的 add / remove 事件，收到事件再读方向，不再每秒轮询
+    // 先开始监听再读方向，读取和等待之间的插拔不会漏掉；udev 不可用时退回每秒读取一次
+    UdevMonitor monitor("typec", nullptr);
 
-                                if (testValue == false) {
-                                    allTestValue = false;
-                                    groupList[i]["itemList"][j]["testResult"] = "NG";
-                                    groupList[i]["itemList"][j]["testValue"] = "NG";
-                                    local_response_data["testCase"]["testResult"] = "NG";
-                                    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, 
-                                        "type-c positive no found matching 2.0 device: VID=0x%X, PID=0x%X", 
-                                        std::stoi(groupList[i]["itemList"][j]["vid"].asString()), 
-                                        std::stoi(groupList[i]["itemList"][j]["pid"].asString()));
-                                        
-                                } else {
-                                    testValue = false; // 重置，继续下一个设备的匹配
-                                }
+    responseData["testCase"]["testResult"] = "OK";
+    bool allTestValue = true;
+    bool timeout = false;
+    int count = 2;
+    int first = -1;
+    while (count > 0 && !flag->is_stop_requested()) {
+        int ret = Board->typeCTest(orientationPath);
+        if ((ret == 1 || ret == 0) && (count == 2 || ret != first)) {
+            const char* side = count == 2 ? "positive" : "negative";
+            // 等这一面的工装设备都枚举出来，最多 TYPEC_ENUMERATE_MS；没有登记表 (udev 不可用) 时退回固定等 2 秒
+            std::vector<std::pair<int, int>> wanted = typec_expected_ids(groups, side);
+            AsyncWaitResult enumerated = ASYNC_WAIT_ERROR;
+            if (Board->deviceRegistry) {
+                enumerated = co_await Board->deviceRegistry->wait_until(waiter_, Board->typecUsbPort,
+                    [wanted](const DeviceSnapshot& devices) {
+                        for (const std::pair<int, int>& id : wanted) {
+                            bool present = false;
+                            for (const UsbDeviceInfo& usb : devices.usb) {
+                                present = present || (usb.vid == id.first && usb.pid == id.second);
+                            }
+                            if (!present) {
+                                return false;
                             }
                         }
-                    }
-                }
-
+                        return true;
+                    }, TYPEC_ENUMERATE_MS, flag);
+            }
+            if (enumerated == ASYNC_WAIT_ERROR) {
+                enumerated = co_await waiter_.sleep_for(2000, flag);
+            }
+            if (enumerated == ASYNC_WAIT_CANCELLED) {
+                continue;
+            }
+            co_await waiter_.run_blocking(work_thread_task, [Board]() {
+                Board->lsusbGetVidPidInfo();
+            });
+            if (!typec_check_group(groups, responseData, side, Board)) {
+                allTestValue = false;
+            }
+            if (count == 2) {
                 first = ret;
-                count--;
                 log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "type-c device first inserted %s", (ret == 1 ? "normal" : "reverse"));
                 dialog.update("TYPE_C", "请翻转TYPE-C设备");
-            }
-
-            if (ret != -1 && ret != first && count == 1) {
-                sleep(2);
-                // Board->scan_usb_with_libusb();        
-                Board->lsusbGetVidPidInfo();
-
-                Json::Value& groupList = local_response_data["testCase"]["groupData"]["testCase"]["groupList"];
-                for (Json::ArrayIndex i = 0; i < groupList.size(); ++i) {
-                    if (groupList[i]["type"].asString() == "negative") {
-                        for (Json::ArrayIndex j = 0; j < groupList[i]["itemList"].size(); ++j) {
-                            
-                            if (strstr(groupList[i]["itemList"][j]["name"].asString().c_str(), "3.0") != NULL) {
-                                for (const auto& info : Board->lsusbFacilityUsbInfoList) {
-                                    if (info.vid == std::stoi(groupList[i]["itemList"][j]["vid"].asString()) && 
-                                        info.pid == std::stoi(groupList[i]["itemList"][j]["pid"].asString())) {
-                                        char buf[256] = {0};
-                                        sprintf(buf, "%d-%d", info.pid, info.vid);
-                                        groupList[i]["itemList"][j]["testResult"] = "OK";
-                                        groupList[i]["itemList"][j]["testValue"] = std::string(buf);
-                                        log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, 
-                                            "type-c negative found matching 3.0 device: VID=0x%X, PID=0x%X", 
-                                            info.vid, info.pid);
-                                        testValue = true;
-                                    } 
-                                }
-
-                                if (testValue == false) {
-                                    allTestValue = false;
-                                    groupList[i]["itemList"][j]["testResult"] = "NG";
-                                    groupList[i]["itemList"][j]["testValue"] = "NG";
-                                    local_response_data["testCase"]["testResult"] = "NG";
-                                    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, 
-                                        "type-c negative no found matching 3.0 device: VID=0x%X, PID=0x%X", 
-                                        std::stoi(groupList[i]["itemList"][j]["vid"].asString()), 
-                                        std::stoi(groupList[i]["itemList"][j]["pid"].asString()));
-                                } else {
-                                    testValue = false; // 重置，继续下一个设备的匹配
-                                }
-
-                            } else if (strstr(groupList[i]["itemList"][j]["name"].asString().c_str(), "2.0") != NULL) {
-                                for (const auto& info : Board->lsusbFacilityUsbInfoList) {
-                                    if (info.vid == std::stoi(groupList[i]["itemList"][j]["vid"].asString()) && 
-                                        info.pid == std::stoi(groupList[i]["itemList"][j]["pid"].asString())) {
-                                        char buf[256] = {0};
-                                        sprintf(buf, "%d-%d", info.pid, info.vid);
-                                        groupList[i]["itemList"][j]["testResult"] = "OK";
-                                        groupList[i]["itemList"][j]["testValue"] = std::string(buf);
-                                        log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, 
-                                            "type-c negative found matching 2.0 device: VID=0x%X, PID=0x%X", 
-                                            info.vid, info.pid);
-                                        testValue = true;
-                                    } 
-                                }
-                                if (testValue == false) {
-                                    allTestValue = false;
-                                    groupList[i]["itemList"][j]["testResult"] = "NG";
-                                    groupList[i]["itemList"][j]["testValue"] = "NG";
-                                    local_response_data["testCase"]["testResult"] = "NG";
-                                    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag,
-                                        "type-c negative no found matching 2.0 device: VID=0x%X, PID=0x%X",
-                                        std::stoi(groupList[i]["itemList"][j]["vid"].asString()),
-                                        std::stoi(groupList[i]["itemList"][j]["pid"].asString()));
-                                } else {
-                                    testValue = false; // 重置，继续下一个设备的匹配
-                                }
-                            }
-                        }
-                    }
-                }
-
-                count--;
+            } else {
                 log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "type-c device second inserted %s", (ret == 1 ? "normal" : "reverse"));
-                dialog.close();
             }
-    
-            if (timeOut-- == 0) {
-                dialog.close();
-                local_response_data["testCase"] = local_response_data["testCase"]["groupData"]["testCase"];
+            count--;
+            continue;
+        }
 
-                std::cout << "Type-C 测试超时" << std::endl;
-                local_response_data["testCase"]["testResult"] = "NG";
-                local_response_data["testCase"]["testValue"] = "NULL";
-                local_response_data["testResult"] = "NG";
-                local_response["result"] = "false";
-                break;
-            }
-            sleep(1);
+        int remainingMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+                              deadline - std::chrono::steady_clock::now()).count();
+        if (remainingMs <= 0) {
+            log_thread_safe(LOG_LEVEL_WARN, TaskHandlerTag, "type-c test timeout");
+            timeout = true;
+            break;
         }
-        local_response_data["testCase"] = local_response_data["testCase"]["groupData"]["testCase"];
-        local_response_data["testCase"]["testResult"] = allTestValue ? "OK" : "NG";
-        local_response["cmdType"] = 1;
-        local_response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
-        local_response["data"] = local_response_data;
-        protocol_.sendResponse(local_response);
-    });
-    interrupt_flags_queue_task.push(typec_task_stop_flag);
+        AsyncWaitResult result = ASYNC_WAIT_ERROR;
+        if (monitor.is_open()) {
+            result = (co_await waiter_.wait_udev(monitor, remainingMs, flag)).result;
+        }
+        if (result == ASYNC_WAIT_ERROR) {
+            co_await waiter_.sleep_for(std::min(remainingMs, 1000), flag);
+        }
+    }
+    dialog.close();
+
+    Json::Value response;
+    response["result"] = "true";
+    responseData["testCase"] = responseData["testCase"]["groupData"]["testCase"];
+    if (timeout) {
+        responseData["testCase"]["testResult"] = "NG";
+        responseData["testCase"]["testValue"] = "NULL";
+        responseData["testResult"] = "NG";
+        response["result"] = "false";
+    } else {
+        responseData["testCase"]["testResult"] = allTestValue ? "OK" : "NG";
+    }
+    response["cmdType"] = 1;
+    response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
+    response["data"] = responseData;
+    sendTestResult(response, patch);
+    task_registry.markDone(cmdIndex, *flag);
 }
 
 void TaskHandler::camera_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    CameraTestCase testCase;
+    JsonDecodeContext ctx;
+    if (!json_decode_member(task.data, "testCase", testCase, ctx)) {
+        respondInvalidParam(task, ctx.error());
+        return;
+    }
+
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
+
     Json::Value response;
     Json::Value response_data;
     response_data = task.data;
 
-    if (response_data["testCase"].isMember("enable") && response_data["testCase"]["enable"].asBool() == false) {
+    if (testCase.enable == false) {
         return;
     }
 
@@ -1710,14 +2077,11 @@ void TaskHandler::camera_test(const Task& task, std::shared_ptr<RkGenericBoard>
     // });
     // camThread.detach();
 
-    std::shared_ptr<interrupt_flag> camera_task_stop_flag =
-        work_thread_task.submit_interruptible([this, Board, response_data](interrupt_flag& flag) mutable {
+    submit_test(task, "camera", [this, Board, response_data, patch, cameraName = "cam" + testCase.cameraId](interrupt_flag& flag) mutable {
             Json::Value local_response;
             Json::Value local_response_data = response_data;
             local_response["result"] = "true";
-            if (local_response_data["testCase"].isMember("cameraId")) {
-                std::string cameraId = local_response_data["testCase"]["cameraId"].asString();
-                std::string cameraName = "cam" + cameraId;
+            {
                 if (Board->cameraidToInfo.find(cameraName) == Board->cameraidToInfo.end()) {
                     local_response_data["testCase"]["testResult"] = "NG";
                     local_response_data["testResult"] = "NG";
@@ -1741,14 +2105,14 @@ void TaskHandler::camera_test(const Task& task, std::shared_ptr<RkGenericBoard>
                 local_response["cmdType"] = 1;
                 local_response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
                 local_response["data"] = local_response_data;
-                protocol_.sendResponse(local_response);
+                sendTestResult(local_response, patch);
             }
         });
-    interrupt_flags_queue_task.push(camera_task_stop_flag);
 }
 
 // read base info: firmware version, hwid, ln, mac, app version, do not consume time, so no need to create a new thread 
 void TaskHandler::baseinfo_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
     Json::Value response;
     Json::Value response_data;
     response_data = task.data;
@@ -1802,10 +2166,11 @@ void TaskHandler::baseinfo_test(const Task& task, std::shared_ptr<RkGenericBoard
     response["cmdType"] = 1;
     response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
     response["data"] = response_data;
-    protocol_.sendResponse(response);
+    sendTestResult(response, patch);
 }
 
 void TaskHandler::microphone_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
     Json::Value response;
     Json::Value response_data;
     response_data = task.data;
@@ -1814,8 +2179,7 @@ void TaskHandler::microphone_test(const Task& task, std::shared_ptr<RkGenericBoa
         return;
     }
 
-    std::shared_ptr<interrupt_flag> mic_task_stop_flag =
-        work_thread_task.submit_interruptible([this, Board, response_data](interrupt_flag& flag) mutable {
+    submit_test(task, "microphone", [this, Board, response_data, patch](interrupt_flag& flag) mutable {
             Json::Value local_response;
             Json::Value local_response_data = response_data;
             local_response["result"] = "true";
@@ -1845,42 +2209,52 @@ void TaskHandler::microphone_test(const Task& task, std::shared_ptr<RkGenericBoa
             local_response["cmdType"] = 1;
             local_response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
             local_response["data"] = local_response_data;
-            protocol_.sendResponse(local_response);
+            sendTestResult(local_response, patch);
 
             log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "Microphone test thread exit.");
         });
-    interrupt_flags_queue_task.push(mic_task_stop_flag);
 }
 
 // common test items are not consume time, but in the future, the number of test items may increase. So create a new thread to handle common test items
 void TaskHandler::common_test(const Task& task, std::shared_ptr<RkGenericBoard> Board) {
+    CommonTestCase testCase;
+    JsonDecodeContext ctx;
+    if (!json_decode_member(task.data, "testCase", testCase, ctx)) {
+        respondInvalidParam(task, ctx.error());
+        return;
+    }
+
+    std::shared_ptr<const PatchRequest> patch = patchRequest(task);
+
     Json::Value response;
     Json::Value response_data;
     response_data = task.data;
 
-    if (response_data["testCase"].isMember("enable") && response_data["testCase"]["enable"].asBool() == false) {
+    if (testCase.enable == false) {
         return;
     }
    
-    std::shared_ptr<interrupt_flag> common_task_stop_flag =
-        work_thread_task.submit_interruptible([this, Board, response_data](interrupt_flag& flag) mutable {
+    submit_test(task, "common", [this, Board, response_data, testCase, patch, cmdIndex = task.cmdIndex](interrupt_flag& flag) mutable {
             Json::Value local_response;
             Json::Value local_response_data = response_data;
             local_response["result"] = "true";
 
-            for (Json::ArrayIndex i = 0; i < local_response_data["testCase"]["rangeCaseList"].size(); ++i) {
+            Json::ArrayIndex range_case_count = (Json::ArrayIndex)testCase.rangeCaseList.size();
+            for (Json::ArrayIndex i = 0; i < range_case_count; ++i) {
                 if (flag.is_stop_requested()) {
                     log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "Common test thread exit.");
                     break;
                 }
+                task_registry.setProgress(cmdIndex, flag, i * 100 / range_case_count);
 
-                if (local_response_data["testCase"]["rangeCaseList"][i]["enable"].asBool() == false) {
+                const CommonRangeCase& range_case = testCase.rangeCaseList[i];
+                if (range_case.enable == false) {
                     continue;
                 }
 
-                std::string common_name = local_response_data["testCase"]["rangeCaseList"][i]["name"].asString();
-                int max = local_response_data["testCase"]["rangeCaseList"][i]["max"].asInt();
-                int min = local_response_data["testCase"]["rangeCaseList"][i]["min"].asInt();
+                const std::string& common_name = range_case.name;
+                double max = range_case.max;
+                double min = range_case.min;
 
                 if (strstr(common_name.c_str(), "adc") != NULL) {
                     if (Board->Adc::adc_map.find(common_name) != Board->Adc::adc_map.end()) {
@@ -1905,11 +2279,10 @@ void TaskHandler::common_test(const Task& task, std::shared_ptr<RkGenericBoard>
             local_response["cmdType"] = 1;
             local_response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
             local_response["data"] = local_response_data;
-            protocol_.sendResponse(local_response);
+            sendTestResult(local_response, patch);
 
             log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag, "Common test thread exit.");
         });
-    interrupt_flags_queue_task.push(common_task_stop_flag);
 }
 
 // TODO : these handlers need to be combined
@@ -1992,6 +2365,155 @@ void TaskHandler::handleSignalToBeMeasuredCombine(const Task& task) {
     protocol_.sendResponse(response, task.cmdIndex);
 }
 
+void TaskHandler::handleCancelTest(const Task& task) {
+    Json::Value response;
+    response["cmdType"] = 2;
+    response["subCommand"] = CMD_CANCEL_TEST;
+    Json::Value data;
+    if (!task.data.isMember("cmdIndex") || !task.data["cmdIndex"].isUInt()) {
+        response["result"] = false;
+        response["desc"] = "missing cmdIndex";
+        data["errorCode"] = ERROR_INVALID_PARAM;
+    } else {
+        uint16_t cmdIndex = static_cast<uint16_t>(task.data["cmdIndex"].asUInt());
+        bool cancelled = task_registry.cancel(cmdIndex);
+        response["result"] = cancelled;
+        response["desc"] = cancelled ? "okay" : "task not found or already finished";
+        data["cmdIndex"] = cmdIndex;
+    }
+    response["data"] = data;
+    protocol_.sendResponse(response, task.cmdIndex);
+}
+
+void TaskHandler::handleQueryTestStatus(const Task& task) {
+    Json::Value response;
+    response["cmdType"] = 2;
+    response["result"] = true;
+    response["subCommand"] = CMD_QUERY_TEST_STATUS;
+    response["desc"] = "okay";
+    Json::Value data;
+    data["taskList"] = task_registry.list();
+    response["data"] = data;
+    protocol_.sendResponse(response, task.cmdIndex);
+}
+
+std::shared_ptr<const TaskHandler::PatchRequest> TaskHandler::patchRequest(const Task& task) {
+    if (!task.data.isObject()) {
+        return nullptr;
+    }
+    const Json::Value* mode = task.data.find("responseMode", "responseMode" + strlen("responseMode"));
+    if (mode == nullptr || !mode->isString() || mode->asString() != "patch") {
+        return nullptr;
+    }
+    return std::make_shared<const PatchRequest>(PatchRequest{task.cmdIndex, task.data});
+}
+
+void TaskHandler::sendTestResult(Json::Value& response, const std::shared_ptr<const PatchRequest>& patch) {
+    if (patch == nullptr) {
+        protocol_.sendResponse(response);
+        return;
+    }
+
+    const Json::Value& data = response["data"];
+    Json::Value base = patch->data;
+    Json::Value patched(Json::objectValue);
+    patched["responseMode"] = "patch";
+    patched["cmdIndex"] = patch->cmdIndex;
+    if (base.isMember("type")) {                                            // 上位机用来对应请求
+        patched["type"] = base["type"];
+    }
+    if (base.isMember("testFuncCode")) {
+        patched["testFuncCode"] = base["testFuncCode"];
+    }
+
+    // net / typec 的结果把 testCase.groupData.testCase 提升为 testCase，用一个 move 代替整棵子树
+    Json::Value ops(Json::arrayValue);
+    const char* nested = "/testCase/groupData/testCase";
+    if (json_pointer_find(base, nested) != nullptr && data.isObject() && data["testCase"].isObject() &&
+        !data["testCase"].isMember("groupData") && json_pointer_move(base, nested, "/testCase")) {
+        Json::Value move(Json::objectValue);
+        move["op"] = "move";
+        move["from"] = nested;
+        move["path"] = "/testCase";
+        ops.append(move);
+    }
+
+    json_diff(base, data, ops);
+    patched["patch"] = ops;
+    response["data"] = patched;
+    protocol_.sendResponse(response);
+}
+
+void TaskHandler::respondInvalidParam(const Task& task, const std::string& error) {
+    log_thread_safe(LOG_LEVEL_ERROR, TaskHandlerTag, "invalid test case (cmdIndex %u): %s", (unsigned)task.cmdIndex, error.c_str());
+
+    Json::Value response;
+    Json::Value data = task.data;
+    data["errorCode"] = ERROR_INVALID_PARAM;
+    data["errorMsg"] = error;
+    data["testResult"] = "NG";
+    response["result"] = "false";
+    response["desc"] = error;
+    response["cmdType"] = 1;
+    response["subCommand"] = CMD_SIGNAL_TOBEMEASURED_RES;
+    response["data"] = data;
+    sendTestResult(response, patchRequest(task));
+}
+
+bool TaskHandler::typec_check_group(const TypecGroupCase& groups, Json::Value& responseData, const char* side, std::shared_ptr<RkGenericBoard> Board) {
+    bool allFound = true;
+    Json::Value& groupList = responseData["testCase"]["groupData"]["testCase"]["groupList"];
+    for (size_t i = 0; i < groups.groupList.size(); ++i) {
+        const TypecGroup& group = groups.groupList[i];
+        if (group.type != side) {
+            continue;
+        }
+
+        for (size_t j = 0; j < group.itemList.size(); ++j) {
+            Json::Value& item = groupList[(Json::ArrayIndex)i]["itemList"][(Json::ArrayIndex)j];
+            const char* usbType = NULL;
+            if (strstr(group.itemList[j].name.c_str(), "3.0") != NULL) {
+                usbType = "3.0";
+            } else if (strstr(group.itemList[j].name.c_str(), "2.0") != NULL) {
+                usbType = "2.0";
+            } else {
+                continue;
+            }
+
+            int vid = group.itemList[j].vid;
+            int pid = group.itemList[j].pid;
+            bool found = false;
+            for (const auto& info : Board->lsusbFacilityUsbInfoList) {
+                if (info.vid == vid && info.pid == pid) {
+                    char buf[256] = {0};
+                    snprintf(buf, sizeof(buf), "%d-%d", info.pid, info.vid);
+                    item["testResult"] = "OK";
+                    item["testValue"] = std::string(buf);
+                    log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag,
+                        "type-c %s found matching %s device: VID=0x%X, PID=0x%X", side, usbType, info.vid, info.pid);
+                    found = true;
+                }
+            }
+
+            if (!found) {
+                allFound = false;
+                item["testResult"] = "NG";
+                item["testValue"] = "NG";
+                responseData["testCase"]["testResult"] = "NG";
+                log_thread_safe(LOG_LEVEL_INFO, TaskHandlerTag,
+                    "type-c %s no found matching %s device: VID=0x%X, PID=0x%X", side, usbType, vid, pid);
+            }
+        }
+    }
+    return allFound;
+}
+
+std::shared_ptr<interrupt_flag> TaskHandler::start_async_test(const Task& task, const std::string& name) {
+    std::shared_ptr<interrupt_flag> flag = task_registry.add(task.cmdIndex, name);
+    task_registry.markRunning(task.cmdIndex, *flag);
+    return flag;
+}
+
 Json::Value TaskHandler::buildResponse(const Task& task, const TestResult& result, const std::string& testName) {
     Json::Value response;
     response["subCommand"] = result.responseCommand;
@@ -2012,6 +2534,8 @@ TestItem TaskHandler::stringToTestItem(const std::string& str) {
     if (str == "rtc") return RTC;
     if (str == "storage") return STORAGE;
     if (str == "ddr") return DDR;
+    if (str == "ddr_bandwidth") return DDR_BANDWIDTH;
+    if (str == "ddr_memtest") return DDR_MEMTEST;
     if (str == "emmc") return EMMC;
     if (str == "wifi") return WIFI;
     if (str == "bluetooth") return BLUETOOTH;
@@ -0,0 +1,184 @@
+#include "task/TaskRegistry.h"
+#include "util/Log.h"
+
+#include <vector>
+#include <algorithm>
+
+std::shared_ptr<interrupt_flag> TaskRegistry::add(uint16_t cmdIndex, const std::string& name) {
+    std::lock_guard<Mutex> lock(mutex_);
+
+    auto it = tasks_.find(cmdIndex);
+    if (it != tasks_.end()) {
+        TaskRecord& old = it->second;
+        if (old.state == TASK_STATE_QUEUED || old.state == TASK_STATE_RUNNING) {
+            log_thread_safe(LOG_LEVEL_WARN, TASK_REGISTRY_TAG, "cmdIndex %u (%s) still active, cancel it",
+                            (unsigned)cmdIndex, old.name.c_str());
+            old.flag->request_stop();
+        }
+        tasks_.erase(it);
+    }
+
+    TaskRecord record;
+    record.cmdIndex = cmdIndex;
+    record.name = name;
+    record.state = TASK_STATE_QUEUED;
+    record.startTime = std::chrono::steady_clock::now();
+    record.startWallTime = time(nullptr);
+    record.progress = 0;
+    record.flag = std::make_shared<interrupt_flag>();
+    tasks_[cmdIndex] = record;
+
+    prune();
+    return record.flag;
+}
+
+TaskRegistry::TaskRecord* TaskRegistry::find(uint16_t cmdIndex, const interrupt_flag& flag) {
+    auto it = tasks_.find(cmdIndex);
+    if (it == tasks_.end() || it->second.flag.get() != &flag) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void TaskRegistry::markRunning(uint16_t cmdIndex, const interrupt_flag& flag) {
+    std::lock_guard<Mutex> lock(mutex_);
+    TaskRecord* record = find(cmdIndex, flag);
+    if (record == nullptr || record->state != TASK_STATE_QUEUED) {
+        return;
+    }
+    record->state = TASK_STATE_RUNNING;
+    record->startTime = std::chrono::steady_clock::now();                  // 排队时间不计入耗时
+    record->startWallTime = time(nullptr);
+}
+
+void TaskRegistry::setProgress(uint16_t cmdIndex, const interrupt_flag& flag, int progress) {
+    std::lock_guard<Mutex> lock(mutex_);
+    TaskRecord* record = find(cmdIndex, flag);
+    if (record == nullptr) {
+        return;
+    }
+    record->progress = std::max(0, std::min(100, progress));
+}
+
+void TaskRegistry::markDone(uint16_t cmdIndex, const interrupt_flag& flag) {
+    std::lock_guard<Mutex> lock(mutex_);
+    TaskRecord* record = find(cmdIndex, flag);
+    if (record == nullptr) {
+        return;
+    }
+    if (record->flag->is_stop_requested()) {
+        record->state = TASK_STATE_CANCELLED;
+    } else {
+        record->state = TASK_STATE_DONE;
+        record->progress = 100;
+    }
+}
+
+bool TaskRegistry::cancel(uint16_t cmdIndex) {
+    std::lock_guard<Mutex> lock(mutex_);
+    auto it = tasks_.find(cmdIndex);
+    if (it == tasks_.end()) {
+        return false;
+    }
+    TaskRecord& record = it->second;
+    if (record.state == TASK_STATE_DONE || record.state == TASK_STATE_CANCELLED) {
+        return false;
+    }
+    record.flag->request_stop();
+    if (record.state == TASK_STATE_QUEUED) {
+        record.state = TASK_STATE_CANCELLED;                                // 还没开始执行，直接记为取消
+    }
+    log_thread_safe(LOG_LEVEL_INFO, TASK_REGISTRY_TAG, "cancel cmdIndex %u (%s)",
+                    (unsigned)cmdIndex, record.name.c_str());
+    return true;
+}
+
+void TaskRegistry::cancelAll() {
+    std::lock_guard<Mutex> lock(mutex_);
+    for (auto& item : tasks_) {
+        TaskRecord& record = item.second;
+        if (record.state == TASK_STATE_DONE || record.state == TASK_STATE_CANCELLED) {
+            continue;
+        }
+        record.flag->request_stop();
+        if (record.state == TASK_STATE_QUEUED) {
+            record.state = TASK_STATE_CANCELLED;
+        }
+    }
+}
+
+void TaskRegistry::addResident(const std::shared_ptr<interrupt_flag>& flag) {
+    std::lock_guard<Mutex> lock(mutex_);
+    residents_.push_back(flag);
+}
+
+void TaskRegistry::shutdown() {
+    std::vector<std::shared_ptr<interrupt_flag>> residents;
+    {
+        std::lock_guard<Mutex> lock(mutex_);
+        residents.swap(residents_);
+    }
+    for (const auto& flag : residents) {
+        flag->request_stop();
+    }
+    cancelAll();
+}
+
+bool TaskRegistry::get(uint16_t cmdIndex, TaskRecord& record) {
+    std::lock_guard<Mutex> lock(mutex_);
+    auto it = tasks_.find(cmdIndex);
+    if (it == tasks_.end()) {
+        return false;
+    }
+    record = it->second;
+    return true;
+}
+
+Json::Value TaskRegistry::list() {
+    std::lock_guard<Mutex> lock(mutex_);
+    Json::Value array(Json::arrayValue);
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& item : tasks_) {
+        const TaskRecord& record = item.second;
+        Json::Value node;
+        node["cmdIndex"] = record.cmdIndex;
+        node["name"] = record.name;
+        node["state"] = stateToString(record.state);
+        node["startTime"] = (Json::Int64)record.startWallTime;
+        node["elapsedMs"] = (Json::Int64)std::chrono::duration_cast<std::chrono::milliseconds>(
+                                now - record.startTime).count();
+        node["progress"] = record.progress;
+        array.append(node);
+    }
+    return array;
+}
+
+const char* TaskRegistry::stateToString(TaskState state) {
+    switch (state) {
+        case TASK_STATE_QUEUED:    return "queued";
+        case TASK_STATE_RUNNING:   return "running";
+        case TASK_STATE_DONE:      return "done";
+        case TASK_STATE_CANCELLED: return "cancelled";
+        default:                   return "unknown";
+    }
+}
+
+void TaskRegistry::prune() {
+    std::vector<uint16_t> finished;
+    for (const auto& item : tasks_) {
+        if (item.second.state == TASK_STATE_DONE || item.second.state == TASK_STATE_CANCELLED) {
+            finished.push_back(item.first);
+        }
+    }
+    if (finished.size() <= MAX_FINISHED_RECORDS) {
+        return;
+    }
+
+    // 按开始时间删除最早结束的记录
+    std::sort(finished.begin(), finished.end(), [this](uint16_t a, uint16_t b) {
+        return tasks_[a].startTime < tasks_[b].startTime;
+    });
+    for (size_t i = 0; i < finished.size() - MAX_FINISHED_RECORDS; ++i) {
+        tasks_.erase(finished[i]);
+    }
+}
@@ -0,0 +1,25 @@
+#include "task/TestCase.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+bool json_decode_value(const Json::Value& value, SwitchKey& out, JsonDecodeContext& ctx) {
+    if (!value.isString()) {
+        return ctx.fail("expected string like \"VOL-_114\"");
+    }
+    const char* str = value.asCString();
+    const char* underscore = strchr(str, '_');
+    if (underscore == nullptr || underscore == str) {
+        return ctx.fail("expected \"<key name>_<key code>\"");
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    long code = strtol(underscore + 1, &end, 10);
+    if (end == underscore + 1 || *end != '\0' || errno != 0 || code < 0 || code > 0xffff) {
+        return ctx.fail("bad key code");
+    }
+    out.name.assign(str, underscore - str);
+    out.code = (int)code;
+    return true;
+}
@@ -0,0 +1,211 @@
+/*
+ * util/JsonPatch 的测试：json_diff 生成的补丁经 json_patch_apply 后必须还原出完整的 target
+ */
+#include <stdlib.h>
+#include <string>
+
+#include "util/JsonPatch.h"
+#include "test_check.h"
+
+static Json::Value parse(const char* text) {
+    Json::Value value;
+    Json::CharReaderBuilder builder;
+    std::string error;
+    std::string input(text);
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    if (!reader->parse(input.data(), input.data() + input.size(), &value, &error)) {
+        fprintf(stderr, "bad test json: %s\n", text);
+        abort();
+    }
+    return value;
+}
+
+// diff 之后 apply，结果必须和 target 完全相同 (包括类型)
+static bool round_trip(const Json::Value& base, const Json::Value& target, Json::Value* out_patch = nullptr) {
+    Json::Value patch;
+    bool changed = json_diff(base, target, patch);
+    Json::Value doc = base;
+    bool applied = !changed || json_patch_apply(doc, patch);
+    if (out_patch != nullptr) {
+        *out_patch = patch;
+    }
+    return changed == (base != target) && applied && doc == target;
+}
+
+// 已有成员改为 null 必须保留为 null，不能当成删除
+static void test_explicit_null() {
+    Json::Value base = parse(R"({"a":1,"b":{"c":2},"d":"x"})");
+    Json::Value target = parse(R"({"a":null,"b":{"c":null},"d":"x","e":null})");
+    CHECK(round_trip(base, target));
+
+    Json::Value doc = base;
+    Json::Value patch;
+    json_diff(base, target, patch);
+    json_patch_apply(doc, patch);
+    CHECK(doc.isMember("a") && doc["a"].isNull());
+    CHECK(doc["b"].isMember("c") && doc["b"]["c"].isNull());
+    CHECK(doc.isMember("e") && doc["e"].isNull());
+
+    // null 改回有值
+    CHECK(round_trip(target, base));
+}
+
+// 数组换成数字 key 的对象 (以及反过来) 必须整体替换，不能当成按下标打补丁
+static void test_array_to_numeric_object() {
+    Json::Value base = parse(R"({"x":[1,2,3]})");
+    Json::Value target = parse(R"({"x":{"0":9,"1":2}})");
+    Json::Value patch;
+    CHECK(round_trip(base, target, &patch));
+    CHECK(patch.size() == 1 && patch[0]["op"] == "replace" && patch[0]["path"] == "/x");
+
+    Json::Value doc = base;
+    json_patch_apply(doc, patch);
+    CHECK(doc["x"].isObject() && !doc["x"].isMember("2"));
+
+    CHECK(round_trip(target, base));
+    CHECK(round_trip(parse("[1,2]"), parse(R"({"0":1,"1":2})")));
+}
+
+// 典型的测试结果：只回传新增的 testResult
+static void test_result_fields() {
+    Json::Value base = parse(R"({"store":[{"name":"ddr"},{"name":"emmc"}]})");
+    Json::Value target = parse(R"({"store":[{"name":"ddr","testResult":"OK"},{"name":"emmc"}]})");
+    Json::Value patch;
+    CHECK(round_trip(base, target, &patch));
+    CHECK(patch.size() == 1);
+    CHECK(patch[0]["op"] == "add" && patch[0]["path"] == "/store/0/testResult" && patch[0]["value"] == "OK");
+
+    Json::Value unchanged;
+    CHECK(!json_diff(base, base, unchanged));
+    CHECK(unchanged.isNull());
+}
+
+static void test_replace_and_remove() {
+    CHECK(round_trip(parse(R"({"a":1,"b":2})"), parse(R"({"a":"1"})")));             // 类型变化 + 删除
+    CHECK(round_trip(parse(R"({"a":1})"), parse(R"({"a":1.5})")));
+    CHECK(round_trip(parse(R"({"list":[1,2,3]})"), parse(R"({"list":[1,2]})")));      // 长度变化
+    CHECK(round_trip(parse(R"({"list":[{"a":1},{"a":2}]})"), parse(R"({"list":[{"a":1},{"b":2}]})")));
+    CHECK(round_trip(parse(R"({"a":1})"), parse("[1]")));                             // 整个文档替换
+    CHECK(round_trip(parse("1"), parse("null")));
+}
+
+// key 中的 '/' 和 '~' 按 RFC 6901 转义
+static void test_escaped_keys() {
+    Json::Value base = parse(R"({"a/b":{"c~d":1},"":2})");
+    Json::Value target = parse(R"({"a/b":{"c~d":3,"~1":4},"":null})");
+    Json::Value patch;
+    CHECK(round_trip(base, target, &patch));
+    bool found = false;
+    for (const Json::Value& op : patch) {
+        found = found || op["path"] == "/a~1b/c~0d";
+    }
+    CHECK(found);
+}
+
+// 补丁模式应答：先 move 提升 testCase，再按 diff 还原
+static void test_move_then_patch() {
+    Json::Value request = parse(R"({"type":"net","testCase":{"groupData":{"testCase":[{"name":"eth0"},{"name":"eth1"}]}}})");
+    Json::Value result = parse(R"({"type":"net","testCase":[{"name":"eth0","testResult":"OK"},{"name":"eth1","testResult":"NG"}]})");
+
+    Json::Value base = request;
+    Json::Value ops(Json::arrayValue);
+    CHECK(json_pointer_move(base, "/testCase/groupData/testCase", "/testCase"));
+    Json::Value move(Json::objectValue);
+    move["op"] = "move";
+    move["from"] = "/testCase/groupData/testCase";
+    move["path"] = "/testCase";
+    ops.append(move);
+    json_diff(base, result, ops);
+
+    Json::Value doc = request;
+    CHECK(json_patch_apply(doc, ops));
+    CHECK(doc == result);
+}
+
+static void test_apply_errors() {
+    Json::Value doc = parse(R"({"a":[1,2]})");
+    CHECK(!json_patch_apply(doc, parse(R"({"a":1})")));                               // 不是操作数组
+    CHECK(!json_patch_apply(doc, parse(R"([{"op":"replace","path":"/b","value":1}])")));
+    CHECK(!json_patch_apply(doc, parse(R"([{"op":"remove","path":"/a/2"}])")));
+    CHECK(!json_patch_apply(doc, parse(R"([{"op":"copy","from":"/a","path":"/b"}])")));
+    CHECK(json_patch_apply(doc, parse(R"([{"op":"add","path":"/a/-","value":3},{"op":"add","path":"/a/0","value":0}])")));
+    CHECK(doc == parse(R"({"a":[0,1,2,3]})"));
+}
+
+// 随机生成的文档互相 diff / apply
+static Json::Value random_value(unsigned& seed, int depth) {
+    int kind = rand_r(&seed) % (depth > 3 ? 4 : 6);
+    switch (kind) {
+        case 0: return Json::Value(Json::nullValue);
+        case 1: return Json::Value(rand_r(&seed) % 3);
+        case 2: return Json::Value(rand_r(&seed) % 2 == 0 ? "OK" : "NG");
+        case 3: return Json::Value(rand_r(&seed) % 2 == 0);
+        case 4: {
+            Json::Value array(Json::arrayValue);
+            int size = rand_r(&seed) % 4;
+            for (int i = 0; i < size; ++i) {
+                array.append(random_value(seed, depth + 1));
+            }
+            return array;
+        }
+        default: {
+            Json::Value object(Json::objectValue);
+            int size = rand_r(&seed) % 4;
+            for (int i = 0; i < size; ++i) {
+                static const char* keys[] = {"0", "1", "a", "b/c", "~"};
+                object[keys[rand_r(&seed) % 5]] = random_value(seed, depth + 1);
+            }
+            return object;
+        }
+    }
+}
+
+// 在 base 的基础上随机修改几处，生成和 base 大部分相同的 target
+static void mutate(Json::Value& value, unsigned& seed, int depth) {
+    if (rand_r(&seed) % 4 == 0) {
+        value = random_value(seed, depth);
+        return;
+    }
+    if (value.isObject()) {
+        if (rand_r(&seed) % 3 == 0 && !value.empty()) {
+            value.removeMember(value.getMemberNames()[rand_r(&seed) % value.size()]);
+        }
+        for (const std::string& key : value.getMemberNames()) {
+            if (rand_r(&seed) % 2 == 0) {
+                mutate(value[key], seed, depth + 1);
+            }
+        }
+    } else if (value.isArray()) {
+        for (Json::ArrayIndex i = 0; i < value.size(); ++i) {
+            if (rand_r(&seed) % 2 == 0) {
+                mutate(value[i], seed, depth + 1);
+            }
+        }
+    }
+}
+
+static void test_random_round_trip() {
+    unsigned seed = 1;
+    int failed = 0;
+    for (int i = 0; i < 20000; ++i) {
+        Json::Value base = random_value(seed, 0);
+        Json::Value target = base;
+        mutate(target, seed, 0);
+        if (!round_trip(base, target) && failed++ < 3) {
+            fprintf(stderr, "round trip failed:\n%s%s", base.toStyledString().c_str(), target.toStyledString().c_str());
+        }
+    }
+    CHECK(failed == 0);
+}
+
+int main() {
+    test_explicit_null();
+    test_array_to_numeric_object();
+    test_result_fields();
+    test_replace_and_remove();
+    test_escaped_keys();
+    test_move_then_patch();
+    test_apply_errors();
+    test_random_round_trip();
+    return test_result("json_patch_test");
+}
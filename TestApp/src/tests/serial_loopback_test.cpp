@@ -0,0 +1,213 @@
+/*
+ * hardware/SerialLoopback 的测试：用 openpty 创建的伪终端代替串口，
+ * 每个 master 端由一个线程按接线方式把收到的数据回传 (自己、对面端口或丢弃)，
+ * 检查 epoll 同时测多个端口时每个端口各自的通过 / 失败、重试次数，以及总耗时不是各端口之和
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <errno.h>
+#include <poll.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "hardware/SerialLoopback.h"
+#include "test_check.h"
+
+// 一个假的串口，slave 的路径交给 SerialLoopback 打开，master 端模拟接线
+struct FakePort {
+    int master = -1;
+    int slave = -1;                         // 一直打开，SerialLoopback 重新打开端口的间隙 master 不会读到 EIO
+    std::string path;
+};
+
+static FakePort open_port() {
+    FakePort port;
+    char name[64];
+    struct termios raw;
+    memset(&raw, 0, sizeof(raw));
+    cfmakeraw(&raw);                        // 默认的 ECHO 会把还没被打开的端口收到的数据原样送回，真实的线不会
+    if (openpty(&port.master, &port.slave, name, &raw, nullptr) < 0) {
+        perror("openpty");
+        exit(1);
+    }
+    port.path = name;
+    return port;
+}
+
+static void close_port(FakePort& port) {
+    close(port.master);
+    close(port.slave);
+}
+
+/*
+ * 接线: 从 from 的 master 读到的数据延迟 delayMs 后写到 to 的 master，to 为空时丢弃 (没接线)
+ * 每条线一个线程，延迟不会影响其它端口
+ */
+class Wiring {
+public:
+    ~Wiring() {
+        stop_ = true;
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void connect(const FakePort& from, const FakePort* to, int delayMs) {
+        int in = from.master;
+        int out = to ? to->master : -1;
+        threads_.emplace_back([this, in, out, delayMs]() {
+            char buffer[256];
+            while (!stop_) {
+                struct pollfd pfd = {in, POLLIN, 0};
+                if (poll(&pfd, 1, 20) <= 0 || !(pfd.revents & POLLIN)) {
+                    continue;
+                }
+                ssize_t n = read(in, buffer, sizeof(buffer));
+                if (n <= 0 || out < 0) {
+                    continue;
+                }
+                if (delayMs > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+                }
+                if (write(out, buffer, n) != n) {
+                    perror("write master");
+                }
+            }
+        });
+    }
+
+private:
+    std::atomic<bool> stop_{false};
+    std::vector<std::thread> threads_;
+};
+
+static SerialLoopbackConfig fast_config() {
+    SerialLoopbackConfig config;
+    config.rounds = 5;
+    config.timeoutMs = 200;
+    config.retries = 1;
+    config.retryDelayMs = 50;
+    return config;
+}
+
+static void test_all_ports_pass() {
+    std::vector<FakePort> ports = {open_port(), open_port(), open_port()};
+    std::vector<std::string> devices;
+    {
+        Wiring wiring;
+        for (const FakePort& port : ports) {
+            wiring.connect(port, &port, 0);
+            devices.push_back(port.path);
+        }
+        std::vector<SerialLoopbackResult> results;
+        CHECK(SerialLoopback(fast_config()).run(devices, results));
+        CHECK(results.size() == 3);
+        for (size_t i = 0; i < results.size(); ++i) {
+            CHECK(results[i].ok && results[i].device == devices[i]);
+            CHECK(results[i].rounds == 5 && results[i].attempts == 1 && results[i].error.empty());
+        }
+    }
+    for (FakePort& port : ports) {
+        close_port(port);
+    }
+}
+
+// 没接线的端口超时、用完重试后失败，不影响同时测试的其它端口
+static void test_per_port_result() {
+    std::vector<FakePort> ports = {open_port(), open_port(), open_port()};
+    std::vector<std::string> devices;
+    for (const FakePort& port : ports) {
+        devices.push_back(port.path);
+    }
+    devices.push_back("/dev/serial_loopback_test_missing");
+    {
+        Wiring wiring;
+        wiring.connect(ports[0], &ports[0], 0);
+        wiring.connect(ports[1], nullptr, 0);
+        wiring.connect(ports[2], &ports[2], 0);
+        std::vector<SerialLoopbackResult> results;
+        CHECK(!SerialLoopback(fast_config()).run(devices, results));
+        CHECK(results.size() == 4);
+        if (results.size() == 4) {
+            CHECK(results[0].ok && results[0].rounds == 5);
+            CHECK(!results[1].ok && results[1].attempts == 2 && results[1].rounds == 0);
+            CHECK(results[1].error.find("timeout") != std::string::npos);
+            CHECK(results[2].ok && results[2].rounds == 5);
+            CHECK(!results[3].ok && results[3].attempts == 2);
+            CHECK(results[3].error.find("open failed") != std::string::npos);
+        }
+    }
+    for (FakePort& port : ports) {
+        close_port(port);
+    }
+}
+
+// 两个端口的线接反了，收到的是对方的标记
+// 端口按顺序打开，端口 0 的标记可能在端口 1 打开时被 tcflush 清掉，端口 1 也可能只是超时；
+// 端口 0 的标记之后才发，一定收到端口 1 的标记。不重试，最后的错误就是第一次的
+static void test_crossed_wiring() {
+    std::vector<FakePort> ports = {open_port(), open_port()};
+    std::vector<std::string> devices = {ports[0].path, ports[1].path};
+    {
+        Wiring wiring;
+        wiring.connect(ports[0], &ports[1], 0);
+        wiring.connect(ports[1], &ports[0], 0);
+        SerialLoopbackConfig config = fast_config();
+        config.retries = 0;
+        std::vector<SerialLoopbackResult> results;
+        CHECK(!SerialLoopback(config).run(devices, results));
+        CHECK(results.size() == 2);
+        for (const SerialLoopbackResult& result : results) {
+            CHECK(!result.ok && result.rounds == 0 && result.attempts == 1);
+        }
+        CHECK(!results.empty() && results[0].error.find("expected") != std::string::npos);
+    }
+    for (FakePort& port : ports) {
+        close_port(port);
+    }
+}
+
+// 每个往返 30ms，4 个端口各 5 轮：同时进行约 150ms，逐个端口测要 600ms
+static void test_ports_run_in_parallel() {
+    std::vector<FakePort> ports = {open_port(), open_port(), open_port(), open_port()};
+    std::vector<std::string> devices;
+    uint64_t slowestUs = 0;
+    {
+        Wiring wiring;
+        for (const FakePort& port : ports) {
+            wiring.connect(port, &port, 30);
+            devices.push_back(port.path);
+        }
+        std::vector<SerialLoopbackResult> results;
+        auto start = std::chrono::steady_clock::now();
+        CHECK(SerialLoopback(fast_config()).run(devices, results));
+        uint64_t elapsedMs = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        CHECK(elapsedMs < 400);
+        for (const SerialLoopbackResult& result : results) {
+            CHECK(result.ok && result.maxRoundTripUs >= 30000);
+            slowestUs = std::max(slowestUs, result.elapsedUs);
+        }
+        CHECK(slowestUs >= 150000);
+    }
+    for (FakePort& port : ports) {
+        close_port(port);
+    }
+}
+
+int main() {
+    test_all_ports_pass();
+    test_per_port_result();
+    test_crossed_wiring();
+    test_ports_run_in_parallel();
+    log_flush();
+    return test_result("serial_loopback_test");
+}
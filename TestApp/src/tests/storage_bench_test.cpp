@@ -0,0 +1,278 @@
+/*
+ * hardware/IoEngine 和 StorageBench 的测试：在临时目录里的文件上
+ * 用同步、io_uring、内核 aio 三种引擎写入带偏移标记的数据再读回，检查每个请求的字节数和内容；
+ * 再用每种引擎跑一遍 StorageBench，检查测试区域、各项结果、临时文件被删除以及取消
+ * 内核或容器不支持 io_uring / aio 时跳过对应的引擎
+ */
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "hardware/IoEngine.h"
+#include "hardware/StorageBench.h"
+#include "test_check.h"
+
+static const uint32_t BLOCK_SIZE = 64 << 10;
+static const uint32_t BLOCK_COUNT = 32;
+static const unsigned DEPTH = 4;
+
+static const IoEngineType ENGINES[] = {IO_ENGINE_SYNC, IO_ENGINE_URING, IO_ENGINE_AIO};
+
+static std::string fixture_root;
+
+// 每个 8 字节字都是它在文件中的偏移加上 seed，错位、串块或漏写都能发现
+static void fill_block(char* buf, uint64_t offset, uint64_t seed) {
+    uint64_t* words = (uint64_t*)buf;
+    for (size_t i = 0; i < BLOCK_SIZE / sizeof(uint64_t); ++i) {
+        words[i] = offset + i * sizeof(uint64_t) + seed;
+    }
+}
+
+static bool check_block(const char* buf, uint64_t offset, uint64_t seed) {
+    const uint64_t* words = (const uint64_t*)buf;
+    for (size_t i = 0; i < BLOCK_SIZE / sizeof(uint64_t); ++i) {
+        if (words[i] != offset + i * sizeof(uint64_t) + seed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 和 StorageBench 一样先打开再加 O_DIRECT，临时目录在 tmpfs 上时退回 page cache
+static int open_temp_file(const char* name) {
+    std::string path = fixture_root + "/" + name;
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        perror(path.c_str());
+        exit(1);
+    }
+    unlink(path.c_str());
+    int status = fcntl(fd, F_GETFL);
+    if (status >= 0) {
+        fcntl(fd, F_SETFL, status | O_DIRECT);
+    }
+    return fd;
+}
+
+/*
+ * 保持 DEPTH 个请求在途读或写 BLOCK_COUNT 个块，块号倒序提交，完成顺序和提交顺序无关
+ * @return 所有块都完成且字节数正确
+ */
+static bool transfer(IoEngine& engine, int fd, bool write, char* buffers, uint64_t seed) {
+    std::vector<IoCompletion> done;
+    std::vector<uint32_t> blockOfTag(DEPTH);
+    std::vector<bool> finished(BLOCK_COUNT, false);
+    uint32_t nextBlock = 0;
+    unsigned inflight = 0;
+    bool ok = true;
+
+    auto issue = [&](uint32_t tag) {
+        if (nextBlock >= BLOCK_COUNT) {
+            return;
+        }
+        uint32_t block = BLOCK_COUNT - 1 - nextBlock++;
+        uint64_t offset = (uint64_t)block * BLOCK_SIZE;
+        char* buf = buffers + (size_t)tag * BLOCK_SIZE;
+        if (write) {
+            fill_block(buf, offset, seed);
+        } else {
+            memset(buf, 0, BLOCK_SIZE);
+        }
+        blockOfTag[tag] = block;
+        CHECK(engine.queue(write, fd, buf, BLOCK_SIZE, offset, tag));
+        inflight++;
+    };
+
+    for (uint32_t tag = 0; tag < DEPTH; ++tag) {
+        issue(tag);
+    }
+    while (inflight > 0) {
+        done.clear();
+        int ret = engine.submitAndWait(1, done);
+        CHECK(ret > 0 && (size_t)ret == done.size());
+        if (ret <= 0) {
+            return false;
+        }
+        for (const IoCompletion& completion : done) {
+            CHECK(completion.tag < DEPTH);
+            if (completion.tag >= DEPTH) {
+                return false;
+            }
+            uint32_t block = blockOfTag[completion.tag];
+            inflight--;
+            CHECK(completion.result == (int64_t)BLOCK_SIZE);
+            if (!write) {
+                CHECK(check_block(buffers + (size_t)completion.tag * BLOCK_SIZE, (uint64_t)block * BLOCK_SIZE, seed));
+            }
+            ok = ok && completion.result == (int64_t)BLOCK_SIZE && !finished[block];
+            finished[block] = true;
+            issue(completion.tag);
+        }
+    }
+    for (bool f : finished) {
+        ok = ok && f;
+    }
+    return ok;
+}
+
+static void test_engine_round_trip(IoEngineType type) {
+    std::unique_ptr<IoEngine> engine = IoEngine::create(type, DEPTH);
+    if (!engine) {
+        printf("storage_bench_test: %s not available, skipped\n", IoEngine::typeName(type));
+        return;
+    }
+    CHECK(strcmp(engine->name(), IoEngine::typeName(type)) == 0);
+
+    char* buffers = nullptr;
+    if (posix_memalign((void**)&buffers, 4096, (size_t)DEPTH * BLOCK_SIZE) != 0) {
+        perror("posix_memalign");
+        exit(1);
+    }
+    int fd = open_temp_file("round_trip");
+    const uint64_t seed = 0x5a5a000000000000ULL + type;
+    CHECK(transfer(*engine, fd, true, buffers, seed));
+    struct stat st;
+    CHECK(fstat(fd, &st) == 0 && (uint64_t)st.st_size == (uint64_t)BLOCK_SIZE * BLOCK_COUNT);
+    CHECK(transfer(*engine, fd, false, buffers, seed));
+
+    // 文件末尾之后读到 0 字节，不是错误
+    std::vector<IoCompletion> done;
+    CHECK(engine->queue(false, fd, buffers, BLOCK_SIZE, (uint64_t)BLOCK_SIZE * BLOCK_COUNT, 1));
+    CHECK(engine->submitAndWait(1, done) == 1);
+    CHECK(done.size() == 1 && done[0].tag == 1 && done[0].result == 0);
+
+    // 只读打开的文件上写失败，完成结果是 -EBADF
+    int readOnly = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+    CHECK(readOnly >= 0);
+    done.clear();
+    CHECK(engine->queue(true, readOnly, buffers, 4096, 0, 2));
+    CHECK(engine->submitAndWait(1, done) == 1);
+    CHECK(done.size() == 1 && done[0].tag == 2 && done[0].result == -EBADF);
+    close(readOnly);
+
+    engine.reset();
+    close(fd);
+    free(buffers);
+}
+
+static StorageBenchConfig small_config(IoEngineType type) {
+    StorageBenchConfig config;
+    config.path = fixture_root;
+    config.sizeBytes = 4 << 20;
+    config.seqBlockSize = 256 << 10;
+    config.randQueueDepth = 8;
+    config.randDurationMs = 100;
+    config.engine = type;
+    return config;
+}
+
+static int count_entries(const std::string& dir) {
+    int count = 0;
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return -1;
+    }
+    while (struct dirent* entry = readdir(d)) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            count++;
+        }
+    }
+    closedir(d);
+    return count;
+}
+
+// 目录: 在临时文件上写、读、随机读，结束后目录里不留文件
+static void test_bench_directory(IoEngineType type) {
+    if (!IoEngine::create(type, 1)) {
+        return;
+    }
+    StorageBenchResult result;
+    CHECK(StorageBench(small_config(type)).run(result));
+    CHECK(result.error.empty());
+    CHECK(result.engine == IoEngine::typeName(type));
+    CHECK(result.regionBytes == (4 << 20));
+    CHECK(result.seqWriteMBps > 0 && result.seqReadMBps > 0 && result.randReadIops > 0);
+    CHECK(result.latP50Us > 0 && result.latP50Us <= result.latP99Us && result.latP99Us <= result.latP999Us);
+    CHECK(result.latP999Us <= result.latMaxUs);
+    CHECK(count_entries(fixture_root) == 0);
+}
+
+// 已有文件默认只读: 区域不超过文件长度，不测写，文件内容不变
+static void test_bench_existing_file() {
+    std::string path = fixture_root + "/existing";
+    std::vector<char> data((1 << 20) + 1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (char)(i * 7);
+    }
+    FILE* fp = fopen(path.c_str(), "w");
+    CHECK(fp != nullptr && fwrite(data.data(), 1, data.size(), fp) == data.size());
+    if (fp) {
+        fclose(fp);
+    }
+
+    StorageBenchConfig config = small_config(IO_ENGINE_SYNC);
+    config.path = path;
+    config.write = false;
+    StorageBenchResult result;
+    CHECK(StorageBench(config).run(result));
+    CHECK(result.regionBytes == (1 << 20));
+    CHECK(result.seqWriteMBps < 0 && result.seqReadMBps > 0 && result.randReadIops > 0);
+
+    std::vector<char> after(data.size());
+    fp = fopen(path.c_str(), "r");
+    CHECK(fp != nullptr && fread(after.data(), 1, after.size(), fp) == after.size());
+    if (fp) {
+        fclose(fp);
+    }
+    CHECK(after == data);
+    unlink(path.c_str());
+
+    // 比一个随机读块还小的文件没有可测的区域
+    fp = fopen(path.c_str(), "w");
+    if (fp) {
+        fputs("short", fp);
+        fclose(fp);
+    }
+    StorageBenchResult small;
+    CHECK(!StorageBench(config).run(small));
+    CHECK(small.error.find("too small") != std::string::npos);
+    unlink(path.c_str());
+}
+
+// 开始前已经置位的中断标志: 第一批完成后返回 cancelled，临时文件同样被删除
+static void test_bench_cancelled() {
+    interrupt_flag flag;
+    flag.request_stop();
+    StorageBenchResult result;
+    CHECK(!StorageBench(small_config(IO_ENGINE_AUTO)).run(result, &flag));
+    CHECK(result.error == "cancelled");
+    CHECK(result.randReadIops < 0);
+    CHECK(count_entries(fixture_root) == 0);
+}
+
+int main() {
+    char tmpl[] = "/var/tmp/storage_bench_test.XXXXXX";
+    if (mkdtemp(tmpl) == nullptr) {
+        perror("mkdtemp");
+        return 1;
+    }
+    fixture_root = tmpl;
+
+    for (IoEngineType type : ENGINES) {
+        test_engine_round_trip(type);
+        test_bench_directory(type);
+    }
+    test_bench_existing_file();
+    test_bench_cancelled();
+
+    rmdir(fixture_root.c_str());
+    log_flush();
+    return test_result("storage_bench_test");
+}
@@ -0,0 +1,30 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+
+/*
+ * 单元测试用的最小断言，失败时打印位置并计数，不中断后面的检查
+ * 每个测试程序 main 的最后 return test_result("名称");
+ */
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+            test_failures++;                                                            \
+        }                                                                               \
+    } while (0)
+
+static inline int test_result(const char* name) {
+    if (test_failures != 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: OK\n", name);
+    return 0;
+}
+
+#endif // TEST_CHECK_H
@@ -0,0 +1,151 @@
+/*
+ * hardware/UsbSysfs 的测试：在临时目录按 /sys/bus/usb/devices 的结构搭建假的 sysfs，
+ * 检查解析出的 vid / pid、速度、端口路径，以及接口目录、不完整的设备被跳过
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "hardware/UsbSysfs.h"
+#include "test_check.h"
+
+static std::string fixture_root;
+
+static void write_attr(const std::string& dir, const char* attr, const char* value) {
+    std::string path = dir + "/" + attr;
+    FILE* fp = fopen(path.c_str(), "w");
+    if (fp == nullptr) {
+        perror(path.c_str());
+        exit(1);
+    }
+    fputs(value, fp);
+    fclose(fp);
+}
+
+// sysfs 的属性文件都以换行结尾
+static std::string add_device(const std::string& parent, const char* name, const char* vid, const char* pid,
+                              const char* busnum, const char* devnum, const char* speed, const char* devpath,
+                              const char* deviceClass) {
+    std::string dir = parent + "/" + name;
+    mkdir(dir.c_str(), 0755);
+    write_attr(dir, "idVendor", (std::string(vid) + "\n").c_str());
+    write_attr(dir, "idProduct", (std::string(pid) + "\n").c_str());
+    write_attr(dir, "busnum", (std::string(busnum) + "\n").c_str());
+    write_attr(dir, "devnum", (std::string(devnum) + "\n").c_str());
+    write_attr(dir, "speed", (std::string(speed) + "\n").c_str());
+    write_attr(dir, "devpath", (std::string(devpath) + "\n").c_str());
+    write_attr(dir, "bDeviceClass", (std::string(deviceClass) + "\n").c_str());
+    return dir;
+}
+
+static void build_fixture() {
+    char tmpl[] = "/tmp/usb_sysfs_test.XXXXXX";
+    if (mkdtemp(tmpl) == nullptr) {
+        perror("mkdtemp");
+        exit(1);
+    }
+    fixture_root = tmpl;
+    std::string devices = fixture_root + "/devices";
+    std::string platform = fixture_root + "/platform";
+    mkdir(devices.c_str(), 0755);
+    mkdir(platform.c_str(), 0755);
+
+    // 故意打乱 busnum / devnum 的创建顺序，scan 要按 lsusb 的顺序排序
+    add_device(devices, "2-1", "0bda", "8153", "2", "3", "5000", "1", "00");
+    add_device(devices, "1-1.3", "046d", "c31c", "1", "6", "1.5", "1.3", "00");    // 低速键盘
+    add_device(devices, "1-1.2", "0781", "5581", "1", "5", "480", "1.2", "00");    // u 盘
+    add_device(devices, "1-1", "05e3", "0610", "1", "2", "480", "1", "09");        // hub
+    add_device(devices, "usb1", "1d6b", "0002", "1", "1", "480", "0", "09");       // root hub
+
+    // 真实的 sysfs 里设备目录是指向 /sys/devices 的符号链接
+    add_device(platform, "usb2", "1d6b", "0003", "2", "1", "5000", "0", "09");
+    symlink((platform + "/usb2").c_str(), (devices + "/usb2").c_str());
+
+    // 接口目录，即使有 idVendor 也不是设备
+    add_device(devices, "1-1.2:1.0", "0781", "5581", "1", "5", "480", "1.2", "08");
+
+    // 没有 idProduct 的目录 (读到一半被拔掉) 跳过
+    std::string partial = devices + "/1-1.4";
+    mkdir(partial.c_str(), 0755);
+    write_attr(partial, "idVendor", "1234\n");
+
+    // 没有换行结尾、缺少可选属性的设备也能解析
+    std::string bare = devices + "/2-2";
+    mkdir(bare.c_str(), 0755);
+    write_attr(bare, "idVendor", "abcd");
+    write_attr(bare, "idProduct", "ef01");
+    write_attr(bare, "busnum", "2");
+    write_attr(bare, "devnum", "4");
+}
+
+static const UsbDeviceInfo* find(const std::vector<UsbDeviceInfo>& devices, const char* name) {
+    for (const UsbDeviceInfo& info : devices) {
+        if (info.name == name) {
+            return &info;
+        }
+    }
+    return nullptr;
+}
+
+static void test_scan() {
+    UsbSysfs sysfs((fixture_root + "/devices").c_str());
+    std::vector<UsbDeviceInfo> devices;
+    CHECK(sysfs.scan(devices));
+    CHECK(devices.size() == 7);
+
+    const char* order[] = {"usb1", "1-1", "1-1.2", "1-1.3", "usb2", "2-1", "2-2"};
+    for (size_t i = 0; i < devices.size() && i < 7; ++i) {
+        CHECK(devices[i].name == order[i]);
+    }
+
+    const UsbDeviceInfo* disk = find(devices, "1-1.2");
+    CHECK(disk != nullptr);
+    if (disk != nullptr) {
+        CHECK(disk->vid == 0x0781 && disk->pid == 0x5581);
+        CHECK(disk->busnum == 1 && disk->devnum == 5);
+        CHECK(disk->speedMbps == 480);
+        CHECK(disk->devpath == "1.2");
+        CHECK(disk->deviceClass == 0);
+    }
+
+    const UsbDeviceInfo* keyboard = find(devices, "1-1.3");
+    CHECK(keyboard != nullptr && keyboard->speedMbps == 1);                 // "1.5" 取整
+
+    const UsbDeviceInfo* hub = find(devices, "1-1");
+    CHECK(hub != nullptr && hub->deviceClass == 9 && hub->devpath == "1");
+
+    const UsbDeviceInfo* root_hub = find(devices, "usb2");                  // 通过符号链接
+    CHECK(root_hub != nullptr && root_hub->vid == 0x1d6b && root_hub->pid == 0x0003 &&
+          root_hub->speedMbps == 5000 && root_hub->devpath == "0");
+
+    const UsbDeviceInfo* bare = find(devices, "2-2");
+    CHECK(bare != nullptr && bare->vid == 0xabcd && bare->pid == 0xef01 && bare->speedMbps == 0 &&
+          bare->devpath.empty());
+
+    CHECK(find(devices, "1-1.2:1.0") == nullptr);
+    CHECK(find(devices, "1-1.4") == nullptr);
+}
+
+static void test_missing_root() {
+    UsbSysfs sysfs((fixture_root + "/missing").c_str());
+    std::vector<UsbDeviceInfo> devices(1);
+    CHECK(!sysfs.scan(devices));
+    CHECK(devices.empty());
+}
+
+int main() {
+    build_fixture();
+    test_scan();
+    test_missing_root();
+
+    std::string cleanup = "rm -rf '" + fixture_root + "'";
+    if (system(cleanup.c_str()) != 0) {
+        fprintf(stderr, "can not remove %s\n", fixture_root.c_str());
+    }
+    log_flush();
+    return test_result("usb_sysfs_test");
+}
@@ -0,0 +1,190 @@
+/*
+ * 日志性能测试：对比当前的环形缓冲区日志和原来的 thread_pool(1) + std::cout 日志
+ * 原来的实现在本文件中按原样保留一份 (legacy_log)，只用于对比
+ *
+ * 用法: log_bench [-n 每个线程的条数] [-t 线程数] > /dev/null
+ *   日志本身输出到 stdout，结果输出到 stderr
+ *   调用耗时: 调用线程在 log 调用上花费的平均时间 (热路径)
+ *     环形缓冲区 128KB，-n 超过约 2000 条后缓冲区写满，调用耗时就等于输出线程的速度
+ *     看热路径用 -n 1000，看满载时的表现用默认值
+ *   持续吞吐: 从第一条写入到全部输出完成，平均每行的时间 (含格式化和输出)
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <chrono>
+#include <ctime>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/Clock.h"
+#include "util/Log.h"
+#include "util/theradpoolv1/thread_pool.h"
+
+static const char* BENCH_TAG = "LogBench";
+
+// ---- 原来的实现：两次 vsnprintf + std::string + std::function 投递到 thread_pool(1)，每行 std::endl ----
+
+static thread_pool* legacy_thread = nullptr;
+
+static std::string legacy_current_time() {
+    auto now = std::chrono::system_clock::now();
+    auto in_time_t = std::chrono::system_clock::to_time_t(now);
+
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %H:%M:%S");
+    return ss.str();
+}
+
+static void legacy_output_str(LogLevel level, const char* TAG, const std::string& msg) {
+    const char* level_str;
+    switch (level) {
+        case LOG_LEVEL_DEBUG: level_str = "DEBUG"; break;
+        case LOG_LEVEL_INFO:  level_str = "INFO ";  break;
+        case LOG_LEVEL_WARN:  level_str = "WARN ";  break;
+        case LOG_LEVEL_ERROR: level_str = "ERROR"; break;
+        default:              level_str = "UNKNOWN";
+    }
+
+    std::cout << "[" << legacy_current_time()
+              << "] [" << level_str
+              << "] [" << TAG << "] "
+              << msg << std::endl;
+}
+
+static void legacy_log(LogLevel level, const char* TAG, const char* format, ...) LOG_FORMAT_CHECK(3, 4);
+static void legacy_log(LogLevel level, const char* TAG, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int needed = vsnprintf(nullptr, 0, format, args_copy);
+    va_end(args_copy);
+
+    std::string msg(needed + 1, '\0');
+    vsnprintf(&msg[0], needed + 1, format, args);
+    va_end(args);
+    msg.resize(needed);
+
+    legacy_thread->submit([level, TAG, msg]() {
+        legacy_output_str(level, TAG, msg);
+    });
+}
+
+// 等原来的日志线程把已投递的日志输出完
+static void legacy_flush() {
+    legacy_thread->submit([]() {
+        std::cout.flush();
+    }).get();
+}
+
+// ---- 测试 ----
+
+struct bench_result {
+    double call_ns;                 // 每次调用的平均耗时
+    double line_us;                 // 持续吞吐，每行耗时
+};
+
+enum bench_case {
+    CASE_ARGS,                      // "%s %d %.2f"
+    CASE_NO_ARGS
+};
+
+template<typename LogFn, typename FlushFn>
+static bench_result run(int threads, long count, bench_case which, LogFn log, FlushFn flush) {
+    std::vector<uint64_t> call_ns(threads, 0);
+    std::vector<std::thread> workers;
+    uint64_t start = monotonic_ns();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t, count, which, log, &call_ns]() {
+            const char* name = "storage";
+            uint64_t begin = monotonic_ns();
+            for (long i = 0; i < count; ++i) {
+                if (which == CASE_ARGS) {
+                    log(name, (int)i, i * 0.5);
+                } else {
+                    log(nullptr, 0, 0.0);
+                }
+            }
+            call_ns[t] = monotonic_ns() - begin;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    flush();
+    uint64_t total = monotonic_ns() - start;
+
+    uint64_t calls = 0;
+    for (uint64_t ns : call_ns) {
+        calls += ns;
+    }
+    bench_result result;
+    result.call_ns = (double)calls / threads / count;
+    result.line_us = (double)total / 1000.0 / ((double)threads * count);
+    return result;
+}
+
+static void report(const char* name, const bench_result& current, const bench_result& legacy) {
+    fprintf(stderr, "%-22s call %8.1f ns (legacy %8.1f ns, x%.1f)   sustained %6.2f us/line (legacy %6.2f us/line, x%.1f)\n",
+            name, current.call_ns, legacy.call_ns, legacy.call_ns / current.call_ns,
+            current.line_us, legacy.line_us, legacy.line_us / current.line_us);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-n count] [-t threads] > /dev/null\n", name);
+    fprintf(stderr, "  -n count    lines per thread, default 100000\n");
+    fprintf(stderr, "  -t threads  logging threads, default 1\n");
+}
+
+int main(int argc, char* argv[]) {
+    long count = 100000;
+    int threads = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:h")) != -1) {
+        switch (opt) {
+            case 'n': count = strtol(optarg, nullptr, 10); break;
+            case 't': threads = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (count <= 0 || threads <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    legacy_thread = new thread_pool(1);
+
+    auto current_args = [](const char* name, int i, double v) {
+        log_thread_safe(LOG_LEVEL_INFO, BENCH_TAG, "disk %s read %d blocks, %.2f MB/s", name, i, v);
+    };
+    auto current_plain = [](const char*, int, double) {
+        log_thread_safe(LOG_LEVEL_INFO, BENCH_TAG, "storage test started");
+    };
+    auto legacy_args = [](const char* name, int i, double v) {
+        legacy_log(LOG_LEVEL_INFO, BENCH_TAG, "disk %s read %d blocks, %.2f MB/s", name, i, v);
+    };
+    auto legacy_plain = [](const char*, int, double) {
+        legacy_log(LOG_LEVEL_INFO, BENCH_TAG, "storage test started");
+    };
+
+    fprintf(stderr, "%ld lines x %d thread(s)\n", count, threads);
+    bench_result a = run(threads, count, CASE_ARGS, current_args, log_flush);
+    bench_result b = run(threads, count, CASE_ARGS, legacy_args, legacy_flush);
+    report("3 args (%s %d %.2f)", a, b);
+
+    a = run(threads, count, CASE_NO_ARGS, current_plain, log_flush);
+    b = run(threads, count, CASE_NO_ARGS, legacy_plain, legacy_flush);
+    report("no args", a, b);
+    return 0;
+}
@@ -0,0 +1,425 @@
+/*
+ * 结构化日志 (JsonLogSink 输出的 JSON Lines) 的索引 / 检索工具
+ * 为每个日志文件建立 <文件>.idx，按 (LN, cmdIndex) 记录连续日志行的 偏移 + 长度，
+ * 索引按 (LN, cmdIndex, 偏移) 排序，查询时二分查找命中的索引，只读取命中的部分，不用整个文件扫描；
+ * 日志追加后只索引新增部分，文件被替换 (inode 变化) 时重建。
+ * .idx 每行一条索引，字段用 tab 分隔，LN 是解码后的原文，其中的 \ tab 换行 转义为 \\ \t \n。
+ * 多块板卡、多天的日志放在一起时直接传入所有文件即可。
+ *
+ * 用法: log_index [-l LN] [-c cmdIndex] [-s] file...
+ *   -l LN        只输出该板卡的日志
+ *   -c cmdIndex  只输出该命令的日志
+ *   -s           不输出日志，统计每个 (LN, cmdIndex) 的行数；没有 -l / -c 时默认如此
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+static const char* INDEX_MAGIC = "ZYLOGIDX";
+static const int INDEX_VERSION = 2;                    // v2: 按 key 排序，LN 解码后转义保存
+
+struct index_entry {
+    std::string ln;
+    int cmd;
+    uint64_t offset;
+    uint64_t length;
+    uint64_t lines;
+};
+
+// 按 (LN, cmdIndex, 偏移) 排序，同一个 key 的索引按文件中的顺序相邻
+static bool entry_less(const index_entry& a, const index_entry& b) {
+    int diff = a.ln.compare(b.ln);
+    if (diff != 0) {
+        return diff < 0;
+    }
+    if (a.cmd != b.cmd) {
+        return a.cmd < b.cmd;
+    }
+    return a.offset < b.offset;
+}
+
+struct file_index {
+    uint64_t inode;
+    uint64_t indexed_size;                      // 已经建立索引的文件长度 (整行)
+    std::vector<index_entry> entries;            // 按 entry_less 排序
+};
+
+// 取出一行中的 cmd 和 ln 字段，字段顺序由 JsonLogSink 固定
+static bool parse_line(const char* line, size_t len, std::string& ln, int& cmd) {
+    std::string text(line, len);
+    size_t pos = text.find(",\"cmd\":");
+    if (pos == std::string::npos) {
+        return false;
+    }
+    cmd = atoi(text.c_str() + pos + 7);
+
+    pos = text.find(",\"ln\":\"", pos);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos += 7;
+    ln.clear();
+    while (pos < text.size() && text[pos] != '"') {
+        char c = text[pos++];
+        if (c != '\\') {
+            ln += c;
+            continue;
+        }
+        if (pos >= text.size()) {
+            return false;
+        }
+        c = text[pos++];
+        switch (c) {
+            case 'n': ln += '\n'; break;
+            case 'r': ln += '\r'; break;
+            case 't': ln += '\t'; break;
+            case 'b': ln += '\b'; break;
+            case 'f': ln += '\f'; break;
+            case 'u': {
+                if (pos + 4 > text.size()) {
+                    return false;
+                }
+                unsigned code = strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+                pos += 4;
+                if (code < 0x80) {                                          // JsonLogSink 只对控制字符用 \u
+                    ln += (char)code;
+                } else if (code < 0x800) {
+                    ln += (char)(0xc0 | (code >> 6));
+                    ln += (char)(0x80 | (code & 0x3f));
+                } else {
+                    ln += (char)(0xe0 | (code >> 12));
+                    ln += (char)(0x80 | ((code >> 6) & 0x3f));
+                    ln += (char)(0x80 | (code & 0x3f));
+                }
+                break;
+            }
+            default: ln += c; break;                                        // \" \\ \/
+        }
+    }
+    return pos < text.size();
+}
+
+// .idx 中的 LN 字段: 空串写成 "-"，"-" 本身写成 "\-"，\ tab 换行 转义
+static std::string escape_field(const std::string& ln) {
+    if (ln.empty()) {
+        return "-";
+    }
+    if (ln == "-") {
+        return "\\-";
+    }
+    std::string out;
+    for (char c : ln) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            default:   out += c; break;
+        }
+    }
+    return out;
+}
+
+static std::string unescape_field(const char* field) {
+    if (strcmp(field, "-") == 0) {
+        return "";
+    }
+    std::string out;
+    for (const char* p = field; *p != '\0'; ++p) {
+        if (*p != '\\' || p[1] == '\0') {
+            out += *p;
+            continue;
+        }
+        ++p;
+        switch (*p) {
+            case 't': out += '\t'; break;
+            case 'n': out += '\n'; break;
+            default:  out += *p; break;                                     // \\ \-
+        }
+    }
+    return out;
+}
+
+static bool load_index(const std::string& path, file_index& index) {
+    FILE* fp = fopen(path.c_str(), "r");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    char magic[16];
+    int version;
+    unsigned long long inode;
+    unsigned long long size;
+    if (fscanf(fp, "%15s %d %llu %llu\n", magic, &version, &inode, &size) != 4 ||
+        strcmp(magic, INDEX_MAGIC) != 0 || version != INDEX_VERSION) {
+        fclose(fp);
+        return false;
+    }
+    index.inode = inode;
+    index.indexed_size = size;
+    index.entries.clear();
+
+    char* line = nullptr;
+    size_t capacity = 0;
+    ssize_t len;
+    while ((len = getline(&line, &capacity, fp)) > 0) {
+        if (line[len - 1] == '\n') {
+            line[len - 1] = '\0';
+        }
+        char* fields[5];
+        int count = 0;
+        char* save = nullptr;
+        for (char* token = strtok_r(line, "\t", &save); token != nullptr && count < 5;
+             token = strtok_r(nullptr, "\t", &save)) {
+            fields[count++] = token;
+        }
+        if (count != 5) {
+            continue;
+        }
+        index_entry entry;
+        entry.ln = unescape_field(fields[0]);
+        entry.cmd = atoi(fields[1]);
+        entry.offset = strtoull(fields[2], nullptr, 10);
+        entry.length = strtoull(fields[3], nullptr, 10);
+        entry.lines = strtoull(fields[4], nullptr, 10);
+        index.entries.push_back(entry);
+    }
+    free(line);
+    fclose(fp);
+
+    if (!std::is_sorted(index.entries.begin(), index.entries.end(), entry_less)) {
+        std::sort(index.entries.begin(), index.entries.end(), entry_less);    // 手工改过的索引
+    }
+    return true;
+}
+
+static bool save_index(const std::string& path, const file_index& index) {
+    std::string tmp = path + ".tmp";
+    FILE* fp = fopen(tmp.c_str(), "w");
+    if (fp == nullptr) {
+        return false;
+    }
+    fprintf(fp, "%s %d %llu %llu\n", INDEX_MAGIC, INDEX_VERSION, (unsigned long long)index.inode,
+            (unsigned long long)index.indexed_size);
+    for (const index_entry& entry : index.entries) {
+        fprintf(fp, "%s\t%d\t%llu\t%llu\t%llu\n", escape_field(entry.ln).c_str(), entry.cmd,
+                (unsigned long long)entry.offset, (unsigned long long)entry.length,
+                (unsigned long long)entry.lines);
+    }
+    bool ok = fclose(fp) == 0;
+    return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+/*
+ * 建立或更新日志文件的索引
+ * 同一个 (LN, cmdIndex) 的连续行合并为一条索引，新增的索引排序后归并进已有的索引
+ */
+static bool update_index(const std::string& log_path, file_index& index) {
+    int fd = open(log_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "log_index: open %s failed: %s\n", log_path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    std::string index_path = log_path + ".idx";
+    if (!load_index(index_path, index) || index.inode != (uint64_t)st.st_ino ||
+        index.indexed_size > (uint64_t)st.st_size) {
+        index.inode = st.st_ino;                                            // 新文件或被替换 / 截断，重建
+        index.indexed_size = 0;
+        index.entries.clear();
+    }
+    if (index.indexed_size == (uint64_t)st.st_size) {
+        close(fd);
+        return true;
+    }
+
+    std::vector<char> buffer(1024 * 1024);
+    std::string pending;                                                    // 跨越读缓冲区的半行
+    uint64_t line_offset = index.indexed_size;
+    uint64_t read_offset = index.indexed_size;
+    std::string ln;
+    int cmd;
+
+    // 文件末尾的那条索引，新增的第一行可能要合并进去；排序后它不一定在最后
+    index_entry* tail = nullptr;
+    for (index_entry& entry : index.entries) {
+        if (entry.offset + entry.length == index.indexed_size) {
+            tail = &entry;
+            break;
+        }
+    }
+    std::vector<index_entry> added;
+
+    while (true) {
+        ssize_t n = pread(fd, buffer.data(), buffer.size(), read_offset);
+        if (n <= 0) {
+            break;
+        }
+        read_offset += n;
+
+        size_t start = 0;
+        for (size_t i = 0; i < (size_t)n; ++i) {
+            if (buffer[i] != '\n') {
+                continue;
+            }
+            pending.append(buffer.data() + start, i - start + 1);
+            start = i + 1;
+
+            uint64_t length = pending.size();
+            if (parse_line(pending.data(), pending.size(), ln, cmd)) {
+                index_entry* last = added.empty() ? tail : &added.back();
+                if (last != nullptr && last->ln == ln && last->cmd == cmd &&
+                    last->offset + last->length == line_offset) {
+                    last->length += length;                                 // 偏移不变，排序位置也不变
+                    last->lines++;
+                } else {
+                    added.push_back({ln, cmd, line_offset, length, 1});
+                }
+            }
+            line_offset += length;
+            pending.clear();
+        }
+        pending.append(buffer.data() + start, n - start);
+    }
+    close(fd);
+
+    std::sort(added.begin(), added.end(), entry_less);
+    size_t old_count = index.entries.size();
+    index.entries.insert(index.entries.end(), added.begin(), added.end());
+    std::inplace_merge(index.entries.begin(), index.entries.begin() + old_count, index.entries.end(), entry_less);
+
+    index.indexed_size = line_offset;                                       // 最后不完整的一行下次再索引
+    if (!save_index(index_path, index)) {
+        fprintf(stderr, "log_index: cannot write %s, index not cached\n", index_path.c_str());
+    }
+    return true;
+}
+
+struct ln_less {
+    bool operator()(const index_entry& entry, const std::string& ln) const { return entry.ln < ln; }
+    bool operator()(const std::string& ln, const index_entry& entry) const { return ln < entry.ln; }
+};
+
+struct cmd_less {
+    bool operator()(const index_entry& entry, int cmd) const { return entry.cmd < cmd; }
+    bool operator()(int cmd, const index_entry& entry) const { return cmd < entry.cmd; }
+};
+
+/*
+ * 二分查找命中的索引，ln 为 nullptr / cmd < -1 表示不过滤
+ * 只给 cmdIndex 时在每个 LN 的区间里分别二分，LN 的数量就是板卡数
+ */
+static std::vector<const index_entry*> find_entries(const file_index& index, const char* ln, int cmd) {
+    std::vector<const index_entry*> result;
+    auto begin = index.entries.begin();
+    auto end = index.entries.end();
+    if (ln != nullptr) {
+        auto range = std::equal_range(begin, end, std::string(ln), ln_less());
+        begin = range.first;
+        end = range.second;
+    }
+
+    auto it = begin;
+    while (it != end) {
+        auto ln_end = std::upper_bound(it, end, it->ln, ln_less());
+        auto range = cmd < -1 ? std::make_pair(it, ln_end) : std::equal_range(it, ln_end, cmd, cmd_less());
+        for (auto match = range.first; match != range.second; ++match) {
+            result.push_back(&*match);
+        }
+        it = ln_end;
+    }
+    return result;
+}
+
+static void print_entries(const std::string& log_path, const file_index& index, const char* ln, int cmd) {
+    int fd = -1;
+    std::vector<char> buffer;
+    std::vector<const index_entry*> matches = find_entries(index, ln, cmd);
+    std::sort(matches.begin(), matches.end(), [](const index_entry* a, const index_entry* b) {
+        return a->offset < b->offset;                                       // 按文件中的顺序输出
+    });
+    for (const index_entry* match : matches) {
+        const index_entry& entry = *match;
+        if (fd < 0 && (fd = open(log_path.c_str(), O_RDONLY | O_CLOEXEC)) < 0) {
+            return;
+        }
+        buffer.resize(entry.length);
+        if (pread(fd, buffer.data(), entry.length, entry.offset) == (ssize_t)entry.length) {
+            fwrite(buffer.data(), 1, entry.length, stdout);
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-l LN] [-c cmdIndex] [-s] file...\n", name);
+    fprintf(stderr, "  -l LN        only print lines of this board\n");
+    fprintf(stderr, "  -c cmdIndex  only print lines of this command\n");
+    fprintf(stderr, "  -s           print line counts per (LN, cmdIndex), default without -l/-c\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* ln = nullptr;
+    int cmd = -2;                                                           // -1 是合法值 (没有关联 cmdIndex 的日志)
+    bool summary = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "l:c:sh")) != -1) {
+        switch (opt) {
+            case 'l': ln = optarg; break;
+            case 'c': cmd = atoi(optarg); break;
+            case 's': summary = true; break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (ln == nullptr && cmd == -2) {
+        summary = true;
+    }
+
+    std::map<std::pair<std::string, int>, uint64_t> counts;
+    int ret = 0;
+    for (int i = optind; i < argc; ++i) {
+        file_index index;
+        if (!update_index(argv[i], index)) {
+            ret = 1;
+            continue;
+        }
+        if (!summary) {
+            print_entries(argv[i], index, ln, cmd);
+            continue;
+        }
+        for (const index_entry* entry : find_entries(index, ln, cmd)) {
+            counts[std::make_pair(entry->ln, entry->cmd)] += entry->lines;
+        }
+    }
+
+    if (summary) {
+        printf("%-24s %8s %10s\n", "LN", "cmdIndex", "lines");
+        for (const auto& item : counts) {
+            printf("%-24s %8d %10llu\n", escape_field(item.first.first).c_str(),
+                   item.first.second, (unsigned long long)item.second);
+        }
+    }
+    return ret;
+}
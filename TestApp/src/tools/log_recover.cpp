@@ -0,0 +1,73 @@
+/*
+ * 从持久化日志环形缓冲区 (默认 /var/log/test_app.ring) 中导出日志
+ * 板卡掉电或程序崩溃后，test_app.log 里最后几秒的日志可能丢失，用这个工具找回
+ *
+ * 用法: log_recover [-n 行数] [-l] [-r] [文件]
+ *   -n N  只输出最后 N 行
+ *   -l    只输出最后一次运行的日志
+ *   -r    在每次运行的日志前输出分隔行
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "common/Constants.h"
+#include "util/LogPersist.h"
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-n lines] [-l] [-r] [file]\n", name);
+    fprintf(stderr, "  -n lines  only print the last N lines\n");
+    fprintf(stderr, "  -l        only print the last run\n");
+    fprintf(stderr, "  -r        print a separator before each run\n");
+    fprintf(stderr, "  file      ring file, default %s\n", LOG_RING_FILE_PATH);
+}
+
+int main(int argc, char* argv[]) {
+    long tail = -1;
+    bool last_run = false;
+    bool separator = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:lrh")) != -1) {
+        switch (opt) {
+            case 'n': tail = strtol(optarg, nullptr, 10); break;
+            case 'l': last_run = true; break;
+            case 'r': separator = true; break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    std::string path = optind < argc ? argv[optind] : LOG_RING_FILE_PATH;
+
+    std::vector<PersistentLogSink::record> records;
+    if (!PersistentLogSink::recover(path, records)) {
+        fprintf(stderr, "%s: cannot read log ring %s\n", argv[0], path.c_str());
+        return 1;
+    }
+
+    size_t begin = 0;
+    if (last_run && !records.empty()) {
+        uint32_t run = records.back().run;
+        begin = records.size();
+        while (begin > 0 && records[begin - 1].run == run) {
+            begin--;
+        }
+    }
+    if (tail >= 0 && records.size() - begin > (size_t)tail) {
+        begin = records.size() - tail;
+    }
+
+    uint32_t current_run = 0;
+    for (size_t i = begin; i < records.size(); ++i) {
+        if (separator && (i == begin || records[i].run != current_run)) {
+            printf("======== run %u (seq %llu) ========\n", records[i].run, (unsigned long long)records[i].seq);
+        }
+        current_run = records[i].run;
+        fwrite(records[i].line.data(), 1, records[i].line.size(), stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include "util/AsyncWait.h"
+#include "util/Log.h"
+
+#include <exception>
+#include <libudev.h>
+
+void AsyncTask::promise_type::unhandled_exception() noexcept {
+    try {
+        throw;
+    } catch (const std::exception& e) {
+        log_thread_safe(LOG_LEVEL_ERROR, "AsyncTask", "coroutine exited with exception: %s", e.what());
+    } catch (...) {
+        log_thread_safe(LOG_LEVEL_ERROR, "AsyncTask", "coroutine exited with unknown exception");
+    }
+}
+
+UdevMonitor::UdevMonitor(const char* subsystem, const char* devtype) : udev_(nullptr), monitor_(nullptr) {
+    udev_ = udev_new();
+    if (udev_ == nullptr) {
+        log_thread_safe(LOG_LEVEL_ERROR, "UdevMonitor", "udev_new failed");
+        return;
+    }
+    monitor_ = udev_monitor_new_from_netlink(udev_, "udev");
+    if (monitor_ == nullptr) {
+        log_thread_safe(LOG_LEVEL_ERROR, "UdevMonitor", "udev_monitor_new_from_netlink failed");
+        return;
+    }
+    udev_monitor_filter_add_match_subsystem_devtype(monitor_, subsystem, devtype);
+    if (udev_monitor_enable_receiving(monitor_) < 0) {
+        log_thread_safe(LOG_LEVEL_ERROR, "UdevMonitor", "udev_monitor_enable_receiving failed");
+        udev_monitor_unref(monitor_);
+        monitor_ = nullptr;
+    }
+}
+
+UdevMonitor::~UdevMonitor() {
+    if (monitor_ != nullptr) {
+        udev_monitor_unref(monitor_);
+    }
+    if (udev_ != nullptr) {
+        udev_unref(udev_);
+    }
+}
+
+int UdevMonitor::fd() const {
+    return monitor_ != nullptr ? udev_monitor_get_fd(monitor_) : -1;
+}
+
+bool UdevMonitor::receive(std::string& action, std::string& devnode) {
+    if (monitor_ == nullptr) {
+        return false;
+    }
+    struct udev_device* dev = udev_monitor_receive_device(monitor_);       // socket 为非阻塞，没有事件时返回 nullptr
+    if (dev == nullptr) {
+        return false;
+    }
+    const char* act = udev_device_get_action(dev);
+    const char* node = udev_device_get_devnode(dev);
+    action = act ? act : "";
+    devnode = node ? node : "";
+    udev_device_unref(dev);
+    return true;
+}
+
+AsyncWaiter::AsyncWaiter(Reactor& reactor, TimerWheel& wheel) : reactor_(reactor), wheel_(wheel) {
+
+}
+
+void AsyncWaiter::wait_fds(const std::vector<int>& fds, uint32_t events, int timeout_ms,
+                           std::shared_ptr<interrupt_flag> flag, wait_callback callback) {
+    auto op = std::make_shared<wait_op>();
+    op->fds = fds;
+    op->timeout_ms = timeout_ms;
+    op->deadline_timer = 0;
+    op->cancel_timer = 0;
+    op->flag = flag;
+    op->callback = std::move(callback);
+    op->done = false;
+    op->log_cmd_index = log_cmd_index();
+
+    // 注册统一在 reactor 线程中进行，避免注册到一半时回调已经触发
+    reactor_.post([this, op, events]() {
+        arm(op, events);
+    });
+}
+
+void AsyncWaiter::wait_fd(int fd, uint32_t events, int timeout_ms,
+                          std::shared_ptr<interrupt_flag> flag, wait_callback callback) {
+    wait_fds(std::vector<int>{fd}, events, timeout_ms, flag, std::move(callback));
+}
+
+void AsyncWaiter::sleep_for(int timeout_ms, std::shared_ptr<interrupt_flag> flag,
+                            std::function<void(AsyncWaitResult result)> callback) {
+    wait_fds(std::vector<int>(), 0, timeout_ms < 0 ? 0 : timeout_ms, flag,
+             [callback](AsyncWaitResult result, int fd) {
+                 callback(result);
+             });
+}
+
+void AsyncWaiter::wait_udev(UdevMonitor& monitor, int timeout_ms, std::shared_ptr<interrupt_flag> flag,
+                            udev_callback callback) {
+    if (!monitor.is_open()) {
+        reactor_.post([callback]() { callback(ASYNC_WAIT_ERROR, "", ""); });
+        return;
+    }
+
+    UdevMonitor* mon = &monitor;
+    wait_fd(monitor.fd(), EPOLLIN, timeout_ms, flag, [mon, callback](AsyncWaitResult result, int fd) {
+        std::string action;
+        std::string devnode;
+        if (result == ASYNC_WAIT_READY && !mon->receive(action, devnode)) {
+            result = ASYNC_WAIT_ERROR;
+        }
+        callback(result, action, devnode);
+    });
+}
+
+std::function<void()> AsyncWaiter::wait_notify(int timeout_ms, std::shared_ptr<interrupt_flag> flag,
+                                               std::function<void(AsyncWaitResult result)> callback) {
+    auto op = std::make_shared<wait_op>();
+    op->timeout_ms = timeout_ms;
+    op->deadline_timer = 0;
+    op->cancel_timer = 0;
+    op->flag = flag;
+    op->callback = [callback](AsyncWaitResult result, int fd) {
+        callback(result);
+    };
+    op->done = false;
+    op->log_cmd_index = log_cmd_index();
+
+    reactor_.post([this, op]() {
+        arm(op, 0);
+    });
+    return [this, op]() {
+        finish(op, ASYNC_WAIT_READY, -1);
+    };
+}
+
+void AsyncWaiter::post(std::function<void()> fn) {
+    int cmd_index = log_cmd_index();
+    reactor_.post([cmd_index, fn]() {
+        LogCmdScope log_scope(cmd_index);
+        fn();
+    });
+}
+
+void AsyncWaiter::run_blocking(thread_pool& pool, std::function<void()> work, std::function<void()> done) {
+    int cmd_index = log_cmd_index();
+    pool.submit([this, cmd_index, work, done]() {
+        {
+            LogCmdScope log_scope(cmd_index);
+            work();
+        }
+        reactor_.post([cmd_index, done]() {
+            LogCmdScope log_scope(cmd_index);
+            done();
+        });
+    });
+}
+
+AsyncAwaitable<AsyncWaiter::fd_event> AsyncWaiter::wait_fds(const std::vector<int>& fds, uint32_t events, int timeout_ms,
+                                                            std::shared_ptr<interrupt_flag> flag) {
+    return AsyncAwaitable<fd_event>([this, fds, events, timeout_ms, flag](std::function<void(fd_event)> resume) {
+        wait_fds(fds, events, timeout_ms, flag, [resume](AsyncWaitResult result, int fd) {
+            resume(fd_event{result, fd});
+        });
+    });
+}
+
+AsyncAwaitable<AsyncWaitResult> AsyncWaiter::sleep_for(int timeout_ms, std::shared_ptr<interrupt_flag> flag) {
+    return AsyncAwaitable<AsyncWaitResult>([this, timeout_ms, flag](std::function<void(AsyncWaitResult)> resume) {
+        sleep_for(timeout_ms, flag, resume);
+    });
+}
+
+AsyncAwaitable<AsyncWaiter::udev_event> AsyncWaiter::wait_udev(UdevMonitor& monitor, int timeout_ms,
+                                                               std::shared_ptr<interrupt_flag> flag) {
+    UdevMonitor* mon = &monitor;
+    return AsyncAwaitable<udev_event>([this, mon, timeout_ms, flag](std::function<void(udev_event)> resume) {
+        wait_udev(*mon, timeout_ms, flag, [resume](AsyncWaitResult result, const std::string& action,
+                                                   const std::string& devnode) {
+            resume(udev_event{result, action, devnode});
+        });
+    });
+}
+
+AsyncAwaitable<AsyncWaitResult> AsyncWaiter::run_blocking(thread_pool& pool, std::function<void()> work) {
+    return AsyncAwaitable<AsyncWaitResult>([this, &pool, work](std::function<void(AsyncWaitResult)> resume) {
+        run_blocking(pool, work, [resume]() {
+            resume(ASYNC_WAIT_READY);
+        });
+    });
+}
+
+void AsyncWaiter::arm(std::shared_ptr<wait_op> op, uint32_t events) {
+    // 定时器回调同样在 reactor 线程中执行，op 只在 reactor 线程中访问
+    if (op->done) {                                                         // wait_notify 在登记之前就被通知了
+        return;
+    }
+    if (op->timeout_ms >= 0) {
+        op->deadline_timer = wheel_.schedule_once(op->timeout_ms, [this, op]() {
+            finish(op, ASYNC_WAIT_TIMEOUT, -1);
+        });
+    }
+    if (op->flag) {
+        op->cancel_timer = wheel_.schedule_periodic(CANCEL_CHECK_MS, [this, op]() {
+            if (op->flag->is_stop_requested()) {
+                finish(op, ASYNC_WAIT_CANCELLED, -1);
+            }
+        });
+    }
+
+    for (int fd : op->fds) {
+        bool ok = reactor_.add_fd(fd, events, [this, op, fd](uint32_t ev) {
+            if (!op->done) {
+                finish(op, (ev & (EPOLLERR | EPOLLHUP)) && !(ev & EPOLLIN) ? ASYNC_WAIT_ERROR : ASYNC_WAIT_READY,
+                       fd);
+            }
+        });
+        if (!ok) {
+            finish(op, ASYNC_WAIT_ERROR, -1);
+            return;
+        }
+    }
+}
+
+void AsyncWaiter::finish(std::shared_ptr<wait_op> op, AsyncWaitResult result, int fd) {
+    if (op->done) {
+        return;
+    }
+    op->done = true;
+
+    for (int wait_fd : op->fds) {
+        reactor_.remove_fd(wait_fd);
+    }
+    if (op->deadline_timer != 0) {
+        wheel_.cancel(op->deadline_timer);
+    }
+    if (op->cancel_timer != 0) {
+        wheel_.cancel(op->cancel_timer);
+    }
+
+    wait_callback callback = std::move(op->callback);                      // 回调中可能再次发起等待，先释放本次的状态
+    op->callback = nullptr;
+    if (callback) {
+        LogCmdScope log_scope(op->log_cmd_index);
+        callback(result, fd);
+    }
+}
@@ -0,0 +1,919 @@
+#include "util/JsonDom.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int JSON_DOM_MAX_DEPTH = 64;
+
+/* ---------------- JsonArena ---------------- */
+
+JsonArena::JsonArena(size_t block_size)
+    : block_size_(block_size < 256 ? 256 : block_size), head_(nullptr), current_(nullptr), offset_(0), used_(0) {}
+
+JsonArena::~JsonArena() {
+    block* b = head_;
+    while (b != nullptr) {
+        block* next = b->next;
+        free(b);
+        b = next;
+    }
+}
+
+void* JsonArena::allocate(size_t size, size_t align) {
+    size_t header = (sizeof(block) + 15) & ~(size_t)15;
+    while (true) {
+        if (current_ != nullptr) {
+            size_t offset = (offset_ + align - 1) & ~(align - 1);
+            if (offset + size <= current_->size) {
+                offset_ = offset + size;
+                return (char*)current_ + header + offset;
+            }
+            // 当前块不够，换下一个已有的块
+            if (current_->next != nullptr) {
+                used_ += offset_;
+                current_ = current_->next;
+                offset_ = 0;
+                continue;
+            }
+        }
+
+        size_t capacity = std::max(block_size_, size + align);
+        block* b = (block*)malloc(header + capacity);
+        if (b == nullptr) {
+            throw std::bad_alloc();
+        }
+        b->next = nullptr;
+        b->size = capacity;
+        if (current_ == nullptr) {
+            head_ = b;
+        } else {
+            used_ += offset_;
+            current_->next = b;
+        }
+        current_ = b;
+        offset_ = 0;
+    }
+}
+
+void JsonArena::reset() {
+    current_ = head_;
+    offset_ = 0;
+    used_ = 0;
+}
+
+size_t JsonArena::used() const {
+    return used_ + offset_;
+}
+
+size_t JsonArena::reserved() const {
+    size_t total = 0;
+    for (block* b = head_; b != nullptr; b = b->next) {
+        total += b->size;
+    }
+    return total;
+}
+
+/* ---------------- JsonNode ---------------- */
+
+const JsonNode& JsonNode::null_node() {
+    static const JsonNode node;
+    return node;
+}
+
+bool JsonNode::as_bool() const {
+    switch (type()) {
+        case BOOL_VALUE: return large_.b;
+        case INT_VALUE: return large_.i != 0;
+        case UINT_VALUE: return large_.u != 0;
+        case REAL_VALUE: return large_.d != 0.0 && !std::isnan(large_.d);
+        default: return false;
+    }
+}
+
+int64_t JsonNode::as_int64() const {
+    switch (type()) {
+        case BOOL_VALUE: return large_.b ? 1 : 0;
+        case INT_VALUE: return large_.i;
+        case UINT_VALUE: return (int64_t)large_.u;
+        case REAL_VALUE: return (int64_t)large_.d;
+        default: return 0;
+    }
+}
+
+uint64_t JsonNode::as_uint64() const {
+    switch (type()) {
+        case BOOL_VALUE: return large_.b ? 1 : 0;
+        case INT_VALUE: return (uint64_t)large_.i;
+        case UINT_VALUE: return large_.u;
+        case REAL_VALUE: return (uint64_t)large_.d;
+        default: return 0;
+    }
+}
+
+double JsonNode::as_double() const {
+    switch (type()) {
+        case BOOL_VALUE: return large_.b ? 1.0 : 0.0;
+        case INT_VALUE: return (double)large_.i;
+        case UINT_VALUE: return (double)large_.u;
+        case REAL_VALUE: return large_.d;
+        default: return 0.0;
+    }
+}
+
+std::string JsonNode::as_string() const {
+    switch (type()) {
+        case STRING_VALUE: return std::string(str(), str_size());
+        case BOOL_VALUE: return large_.b ? "true" : "false";
+        case NULL_VALUE: return "";
+        default: {
+            std::string out;
+            JsonDocument::write(*this, out);
+            return out;
+        }
+    }
+}
+
+const char* JsonNode::str() const {
+    if (type() != STRING_VALUE) {
+        return "";
+    }
+    return small_.size == LONG_STRING ? large_.str : small_.chars;
+}
+
+size_t JsonNode::str_size() const {
+    if (type() != STRING_VALUE) {
+        return 0;
+    }
+    return small_.size == LONG_STRING ? large_.size : small_.size;
+}
+
+bool JsonNode::equals(const char* s, size_t size) const {
+    return str_size() == size && memcmp(str(), s, size) == 0;
+}
+
+size_t JsonNode::size() const {
+    return type() == ARRAY_VALUE || type() == OBJECT_VALUE ? large_.size : 0;
+}
+
+const JsonNode& JsonNode::operator[](size_t index) const {
+    if (type() != ARRAY_VALUE || index >= large_.size) {
+        return null_node();
+    }
+    return large_.items[index];
+}
+
+// 和 jsoncpp 的 CZString 排序相同: 按字节比较，前缀相同时短的在前
+static int compare_key(const char* a, size_t a_size, const char* b, size_t b_size) {
+    int ret = memcmp(a, b, std::min(a_size, b_size));
+    if (ret != 0) {
+        return ret;
+    }
+    return a_size < b_size ? -1 : (a_size > b_size ? 1 : 0);
+}
+
+const JsonNode* JsonNode::find(const char* key, size_t size) const {
+    if (type() != OBJECT_VALUE) {
+        return nullptr;
+    }
+    size_t low = 0;
+    size_t high = large_.size;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        const JsonNode& name = large_.members[mid].key;
+        int ret = compare_key(name.str(), name.str_size(), key, size);
+        if (ret == 0) {
+            return &large_.members[mid].value;
+        }
+        if (ret < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
+const JsonNode* JsonNode::find(const char* key) const {
+    return find(key, strlen(key));
+}
+
+const JsonNode& JsonNode::operator[](const char* key) const {
+    const JsonNode* node = find(key);
+    return node != nullptr ? *node : null_node();
+}
+
+const JsonMember& JsonNode::member(size_t index) const {
+    static const JsonMember empty;
+    if (type() != OBJECT_VALUE || index >= large_.size) {
+        return empty;
+    }
+    return large_.members[index];
+}
+
+/* ---------------- JsonDocument ---------------- */
+
+JsonDocument::JsonDocument(size_t arena_block) : arena_(arena_block) {}
+
+void JsonDocument::clear() {
+    arena_.reset();
+    root_ = JsonNode();
+    error_.clear();
+}
+
+void JsonDocument::set_string(JsonNode& node, const char* str, size_t size) {
+    node.small_.type = JsonNode::STRING_VALUE;
+    if (size <= JsonNode::SHORT_STRING_MAX) {
+        node.small_.size = (uint8_t)size;
+        memcpy(node.small_.chars, str, size);
+        return;
+    }
+    char* copy = (char*)arena_.allocate(size, 1);
+    memcpy(copy, str, size);
+    node.large_.string_kind = JsonNode::LONG_STRING;
+    node.large_.size = (uint32_t)size;
+    node.large_.str = copy;
+}
+
+JsonNode* JsonDocument::copy_nodes(const JsonNode* nodes, size_t count) {
+    if (count == 0) {
+        return nullptr;
+    }
+    JsonNode* copy = (JsonNode*)arena_.allocate(sizeof(JsonNode) * count, alignof(JsonNode));
+    memcpy((void*)copy, nodes, sizeof(JsonNode) * count);
+    return copy;
+}
+
+JsonMember* JsonDocument::copy_members(JsonMember* members, size_t& count) {
+    if (count == 0) {
+        return nullptr;
+    }
+    // 按 key 排序，重复的 key 和 jsoncpp 一样保留后出现的
+    auto less = [](const JsonMember& a, const JsonMember& b) {
+        return compare_key(a.key.str(), a.key.str_size(), b.key.str(), b.key.str_size()) < 0;
+    };
+    if (count <= 32) {
+        // 协议中的对象成员都不多，插入排序不用临时缓冲区
+        for (size_t i = 1; i < count; ++i) {
+            JsonMember item = members[i];
+            size_t j = i;
+            while (j > 0 && less(item, members[j - 1])) {
+                members[j] = members[j - 1];
+                j--;
+            }
+            members[j] = item;
+        }
+    } else {
+        std::stable_sort(members, members + count, less);
+    }
+    size_t unique = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (unique > 0 && members[unique - 1].key.equals(members[i].key.str(), members[i].key.str_size())) {
+            members[unique - 1] = members[i];
+        } else {
+            members[unique++] = members[i];
+        }
+    }
+    count = unique;
+    JsonMember* copy = (JsonMember*)arena_.allocate(sizeof(JsonMember) * unique, alignof(JsonMember));
+    memcpy((void*)copy, members, sizeof(JsonMember) * unique);
+    return copy;
+}
+
+class JsonDocument::parser {
+public:
+    parser(JsonDocument& doc, const char* data, size_t size)
+        : doc_(doc), begin_(data), p_(data), end_(data + size), depth_(0) {}
+
+    bool parse(JsonNode& root) {
+        if (!parse_value(root)) {
+            return false;
+        }
+        skip_space();
+        while (p_ < end_ && *p_ == '\0') {                                  // 协议帧的 JSON 带结尾的 '\0'
+            p_++;
+        }
+        if (p_ != end_) {
+            return fail("unexpected data after value");
+        }
+        return true;
+    }
+
+private:
+    bool fail(const char* message) {
+        char text[128];
+        snprintf(text, sizeof(text), "%s at offset %zu", message, (size_t)(p_ - begin_));
+        doc_.error_ = text;
+        return false;
+    }
+
+    void skip_space() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+            p_++;
+        }
+    }
+
+    bool literal(const char* text, size_t size) {
+        if ((size_t)(end_ - p_) < size || memcmp(p_, text, size) != 0) {
+            return fail("invalid literal");
+        }
+        p_ += size;
+        return true;
+    }
+
+    bool parse_value(JsonNode& node) {
+        skip_space();
+        if (p_ >= end_) {
+            return fail("unexpected end of data");
+        }
+        switch (*p_) {
+            case '{': return parse_object(node);
+            case '[': return parse_array(node);
+            case '"': return parse_string(node);
+            case 't':
+                node.large_.type = JsonNode::BOOL_VALUE;
+                node.large_.b = true;
+                return literal("true", 4);
+            case 'f':
+                node.large_.type = JsonNode::BOOL_VALUE;
+                node.large_.b = false;
+                return literal("false", 5);
+            case 'n':
+                node.set_null();
+                return literal("null", 4);
+            default:
+                if (*p_ == '-' || (*p_ >= '0' && *p_ <= '9')) {
+                    return parse_number(node);
+                }
+                return fail("invalid value");
+        }
+    }
+
+    bool parse_object(JsonNode& node) {
+        if (++depth_ > JSON_DOM_MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+        p_++;
+        size_t mark = doc_.member_stack_.size();
+        skip_space();
+        if (p_ < end_ && *p_ == '}') {
+            p_++;
+        } else {
+            while (true) {
+                JsonMember member;
+                skip_space();
+                if (p_ >= end_ || *p_ != '"') {
+                    return fail("expected member name");
+                }
+                if (!parse_string(member.key)) {
+                    return false;
+                }
+                skip_space();
+                if (p_ >= end_ || *p_ != ':') {
+                    return fail("expected ':'");
+                }
+                p_++;
+                if (!parse_value(member.value)) {
+                    return false;
+                }
+                doc_.member_stack_.push_back(member);
+
+                skip_space();
+                if (p_ < end_ && *p_ == ',') {
+                    p_++;
+                } else if (p_ < end_ && *p_ == '}') {
+                    p_++;
+                    break;
+                } else {
+                    return fail("expected ',' or '}'");
+                }
+            }
+        }
+
+        size_t count = doc_.member_stack_.size() - mark;
+        node.set_null();
+        node.large_.type = JsonNode::OBJECT_VALUE;
+        node.large_.members = doc_.copy_members(doc_.member_stack_.data() + mark, count);
+        node.large_.size = (uint32_t)count;
+        doc_.member_stack_.resize(mark);
+        depth_--;
+        return true;
+    }
+
+    bool parse_array(JsonNode& node) {
+        if (++depth_ > JSON_DOM_MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+        p_++;
+        size_t mark = doc_.node_stack_.size();
+        skip_space();
+        if (p_ < end_ && *p_ == ']') {
+            p_++;
+        } else {
+            while (true) {
+                JsonNode item;
+                if (!parse_value(item)) {
+                    return false;
+                }
+                doc_.node_stack_.push_back(item);
+
+                skip_space();
+                if (p_ < end_ && *p_ == ',') {
+                    p_++;
+                } else if (p_ < end_ && *p_ == ']') {
+                    p_++;
+                    break;
+                } else {
+                    return fail("expected ',' or ']'");
+                }
+            }
+        }
+
+        size_t count = doc_.node_stack_.size() - mark;
+        node.set_null();
+        node.large_.type = JsonNode::ARRAY_VALUE;
+        node.large_.size = (uint32_t)count;
+        node.large_.items = doc_.copy_nodes(doc_.node_stack_.data() + mark, count);
+        doc_.node_stack_.resize(mark);
+        depth_--;
+        return true;
+    }
+
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool parse_hex4(unsigned& value) {
+        if (end_ - p_ < 4) {
+            return fail("bad unicode escape");
+        }
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            int digit = hex_value(p_[i]);
+            if (digit < 0) {
+                return fail("bad unicode escape");
+            }
+            value = (value << 4) | digit;
+        }
+        p_ += 4;
+        return true;
+    }
+
+    static void append_utf8(std::string& out, unsigned cp) {
+        if (cp < 0x80) {
+            out += (char)cp;
+        } else if (cp < 0x800) {
+            out += (char)(0xc0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+            out += (char)(0xe0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3f));
+            out += (char)(0x80 | (cp & 0x3f));
+        } else {
+            out += (char)(0xf0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3f));
+            out += (char)(0x80 | ((cp >> 6) & 0x3f));
+            out += (char)(0x80 | (cp & 0x3f));
+        }
+    }
+
+    bool parse_string(JsonNode& node) {
+        p_++;
+        const char* start = p_;
+        while (p_ < end_ && *p_ != '"' && *p_ != '\\') {
+            p_++;
+        }
+        if (p_ < end_ && *p_ == '"') {                                     // 没有转义，直接拷贝
+            doc_.set_string(node, start, p_ - start);
+            p_++;
+            return true;
+        }
+
+        std::string& out = doc_.scratch_;
+        out.assign(start, p_ - start);
+        while (p_ < end_ && *p_ != '"') {
+            if (*p_ != '\\') {
+                out += *p_++;
+                continue;
+            }
+            if (++p_ >= end_) {
+                break;
+            }
+            char c = *p_++;
+            switch (c) {
+                case '"':  out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/'; break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    unsigned cp;
+                    if (!parse_hex4(cp)) {
+                        return false;
+                    }
+                    if (cp >= 0xd800 && cp <= 0xdbff) {                     // 代理对
+                        unsigned low;
+                        if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u') {
+                            return fail("expected low surrogate");
+                        }
+                        p_ += 2;
+                        if (!parse_hex4(low) || low < 0xdc00 || low > 0xdfff) {
+                            return fail("bad low surrogate");
+                        }
+                        cp = 0x10000 + ((cp & 0x3ff) << 10) + (low & 0x3ff);
+                    }
+                    append_utf8(out, cp);
+                    break;
+                }
+                default:
+                    return fail("bad escape");
+            }
+        }
+        if (p_ >= end_) {
+            return fail("unterminated string");
+        }
+        p_++;
+        doc_.set_string(node, out.data(), out.size());
+        return true;
+    }
+
+    bool parse_number(JsonNode& node) {
+        const char* start = p_;
+        bool negative = *p_ == '-';
+        if (negative) {
+            p_++;
+        }
+        uint64_t value = 0;
+        bool overflow = false;
+        const char* digits = p_;
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            unsigned digit = *p_ - '0';
+            if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+                overflow = true;
+            }
+            value = value * 10 + digit;
+            p_++;
+        }
+        if (p_ == digits) {
+            return fail("invalid number");
+        }
+        bool real = false;
+        if (p_ < end_ && *p_ == '.') {
+            real = true;
+            p_++;
+            while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                p_++;
+            }
+        }
+        if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+            real = true;
+            p_++;
+            if (p_ < end_ && (*p_ == '+' || *p_ == '-')) {
+                p_++;
+            }
+            while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                p_++;
+            }
+        }
+
+        node.set_null();
+        if (!real && !overflow) {
+            if (!negative && value <= (uint64_t)std::numeric_limits<int64_t>::max()) {
+                node.large_.type = JsonNode::INT_VALUE;
+                node.large_.i = (int64_t)value;
+                return true;
+            }
+            if (!negative) {
+                node.large_.type = JsonNode::UINT_VALUE;
+                node.large_.u = value;
+                return true;
+            }
+            if (value <= (uint64_t)std::numeric_limits<int64_t>::max() + 1) {
+                node.large_.type = JsonNode::INT_VALUE;
+                node.large_.i = (int64_t)(0 - value);
+                return true;
+            }
+        }
+
+        // 输入不一定以 '\0' 结尾，拷贝出来再转换
+        char text[64];
+        size_t size = p_ - start;
+        if (size >= sizeof(text)) {
+            return fail("number too long");
+        }
+        memcpy(text, start, size);
+        text[size] = '\0';
+        node.large_.type = JsonNode::REAL_VALUE;
+        node.large_.d = strtod(text, nullptr);
+        return true;
+    }
+
+    JsonDocument& doc_;
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    int depth_;
+};
+
+bool JsonDocument::parse(const char* data, size_t size) {
+    clear();
+    node_stack_.clear();
+    member_stack_.clear();
+    parser p(*this, data, size);
+    if (!p.parse(root_)) {
+        root_ = JsonNode();
+        arena_.reset();
+        return false;
+    }
+    return true;
+}
+
+void JsonDocument::convert(const Json::Value& value, JsonNode& node) {
+    node.set_null();
+    switch (value.type()) {
+        case Json::nullValue:
+            break;
+        case Json::booleanValue:
+            node.large_.type = JsonNode::BOOL_VALUE;
+            node.large_.b = value.asBool();
+            break;
+        case Json::intValue:
+            node.large_.type = JsonNode::INT_VALUE;
+            node.large_.i = value.asLargestInt();
+            break;
+        case Json::uintValue:
+            // 和解析时一样，不超过 INT64_MAX 的按有符号保存
+            if (value.asLargestUInt() <= (Json::LargestUInt)std::numeric_limits<int64_t>::max()) {
+                node.large_.type = JsonNode::INT_VALUE;
+                node.large_.i = (int64_t)value.asLargestUInt();
+            } else {
+                node.large_.type = JsonNode::UINT_VALUE;
+                node.large_.u = value.asLargestUInt();
+            }
+            break;
+        case Json::realValue:
+            node.large_.type = JsonNode::REAL_VALUE;
+            node.large_.d = value.asDouble();
+            break;
+        case Json::stringValue: {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            if (value.getString(&begin, &end)) {
+                set_string(node, begin, end - begin);
+            } else {
+                set_string(node, "", 0);
+            }
+            break;
+        }
+        case Json::arrayValue: {
+            size_t mark = node_stack_.size();
+            for (Json::ArrayIndex i = 0; i < value.size(); ++i) {
+                JsonNode item;
+                convert(value[i], item);
+                node_stack_.push_back(item);
+            }
+            size_t count = node_stack_.size() - mark;
+            node.large_.type = JsonNode::ARRAY_VALUE;
+            node.large_.size = (uint32_t)count;
+            node.large_.items = copy_nodes(node_stack_.data() + mark, count);
+            node_stack_.resize(mark);
+            break;
+        }
+        case Json::objectValue: {
+            size_t mark = member_stack_.size();
+            for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it) {
+                JsonMember member;
+                const char* end = nullptr;
+                const char* name = it.memberName(&end);
+                set_string(member.key, name, end - name);
+                convert(*it, member.value);
+                member_stack_.push_back(member);
+            }
+            // jsoncpp 的成员已经按 key 排好序，copy_members 的插入排序不会移动
+            size_t count = member_stack_.size() - mark;
+            node.large_.type = JsonNode::OBJECT_VALUE;
+            node.large_.members = copy_members(member_stack_.data() + mark, count);
+            node.large_.size = (uint32_t)count;
+            member_stack_.resize(mark);
+            break;
+        }
+    }
+}
+
+void JsonDocument::from_value(const Json::Value& value) {
+    clear();
+    node_stack_.clear();
+    member_stack_.clear();
+    convert(value, root_);
+}
+
+void JsonDocument::to_value(const JsonNode& node, Json::Value& value) {
+    switch (node.type()) {
+        case JsonNode::NULL_VALUE:
+            value = Json::Value();
+            break;
+        case JsonNode::BOOL_VALUE:
+            value = Json::Value(node.large_.b);
+            break;
+        case JsonNode::INT_VALUE:
+            // 和 jsoncpp 解析一样，int 范围内的整数用 Int 保存
+            if (node.large_.i >= Json::Value::minInt && node.large_.i <= Json::Value::maxInt) {
+                value = Json::Value((Json::Int)node.large_.i);
+            } else {
+                value = Json::Value((Json::Int64)node.large_.i);
+            }
+            break;
+        case JsonNode::UINT_VALUE:
+            value = Json::Value((Json::UInt64)node.large_.u);
+            break;
+        case JsonNode::REAL_VALUE:
+            value = Json::Value(node.large_.d);
+            break;
+        case JsonNode::STRING_VALUE:
+            value = Json::Value(node.str(), node.str() + node.str_size());
+            break;
+        case JsonNode::ARRAY_VALUE:
+            value = Json::Value(Json::arrayValue);
+            value.resize(node.large_.size);
+            for (uint32_t i = 0; i < node.large_.size; ++i) {
+                to_value(node.large_.items[i], value[i]);
+            }
+            break;
+        case JsonNode::OBJECT_VALUE:
+            value = Json::Value(Json::objectValue);
+            for (uint32_t i = 0; i < node.large_.size; ++i) {
+                const JsonMember& member = node.large_.members[i];
+                const char* key = member.key.str();
+                to_value(member.value, value[std::string(key, member.key.str_size())]);
+            }
+            break;
+    }
+}
+
+/* ---------------- 输出 ---------------- */
+
+static const char JSON_HEX[] = "0123456789abcdef";
+
+static void append_unicode_escape(std::string& out, unsigned cp) {
+    char text[6] = {'\\', 'u', JSON_HEX[(cp >> 12) & 0xf], JSON_HEX[(cp >> 8) & 0xf],
+                    JSON_HEX[(cp >> 4) & 0xf], JSON_HEX[cp & 0xf]};
+    out.append(text, 6);
+}
+
+// 和 jsoncpp 的 utf8ToCodepoint 相同，非法编码返回 U+FFFD
+static unsigned utf8_codepoint(const char*& s, const char* end) {
+    const unsigned REPLACEMENT = 0xfffd;
+    unsigned first = (unsigned char)*s;
+    if (first < 0x80) {
+        return first;
+    }
+    if (first < 0xe0) {
+        if (end - s < 2) {
+            return REPLACEMENT;
+        }
+        unsigned cp = ((first & 0x1f) << 6) | ((unsigned)s[1] & 0x3f);
+        s += 1;
+        return cp < 0x80 ? REPLACEMENT : cp;
+    }
+    if (first < 0xf0) {
+        if (end - s < 3) {
+            return REPLACEMENT;
+        }
+        unsigned cp = ((first & 0x0f) << 12) | (((unsigned)s[1] & 0x3f) << 6) | ((unsigned)s[2] & 0x3f);
+        s += 2;
+        if (cp >= 0xd800 && cp <= 0xdfff) {
+            return REPLACEMENT;
+        }
+        return cp < 0x800 ? REPLACEMENT : cp;
+    }
+    if (first < 0xf8) {
+        if (end - s < 4) {
+            return REPLACEMENT;
+        }
+        unsigned cp = ((first & 0x07) << 18) | (((unsigned)s[1] & 0x3f) << 12) |
+                      (((unsigned)s[2] & 0x3f) << 6) | ((unsigned)s[3] & 0x3f);
+        s += 3;
+        return cp < 0x10000 ? REPLACEMENT : cp;
+    }
+    return REPLACEMENT;
+}
+
+static void write_string(const char* str, size_t size, std::string& out) {
+    out += '"';
+    const char* end = str + size;
+    const char* run = str;                                                  // 不需要转义的连续字符一次追加
+    for (const char* c = str; c < end; ++c) {
+        unsigned char ch = *c;
+        if (ch >= 0x20 && ch < 0x80 && ch != '"' && ch != '\\') {
+            continue;
+        }
+        out.append(run, c - run);
+        switch (ch) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                unsigned cp = utf8_codepoint(c, end);                       // 会移动 c 到字符的最后一个字节
+                if (cp < 0x10000) {
+                    append_unicode_escape(out, cp);
+                } else {
+                    cp -= 0x10000;
+                    append_unicode_escape(out, 0xd800 + ((cp >> 10) & 0x3ff));
+                    append_unicode_escape(out, 0xdc00 + (cp & 0x3ff));
+                }
+                break;
+            }
+        }
+        run = c + 1;
+    }
+    out.append(run, end - run);
+    out += '"';
+}
+
+static void write_real(double value, std::string& out) {
+    if (!std::isfinite(value)) {
+        out += std::isnan(value) ? "null" : (value < 0 ? "-1e+9999" : "1e+9999");
+        return;
+    }
+    char text[40];
+    int size = snprintf(text, sizeof(text), "%.17g", value);
+    out.append(text, size);
+    if (strchr(text, '.') == nullptr && strchr(text, 'e') == nullptr) {
+        out += ".0";                                                        // 和 jsoncpp 一样保留浮点类型
+    }
+}
+
+// 整数是最常见的值，不用 snprintf
+static void write_uint(uint64_t value, std::string& out) {
+    char text[20];
+    char* p = text + sizeof(text);
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    out.append(p, text + sizeof(text) - p);
+}
+
+void JsonDocument::write(const JsonNode& node, std::string& out) {
+    switch (node.type()) {
+        case JsonNode::NULL_VALUE:
+            out += "null";
+            break;
+        case JsonNode::BOOL_VALUE:
+            out += node.large_.b ? "true" : "false";
+            break;
+        case JsonNode::INT_VALUE:
+            if (node.large_.i < 0) {
+                out += '-';
+                write_uint(0 - (uint64_t)node.large_.i, out);
+            } else {
+                write_uint((uint64_t)node.large_.i, out);
+            }
+            break;
+        case JsonNode::UINT_VALUE:
+            write_uint(node.large_.u, out);
+            break;
+        case JsonNode::REAL_VALUE:
+            write_real(node.large_.d, out);
+            break;
+        case JsonNode::STRING_VALUE:
+            write_string(node.str(), node.str_size(), out);
+            break;
+        case JsonNode::ARRAY_VALUE:
+            out += '[';
+            for (uint32_t i = 0; i < node.large_.size; ++i) {
+                if (i > 0) {
+                    out += ',';
+                }
+                write(node.large_.items[i], out);
+            }
+            out += ']';
+            break;
+        case JsonNode::OBJECT_VALUE:
+            out += '{';
+            for (uint32_t i = 0; i < node.large_.size; ++i) {
+                const JsonMember& member = node.large_.members[i];
+                if (i > 0) {
+                    out += ',';
+                }
+                write_string(member.key.str(), member.key.str_size(), out);
+                out += ':';
+                write(member.value, out);
+            }
+            out += '}';
+            break;
+    }
+}
@@ -0,0 +1,244 @@
+#include "util/JsonPatch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <utility>
+
+// 路径中的 '~' 和 '/' 转义为 ~0、~1 (RFC 6901)
+static void append_token(std::string& path, const char* key, const char* end) {
+    path += '/';
+    for (; key != end; ++key) {
+        if (*key == '~') {
+            path += "~0";
+        } else if (*key == '/') {
+            path += "~1";
+        } else {
+            path += *key;
+        }
+    }
+}
+
+static void append_op(Json::Value& patch, const char* op, const std::string& path, const Json::Value* value) {
+    if (!patch.isArray()) {
+        patch = Json::Value(Json::arrayValue);
+    }
+    Json::Value item(Json::objectValue);
+    item["op"] = op;
+    item["path"] = path;
+    if (value != nullptr) {
+        item["value"] = *value;
+    }
+    patch.append(std::move(item));
+}
+
+static bool diff_at(const Json::Value& base, const Json::Value& target, std::string& path, Json::Value& patch) {
+    size_t length = path.size();
+    bool changed = false;
+
+    if (base.isObject() && target.isObject()) {
+        for (Json::Value::const_iterator it = target.begin(); it != target.end(); ++it) {
+            const char* end = nullptr;
+            const char* key = it.memberName(&end);
+            const Json::Value* old = base.find(key, end);
+            append_token(path, key, end);
+            if (old == nullptr) {
+                append_op(patch, "add", path, &*it);
+                changed = true;
+            } else if (diff_at(*old, *it, path, patch)) {
+                changed = true;
+            }
+            path.resize(length);
+        }
+        for (Json::Value::const_iterator it = base.begin(); it != base.end(); ++it) {
+            const char* end = nullptr;
+            const char* key = it.memberName(&end);
+            if (target.find(key, end) == nullptr) {
+                append_token(path, key, end);
+                append_op(patch, "remove", path, nullptr);
+                path.resize(length);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    if (base.isArray() && target.isArray() && base.size() == target.size()) {
+        for (Json::ArrayIndex i = 0; i < target.size(); ++i) {
+            path += '/';
+            path += std::to_string(i);
+            if (diff_at(base[i], target[i], path, patch)) {
+                changed = true;
+            }
+            path.resize(length);
+        }
+        return changed;
+    }
+
+    // 值不同或类型不同 (包括变成 null、数组和对象互换) 时整体替换
+    if (base == target) {
+        return false;
+    }
+    append_op(patch, "replace", path, &target);
+    return true;
+}
+
+bool json_diff(const Json::Value& base, const Json::Value& target, Json::Value& patch) {
+    std::string path;
+    return diff_at(base, target, path, patch);
+}
+
+// 取出 pointer 中下一段 token，处理 ~1 -> '/'、~0 -> '~'
+static const char* next_token(const char* pointer, std::string& token) {
+    token.clear();
+    const char* p = pointer + 1;                                            // 跳过 '/'
+    while (*p != '\0' && *p != '/') {
+        if (*p == '~' && (p[1] == '0' || p[1] == '1')) {
+            token += (p[1] == '0') ? '~' : '/';
+            p += 2;
+        } else {
+            token += *p++;
+        }
+    }
+    return p;
+}
+
+static const Json::Value* child(const Json::Value& node, const std::string& token) {
+    if (node.isObject()) {
+        return node.find(token.data(), token.data() + token.size());
+    }
+    if (node.isArray()) {
+        char* end = nullptr;
+        unsigned long index = strtoul(token.c_str(), &end, 10);
+        if (token.empty() || *end != '\0' || index >= node.size()) {
+            return nullptr;
+        }
+        return &node[(Json::ArrayIndex)index];
+    }
+    return nullptr;
+}
+
+const Json::Value* json_pointer_find(const Json::Value& doc, const char* pointer) {
+    const Json::Value* node = &doc;
+    std::string token;
+    while (node != nullptr && *pointer == '/') {
+        pointer = next_token(pointer, token);
+        node = child(*node, token);
+    }
+    return (*pointer == '\0') ? node : nullptr;                             // 非空 pointer 必须以 '/' 开头
+}
+
+// 拆成父节点的 pointer 和最后一段 token
+static bool split_pointer(const char* pointer, std::string& parent, std::string& key) {
+    const char* last = strrchr(pointer, '/');
+    if (last == nullptr) {
+        return false;
+    }
+    parent.assign(pointer, last - pointer);
+    next_token(last, key);
+    return true;
+}
+
+static Json::Value* find_container(Json::Value& doc, const std::string& pointer) {
+    Json::Value* node = const_cast<Json::Value*>(json_pointer_find(doc, pointer.c_str()));
+    if (node == nullptr || !(node->isObject() || node->isArray())) {
+        return nullptr;
+    }
+    return node;
+}
+
+// 数组下标，append 为 true 时允许 "-" 和 size (追加位置)
+static bool array_index(const Json::Value& array, const std::string& token, bool append, Json::ArrayIndex& index) {
+    if (append && token == "-") {
+        index = array.size();
+        return true;
+    }
+    char* end = nullptr;
+    unsigned long value = strtoul(token.c_str(), &end, 10);
+    if (token.empty() || *end != '\0' || (token.size() > 1 && token[0] == '0')) {
+        return false;
+    }
+    index = (Json::ArrayIndex)value;
+    return append ? index <= array.size() : index < array.size();
+}
+
+// RFC 6902 add: 对象成员新增或覆盖，数组在下标处插入
+static bool pointer_add(Json::Value& doc, const std::string& pointer, Json::Value value) {
+    if (pointer.empty()) {
+        doc = std::move(value);
+        return true;
+    }
+    std::string parent_pointer, key;
+    if (!split_pointer(pointer.c_str(), parent_pointer, key)) {
+        return false;
+    }
+    Json::Value* parent = find_container(doc, parent_pointer);
+    if (parent == nullptr) {
+        return false;
+    }
+    if (parent->isObject()) {
+        (*parent)[key] = std::move(value);
+        return true;
+    }
+    Json::ArrayIndex index;
+    if (!array_index(*parent, key, true, index)) {
+        return false;
+    }
+    return parent->insert(index, std::move(value));
+}
+
+static bool pointer_remove(Json::Value& doc, const std::string& pointer, Json::Value* removed) {
+    std::string parent_pointer, key;
+    if (!split_pointer(pointer.c_str(), parent_pointer, key)) {
+        return false;                                                       // 不能删除整个文档
+    }
+    Json::Value* parent = find_container(doc, parent_pointer);
+    if (parent == nullptr) {
+        return false;
+    }
+    if (parent->isObject()) {
+        return parent->removeMember(key.data(), key.data() + key.size(), removed);
+    }
+    Json::ArrayIndex index;
+    return array_index(*parent, key, false, index) && parent->removeIndex(index, removed);
+}
+
+bool json_pointer_move(Json::Value& doc, const char* from, const char* to) {
+    Json::Value value;                                                      // from 可能在 to 的子树中，先取出来
+    if (!pointer_remove(doc, from, &value)) {
+        return false;
+    }
+    return pointer_add(doc, to, std::move(value));
+}
+
+bool json_patch_apply(Json::Value& doc, const Json::Value& patch) {
+    if (!patch.isArray()) {
+        return false;
+    }
+    for (const Json::Value& item : patch) {
+        if (!item.isObject() || !item["op"].isString() || !item["path"].isString()) {
+            return false;
+        }
+        const std::string op = item["op"].asString();
+        const std::string path = item["path"].asString();
+        const Json::Value* value = item.find("value", "value" + 5);
+        bool ok = false;
+        if (op == "add" && value != nullptr) {
+            ok = pointer_add(doc, path, *value);
+        } else if (op == "remove") {
+            ok = pointer_remove(doc, path, nullptr);
+        } else if (op == "replace" && value != nullptr) {
+            Json::Value* target = const_cast<Json::Value*>(json_pointer_find(doc, path.c_str()));
+            if (target != nullptr) {
+                *target = *value;
+                ok = true;
+            }
+        } else if (op == "move" && item["from"].isString()) {
+            ok = json_pointer_move(doc, item["from"].asCString(), path.c_str());
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
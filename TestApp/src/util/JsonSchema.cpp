@@ -0,0 +1,105 @@
+#include "util/JsonSchema.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+
+JsonDecodeContext::JsonDecodeContext(const char* root) : root_(root), failed_(false) {
+    path_.reserve(8);
+}
+
+bool JsonDecodeContext::fail(const char* message) {
+    if (failed_) {
+        return false;
+    }
+    failed_ = true;
+    error_ = root_;
+    for (const path_item& item : path_) {
+        if (item.key != nullptr) {
+            error_ += '.';
+            error_ += item.key;
+        } else {
+            error_ += '[';
+            error_ += std::to_string(item.index);
+            error_ += ']';
+        }
+    }
+    error_ += ": ";
+    error_ += message;
+    return false;
+}
+
+// 整个字符串都是数字才算，"12abc" 和空串都不接受
+static bool parse_long(const char* str, long& out) {
+    char* end = nullptr;
+    errno = 0;
+    out = strtol(str, &end, 10);
+    return end != str && *end == '\0' && errno == 0;
+}
+
+static bool parse_double(const char* str, double& out) {
+    char* end = nullptr;
+    errno = 0;
+    out = strtod(str, &end);
+    return end != str && *end == '\0' && errno == 0 && isfinite(out);
+}
+
+bool json_decode_value(const Json::Value& value, bool& out, JsonDecodeContext& ctx) {
+    if (value.isBool()) {
+        out = value.asBool();
+        return true;
+    }
+    if (value.type() == Json::intValue || value.type() == Json::uintValue) {
+        if (value.asLargestInt() != 0 && value.asLargestInt() != 1) {
+            return ctx.fail("expected bool");
+        }
+        out = value.asLargestInt() == 1;
+        return true;
+    }
+    return ctx.fail("expected bool");
+}
+
+bool json_decode_value(const Json::Value& value, int& out, JsonDecodeContext& ctx) {
+    if (value.isInt()) {                                                    // 整数值的浮点数也是 isInt
+        out = value.asInt();
+        return true;
+    }
+    if (value.isString()) {
+        long number;
+        if (parse_long(value.asCString(), number) && number >= Json::Value::minInt && number <= Json::Value::maxInt) {
+            out = (int)number;
+            return true;
+        }
+        return ctx.fail("expected integer string");
+    }
+    return ctx.fail("expected integer");
+}
+
+bool json_decode_value(const Json::Value& value, double& out, JsonDecodeContext& ctx) {
+    if (value.isNumeric()) {
+        out = value.asDouble();
+        return true;
+    }
+    if (value.isString()) {
+        if (parse_double(value.asCString(), out)) {
+            return true;
+        }
+        return ctx.fail("expected number string");
+    }
+    return ctx.fail("expected number");
+}
+
+bool json_decode_value(const Json::Value& value, std::string& out, JsonDecodeContext& ctx) {
+    if (value.isString()) {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        value.getString(&begin, &end);
+        out.assign(begin, end - begin);
+        return true;
+    }
+    if (value.type() == Json::intValue || value.type() == Json::uintValue) {
+        out = value.asString();
+        return true;
+    }
+    return ctx.fail("expected string");
+}
@@ -1,11 +1,26 @@
 #include "util/Log.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdarg>
 #include <ctime>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <sstream>
-#include "util/theradpoolv1/thread_pool.h"
-
-thread_pool* log_thread = new thread_pool(1);   
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "util/LogRing.h"
+#include "util/LogSink.h"
+#include "util/Clock.h"
 
 // 全局日志级别控制
 static LogLevel currentLogLevel = defaultLogLevel;
@@ -15,131 +30,800 @@ void SetLogLevel(LogLevel level) {
     currentLogLevel = level;
 }
 
+// 按 TAG 设置的日志级别，一般只有几个，线性查找；每项高 32 位为 TAG id，低 32 位为级别
+static const int LOG_TAG_LEVEL_MAX = 32;
+static std::mutex tagLevelMutex;
+static std::atomic<int> tagLevelCount(0);
+static std::atomic<uint64_t> tagLevels[LOG_TAG_LEVEL_MAX];
+
+void log_set_tag_level(uint32_t tag_id, LogLevel level) {
+    std::lock_guard<std::mutex> lock(tagLevelMutex);
+    int count = tagLevelCount.load(std::memory_order_relaxed);
+    uint64_t item = ((uint64_t)tag_id << 32) | (uint32_t)level;
+    for (int i = 0; i < count; ++i) {
+        if ((uint32_t)(tagLevels[i].load(std::memory_order_relaxed) >> 32) == tag_id) {
+            tagLevels[i].store(item, std::memory_order_release);
+            return;
+        }
+    }
+    if (count < LOG_TAG_LEVEL_MAX) {
+        tagLevels[count].store(item, std::memory_order_relaxed);
+        tagLevelCount.store(count + 1, std::memory_order_release);
+    }
+}
+
+void log_set_tag_level(const char* TAG, LogLevel level) {
+    log_set_tag_level(log_tag_id(TAG), level);
+}
+
+// 判断该级别的日志是否需要记录
+static bool log_enabled(LogLevel level, const char* TAG) {
+    int count = tagLevelCount.load(std::memory_order_acquire);
+    if (count > 0) {
+        uint32_t tag_id = log_tag_id(TAG);
+        for (int i = 0; i < count; ++i) {
+            uint64_t item = tagLevels[i].load(std::memory_order_acquire);
+            if ((uint32_t)(item >> 32) == tag_id) {
+                return level >= (LogLevel)(uint32_t)item;
+            }
+        }
+    }
+    return level >= currentLogLevel;
+}
+
 // 获取当前时间字符串
 std::string get_current_time() {
     auto now = std::chrono::system_clock::now();
     auto in_time_t = std::chrono::system_clock::to_time_t(now);
-    
+
     std::stringstream ss;
     ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %H:%M:%S");
     return ss.str();
 }
 
-// 日志输出辅助函数
-static void log_output(LogLevel level, const char* TAG, const char* format, va_list args) {
-    // 检查日志级别是否需要输出
-    if (level < currentLogLevel) {
-        return;
+/*
+ * 日志写入流程:
+ * 调用线程只记录 格式串指针 + TAG 指针 + 参数 + 单调时间 到本线程的 LogRing (无锁、无内存分配、不格式化)，
+ * 后台日志线程收集所有线程的记录，按时间排序后再格式化，批量交给各个 LogSink 输出。
+ * 格式串和 TAG 只保存指针，必须是字符串常量或生命周期覆盖整个程序的字符串；
+ * %s 参数在调用时拷贝，不受此限制。
+ */
+
+static const size_t LOG_RING_SIZE = 128 * 1024;        // 每个线程的环形缓冲区大小
+static const size_t LOG_RECORD_MAX = 8 * 1024;         // 单条记录上限，超长的 %s 参数被截断；环形缓冲区按实际长度占用
+static const size_t LOG_STRING_RESERVE = 64;           // 截断字符串时给后面的参数预留的空间
+static const int LOG_IDLE_MIN_MS = 2;                  // 后台线程空闲时的轮询间隔，没有日志时逐步加倍
+static const int LOG_IDLE_MAX_MS = 50;
+
+// 环形缓冲区中的一条日志，后面紧跟参数区
+struct log_record {
+    uint32_t size;                  // 记录长度，含头部，LogRing 要求放在第一个字段
+    uint8_t level;
+    uint8_t has_cmd;                // 是否关联了 cmdIndex
+    uint16_t cmd_index;
+    uint64_t timestamp;             // CLOCK_MONOTONIC 纳秒
+    const char* tag;
+    const char* format;
+};
+
+/*
+ * 参数区按格式串中的顺序存放:
+ * 整数、浮点、指针、'*' 宽度精度各占 8 字节；
+ * 字符串为 uint32_t 长度 + 内容 + '\0'，按 8 字节对齐
+ */
+
+enum arg_length {
+    ARG_LEN_NONE = 0,
+    ARG_LEN_HH,
+    ARG_LEN_H,
+    ARG_LEN_L,
+    ARG_LEN_LL,
+    ARG_LEN_Z,
+    ARG_LEN_J,
+    ARG_LEN_T,
+    ARG_LEN_BIG_L
+};
+
+struct format_spec {
+    const char* begin;              // '%'
+    const char* end;                // 转换字符之后
+    char conv;                      // 转换字符，格式串不完整时为 0
+    arg_length length;
+    int stars;                      // 宽度 / 精度中 '*' 的个数
+    bool precision_star;
+    int precision;                  // 精度，没有写精度时为 -1
+};
+
+// 解析 p ('%' 处) 开始的一个转换说明，写入和格式化两端共用，保证参数顺序一致
+static void parse_spec(const char* p, format_spec& spec) {
+    spec.begin = p++;
+    spec.length = ARG_LEN_NONE;
+    spec.stars = 0;
+    spec.precision_star = false;
+    spec.precision = -1;
+
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'') {
+        p++;
+    }
+    if (*p == '*') {
+        spec.stars++;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec.stars++;
+            spec.precision_star = true;
+            p++;
+        } else {
+            spec.precision = 0;
+            while (*p >= '0' && *p <= '9') {
+                spec.precision = spec.precision * 10 + (*p - '0');
+                p++;
+            }
+        }
     }
-    
-    // 获取日志级别字符串
-    const char* level_str;
-    switch (level) {
-        case LOG_LEVEL_DEBUG: level_str = "DEBUG"; break;
-        case LOG_LEVEL_INFO:  level_str = "INFO ";  break;
-        case LOG_LEVEL_WARN:  level_str = "WARN ";  break;
-        case LOG_LEVEL_ERROR: level_str = "ERROR"; break;
-        default:              level_str = "UNKNOWN";
-    }
-    
-    // 输出日志头部
-    std::cout << "[" << get_current_time() << "] [" << level_str << "] [" << TAG << "] ";
-    
-    // 输出日志内容
-    vprintf(format, args);
-    std::cout << std::endl;
-}
-
-// 各日志级别的实现
-void LogDebug(const char* TAG, const char* format, ...) {
-    va_list args;
-    va_start(args, format);
-    log_output(LOG_LEVEL_DEBUG, TAG, format, args);
-    va_end(args);
-}
 
-void LogInfo(const char* TAG, const char* format, ...) {
-    va_list args;
-    va_start(args, format);
-    log_output(LOG_LEVEL_INFO, TAG, format, args);
-    va_end(args);
-}
+    switch (*p) {
+        case 'h':
+            p++;
+            spec.length = ARG_LEN_H;
+            if (*p == 'h') {
+                p++;
+                spec.length = ARG_LEN_HH;
+            }
+            break;
+        case 'l':
+            p++;
+            spec.length = ARG_LEN_L;
+            if (*p == 'l') {
+                p++;
+                spec.length = ARG_LEN_LL;
+            }
+            break;
+        case 'q': p++; spec.length = ARG_LEN_LL; break;
+        case 'z':
+        case 'Z': p++; spec.length = ARG_LEN_Z; break;
+        case 'j': p++; spec.length = ARG_LEN_J; break;
+        case 't': p++; spec.length = ARG_LEN_T; break;
+        case 'L': p++; spec.length = ARG_LEN_BIG_L; break;
+        default: break;
+    }
 
-void LogWarn(const char* TAG, const char* format, ...) {
-    va_list args;
-    va_start(args, format);
-    log_output(LOG_LEVEL_WARN, TAG, format, args);
-    va_end(args);
+    spec.conv = *p;
+    spec.end = *p ? p + 1 : p;
 }
 
-void LogError(const char* TAG, const char* format, ...) {
-    va_list args;
-    va_start(args, format);
-    log_output(LOG_LEVEL_ERROR, TAG, format, args);
-    va_end(args);
+// 写入端: 把可变参数按格式串拷贝到记录的参数区
+class arg_writer {
+public:
+    arg_writer(uint8_t* begin, uint8_t* end) : pos_(begin), end_(end) {}
+
+    bool put(uint64_t value) {
+        if (end_ - pos_ < 8) {
+            return false;
+        }
+        memcpy(pos_, &value, sizeof(value));
+        pos_ += 8;
+        return true;
+    }
+
+    bool put_double(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return put(bits);
+    }
+
+    bool put_string(const char* str, int precision) {
+        if (str == nullptr) {
+            str = "(null)";
+        }
+        size_t len = precision >= 0 ? strnlen(str, precision) : strlen(str);   // 有精度时字符串可以不以 '\0' 结尾
+        size_t room = end_ - pos_;
+        if (room < sizeof(uint32_t) + 1 + 8) {
+            return false;
+        }
+        room -= sizeof(uint32_t) + 1;
+        if (len > room) {
+            len = room > LOG_STRING_RESERVE * 2 ? room - LOG_STRING_RESERVE : room;
+        }
+        uint32_t len32 = len;
+        memcpy(pos_, &len32, sizeof(len32));
+        memcpy(pos_ + sizeof(len32), str, len);
+        pos_[sizeof(len32) + len] = '\0';
+        pos_ += (sizeof(len32) + len + 1 + 7) & ~(size_t)7;
+        return true;
+    }
+
+    uint8_t* pos() const { return pos_; }
+
+private:
+    uint8_t* pos_;
+    uint8_t* end_;
+};
+
+// 格式化端: 按同样的顺序读回参数
+class arg_reader {
+public:
+    arg_reader(const uint8_t* begin, const uint8_t* end) : pos_(begin), end_(end) {}
+
+    bool get(uint64_t& value) {
+        if (end_ - pos_ < 8) {
+            return false;
+        }
+        memcpy(&value, pos_, sizeof(value));
+        pos_ += 8;
+        return true;
+    }
+
+    bool get_double(double& value) {
+        uint64_t bits;
+        if (!get(bits)) {
+            return false;
+        }
+        memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    bool get_string(const char*& str) {
+        uint32_t len;
+        if ((size_t)(end_ - pos_) < sizeof(len) + 1) {
+            return false;
+        }
+        memcpy(&len, pos_, sizeof(len));
+        size_t total = (sizeof(len) + len + 1 + 7) & ~(size_t)7;
+        if ((size_t)(end_ - pos_) < total) {
+            return false;
+        }
+        str = (const char*)pos_ + sizeof(len);
+        pos_ += total;
+        return true;
+    }
+
+private:
+    const uint8_t* pos_;
+    const uint8_t* end_;
+};
+
+/*
+ * 按格式串读取可变参数写入参数区
+ * 参数区满了就停止，后面的转换说明在格式化时原样输出
+ */
+static uint8_t* encode_args(uint8_t* begin, uint8_t* end, const char* format, va_list args) {
+    arg_writer writer(begin, end);
+    format_spec spec;
+    const char* p = format;
+
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        parse_spec(p, spec);
+        p = spec.end;
+
+        bool ok = true;
+        int star_precision = -1;
+        for (int i = 0; i < spec.stars && ok; ++i) {
+            int star = va_arg(args, int);
+            star_precision = star;
+            ok = writer.put((uint64_t)(int64_t)star);
+        }
+
+        switch (spec.conv) {
+            case 'd':
+            case 'i': {
+                int64_t value;
+                switch (spec.length) {
+                    case ARG_LEN_L: value = va_arg(args, long); break;
+                    case ARG_LEN_LL: value = va_arg(args, long long); break;
+                    case ARG_LEN_Z: value = va_arg(args, ssize_t); break;
+                    case ARG_LEN_J: value = va_arg(args, intmax_t); break;
+                    case ARG_LEN_T: value = va_arg(args, ptrdiff_t); break;
+                    default: value = va_arg(args, int); break;
+                }
+                ok = ok && writer.put((uint64_t)value);
+                break;
+            }
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X': {
+                uint64_t value;
+                switch (spec.length) {
+                    case ARG_LEN_L: value = va_arg(args, unsigned long); break;
+                    case ARG_LEN_LL: value = va_arg(args, unsigned long long); break;
+                    case ARG_LEN_Z: value = va_arg(args, size_t); break;
+                    case ARG_LEN_J: value = va_arg(args, uintmax_t); break;
+                    case ARG_LEN_T: value = va_arg(args, ptrdiff_t); break;
+                    default: value = va_arg(args, unsigned int); break;
+                }
+                ok = ok && writer.put(value);
+                break;
+            }
+            case 'c':
+                ok = ok && writer.put((uint64_t)(int64_t)va_arg(args, int));
+                break;
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                double value = spec.length == ARG_LEN_BIG_L ? (double)va_arg(args, long double) : va_arg(args, double);
+                ok = ok && writer.put_double(value);
+                break;
+            }
+            case 's':
+                ok = ok && writer.put_string(va_arg(args, const char*),
+                                             spec.precision_star ? star_precision : spec.precision);
+                break;
+            case 'p':
+                ok = ok && writer.put((uint64_t)(uintptr_t)va_arg(args, void*));
+                break;
+            case 'n':
+                (void)va_arg(args, void*);                                  // 不支持 %n，只跳过参数
+                break;
+            default:
+                break;
+        }
+        if (!ok) {
+            break;
+        }
+    }
+    return writer.pos();
 }
 
-void log_output_str(LogLevel level, const char* TAG, const std::string& msg) {
-    if (level < currentLogLevel) {
+template<typename T>
+static void append_spec(std::string& out, const char* spec, const int* stars, int star_count, T value) {
+    char buffer[256];
+    int n;
+    switch (star_count) {
+        case 0: n = snprintf(buffer, sizeof(buffer), spec, value); break;
+        case 1: n = snprintf(buffer, sizeof(buffer), spec, stars[0], value); break;
+        default: n = snprintf(buffer, sizeof(buffer), spec, stars[0], stars[1], value); break;
+    }
+    if (n < 0) {
+        return;
+    }
+    if ((size_t)n < sizeof(buffer)) {
+        out.append(buffer, n);
         return;
     }
 
-    const char* level_str;
-    switch (level) {
-        case LOG_LEVEL_DEBUG: level_str = "DEBUG"; break;
-        case LOG_LEVEL_INFO:  level_str = "INFO ";  break;
-        case LOG_LEVEL_WARN:  level_str = "WARN ";  break;
-        case LOG_LEVEL_ERROR: level_str = "ERROR"; break;
-        default:              level_str = "UNKNOWN";
+    size_t offset = out.size();
+    out.resize(offset + n + 1);
+    switch (star_count) {
+        case 0: snprintf(&out[offset], n + 1, spec, value); break;
+        case 1: snprintf(&out[offset], n + 1, spec, stars[0], value); break;
+        default: snprintf(&out[offset], n + 1, spec, stars[0], stars[1], value); break;
     }
+    out.resize(offset + n);
+}
+
+// 后台线程中按格式串和参数区还原日志内容，逐个转换说明调用 snprintf
+static void format_args(std::string& out, const char* format, const uint8_t* begin, const uint8_t* end) {
+    arg_reader reader(begin, end);
+    format_spec spec;
+    const char* p = format;
+    const char* literal = format;
+    bool exhausted = false;
+
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        out.append(literal, p - literal);
+        if (p[1] == '%') {
+            out += '%';
+            p += 2;
+            literal = p;
+            continue;
+        }
+        parse_spec(p, spec);
+        p = spec.end;
+        literal = p;
+
+        // 复制出单个转换说明，long double 已转换为 double，去掉 'L'
+        char mini[32];
+        size_t spec_len = spec.end - spec.begin;
+        if (exhausted || spec_len >= sizeof(mini)) {
+            out.append(spec.begin, spec_len);
+            continue;
+        }
+        size_t mini_len = 0;
+        for (const char* q = spec.begin; q < spec.end; ++q) {
+            if (!(*q == 'L' && spec.length == ARG_LEN_BIG_L)) {
+                mini[mini_len++] = *q;
+            }
+        }
+        mini[mini_len] = '\0';
 
-    std::cout << "[" << get_current_time()
-              << "] [" << level_str
-              << "] [" << TAG << "] "
-              << msg << std::endl;
+        int stars[2] = {0, 0};
+        uint64_t value = 0;
+        bool ok = true;
+        for (int i = 0; i < spec.stars && ok; ++i) {
+            ok = reader.get(value);
+            stars[i] = (int)(int64_t)value;
+        }
+
+        switch (spec.conv) {
+            case 'd':
+            case 'i':
+                if ((ok = ok && reader.get(value))) {
+                    int64_t v = (int64_t)value;
+                    switch (spec.length) {
+                        case ARG_LEN_L: append_spec(out, mini, stars, spec.stars, (long)v); break;
+                        case ARG_LEN_LL: append_spec(out, mini, stars, spec.stars, (long long)v); break;
+                        case ARG_LEN_Z: append_spec(out, mini, stars, spec.stars, (ssize_t)v); break;
+                        case ARG_LEN_J: append_spec(out, mini, stars, spec.stars, (intmax_t)v); break;
+                        case ARG_LEN_T: append_spec(out, mini, stars, spec.stars, (ptrdiff_t)v); break;
+                        default: append_spec(out, mini, stars, spec.stars, (int)v); break;
+                    }
+                }
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                if ((ok = ok && reader.get(value))) {
+                    switch (spec.length) {
+                        case ARG_LEN_L: append_spec(out, mini, stars, spec.stars, (unsigned long)value); break;
+                        case ARG_LEN_LL: append_spec(out, mini, stars, spec.stars, (unsigned long long)value); break;
+                        case ARG_LEN_Z: append_spec(out, mini, stars, spec.stars, (size_t)value); break;
+                        case ARG_LEN_J: append_spec(out, mini, stars, spec.stars, (uintmax_t)value); break;
+                        case ARG_LEN_T: append_spec(out, mini, stars, spec.stars, (ptrdiff_t)value); break;
+                        default: append_spec(out, mini, stars, spec.stars, (unsigned int)value); break;
+                    }
+                }
+                break;
+            case 'c':
+                if ((ok = ok && reader.get(value))) {
+                    append_spec(out, mini, stars, spec.stars, (int)(int64_t)value);
+                }
+                break;
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                double d = 0;
+                if ((ok = ok && reader.get_double(d))) {
+                    append_spec(out, mini, stars, spec.stars, d);
+                }
+                break;
+            }
+            case 's': {
+                const char* str = nullptr;
+                if ((ok = ok && reader.get_string(str))) {
+                    append_spec(out, mini, stars, spec.stars, str);
+                }
+                break;
+            }
+            case 'p':
+                if ((ok = ok && reader.get(value))) {
+                    append_spec(out, mini, stars, spec.stars, (void*)(uintptr_t)value);
+                }
+                break;
+            case 'n':
+                break;
+            default:
+                out.append(spec.begin, spec_len);                          // 不认识的转换说明原样输出
+                break;
+        }
+        if (!ok) {
+            exhausted = true;
+            out.append(spec.begin, spec_len);
+        }
+    }
+    out.append(literal, p - literal);
 }
 
-// void log_thread_safe(LogLevel level, const char* TAG, const char* format, ...) {
-//     va_list args;
-//     va_start(args, format);
+// 一个线程的日志缓冲区，线程退出后由后台线程输出完剩余日志再回收
+struct log_ring_slot {
+    explicit log_ring_slot(uint32_t thread_id) : ring(LOG_RING_SIZE), tid(thread_id), closed(false) {}
 
-//     char buffer[1024];
-//     vsnprintf(buffer, sizeof(buffer), format, args);
+    LogRing ring;
+    uint32_t tid;
+    std::atomic<bool> closed;
+};
 
-//     va_end(args);
+struct log_thread_ring {
+    std::shared_ptr<log_ring_slot> slot;
 
-//     std::string msg(buffer);
+    ~log_thread_ring() {
+        if (slot) {
+            slot->closed.store(true, std::memory_order_release);
+        }
+    }
+};
 
-//     log_thread->submit([level, TAG, msg]() {
-//         log_output_str(level, TAG, msg);
-//     });
-// }
+static thread_local log_thread_ring current_ring;
+static thread_local int current_cmd_index = -1;
+
+/**
+ * 后台日志线程
+ * 轮询所有线程的 LogRing，有日志时 LOG_IDLE_MIN_MS 轮询一次，没有日志时间隔逐步加倍到 LOG_IDLE_MAX_MS；
+ * 某个线程的缓冲区用掉一半时由写入方主动唤醒。
+ * 对象创建后不再析构，程序退出时由 atexit 输出剩余日志。
+ */
+class log_backend {
+public:
+    static log_backend& instance() {
+        static log_backend* backend = new log_backend();
+        return *backend;
+    }
+
+    log_ring_slot* register_thread() {
+        auto slot = std::make_shared<log_ring_slot>((uint32_t)syscall(SYS_gettid));
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.push_back(slot);
+        }
+        current_ring.slot = slot;
+        return slot.get();
+    }
+
+    void wake() {
+        wakeup_.store(true, std::memory_order_release);
+        cv_.notify_one();
+    }
+
+    void add_sink(std::shared_ptr<LogSink> sink) {
+        std::lock_guard<std::mutex> lock(consume_mutex_);
+        sinks_.push_back(sink);
+    }
+
+    void set_ln(const std::string& ln) {
+        std::lock_guard<std::mutex> lock(consume_mutex_);
+        ln_ = ln;                                                           // 已经写入缓冲区的日志也按新的 LN 输出
+    }
+
+    void enable_console(bool enable) {
+        std::lock_guard<std::mutex> lock(consume_mutex_);
+        auto it = std::find(sinks_.begin(), sinks_.end(), console_);
+        if (enable && it == sinks_.end()) {
+            sinks_.push_back(console_);
+        } else if (!enable && it != sinks_.end()) {
+            console_->flush();
+            sinks_.erase(it);
+        }
+    }
+
+    // 输出所有已经写入的日志
+    void flush() {
+        while (drain()) {
+        }
+    }
+
+private:
+    struct pending_record {
+        uint64_t timestamp;
+        const log_record* record;
+        const log_ring_slot* slot;
+    };
+
+    log_backend() : wakeup_(false), console_(std::make_shared<ConsoleLogSink>()), cached_second_(-1) {
+        cached_time_[0] = '\0';
+        sinks_.push_back(console_);
+        std::thread(&log_backend::run, this).detach();
+        atexit([]() {
+            log_backend::instance().flush();
+        });
+    }
+
+    void run() {
+        sigset_t mask;                                                      // 第一条日志可能早于 main 屏蔽 SIGINT
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGINT);
+        pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+        int idle_ms = LOG_IDLE_MIN_MS;
+        while (true) {
+            if (drain()) {
+                idle_ms = LOG_IDLE_MIN_MS;
+            } else {
+                idle_ms = std::min(idle_ms * 2, LOG_IDLE_MAX_MS);
+                poll_sinks();
+            }
+
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            cv_.wait_for(lock, std::chrono::milliseconds(idle_ms), [this]() {
+                return wakeup_.load(std::memory_order_acquire);
+            });
+            wakeup_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // 取出各线程当前的日志，按时间排序后输出，返回是否有日志
+    bool drain() {
+        std::lock_guard<std::mutex> consume_lock(consume_mutex_);
+
+        std::vector<std::shared_ptr<log_ring_slot>> rings;
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                        [](const std::shared_ptr<log_ring_slot>& slot) {
+                                            return slot->closed.load(std::memory_order_acquire) && slot->ring.empty();
+                                        }),
+                         rings_.end());
+            rings = rings_;
+        }
+
+        pending_.clear();
+        for (auto& slot : rings) {
+            size_t size;
+            size_t taken = 0;
+            const void* data;
+            while (taken < slot->ring.capacity() / 2 && (data = slot->ring.peek(size)) != nullptr) {
+                const log_record* record = (const log_record*)data;
+                pending_.push_back({record->timestamp, record, slot.get()});
+                taken += size;
+            }
+        }
+        if (pending_.empty()) {
+            return false;
+        }
+
+        std::stable_sort(pending_.begin(), pending_.end(), [](const pending_record& a, const pending_record& b) {
+            return a.timestamp < b.timestamp;
+        });
+
+        struct timespec realtime;
+        clock_gettime(CLOCK_REALTIME, &realtime);
+        int64_t offset = (int64_t)((uint64_t)realtime.tv_sec * 1000000000ull + realtime.tv_nsec) -
+                         (int64_t)monotonic_ns();                           // 单调时间转换为墙上时间
+
+        for (const pending_record& item : pending_) {
+            const log_record* record = item.record;
+            const uint8_t* args = (const uint8_t*)(record + 1);
+            message_.clear();
+            format_args(message_, record->format, args, (const uint8_t*)record + record->size);
+
+            LogEntry entry;
+            entry.level = (LogLevel)record->level;
+            entry.tag = record->tag;
+            entry.tid = item.slot->tid;
+            entry.timestamp = record->timestamp + offset;
+            entry.time_str = time_string(entry.timestamp / 1000000000ull);
+            entry.msg = message_.data();
+            entry.msg_len = message_.size();
+            entry.cmd_index = record->has_cmd ? record->cmd_index : -1;
+            entry.ln = ln_.c_str();
+            for (auto& sink : sinks_) {
+                sink->write(entry);
+            }
+        }
+        for (auto& sink : sinks_) {
+            sink->flush();
+        }
+
+        for (auto& slot : rings) {
+            slot->ring.release();
+        }
+        return true;
+    }
 
-void log_thread_safe(LogLevel level, const char* TAG, const char* format, ...) {
-    if (level < currentLogLevel) {
+    void poll_sinks() {
+        std::lock_guard<std::mutex> lock(consume_mutex_);
+        for (auto& sink : sinks_) {
+            sink->poll();
+        }
+    }
+
+    // 同一秒内的日志复用时间字符串
+    const char* time_string(time_t second) {
+        if (second != cached_second_) {
+            struct tm tm_time;
+            localtime_r(&second, &tm_time);
+            strftime(cached_time_, sizeof(cached_time_), "%Y-%m-%d %H:%M:%S", &tm_time);
+            cached_second_ = second;
+        }
+        return cached_time_;
+    }
+
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<log_ring_slot>> rings_;
+
+    std::mutex wait_mutex_;
+    std::condition_variable cv_;
+    std::atomic<bool> wakeup_;
+
+    std::mutex consume_mutex_;                          // 后台线程和 atexit 刷出互斥，以下成员由它保护
+    std::vector<std::shared_ptr<LogSink>> sinks_;
+    std::shared_ptr<LogSink> console_;
+    std::vector<pending_record> pending_;
+    std::string message_;
+    std::string ln_;
+    time_t cached_second_;
+    char cached_time_[32];
+};
+
+// 记录一条日志到当前线程的缓冲区，不做格式化
+static void log_write(LogLevel level, const char* TAG, const char* format, va_list args) {
+    if (!log_enabled(level, TAG)) {
         return;
     }
 
-    va_list args;
-    va_start(args, format);
+    uint64_t timestamp = monotonic_ns();
+    log_backend& backend = log_backend::instance();
+    log_ring_slot* slot = current_ring.slot.get();
+    if (slot == nullptr) {
+        slot = backend.register_thread();
+    }
 
-    // 先拷贝 args，用于计算长度
-    va_list args_copy;
-    va_copy(args_copy, args);
-    int needed = vsnprintf(nullptr, 0, format, args_copy);
-    va_end(args_copy);
+    // 先编码到线程的暂存区，按实际长度向环形缓冲区申请，一条日志通常只占几十字节
+    alignas(8) static thread_local uint8_t scratch[LOG_RECORD_MAX];
+    log_record* record = (log_record*)scratch;
+    uint8_t* end = encode_args(scratch + sizeof(log_record), scratch + LOG_RECORD_MAX, format, args);
+    record->size = end - scratch;
+    record->level = level;
+    record->has_cmd = current_cmd_index >= 0;
+    record->cmd_index = current_cmd_index >= 0 ? current_cmd_index : 0;
+    record->timestamp = timestamp;
+    record->tag = TAG;
+    record->format = format;
 
-    // 创建动态字符串，+1 留给 '\0'
-    std::string msg(needed + 1, '\0');
-    vsnprintf(&msg[0], needed + 1, format, args); // 使用 &msg[0] 获取可写缓冲区
+    uint8_t* data;
+    while ((data = (uint8_t*)slot->ring.reserve(record->size)) == nullptr) {
+        backend.wake();                                                     // 缓冲区满，等后台线程取走，不丢日志
+        std::this_thread::yield();
+    }
+    memcpy(data, scratch, record->size);
 
-    va_end(args);
+    if (slot->ring.commit(record->size)) {
+        backend.wake();
+    }
+}
+
+void log_flush() {
+    log_backend::instance().flush();
+}
 
-    // 去掉最后的 '\0'，保持字符串长度正确
-    msg.resize(needed);
+void log_add_sink(std::shared_ptr<LogSink> sink) {
+    if (sink) {
+        log_backend::instance().add_sink(sink);
+    }
+}
+
+void log_enable_console(bool enable) {
+    log_backend::instance().enable_console(enable);
+}
+
+int log_cmd_index() {
+    return current_cmd_index;
+}
+
+void log_set_cmd_index(int cmdIndex) {
+    current_cmd_index = cmdIndex;
+}
 
-    // 提交到日志线程异步打印
-    log_thread->submit([level, TAG, msg]() {
-        log_output_str(level, TAG, msg);
-    });
+void log_set_ln(const std::string& ln) {
+    log_backend::instance().set_ln(ln);
+}
+
+void log_output_str(LogLevel level, const char* TAG, const std::string& msg) {
+    log_thread_safe(level, TAG, "%s", msg.c_str());
+}
+
+// log_thread_safe / LogDebug ... 宏最终调用这里
+void log_printf(LogLevel level, const char* TAG, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    log_write(level, TAG, format, args);
+    va_end(args);
 }
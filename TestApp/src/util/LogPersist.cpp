@@ -0,0 +1,234 @@
+#include "util/LogPersist.h"
+#include "protocol/Crc16.h"
+#include "util/Clock.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const size_t PERSIST_LINE_MAX = 60000;              // 记录长度字段和 CRC16 的长度都是 16 位
+
+PersistentLogSink::PersistentLogSink(const std::string& path, size_t size, int writeback_ms)
+    : path_(path), size_(size), writeback_ns_((uint64_t)(writeback_ms > 0 ? writeback_ms : 0) * 1000000ull),
+      fd_(-1), data_(nullptr), capacity_(0), offset_(0), seq_(1), run_(1),
+      urgent_(false), dirty_begin_(0), dirty_end_(0), last_writeback_(monotonic_ns()) {
+    size_ = (size_ + 4095) & ~(size_t)4095;
+    if (size_ < HEADER_SIZE * 2) {
+        size_ = HEADER_SIZE * 2;
+    }
+    open_file();
+}
+
+PersistentLogSink::~PersistentLogSink() {
+    if (data_ != nullptr) {
+        writeback();
+        munmap(data_, size_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+uint16_t PersistentLogSink::record_crc(const record_header* header) {
+    // 从 seq 开始到日志行结尾在内存中是连续的
+    Crc16::Calculator crc;
+    const uint8_t* begin = (const uint8_t*)&header->seq;
+    size_t length = sizeof(record_header) - offsetof(record_header, seq) + header->length;
+    return crc.calculate(begin, (uint16_t)length);
+}
+
+size_t PersistentLogSink::record_size(size_t length) {
+    return (sizeof(record_header) + length + 7) & ~(size_t)7;
+}
+
+void PersistentLogSink::scan(const uint8_t* area, size_t capacity, std::vector<found_record>& found) {
+    size_t offset = 0;
+    while (offset + sizeof(record_header) <= capacity) {
+        const record_header* header = (const record_header*)(area + offset);
+        if (header->magic == RECORD_MAGIC && header->length <= PERSIST_LINE_MAX) {
+            size_t size = record_size(header->length);
+            if (offset + size <= capacity && record_crc(header) == header->crc) {
+                found.push_back({header->seq, header->run, offset, size});
+                offset += size;
+                continue;
+            }
+        }
+        offset += 8;                                                        // 被覆盖了一半的旧记录，继续找下一个
+    }
+}
+
+bool PersistentLogSink::open_file() {
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        // 后台日志线程中不能再写日志，直接输出到 stderr
+        fprintf(stderr, "PersistentLogSink: open %s failed: %s\n", path_.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    bool fresh = fstat(fd_, &st) != 0 || st.st_size == 0;                   // 新建的文件内容本来就全是 0
+    if (fresh || (size_t)st.st_size != size_) {
+        if (ftruncate(fd_, size_) != 0) {
+            fprintf(stderr, "PersistentLogSink: ftruncate %s failed: %s\n", path_.c_str(), strerror(errno));
+            close(fd_);
+            fd_ = -1;
+            return false;
+        }
+    }
+
+    void* addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        fprintf(stderr, "PersistentLogSink: mmap %s failed: %s\n", path_.c_str(), strerror(errno));
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    data_ = (uint8_t*)addr;
+    capacity_ = size_ - HEADER_SIZE;
+
+    file_header* header = (file_header*)data_;
+    if (header->magic != FILE_MAGIC || header->version != FILE_VERSION || header->size != size_) {
+        if (!fresh) {
+            memset(data_, 0, size_);                                        // 格式不同，整个清空
+        }
+        header->magic = FILE_MAGIC;
+        header->version = FILE_VERSION;
+        header->size = size_;
+        header->run = 0;
+    }
+
+    // 接着上次运行最后一条记录继续写
+    std::vector<found_record> found;
+    scan(data_ + HEADER_SIZE, capacity_, found);
+    uint32_t last_run = header->run;
+    for (const found_record& item : found) {
+        if (item.seq >= seq_) {
+            seq_ = item.seq + 1;
+            offset_ = item.offset + item.size;
+        }
+        last_run = std::max(last_run, item.run);
+    }
+    run_ = last_run + 1;
+    header->run = run_;
+    header->write_offset = offset_;
+
+    dirty_begin_ = 0;
+    dirty_end_ = HEADER_SIZE;
+    return true;
+}
+
+void PersistentLogSink::write(const LogEntry& entry) {
+    if (data_ == nullptr) {
+        return;
+    }
+
+    line_.clear();
+    log_format_line(line_, entry);
+    if (line_.size() > PERSIST_LINE_MAX) {
+        line_.resize(PERSIST_LINE_MAX - 1);
+        line_ += '\n';
+    }
+
+    size_t size = record_size(line_.size());
+    if (offset_ + size > capacity_) {
+        offset_ = 0;                                                        // 记录不跨越文件末尾
+    }
+
+    // 只是普通的内存写入，由内核回写到文件
+    record_header* record = (record_header*)(data_ + HEADER_SIZE + offset_);
+    record->magic = RECORD_MAGIC;
+    record->length = (uint16_t)line_.size();
+    record->seq = seq_++;
+    record->run = run_;
+    record->reserved = 0;
+    memcpy(record + 1, line_.data(), line_.size());
+    record->crc = record_crc(record);
+
+    size_t begin = HEADER_SIZE + offset_;
+    offset_ += size;
+    ((file_header*)data_)->write_offset = offset_;
+
+    if (dirty_end_ == dirty_begin_) {
+        dirty_begin_ = begin;
+        dirty_end_ = begin + size;
+    } else {
+        dirty_begin_ = std::min(dirty_begin_, begin);
+        dirty_end_ = std::max(dirty_end_, begin + size);
+    }
+
+    if (entry.level >= LOG_LEVEL_WARN) {
+        urgent_ = true;
+    }
+}
+
+void PersistentLogSink::flush() {
+    if (urgent_ || monotonic_ns() - last_writeback_ >= writeback_ns_) {
+        writeback();
+    }
+    urgent_ = false;
+}
+
+void PersistentLogSink::poll() {
+    if (dirty_end_ != dirty_begin_ && monotonic_ns() - last_writeback_ >= writeback_ns_) {
+        writeback();
+    }
+}
+
+void PersistentLogSink::writeback() {
+    if (fd_ >= 0 && dirty_end_ != dirty_begin_) {
+        // 只发起回写不等待，相当于把内核的 dirty_expire 从 30s 缩短到 writeback_ms
+        sync_file_range(fd_, dirty_begin_, dirty_end_ - dirty_begin_, SYNC_FILE_RANGE_WRITE);
+        sync_file_range(fd_, 0, HEADER_SIZE, SYNC_FILE_RANGE_WRITE);
+    }
+    dirty_begin_ = 0;
+    dirty_end_ = 0;
+    last_writeback_ = monotonic_ns();
+}
+
+bool PersistentLogSink::recover(const std::string& path, std::vector<record>& records) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_SIZE * 2) {
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    const uint8_t* data = (const uint8_t*)addr;
+    const file_header* header = (const file_header*)data;
+    if (header->magic != FILE_MAGIC || header->version != FILE_VERSION) {
+        munmap(addr, size);
+        return false;
+    }
+
+    std::vector<found_record> found;
+    scan(data + HEADER_SIZE, size - HEADER_SIZE, found);
+    std::sort(found.begin(), found.end(), [](const found_record& a, const found_record& b) {
+        return a.seq < b.seq;
+    });
+
+    records.clear();
+    records.reserve(found.size());
+    for (const found_record& item : found) {
+        const record_header* rec = (const record_header*)(data + HEADER_SIZE + item.offset);
+        records.push_back({rec->seq, rec->run, std::string((const char*)(rec + 1), rec->length)});
+    }
+
+    munmap(addr, size);
+    return true;
+}
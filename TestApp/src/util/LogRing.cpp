@@ -0,0 +1,84 @@
+#include "util/LogRing.h"
+
+#include <string.h>
+
+LogRing::LogRing(size_t capacity) : tail_(0), reserve_pos_(0), cached_head_(0), head_(0), read_pos_(0) {
+    capacity_ = 4096;
+    while (capacity_ < capacity) {
+        capacity_ <<= 1;
+    }
+    mask_ = capacity_ - 1;
+    buffer_ = new uint8_t[capacity_];
+}
+
+LogRing::~LogRing() {
+    delete[] buffer_;
+}
+
+void* LogRing::reserve(size_t size) {
+    size = (size + ALIGN - 1) & ~(ALIGN - 1);
+    if (size == 0 || size > capacity_ / 2) {
+        return nullptr;
+    }
+
+    uint64_t pos = tail_.load(std::memory_order_relaxed);
+    size_t index = pos & mask_;
+    size_t contiguous = capacity_ - index;
+    size_t need = contiguous < size ? contiguous + size : size;            // 尾部放不下要连同尾部一起跳过
+
+    if (capacity_ - (pos - cached_head_) < need) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (capacity_ - (pos - cached_head_) < need) {
+            return nullptr;
+        }
+    }
+
+    if (contiguous < size) {
+        uint32_t mark = WRAP_MARK;
+        memcpy(buffer_ + index, &mark, sizeof(mark));
+        pos += contiguous;
+    }
+    reserve_pos_ = pos;
+    return buffer_ + (pos & mask_);
+}
+
+bool LogRing::commit(size_t size) {
+    size = (size + ALIGN - 1) & ~(ALIGN - 1);
+    uint64_t tail = reserve_pos_ + size;
+    tail_.store(tail, std::memory_order_release);
+
+    if (tail - cached_head_ > capacity_ / 2) {                              // 缓存的读位置可能过时，超过一半时再确认
+        cached_head_ = head_.load(std::memory_order_acquire);
+    }
+    return tail - cached_head_ > capacity_ / 2;
+}
+
+const void* LogRing::peek(size_t& size) {
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    while (read_pos_ != tail) {
+        size_t index = read_pos_ & mask_;
+        uint32_t length;
+        memcpy(&length, buffer_ + index, sizeof(length));
+        if (length == WRAP_MARK) {
+            read_pos_ += capacity_ - index;
+            continue;
+        }
+        size = (length + ALIGN - 1) & ~(ALIGN - 1);
+        const void* record = buffer_ + index;
+        read_pos_ += size;
+        return record;
+    }
+    return nullptr;
+}
+
+void LogRing::release() {
+    head_.store(read_pos_, std::memory_order_release);
+}
+
+bool LogRing::empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+}
+
+size_t LogRing::used() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+}
@@ -0,0 +1,232 @@
+#include "util/LogSink.h"
+#include "util/Clock.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+const char* log_level_name(LogLevel level) {
+    switch (level) {
+        case LOG_LEVEL_DEBUG: return "DEBUG";
+        case LOG_LEVEL_INFO:  return "INFO ";
+        case LOG_LEVEL_WARN:  return "WARN ";
+        case LOG_LEVEL_ERROR: return "ERROR";
+        default:              return "UNKNOWN";
+    }
+}
+
+void log_format_line(std::string& out, const LogEntry& entry) {
+    out += '[';
+    out += entry.time_str;
+    out += "] [";
+    out += log_level_name(entry.level);
+    out += "] [";
+    out += entry.tag;
+    out += "] ";
+    out.append(entry.msg, entry.msg_len);
+    out += '\n';
+}
+
+static void append_json_string(std::string& out, const char* str, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = str[i];
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out += hex[c >> 4];
+                    out += hex[c & 0xf];
+                } else {
+                    out += (char)c;                                         // UTF-8 (中文) 原样输出
+                }
+                break;
+        }
+    }
+    out += '"';
+}
+
+void log_format_json(std::string& out, const LogEntry& entry) {
+    char number[64];
+    const char* level = log_level_name(entry.level);
+    size_t level_len = strlen(level);
+    while (level_len > 0 && level[level_len - 1] == ' ') {
+        level_len--;
+    }
+
+    snprintf(number, sizeof(number), "{\"ts\":%llu,\"time\":\"",
+             (unsigned long long)(entry.timestamp / 1000000ull));
+    out += number;
+    out += entry.time_str;
+    snprintf(number, sizeof(number), ".%03u\",\"level\":", (unsigned)(entry.timestamp / 1000000ull % 1000));
+    out += number;
+    append_json_string(out, level, level_len);
+    out += ",\"tag\":";
+    append_json_string(out, entry.tag, strlen(entry.tag));
+    snprintf(number, sizeof(number), ",\"tid\":%u,\"cmd\":%d,\"ln\":", entry.tid, entry.cmd_index);
+    out += number;
+    append_json_string(out, entry.ln, strlen(entry.ln));
+    out += ",\"msg\":";
+    size_t msg_len = entry.msg_len;
+    while (msg_len > 0 && entry.msg[msg_len - 1] == '\n') {                 // LogDebug 的格式串常带结尾换行
+        msg_len--;
+    }
+    append_json_string(out, entry.msg, msg_len);
+    out += "}\n";
+}
+
+void ConsoleLogSink::write(const LogEntry& entry) {
+    log_format_line(buffer_, entry);
+}
+
+void ConsoleLogSink::flush() {
+    if (buffer_.empty()) {
+        return;
+    }
+    fwrite(buffer_.data(), 1, buffer_.size(), stdout);                      // 一批日志只刷一次，不再每行 endl
+    fflush(stdout);
+    buffer_.clear();
+}
+
+FileLogSink::FileLogSink(const std::string& path, size_t max_size, int max_files, int sync_interval_ms)
+    : path_(path), max_size_(max_size), max_files_(max_files < 0 ? 0 : max_files),
+      sync_interval_ns_((uint64_t)(sync_interval_ms > 0 ? sync_interval_ms : 0) * 1000000ull),
+      fd_(-1), file_size_(0), urgent_(false), dirty_(false), rotate_failed_(false), last_sync_(monotonic_ns()) {
+    open_file();
+}
+
+FileLogSink::~FileLogSink() {
+    write_buffer();
+    if (fd_ >= 0) {
+        fdatasync(fd_);
+        close(fd_);
+    }
+}
+
+void FileLogSink::format(std::string& out, const LogEntry& entry) {
+    log_format_line(out, entry);
+}
+
+void FileLogSink::write(const LogEntry& entry) {
+    format(buffer_, entry);
+    if (entry.level >= LOG_LEVEL_WARN) {
+        urgent_ = true;
+    }
+    if (buffer_.size() >= BUFFER_LIMIT) {
+        write_buffer();
+    }
+}
+
+void FileLogSink::flush() {
+    write_buffer();
+    if (urgent_ || monotonic_ns() - last_sync_ >= sync_interval_ns_) {
+        sync();
+    }
+    urgent_ = false;
+}
+
+void FileLogSink::poll() {
+    if (dirty_ && monotonic_ns() - last_sync_ >= sync_interval_ns_) {
+        sync();
+    }
+}
+
+void JsonLogSink::format(std::string& out, const LogEntry& entry) {
+    log_format_json(out, entry);
+}
+
+bool FileLogSink::open_file() {
+    fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        // 后台日志线程中不能再写日志，直接输出到 stderr
+        fprintf(stderr, "FileLogSink: open %s failed: %s\n", path_.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    file_size_ = fstat(fd_, &st) == 0 ? st.st_size : 0;
+    return true;
+}
+
+void FileLogSink::write_buffer() {
+    if (buffer_.empty()) {
+        return;
+    }
+    if (fd_ < 0 && !open_file()) {                                          // 目录还没挂载等情况，下次再试
+        buffer_.clear();
+        return;
+    }
+    if (file_size_ > 0 && file_size_ + buffer_.size() > max_size_) {
+        rotate();
+        if (fd_ < 0) {
+            buffer_.clear();
+            return;
+        }
+    }
+
+    const char* data = buffer_.data();
+    size_t left = buffer_.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd_, data, left);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "FileLogSink: write %s failed: %s\n", path_.c_str(), strerror(errno));
+            break;
+        }
+        data += n;
+        left -= n;
+        file_size_ += n;
+    }
+    buffer_.clear();
+    dirty_ = true;
+}
+
+void FileLogSink::rotate() {
+    fdatasync(fd_);
+    close(fd_);
+    fd_ = -1;
+
+    if (max_files_ == 0) {
+        // 清空失败 (只读挂载、IO 错误) 时不再重新打开追加，文件不会超过上限；这批日志丢弃，下次写出时再试
+        if (truncate(path_.c_str(), 0) != 0) {
+            if (!rotate_failed_) {
+                fprintf(stderr, "FileLogSink: truncate %s failed: %s, dropping logs until it succeeds\n",
+                    path_.c_str(), strerror(errno));
+            }
+            rotate_failed_ = true;
+            return;
+        }
+        rotate_failed_ = false;
+    } else {
+        // path.(n-1) -> path.n ... path -> path.1，最旧的一个被覆盖
+        for (int i = max_files_ - 1; i >= 1; --i) {
+            std::string from = path_ + "." + std::to_string(i);
+            std::string to = path_ + "." + std::to_string(i + 1);
+            rename(from.c_str(), to.c_str());
+        }
+        rename(path_.c_str(), (path_ + ".1").c_str());
+    }
+
+    dirty_ = false;
+    last_sync_ = monotonic_ns();
+    open_file();
+}
+
+void FileLogSink::sync() {
+    if (fd_ >= 0 && dirty_) {
+        fdatasync(fd_);
+    }
+    dirty_ = false;
+    last_sync_ = monotonic_ns();
+}
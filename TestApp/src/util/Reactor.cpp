@@ -0,0 +1,170 @@
+#include "util/Reactor.h"
+#include "util/Log.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+Reactor::Reactor() : epoll_fd_(-1), wakeup_fd_(-1), running_(false) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        log_thread_safe(LOG_LEVEL_ERROR, REACTOR_TAG, "epoll_create1 failed: %s", strerror(errno));
+        return;
+    }
+
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ < 0) {
+        log_thread_safe(LOG_LEVEL_ERROR, REACTOR_TAG, "eventfd failed: %s", strerror(errno));
+        return;
+    }
+
+    struct epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeup_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev) < 0) {
+        log_thread_safe(LOG_LEVEL_ERROR, REACTOR_TAG, "add wakeup fd failed: %s", strerror(errno));
+    }
+}
+
+Reactor::~Reactor() {
+    stop();
+    if (wakeup_fd_ >= 0) {
+        close(wakeup_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool Reactor::start() {
+    if (epoll_fd_ < 0 || wakeup_fd_ < 0) {
+        return false;
+    }
+    if (running_.exchange(true)) {
+        return true;
+    }
+    thread_ = std::thread(&Reactor::loop, this);
+    return true;
+}
+
+void Reactor::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    wakeup();
+    if (thread_.joinable() && std::this_thread::get_id() != thread_.get_id()) {
+        thread_.join();
+    } else if (thread_.joinable()) {
+        thread_.detach();                                                   // 在回调里调用 stop，不能 join 自己
+    }
+}
+
+bool Reactor::add_fd(int fd, uint32_t events, fd_callback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    struct epoll_event ev {};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        log_thread_safe(LOG_LEVEL_ERROR, REACTOR_TAG, "add fd %d failed: %s", fd, strerror(errno));
+        return false;
+    }
+    handlers_[fd] = std::make_shared<fd_callback>(std::move(callback));
+    return true;
+}
+
+bool Reactor::modify_fd(int fd, uint32_t events) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    struct epoll_event ev {};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        log_thread_safe(LOG_LEVEL_ERROR, REACTOR_TAG, "modify fd %d failed: %s", fd, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool Reactor::remove_fd(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (handlers_.erase(fd) == 0) {
+        return false;
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    return true;
+}
+
+void Reactor::post(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(fn));
+    }
+    wakeup();
+}
+
+bool Reactor::is_loop_thread() const {
+    return std::this_thread::get_id() == loop_thread_id_.load(std::memory_order_acquire);
+}
+
+bool Reactor::is_running() const {
+    return running_.load();
+}
+
+void Reactor::wakeup() {
+    uint64_t one = 1;
+    ssize_t n = write(wakeup_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+void Reactor::run_pending() {
+    std::vector<std::function<void()>> fns;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fns.swap(pending_);
+    }
+    for (auto& fn : fns) {
+        fn();
+    }
+}
+
+void Reactor::loop() {
+    loop_thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
+    log_thread_safe(LOG_LEVEL_INFO, REACTOR_TAG, "reactor thread started");
+
+    const int MAX_EVENTS = 32;
+    struct epoll_event events[MAX_EVENTS];
+    while (running_) {
+        int n = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_thread_safe(LOG_LEVEL_ERROR, REACTOR_TAG, "epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeup_fd_) {
+                uint64_t value;
+                while (read(wakeup_fd_, &value, sizeof(value)) > 0) {
+                }
+                continue;
+            }
+
+            std::shared_ptr<fd_callback> handler;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);                  // 同一批事件中前面的回调可能已经移除了这个 fd
+                auto it = handlers_.find(fd);
+                if (it != handlers_.end()) {
+                    handler = it->second;
+                }
+            }
+            if (handler && *handler) {
+                (*handler)(events[i].events);
+            }
+        }
+        run_pending();
+    }
+    log_thread_safe(LOG_LEVEL_INFO, REACTOR_TAG, "reactor thread exit");
+}
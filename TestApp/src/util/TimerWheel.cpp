@@ -0,0 +1,285 @@
+#include "util/TimerWheel.h"
+#include "util/Clock.h"
+#include "util/Log.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+TimerWheel::TimerWheel(Reactor& reactor, uint32_t tick_ms)
+    : reactor_(reactor), tick_ms_(tick_ms > 0 ? tick_ms : 1), tick_ns_((uint64_t)tick_ms_ * 1000000), start_ns_(0),
+      timer_fd_(-1), armed_tick_(UINT64_MAX), next_tick_(0), next_id_(1) {
+    start_ns_ = now_ns();
+    for (int level = 0; level < WHEEL_LEVELS; ++level) {
+        for (int index = 0; index < WHEEL_SIZE; ++index) {
+            timer_node& head = wheel_[level][index].head;
+            head.prev = &head;
+            head.next = &head;
+        }
+    }
+
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ < 0) {
+        log_thread_safe(LOG_LEVEL_ERROR, TIMER_WHEEL_TAG, "timerfd_create failed: %s", strerror(errno));
+        return;
+    }
+    reactor_.add_fd(timer_fd_, EPOLLIN, [this](uint32_t events) {
+        on_tick();
+    });
+}
+
+TimerWheel::~TimerWheel() {
+    if (timer_fd_ >= 0) {
+        reactor_.remove_fd(timer_fd_);
+        close(timer_fd_);
+    }
+}
+
+TimerWheel::timer_id TimerWheel::schedule_once(uint32_t delay_ms, std::function<void()> callback,
+                                               std::shared_ptr<interrupt_flag> flag) {
+    return schedule(delay_ms, 0, std::move(callback), flag);
+}
+
+TimerWheel::timer_id TimerWheel::schedule_periodic(uint32_t interval_ms, std::function<void()> callback,
+                                                   std::shared_ptr<interrupt_flag> flag) {
+    return schedule(interval_ms, interval_ms > 0 ? interval_ms : 1, std::move(callback), flag);
+}
+
+bool TimerWheel::cancel(timer_id id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timers_.find(id);
+    if (it == timers_.end()) {
+        return false;
+    }
+    timer_node* node = it->second.get();
+    node->cancelled = true;
+    if (node->prev != nullptr) {                                            // 正在回调的定时器已经不在槽里
+        unlink_node(node);
+    }
+    timers_.erase(it);
+    if (timers_.empty()) {
+        update_timerfd();                                                   // 还有其它定时器时不重新设定，多唤醒一次无妨
+    }
+    return true;
+}
+
+size_t TimerWheel::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+}
+
+TimerWheel::timer_id TimerWheel::schedule(uint32_t delay_ms, uint32_t interval_ms, std::function<void()> callback,
+                                          std::shared_ptr<interrupt_flag> flag) {
+    if (timer_fd_ < 0 || !callback) {
+        return 0;
+    }
+
+    auto node = std::make_shared<timer_node>();
+    node->callback = std::move(callback);
+    node->flag = flag;
+    node->interval = interval_ms > 0 ? ms_to_ticks(interval_ms) : 0;
+    node->cancelled = false;
+    node->prev = nullptr;
+    node->next = nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (timers_.empty()) {
+        next_tick_ = std::max(next_tick_, current_tick());                  // 空闲期间 timerfd 停止，直接跳过经过的 tick
+    }
+    // 按实际时间向上取整到 tick，保证不早于 delay_ms 触发
+    uint64_t expires_ns = now_ns() - start_ns_ + (uint64_t)delay_ms * 1000000;
+    node->id = next_id_++;
+    node->expires = std::max(next_tick_, (expires_ns + tick_ns_ - 1) / tick_ns_);
+    add_node(node.get());
+    timers_[node->id] = node;
+    if (node->expires < armed_tick_) {
+        arm_timerfd(node->expires);
+    }
+    return node->id;
+}
+
+uint64_t TimerWheel::ms_to_ticks(uint32_t ms) const {
+    uint64_t ticks = (ms + tick_ms_ - 1) / tick_ms_;
+    return ticks > 0 ? ticks : 1;
+}
+
+void TimerWheel::add_node(timer_node* node) {
+    uint64_t expires = node->expires;
+    int64_t delta = (int64_t)(expires - next_tick_);
+    timer_node* head;
+
+    if (delta < 0) {                                                        // 已经过期，下一个 tick 处理
+        head = &wheel_[0][next_tick_ & WHEEL_MASK].head;
+    } else if (delta < (1 << WHEEL_BITS)) {
+        head = &wheel_[0][expires & WHEEL_MASK].head;
+    } else if (delta < (1 << (2 * WHEEL_BITS))) {
+        head = &wheel_[1][(expires >> WHEEL_BITS) & WHEEL_MASK].head;
+    } else if (delta < (1 << (3 * WHEEL_BITS))) {
+        head = &wheel_[2][(expires >> (2 * WHEEL_BITS)) & WHEEL_MASK].head;
+    } else {
+        if (delta >= (1 << (4 * WHEEL_BITS))) {                             // 超出时间轮范围，按最长处理
+            expires = next_tick_ + (1 << (4 * WHEEL_BITS)) - 1;
+            node->expires = expires;
+        }
+        head = &wheel_[3][(expires >> (3 * WHEEL_BITS)) & WHEEL_MASK].head;
+    }
+
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+void TimerWheel::unlink_node(timer_node* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = nullptr;
+    node->next = nullptr;
+}
+
+int TimerWheel::cascade(int level, int index) {
+    timer_node& head = wheel_[level][index].head;
+    timer_node* node = head.next;
+    head.prev = &head;
+    head.next = &head;
+
+    while (node != &head) {                                                 // 上层槽中的定时器重新放到下层
+        timer_node* next = node->next;
+        add_node(node);
+        node = next;
+    }
+    return index;
+}
+
+void TimerWheel::advance(std::vector<std::shared_ptr<timer_node>>& expired) {
+    int index = next_tick_ & WHEEL_MASK;
+    if (index == 0) {
+        for (int level = 1; level < WHEEL_LEVELS; ++level) {
+            if (cascade(level, (next_tick_ >> (level * WHEEL_BITS)) & WHEEL_MASK) != 0) {
+                break;
+            }
+        }
+    }
+    next_tick_++;
+
+    timer_node& head = wheel_[0][index].head;
+    while (head.next != &head) {
+        timer_node* node = head.next;
+        unlink_node(node);
+        auto it = timers_.find(node->id);
+        if (it != timers_.end()) {
+            expired.push_back(it->second);
+        }
+    }
+}
+
+void TimerWheel::on_tick() {
+    uint64_t expirations = 0;
+    if (read(timer_fd_, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<timer_node>> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        armed_tick_ = UINT64_MAX;
+        uint64_t now = current_tick();
+        while (next_tick_ <= now) {                                         // 补齐两次唤醒之间经过的 tick
+            if (timers_.empty()) {
+                next_tick_ = now + 1;
+                break;
+            }
+            advance(expired);
+        }
+    }
+
+    for (auto& node : expired) {
+        bool run = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!node->cancelled && node->flag && node->flag->is_stop_requested()) {
+                node->cancelled = true;                                     // 测试被取消，定时器随之丢弃
+                timers_.erase(node->id);
+            }
+            run = !node->cancelled;
+        }
+        if (run) {
+            node->callback();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (node->cancelled) {
+            continue;
+        }
+        if (node->interval > 0) {
+            node->expires += node->interval;
+            add_node(node.get());
+        } else {
+            timers_.erase(node->id);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    update_timerfd();
+}
+
+uint64_t TimerWheel::now_ns() const {
+    return monotonic_ns();
+}
+
+uint64_t TimerWheel::current_tick() const {
+    return (now_ns() - start_ns_) / tick_ns_;
+}
+
+/*
+ * 下一次需要处理的 tick：第 0 层最早的非空槽，或者上层最早一个需要下放的非空槽
+ * 上层槽中定时器的到期 tick 不早于下放点，所以结果不会晚于真正的到期时间
+ */
+uint64_t TimerWheel::next_wakeup_tick() {
+    uint64_t wakeup = UINT64_MAX;
+    for (int i = 0; i < WHEEL_SIZE; ++i) {
+        uint64_t tick = next_tick_ + i;
+        const timer_node& head = wheel_[0][tick & WHEEL_MASK].head;
+        if (head.next != &head) {
+            wakeup = tick;
+            break;
+        }
+    }
+
+    for (int level = 1; level < WHEEL_LEVELS; ++level) {
+        int shift = level * WHEEL_BITS;
+        uint64_t step = 1ULL << shift;
+        uint64_t tick = (next_tick_ + step - 1) & ~(step - 1);              // 本层第一个下放点
+        for (int i = 0; i < WHEEL_SIZE && tick < wakeup; ++i, tick += step) {
+            const timer_node& head = wheel_[level][(tick >> shift) & WHEEL_MASK].head;
+            if (head.next != &head) {
+                wakeup = tick;
+                break;
+            }
+        }
+    }
+    return wakeup;
+}
+
+void TimerWheel::arm_timerfd(uint64_t tick) {
+    struct itimerspec its {};
+    if (tick != UINT64_MAX) {
+        uint64_t ns = start_ns_ + tick * tick_ns_;                          // 已经过去的时间立即触发
+        its.it_value.tv_sec = ns / 1000000000ULL;
+        its.it_value.tv_nsec = ns % 1000000000ULL;
+        if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0) {
+            its.it_value.tv_nsec = 1;                                       // 全 0 表示停止
+        }
+    }
+    timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &its, nullptr);
+    armed_tick_ = tick;
+}
+
+void TimerWheel::update_timerfd() {
+    uint64_t tick = timers_.empty() ? UINT64_MAX : next_wakeup_tick();
+    if (tick != armed_tick_) {
+        arm_timerfd(tick);
+    }
+}